@@ -25,6 +25,11 @@
 /* Define to 1 if C AltiVec extensions are available. */
 /* #undef CAN_COMPILE_C_ALTIVEC */
 
+/* Define to 1 if AVX2 intrinsics are available. */
+#if defined(_MSC_VER) && _MSC_VER >= 1700
+# define CAN_COMPILE_AVX2 1
+#endif
+
 /* Define to 1 inline MMX assembly is available. */
 #define CAN_COMPILE_MMX 1
 
@@ -428,7 +428,7 @@ template < class T > T atomic_fetch_xor( T *object, T desired )
 }
 
 #  define atomic_fetch_xor_explicit(object,operand,order) \
-    atomic_fetch_sub(object,operand)
+    atomic_fetch_xor(object,operand)
 
 template < class T > T atomic_fetch_and( T *object, T desired )
 {
@@ -458,6 +458,104 @@ template < class T > T atomic_fetch_and( T *object, T desired )
     atomic_flag_clear(object)
 // sunqueen add end
 
+#  if defined (_MSC_VER)
+#   include <intrin.h>
+/* The global lock above serializes every atomic operation of the process.
+ * The 64 bits integers (statistics counters, dates) use interlocked
+ * operations instead; these overloads are preferred to the templates. */
+#   define VLC_ATOMIC_FETCH_OP_64(T,name,op) \
+static inline T atomic_##name( T *object, T operand ) \
+{ \
+    T old = atomic_load( object ); \
+    while( !atomic_compare_exchange_strong( object, &old, (T)(old op operand) ) ); \
+    return old; \
+}
+
+#   define VLC_ATOMIC_INTERLOCKED_64(T) \
+static inline T atomic_load( T *object ) \
+{ \
+    /* A plain read is not atomic on x86 */ \
+    return (T)_InterlockedCompareExchange64( (volatile __int64 *)object, 0, 0 ); \
+} \
+static inline bool atomic_compare_exchange_strong( T *object, T *expected, T desired ) \
+{ \
+    const __int64 old = _InterlockedCompareExchange64( (volatile __int64 *)object, \
+                                                       (__int64)desired, (__int64)*expected ); \
+    if( old == (__int64)*expected ) \
+        return true; \
+    *expected = (T)old; \
+    return false; \
+} \
+static inline T atomic_exchange( T *object, T desired ) \
+{ \
+    T old = atomic_load( object ); \
+    while( !atomic_compare_exchange_strong( object, &old, desired ) ); \
+    return old; \
+} \
+static inline void atomic_store( T *object, T desired ) \
+{ \
+    atomic_exchange( object, desired ); \
+} \
+VLC_ATOMIC_FETCH_OP_64(T, fetch_add, +) \
+VLC_ATOMIC_FETCH_OP_64(T, fetch_sub, -) \
+VLC_ATOMIC_FETCH_OP_64(T, fetch_or, |) \
+VLC_ATOMIC_FETCH_OP_64(T, fetch_xor, ^) \
+VLC_ATOMIC_FETCH_OP_64(T, fetch_and, &)
+
+VLC_ATOMIC_INTERLOCKED_64(long long)
+VLC_ATOMIC_INTERLOCKED_64(unsigned long long)
+
+/* Likewise for the 32 bits integers (reference and change counts), whose
+ * aligned reads are atomic */
+#   define VLC_ATOMIC_INTERLOCKED_32(T) \
+static inline T atomic_load( T *object ) \
+{ \
+    return *(volatile T *)object; \
+} \
+static inline void atomic_store( T *object, T desired ) \
+{ \
+    _InterlockedExchange( (volatile long *)object, (long)desired ); \
+} \
+static inline T atomic_exchange( T *object, T desired ) \
+{ \
+    return (T)_InterlockedExchange( (volatile long *)object, (long)desired ); \
+} \
+static inline bool atomic_compare_exchange_strong( T *object, T *expected, T desired ) \
+{ \
+    const long old = _InterlockedCompareExchange( (volatile long *)object, \
+                                                  (long)desired, (long)*expected ); \
+    if( old == (long)*expected ) \
+        return true; \
+    *expected = (T)old; \
+    return false; \
+} \
+static inline T atomic_fetch_add( T *object, T operand ) \
+{ \
+    return (T)_InterlockedExchangeAdd( (volatile long *)object, (long)operand ); \
+} \
+static inline T atomic_fetch_sub( T *object, T operand ) \
+{ \
+    return (T)_InterlockedExchangeAdd( (volatile long *)object, -(long)operand ); \
+} \
+static inline T atomic_fetch_or( T *object, T operand ) \
+{ \
+    return (T)_InterlockedOr( (volatile long *)object, (long)operand ); \
+} \
+static inline T atomic_fetch_xor( T *object, T operand ) \
+{ \
+    return (T)_InterlockedXor( (volatile long *)object, (long)operand ); \
+} \
+static inline T atomic_fetch_and( T *object, T operand ) \
+{ \
+    return (T)_InterlockedAnd( (volatile long *)object, (long)operand ); \
+}
+
+VLC_ATOMIC_INTERLOCKED_32(int)
+VLC_ATOMIC_INTERLOCKED_32(unsigned int)
+VLC_ATOMIC_INTERLOCKED_32(long)
+VLC_ATOMIC_INTERLOCKED_32(unsigned long)
+#  endif
+
 # endif
 # endif
 
@@ -117,6 +117,9 @@ struct block_t
 
     /* Rudimentary support for overloading block (de)allocation. */
     block_free_t pf_release;
+
+    /* Payload shared with other blocks (see block_Share), or NULL */
+    struct block_payload_t *p_payload;
 };
 
 /****************************************************************************
@@ -134,6 +137,12 @@ struct block_t
  *      with preheader and or body (increase
  *      and decrease are supported). Use it as it is optimised.
  * - block_Duplicate : create a copy of a block.
+ * - block_Share : create a block sharing the payload of a block, without
+ *      copying it. The payload is released with the last block.
+ * - block_Unshare : make the payload of a block writable, by copying it if
+ *      other blocks share it. It must be called before writing into the
+ *      payload of a block that may be shared. Growing a shared block with
+ *      block_Realloc copies it too.
  ****************************************************************************/
 VLC_API void block_Init( block_t *, void *, size_t );
 VLC_API block_t *block_Alloc( size_t ) VLC_USED VLC_MALLOC;
@@ -166,6 +175,9 @@ static inline void block_Release( block_t *p_block )
     p_block->pf_release( p_block );
 }
 
+VLC_API block_t *block_Share( block_t * ) VLC_USED;
+VLC_API block_t *block_Unshare( block_t * ) VLC_USED;
+
 VLC_API block_t *block_heap_Alloc(void *, size_t) VLC_USED VLC_MALLOC;
 VLC_API block_t *block_mmap_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC;
 VLC_API block_t * block_shm_Alloc(void *addr, size_t length) VLC_USED VLC_MALLOC;
@@ -299,6 +311,7 @@ static inline block_t *block_ChainGather( block_t *p_list )
  * - block_FifoEmpty : free all blocks in a fifo
  * - block_FifoPut : put a block
  * - block_FifoGet : get a packet from the fifo (and wait if it is empty)
+ * - block_FifoTryGet : get a packet from the fifo, or NULL if it is empty
  * - block_FifoShow : show the first packet of the fifo (and wait if
  *      needed), be carefull, you can use it ONLY if you are sure to be the
  *      only one getting data from the fifo.
@@ -313,6 +326,7 @@ VLC_API void block_FifoPace( block_fifo_t *fifo, size_t max_depth, size_t max_si
 VLC_API void block_FifoEmpty( block_fifo_t * );
 VLC_API size_t block_FifoPut( block_fifo_t *, block_t * );
 void block_FifoWake( block_fifo_t * );
+block_t *block_FifoTryGet( block_fifo_t * ) VLC_USED;
 VLC_API block_t * block_FifoGet( block_fifo_t * ) VLC_USED;
 VLC_API block_t * block_FifoShow( block_fifo_t * );
 size_t block_FifoSize( const block_fifo_t *p_fifo ) VLC_USED;
@@ -36,6 +36,16 @@
 
 typedef struct decoder_owner_sys_t decoder_owner_sys_t;
 
+/**
+ * Feedback of the video output about the pictures of a decoder
+ * (see decoder_GetDisplayFeedback).
+ */
+typedef struct
+{
+    mtime_t i_render; /**< Time needed to render a picture */
+    mtime_t i_late;   /**< Average lateness of the last pictures, negative if early */
+} decoder_feedback_t;
+
 /**
  * \defgroup decoder Decoder
  *
@@ -108,6 +118,27 @@ struct decoder_t
      */
     int             i_extra_picture_buffers;
 
+    /**
+     * Memory layout needed to decode directly into the pictures returned
+     * by decoder_NewPicture(). The video output is requested again when it
+     * changes.
+     */
+    picture_layout_t picture_layout;
+
+    /**
+     * Number of decoded pictures copied into the pictures returned by
+     * decoder_NewPicture(). The core reads and resets it after each call
+     * to pf_decode_video.
+     */
+    unsigned        i_copied_pictures;
+
+    /**
+     * Number of pictures the decoder did not decode or output in order to
+     * catch up. The core reads and resets it after each call to
+     * pf_decode_video.
+     */
+    unsigned        i_skipped_pictures;
+
     /* Audio output callbacks
      * XXX use decoder_NewAudioBuffer/decoder_DeleteAudioBuffer */
     block_t        *(*pf_aout_buffer_new)( decoder_t *, int );
@@ -129,6 +160,10 @@ struct decoder_t
      * XXX use decoder_GetDisplayRate */
     int             (*pf_get_display_rate)( decoder_t * );
 
+    /* Display feedback
+     * XXX use decoder_GetDisplayFeedback */
+    int             (*pf_get_display_feedback)( decoder_t *, decoder_feedback_t * );
+
     /* Private structure for the owner of the decoder */
     decoder_owner_sys_t *p_owner;
 
@@ -243,4 +278,13 @@ VLC_API mtime_t decoder_GetDisplayDate( decoder_t *, mtime_t ) VLC_USED;
  */
 VLC_API int decoder_GetDisplayRate( decoder_t * ) VLC_USED;
 
+/**
+ * This function returns how well the video output keeps up with the
+ * pictures of the decoder. It returns VLC_EGENERIC if there is none.
+ * Decoders may use it to skip non reference pictures or to lower their
+ * quality before the pictures get late, when they are allowed to drop
+ * (b_pace_control is false).
+ */
+VLC_API int decoder_GetDisplayFeedback( decoder_t *, decoder_feedback_t * ) VLC_USED;
+
 #endif /* _VLC_CODEC_H */
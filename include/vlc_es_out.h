@@ -89,6 +89,11 @@ enum es_out_query_e
     ES_OUT_GET_PCR_SYSTEM, /* arg1=mtime_t *, arg2=mtime_t * res=can fail */
     ES_OUT_MODIFY_PCR_SYSTEM, /* arg1=int is_absolute, arg2=mtime_t, res=can fail */
 
+    /* Same as ES_OUT_RESET_PCR, but the buffering ends after at most the
+     * given stream duration. It is meant for demuxers replaying cached data
+     * after a program change, so that playback starts on that data. */
+    ES_OUT_RESTART_BUFFERING, /* arg1=int64_t i_max(microsecond) */
+
     /* First value usable for private control */
     ES_OUT_PRIVATE_START = 0x10000,
 };
@@ -280,6 +280,20 @@ VLC_API void input_item_Release(input_item_t *);
 /******************
  * Input stats
  ******************/
+/**
+ * Distribution of durations in microseconds, in power-of-two buckets:
+ * bucket 0 counts null durations, bucket n counts durations in
+ * [2^(n-1), 2^n[ and the last bucket also counts all longer durations.
+ */
+#define INPUT_STATS_HISTOGRAM_BUCKETS 24
+
+typedef struct input_stats_histogram_t
+{
+    int64_t i_count;
+    int64_t i_total; /**< sum of all durations */
+    int64_t pi_buckets[INPUT_STATS_HISTOGRAM_BUCKETS];
+} input_stats_histogram_t;
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -305,6 +319,8 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_copied_pictures; /**< copies between the decoder and display */
+    int64_t i_skipped_pictures; /**< not decoded by the decoder to catch up */
 
     /* Sout */
     int64_t i_sent_packets;
@@ -314,6 +330,13 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Latencies */
+    input_stats_histogram_t decode_time; /**< per decoded block */
+    input_stats_histogram_t display_lateness; /**< per queued picture */
+    input_stats_histogram_t read_jitter; /**< between access blocks */
+    input_stats_histogram_t clock_latency; /**< caching, per clock reference */
+    input_stats_histogram_t clock_jitter; /**< of the clock references */
 };
 
 #endif
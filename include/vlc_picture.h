@@ -151,6 +151,44 @@ typedef struct
  */
 VLC_API picture_t * picture_NewFromResource( const video_format_t *, const picture_resource_t * ) VLC_USED;
 
+/**
+ * Memory layout requirements of picture buffers.
+ *
+ * The decoder, the video filters and the display agree on it, so that the
+ * decoder can write directly into the pictures that are displayed. A zero
+ * field is no requirement.
+ */
+typedef struct
+{
+    unsigned i_align;   /**< Alignment of the planes and pitches, in bytes */
+    unsigned i_width;   /**< Minimum width, in pixels, including margins */
+    unsigned i_height;  /**< Minimum height, in lines, including margins */
+} picture_layout_t;
+
+/**
+ * It merges the requirements of two layouts into the first one.
+ */
+static inline void picture_layout_Merge( picture_layout_t *p_dst,
+                                         const picture_layout_t *p_src )
+{
+    p_dst->i_align  = __MAX( p_dst->i_align, p_src->i_align );
+    p_dst->i_width  = __MAX( p_dst->i_width, p_src->i_width );
+    p_dst->i_height = __MAX( p_dst->i_height, p_src->i_height );
+}
+
+/**
+ * This function will create a new picture using the given format, with
+ * planes allocated to fulfil the given layout.
+ *
+ * If the layout is NULL then a plain picture_NewFromFormat is returned.
+ */
+VLC_API picture_t * picture_NewFromLayout( const video_format_t *, const picture_layout_t * ) VLC_USED;
+
+/**
+ * It returns true if the planes of the picture fulfil the given layout.
+ */
+VLC_API bool picture_HasLayout( const picture_t *, const picture_layout_t * ) VLC_USED;
+
 /**
  * This function will increase the picture reference count.
  * It will not have any effect on picture obtained from vout
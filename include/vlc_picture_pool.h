@@ -78,6 +78,12 @@ VLC_API picture_pool_t * picture_pool_New( int picture_count, picture_t *picture
  */
 VLC_API picture_pool_t * picture_pool_NewFromFormat( const video_format_t *, int picture_count ) VLC_USED;
 
+/**
+ * It creates a picture_pool_t creating images using the given format and
+ * fulfilling the given layout (see picture_NewFromLayout).
+ */
+VLC_API picture_pool_t * picture_pool_NewFromLayout( const video_format_t *, const picture_layout_t *, int picture_count ) VLC_USED;
+
 /**
  * It destroys a pool created by picture_pool_New.
  *
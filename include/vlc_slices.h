@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * vlc_slices.h: slice-parallel jobs
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SLICES_H
+#define VLC_SLICES_H 1
+
+/**
+ * \file
+ * This file defines the functions to run a job in parallel slices on the
+ * thread pool of the libvlc instance.
+ *
+ * A job is typically a video filter processing its planes as horizontal
+ * bands: each slice must be independent of the others.
+ */
+
+/**
+ * Callback processing one slice of a job.
+ *
+ * \param opaque the job data given to vlc_slices_Run()
+ * \param slice index of the slice, in [0, slices)
+ * \param slices number of slices of the job
+ */
+typedef void (*vlc_slice_callback_t)(void *opaque, unsigned slice, unsigned slices);
+
+/**
+ * It returns the number of threads (the calling one included) that can run
+ * the slices of a job: jobs should be split in at least that many slices.
+ */
+VLC_API unsigned vlc_slices_Count(vlc_object_t *);
+#define vlc_slices_Count(o) vlc_slices_Count(VLC_OBJECT(o))
+
+/**
+ * It runs the given callback for each of the slices, in parallel, and
+ * returns once all of them have been processed.
+ *
+ * The calling thread processes slices too. It is not a cancellation point.
+ * Several threads can run jobs at the same time.
+ */
+VLC_API void vlc_slices_Run(vlc_object_t *, vlc_slice_callback_t, void *opaque, unsigned slices);
+#define vlc_slices_Run(o, cb, opaque, slices) \
+    vlc_slices_Run(VLC_OBJECT(o), cb, opaque, slices)
+
+/**
+ * It computes the lines [*first, *end) of a band of a plane for a slice.
+ *
+ * The band boundaries are multiples of align (which must be a power of 2),
+ * except for the end of the last band.
+ */
+static inline void vlc_slice_Lines(unsigned slice, unsigned slices,
+                                   int lines, int align, int *first, int *end)
+{
+    const int band = ((lines + (int)slices - 1) / (int)slices + align - 1) & ~(align - 1);
+
+    *first = __MIN((int)slice * band, lines);
+    *end   = __MIN(*first + band, lines);
+}
+
+#endif /* VLC_SLICES_H */
+
@@ -132,6 +132,21 @@ struct  sout_mux_t
     bool  b_waiting_stream;
     /* we wait one second after first stream added */
     mtime_t     i_add_stream_start;
+    /* sout-mux-caching, read once */
+    mtime_t     i_add_stream_caching;
+
+    /* inputs with enough data, in a min-heap on the dts of their first
+     * block (see sout_MuxGetStream) */
+    struct
+    {
+        sout_input_t **pp_heap;
+        int          i_heap;
+        int          i_inputs;  /* number of inputs when it was built */
+        int          i_blocks;  /* blocks an input needs to be in it */
+        int          i_waiting; /* audio/video inputs not in it */
+        sout_input_t *p_last;   /* last input returned, to update */
+        bool         b_dirty;
+    } interleaver;
 };
 
 enum sout_mux_query_e
@@ -149,8 +164,20 @@ struct sout_input_t
     block_fifo_t    *p_fifo;
 
     void            *p_sys;
+
+    /* XXX private to stream_output.c */
+    int             i_index;    /* in sout_mux_t::pp_inputs */
+    int             i_heap;     /* in the interleaver heap, or -1 */
+    mtime_t         i_heap_dts;
 };
 
+/** A block dequeued by sout_MuxPull */
+typedef struct
+{
+    sout_input_t    *p_input;
+    block_t         *p_block;
+} sout_mux_block_t;
+
 
 VLC_API sout_mux_t * sout_MuxNew( sout_instance_t*, const char *, sout_access_out_t * ) VLC_USED;
 VLC_API sout_input_t * sout_MuxAddStream( sout_mux_t *, es_format_t * ) VLC_USED;
@@ -158,6 +185,7 @@ VLC_API void sout_MuxDeleteStream( sout_mux_t *, sout_input_t * );
 VLC_API void sout_MuxDelete( sout_mux_t * );
 VLC_API void sout_MuxSendBuffer( sout_mux_t *, sout_input_t  *, block_t * );
 VLC_API int sout_MuxGetStream(sout_mux_t *, int , mtime_t *);
+VLC_API int sout_MuxPull(sout_mux_t *, int, sout_mux_block_t *, int);
 
 static inline int sout_MuxControl( sout_mux_t *p_mux, int i_query, ... )
 {
@@ -211,6 +239,24 @@ static inline int sout_StreamIdSend( sout_stream_t *s, sout_stream_id_t *id, blo
     return s->pf_send( s, id, b );
 }
 
+/**
+ * Receiver of the elementary streams of the "fanout" stream output.
+ *
+ * The owner of an input (e.g. the VLM, for inputs shared by several media
+ * instances) sets a pointer to one of these in the "sout-fanout" address
+ * variable of the input's parent; the "fanout" stream output then passes
+ * every stream and block to it. pf_send() takes ownership of the block.
+ */
+typedef struct sout_fanout_t sout_fanout_t;
+struct sout_fanout_t
+{
+    void *p_sys;
+
+    void *(*pf_add)( sout_fanout_t *, const es_format_t * );
+    void  (*pf_del)( sout_fanout_t *, void * );
+    int   (*pf_send)( sout_fanout_t *, void *, block_t * );
+};
+
 /****************************************************************************
  * Encoder
  ****************************************************************************/
@@ -207,6 +207,13 @@ static inline int stream_DemuxControl( stream_t *s, int query, ... )
 VLC_API stream_t * stream_MemoryNew(vlc_object_t *p_obj, uint8_t *p_buffer, uint64_t i_size, bool b_preserve_memory );
 #define stream_MemoryNew( a, b, c, d ) stream_MemoryNew( VLC_OBJECT(a), b, c, d )
 
+/**
+ * Create a stream_t reading from a block, without copying it.
+ * The block is released by stream_Delete.
+ */
+VLC_API stream_t * stream_BlockNew(vlc_object_t *p_obj, block_t *p_block );
+#define stream_BlockNew( a, b ) stream_BlockNew( VLC_OBJECT(a), b )
+
 /**
  * Create a stream_t reading from a URL.
  * You must delete it using stream_Delete.
@@ -168,6 +168,26 @@ VLC_API int var_GetAndSet( vlc_object_t *, const char *, int, vlc_value_t * );
 
 VLC_API int var_Inherit( vlc_object_t *, const char *, int, vlc_value_t * );
 
+/**
+ * Variable name handle
+ *
+ * Variable names are interned: var_Handle() returns the same handle for a
+ * given name during the whole process life, so it can be kept in a static
+ * or in a module private structure. Looking a variable up by handle compares
+ * pointers instead of strings, and var_InheritHandle() remembers in which
+ * object (or in the configuration) the variable was found, until a variable
+ * is created or destroyed.
+ */
+typedef struct vlc_var_handle_t vlc_var_handle_t;
+
+VLC_API const vlc_var_handle_t *var_Handle( const char * ) VLC_USED;
+VLC_API int var_GetHandleChecked( vlc_object_t *, const vlc_var_handle_t *, int, vlc_value_t * );
+#define var_GetHandleChecked(o,h,t,v) var_GetHandleChecked(VLC_OBJECT(o),h,t,v)
+VLC_API int var_SetHandleChecked( vlc_object_t *, const vlc_var_handle_t *, int, vlc_value_t );
+#define var_SetHandleChecked(o,h,t,v) var_SetHandleChecked(VLC_OBJECT(o),h,t,v)
+VLC_API int var_InheritHandle( vlc_object_t *, const vlc_var_handle_t *, int, vlc_value_t * );
+#define var_InheritHandle(o,h,t,v) var_InheritHandle(VLC_OBJECT(o),h,t,v)
+
 VLC_API void var_FreeList( vlc_value_t *, vlc_value_t * );
 
 
@@ -747,6 +767,124 @@ VLC_API int var_InheritURational( vlc_object_t *, unsigned *num, unsigned *den,
 #define var_GetNonEmptyString(a,b)   var_GetNonEmptyString( VLC_OBJECT(a),b)
 #define var_GetAddress(a,b)  var_GetAddress( VLC_OBJECT(a),b)
 
+/**
+ * Get an integer value from a variable handle (see var_Handle)
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_handle The handle of the variable name
+ */
+VLC_USED
+static inline int64_t var_GetIntegerFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle )
+{
+    vlc_value_t val;
+    if( !var_GetHandleChecked( p_obj, p_handle, VLC_VAR_INTEGER, &val ) )
+        return val.i_int;
+    else
+        return 0;
+}
+
+VLC_USED
+static inline bool var_GetBoolFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle )
+{
+    vlc_value_t val;
+    if( !var_GetHandleChecked( p_obj, p_handle, VLC_VAR_BOOL, &val ) )
+        return val.b_bool;
+    else
+        return false;
+}
+
+VLC_USED
+static inline float var_GetFloatFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle )
+{
+    vlc_value_t val;
+    if( !var_GetHandleChecked( p_obj, p_handle, VLC_VAR_FLOAT, &val ) )
+        return val.f_float;
+    else
+        return 0.0;
+}
+
+VLC_USED
+static inline int64_t var_GetTimeFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle )
+{
+    vlc_value_t val;
+    if( !var_GetHandleChecked( p_obj, p_handle, VLC_VAR_TIME, &val ) )
+        return val.i_time;
+    else
+        return 0;
+}
+
+VLC_USED
+static inline void *var_GetAddressFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle )
+{
+    vlc_value_t val;
+    if( var_GetHandleChecked( p_obj, p_handle, VLC_VAR_ADDRESS, &val ) )
+        return NULL;
+    else
+        return val.p_address;
+}
+
+/**
+ * Set the value of a boolean variable from a variable handle (see var_Handle)
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_handle The handle of the variable name
+ * \param b The new boolean value of this variable
+ */
+static inline int var_SetBoolFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle, bool b )
+{
+    vlc_value_t val;
+    val.b_bool = b;
+    return var_SetHandleChecked( p_obj, p_handle, VLC_VAR_BOOL, val );
+}
+
+static inline int var_SetTimeFast( vlc_object_t *p_obj, const vlc_var_handle_t *p_handle, int64_t i )
+{
+    vlc_value_t val;
+    val.i_time = i;
+    return var_SetHandleChecked( p_obj, p_handle, VLC_VAR_TIME, val );
+}
+
+VLC_USED
+static inline int64_t var_InheritIntegerFast( vlc_object_t *obj, const vlc_var_handle_t *handle )
+{
+    vlc_value_t val;
+
+    if( var_InheritHandle( obj, handle, VLC_VAR_INTEGER, &val ) )
+        val.i_int = 0;
+    return val.i_int;
+}
+
+VLC_USED
+static inline bool var_InheritBoolFast( vlc_object_t *obj, const vlc_var_handle_t *handle )
+{
+    vlc_value_t val;
+
+    if( var_InheritHandle( obj, handle, VLC_VAR_BOOL, &val ) )
+        val.b_bool = false;
+    return val.b_bool;
+}
+
+VLC_USED
+static inline float var_InheritFloatFast( vlc_object_t *obj, const vlc_var_handle_t *handle )
+{
+    vlc_value_t val;
+
+    if( var_InheritHandle( obj, handle, VLC_VAR_FLOAT, &val ) )
+        val.f_float = 0.;
+    return val.f_float;
+}
+
+#define var_GetIntegerFast(a,b)   var_GetIntegerFast( VLC_OBJECT(a),b)
+#define var_GetBoolFast(a,b)   var_GetBoolFast( VLC_OBJECT(a),b)
+#define var_GetFloatFast(a,b)   var_GetFloatFast( VLC_OBJECT(a),b)
+#define var_GetTimeFast(a,b)   var_GetTimeFast( VLC_OBJECT(a),b)
+#define var_GetAddressFast(a,b)   var_GetAddressFast( VLC_OBJECT(a),b)
+#define var_SetBoolFast(a,b,c)   var_SetBoolFast( VLC_OBJECT(a),b,c)
+#define var_SetTimeFast(a,b,c)   var_SetTimeFast( VLC_OBJECT(a),b,c)
+#define var_InheritIntegerFast(o, h) var_InheritIntegerFast(VLC_OBJECT(o), h)
+#define var_InheritBoolFast(o, h) var_InheritBoolFast(VLC_OBJECT(o), h)
+#define var_InheritFloatFast(o, h) var_InheritFloatFast(VLC_OBJECT(o), h)
+
 VLC_API int var_LocationParse(vlc_object_t *, const char *mrl, const char *prefix);
 #define var_LocationParse(o, m, p) var_LocationParse(VLC_OBJECT(o), m, p)
 
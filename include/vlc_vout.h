@@ -56,6 +56,7 @@ typedef struct {
     bool                 change_fmt;
     const video_format_t *fmt;
     unsigned             dpb_size;
+    const picture_layout_t *layout; /* Layout of the decoder pictures or NULL */
 } vout_configuration_t;
 
 /**
@@ -43,8 +43,8 @@ private:
 
 ////////// BasicTaskScheduler0 //////////
 
-BasicTaskScheduler0::BasicTaskScheduler0()
-  : fLastHandledSocketNum(-1), fTriggersAwaitingHandling(0), fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1) {
+BasicTaskScheduler0::BasicTaskScheduler0(Boolean useHeapDelayQueue)
+  : fDelayQueue(useHeapDelayQueue), fLastHandledSocketNum(-1), fTriggersAwaitingHandling(0), fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1) {
   fHandlers = new HandlerSet;
   for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
     fTriggeredEventHandlers[i] = NULL;
@@ -82,6 +82,39 @@ void BasicTaskScheduler0::doEventLoop(char* watchVariable) {
   }
 }
 
+void BasicTaskScheduler0::handleTriggeredEvents() {
+  if (fTriggersAwaitingHandling == 0) return;
+
+  if (fTriggersAwaitingHandling == fLastUsedTriggerMask) {
+    // Common-case optimization for a single event trigger:
+    fTriggersAwaitingHandling = 0;
+    if (fTriggeredEventHandlers[fLastUsedTriggerNum] != NULL) {
+      (*fTriggeredEventHandlers[fLastUsedTriggerNum])(fTriggeredEventClientDatas[fLastUsedTriggerNum]);
+    }
+  } else {
+    // Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
+    unsigned i = fLastUsedTriggerNum;
+    EventTriggerId mask = fLastUsedTriggerMask;
+
+    do {
+      i = (i+1)%MAX_NUM_EVENT_TRIGGERS;
+      mask >>= 1;
+      if (mask == 0) mask = 0x80000000;
+
+      if ((fTriggersAwaitingHandling&mask) != 0) {
+	fTriggersAwaitingHandling &=~ mask;
+	if (fTriggeredEventHandlers[i] != NULL) {
+	  (*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
+	}
+
+	fLastUsedTriggerMask = mask;
+	fLastUsedTriggerNum = i;
+	break;
+      }
+    } while (i != fLastUsedTriggerNum);
+  }
+}
+
 EventTriggerId BasicTaskScheduler0::createEventTrigger(TaskFunc* eventHandlerProc) {
   unsigned i = fLastUsedTriggerNum;
   EventTriggerId mask = fLastUsedTriggerMask;
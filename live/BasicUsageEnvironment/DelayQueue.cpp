@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "DelayQueue.hh"
+#include "HashTable.hh"
 #include "GroupsockHelper.hh"
 
 static const int MILLION = 1000000;
@@ -91,10 +92,18 @@ const DelayInterval ETERNITY(INT_MAX, MILLION-1);
 
 intptr_t DelayQueueEntry::tokenCounter = 0;
 
+#define NOT_IN_HEAP (~0U)
+
 DelayQueueEntry::DelayQueueEntry(DelayInterval delay)
-  : fDeltaTimeRemaining(delay) {
+  : fDeltaTimeRemaining(delay), fHeapIndex(NOT_IN_HEAP) {
   fNext = fPrev = this;
-  fToken = ++tokenCounter;
+  // Entries are created by each worker thread's own scheduler (see "RTSPServerWorkerPool"),
+  // but tokens are drawn from one counter:
+#if defined(__GNUC__)
+  fToken = __sync_add_and_fetch(&tokenCounter, 1);
+#else
+  fToken = ++tokenCounter; // worker threads are used only on POSIX systems
+#endif
 }
 
 DelayQueueEntry::~DelayQueueEntry() {
@@ -107,12 +116,26 @@ void DelayQueueEntry::handleTimeout() {
 
 ///// DelayQueue /////
 
-DelayQueue::DelayQueue()
-  : DelayQueueEntry(ETERNITY) {
+DelayQueue::DelayQueue(Boolean useHeap)
+  : DelayQueueEntry(ETERNITY),
+    fUseHeap(useHeap), fHeap(NULL), fHeapSize(0), fHeapMaxSize(0),
+    fTokenTable(NULL), fTimeToNextAlarm(ETERNITY) {
   fLastSyncTime = TimeNow();
+  if (fUseHeap) fTokenTable = HashTable::create(ONE_WORD_HASH_KEYS);
 }
 
 DelayQueue::~DelayQueue() {
+  if (fUseHeap) {
+    while (fHeapSize > 0) {
+      DelayQueueEntry* entryToRemove = fHeap[fHeapSize-1];
+      removeEntry(entryToRemove);
+      delete entryToRemove;
+    }
+    delete[] fHeap;
+    delete fTokenTable;
+    return;
+  }
+
   while (fNext != this) {
     DelayQueueEntry* entryToRemove = fNext;
     removeEntry(entryToRemove);
@@ -121,6 +144,25 @@ DelayQueue::~DelayQueue() {
 }
 
 void DelayQueue::addEntry(DelayQueueEntry* newEntry) {
+  if (fUseHeap) {
+    // "fDeltaTimeRemaining" holds the requested delay; turn it into a deadline:
+    newEntry->fDeadline = TimeNow();
+    newEntry->fDeadline += newEntry->fDeltaTimeRemaining;
+
+    if (fHeapSize == fHeapMaxSize) {
+      unsigned newMaxSize = fHeapMaxSize == 0 ? 64 : 2*fHeapMaxSize;
+      DelayQueueEntry** newHeap = new DelayQueueEntry*[newMaxSize];
+      for (unsigned i = 0; i < fHeapSize; ++i) newHeap[i] = fHeap[i];
+      delete[] fHeap;
+      fHeap = newHeap;
+      fHeapMaxSize = newMaxSize;
+    }
+    heapSet(fHeapSize++, newEntry);
+    heapSiftUp(newEntry->fHeapIndex);
+    fTokenTable->Add((char const*)(newEntry->token()), newEntry);
+    return;
+  }
+
   synchronize();
 
   DelayQueueEntry* cur = head();
@@ -151,6 +193,22 @@ void DelayQueue::updateEntry(intptr_t tokenToFind, DelayInterval newDelay) {
 }
 
 void DelayQueue::removeEntry(DelayQueueEntry* entry) {
+  if (fUseHeap) {
+    if (entry == NULL || entry->fHeapIndex == NOT_IN_HEAP) return;
+
+    unsigned index = entry->fHeapIndex;
+    fTokenTable->Remove((char const*)(entry->token()));
+    entry->fHeapIndex = NOT_IN_HEAP;
+    if (index != --fHeapSize) {
+      // Move the last entry into the hole, and restore the heap order:
+      DelayQueueEntry* moved = fHeap[fHeapSize];
+      heapSet(index, moved);
+      heapSiftUp(index);
+      heapSiftDown(moved->fHeapIndex);
+    }
+    return;
+  }
+
   if (entry == NULL || entry->fNext == NULL) return;
 
   entry->fNext->fDeltaTimeRemaining += entry->fDeltaTimeRemaining;
@@ -167,6 +225,13 @@ DelayQueueEntry* DelayQueue::removeEntry(intptr_t tokenToFind) {
 }
 
 DelayInterval const& DelayQueue::timeToNextAlarm() {
+  if (fUseHeap) {
+    if (fHeapSize == 0) return ETERNITY;
+
+    fTimeToNextAlarm = fHeap[0]->fDeadline - TimeNow();
+    return fTimeToNextAlarm;
+  }
+
   if (head()->fDeltaTimeRemaining == DELAY_ZERO) return DELAY_ZERO; // a common case
 
   synchronize();
@@ -174,6 +239,17 @@ DelayInterval const& DelayQueue::timeToNextAlarm() {
 }
 
 void DelayQueue::handleAlarm() {
+  if (fUseHeap) {
+    if (fHeapSize == 0 || TimeNow() < fHeap[0]->fDeadline) return;
+
+    // This event is due to be handled:
+    DelayQueueEntry* toRemove = fHeap[0];
+    removeEntry(toRemove); // do this first, in case handler accesses queue
+
+    toRemove->handleTimeout();
+    return;
+  }
+
   if (head()->fDeltaTimeRemaining != DELAY_ZERO) synchronize();
 
   if (head()->fDeltaTimeRemaining == DELAY_ZERO) {
@@ -186,6 +262,10 @@ void DelayQueue::handleAlarm() {
 }
 
 DelayQueueEntry* DelayQueue::findEntryByToken(intptr_t tokenToFind) {
+  if (fUseHeap) {
+    return (DelayQueueEntry*)(fTokenTable->Lookup((char const*)tokenToFind));
+  }
+
   DelayQueueEntry* cur = head();
   while (cur != this) {
     if (cur->token() == tokenToFind) return cur;
@@ -196,6 +276,8 @@ DelayQueueEntry* DelayQueue::findEntryByToken(intptr_t tokenToFind) {
 }
 
 void DelayQueue::synchronize() {
+  if (fUseHeap) return; // deadlines are absolute; nothing to adjust
+
   // First, figure out how much time has elapsed since the last sync:
   EventTime timeNow = TimeNow();
   if (timeNow < fLastSyncTime) {
@@ -216,6 +298,48 @@ void DelayQueue::synchronize() {
   curEntry->fDeltaTimeRemaining -= timeSinceLastSync;
 }
 
+Boolean DelayQueue::heapLess(unsigned i, unsigned j) const {
+  DelayQueueEntry* a = fHeap[i];
+  DelayQueueEntry* b = fHeap[j];
+
+  if (a->fDeadline < b->fDeadline) return True;
+  if (b->fDeadline < a->fDeadline) return False;
+  // Same deadline: the oldest entry first, as the linear queue does:
+  return a->token() < b->token();
+}
+
+void DelayQueue::heapSet(unsigned index, DelayQueueEntry* entry) {
+  fHeap[index] = entry;
+  entry->fHeapIndex = index;
+}
+
+void DelayQueue::heapSiftUp(unsigned index) {
+  while (index > 0) {
+    unsigned parent = (index-1)/2;
+    if (!heapLess(index, parent)) break;
+
+    DelayQueueEntry* tmp = fHeap[parent];
+    heapSet(parent, fHeap[index]);
+    heapSet(index, tmp);
+    index = parent;
+  }
+}
+
+void DelayQueue::heapSiftDown(unsigned index) {
+  while (1) {
+    unsigned smallest = index;
+    unsigned left = 2*index + 1, right = left + 1;
+    if (left < fHeapSize && heapLess(left, smallest)) smallest = left;
+    if (right < fHeapSize && heapLess(right, smallest)) smallest = right;
+    if (smallest == index) break;
+
+    DelayQueueEntry* tmp = fHeap[smallest];
+    heapSet(smallest, fHeap[index]);
+    heapSet(index, tmp);
+    index = smallest;
+  }
+}
+
 
 ///// EventTime /////
 
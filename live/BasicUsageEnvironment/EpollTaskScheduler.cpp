@@ -0,0 +1,228 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2012 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// Implementation of an "epoll()"-based task scheduler
+
+#include "BasicUsageEnvironment.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+////////// EpollTaskScheduler //////////
+
+#if defined(__linux__)
+
+#define MAX_EVENTS_PER_STEP 256
+#define MAX_ALARMS_PER_STEP 64
+    // Once several thousand clients are streaming, most steps find many
+    // sockets ready and many delayed tasks (e.g., RTP packet sends) due, so
+    // we handle a batch of each per "epoll_wait()" rather than just one.
+
+#define MAX_SCHEDULER_GRANULARITY 10000 // 10 milliseconds: We will return to the event loop at least this often
+static void schedulerTickTask(void* clientData) {
+  ((EpollTaskScheduler*)clientData)->scheduleDelayedTask(MAX_SCHEDULER_GRANULARITY, schedulerTickTask, clientData);
+}
+
+EpollTaskScheduler* EpollTaskScheduler::createNew(Boolean useHeapDelayQueue) {
+  int epollFd = epoll_create(1024/*a hint only*/);
+  if (epollFd < 0) return NULL;
+
+  return new EpollTaskScheduler(epollFd, useHeapDelayQueue);
+}
+
+EpollTaskScheduler::EpollTaskScheduler(int epollFd, Boolean useHeapDelayQueue)
+  : BasicTaskScheduler0(useHeapDelayQueue),
+    fEpollFd(epollFd), fSocketTable(NULL), fSocketTableSize(0) {
+  schedulerTickTask(this); // ensures that we handle events frequently
+}
+
+EpollTaskScheduler::~EpollTaskScheduler() {
+  close(fEpollFd);
+  free(fSocketTable);
+}
+
+#ifndef MILLION
+#define MILLION 1000000
+#endif
+
+void EpollTaskScheduler::SingleStep(unsigned maxDelayTime) {
+  DelayInterval const& timeToDelay = fDelayQueue.timeToNextAlarm();
+  // Round up to whole milliseconds, so that we don't wake up just before an alarm is due:
+  long timeoutSecs = timeToDelay.seconds();
+  long timeoutUSecs = timeToDelay.useconds();
+  // Don't make the timeout any larger than 1 million seconds (11.5 days)
+  if (timeoutSecs > MILLION) timeoutSecs = MILLION;
+  // Also check our "maxDelayTime" parameter (if it's > 0):
+  if (maxDelayTime > 0 &&
+      (timeoutSecs > (long)maxDelayTime/MILLION ||
+       (timeoutSecs == (long)maxDelayTime/MILLION &&
+	timeoutUSecs > (long)maxDelayTime%MILLION))) {
+    timeoutSecs = maxDelayTime/MILLION;
+    timeoutUSecs = maxDelayTime%MILLION;
+  }
+  int timeoutMSecs = (int)(timeoutSecs*1000 + (timeoutUSecs+999)/1000);
+
+  struct epoll_event events[MAX_EVENTS_PER_STEP];
+  int numEvents = epoll_wait(fEpollFd, events, MAX_EVENTS_PER_STEP, timeoutMSecs);
+  if (numEvents < 0) {
+    if (errno != EINTR && errno != EAGAIN) {
+      // Unexpected error - treat this as fatal:
+      perror("EpollTaskScheduler::SingleStep(): epoll_wait() fails");
+      internalError();
+    }
+    numEvents = 0;
+  }
+
+  // Note the state of each ready socket before calling any handler, because a handler may
+  // close (and even reuse the number of) another socket that is also in "events":
+  unsigned generations[MAX_EVENTS_PER_STEP];
+  for (int i = 0; i < numEvents; ++i) {
+    int sock = events[i].data.fd;
+    generations[i] = sock < fSocketTableSize ? fSocketTable[sock].generation : 0;
+  }
+
+  for (int i = 0; i < numEvents; ++i) {
+    int sock = events[i].data.fd; // alias
+    if (sock >= fSocketTableSize || fSocketTable[sock].generation != generations[i]) continue;
+
+    SocketHandler& handler = fSocketTable[sock];
+    uint32_t ev = events[i].events;
+    int resultConditionSet = 0;
+    // Like "select()", report errors and hang-ups as readiness, so that the handler finds out:
+    if (ev&(EPOLLIN|EPOLLERR|EPOLLHUP)) resultConditionSet |= SOCKET_READABLE;
+    if (ev&(EPOLLOUT|EPOLLERR|EPOLLHUP)) resultConditionSet |= SOCKET_WRITABLE;
+    if (ev&EPOLLPRI) resultConditionSet |= SOCKET_EXCEPTION;
+    if ((resultConditionSet&handler.conditionSet) != 0 && handler.handlerProc != NULL) {
+      fLastHandledSocketNum = sock;
+      (*handler.handlerProc)(handler.clientData, resultConditionSet&handler.conditionSet);
+    }
+  }
+
+  // Also handle any newly-triggered event (Note that we do this *after* calling socket handlers,
+  // in case the triggered event handler modifies the set of readable sockets.)
+  handleTriggeredEvents();
+
+  // Also handle any delayed events that may have come due.
+  for (unsigned i = 0; i < MAX_ALARMS_PER_STEP; ++i) {
+    fDelayQueue.handleAlarm();
+    if (!(fDelayQueue.timeToNextAlarm() == DELAY_ZERO)) break;
+  }
+}
+
+Boolean EpollTaskScheduler::growSocketTable(int socketNum) {
+  if (socketNum < fSocketTableSize) return True;
+
+  int newSize = fSocketTableSize == 0 ? 1024 : fSocketTableSize;
+  while (newSize <= socketNum) newSize *= 2;
+  SocketHandler* newTable = (SocketHandler*)realloc(fSocketTable, newSize*sizeof (SocketHandler));
+  if (newTable == NULL) return False;
+
+  memset(&newTable[fSocketTableSize], 0, (newSize - fSocketTableSize)*sizeof (SocketHandler));
+  fSocketTable = newTable;
+  fSocketTableSize = newSize;
+  return True;
+}
+
+static uint32_t epollEventsFor(int conditionSet) {
+  uint32_t events = 0;
+  if (conditionSet&SOCKET_READABLE) events |= EPOLLIN;
+  if (conditionSet&SOCKET_WRITABLE) events |= EPOLLOUT;
+  if (conditionSet&SOCKET_EXCEPTION) events |= EPOLLPRI;
+  return events;
+}
+
+void EpollTaskScheduler
+  ::setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData) {
+  if (socketNum < 0) return;
+  if (!growSocketTable(socketNum)) {
+    internalError();
+    return;
+  }
+
+  SocketHandler& handler = fSocketTable[socketNum];
+  Boolean wasRegistered = handler.conditionSet != 0;
+  ++handler.generation;
+
+  if (conditionSet == 0) {
+    if (wasRegistered) {
+      struct epoll_event ev; // ignored, but required by older kernels
+      memset(&ev, 0, sizeof ev);
+      epoll_ctl(fEpollFd, EPOLL_CTL_DEL, socketNum, &ev);
+    }
+    handler.conditionSet = 0;
+    handler.handlerProc = NULL;
+    handler.clientData = NULL;
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof ev);
+  ev.events = epollEventsFor(conditionSet);
+  ev.data.fd = socketNum;
+  if (epoll_ctl(fEpollFd, wasRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, socketNum, &ev) < 0) {
+    // The socket may have been closed (and its number reused) without its handling being turned off:
+    if (errno == ENOENT) epoll_ctl(fEpollFd, EPOLL_CTL_ADD, socketNum, &ev);
+    else if (errno == EEXIST) epoll_ctl(fEpollFd, EPOLL_CTL_MOD, socketNum, &ev);
+  }
+  handler.conditionSet = conditionSet;
+  handler.handlerProc = handlerProc;
+  handler.clientData = clientData;
+}
+
+void EpollTaskScheduler::moveSocketHandling(int oldSocketNum, int newSocketNum) {
+  if (oldSocketNum < 0 || newSocketNum < 0) return; // sanity check
+  if (oldSocketNum >= fSocketTableSize) return;
+
+  SocketHandler handler = fSocketTable[oldSocketNum];
+  setBackgroundHandling(oldSocketNum, 0, NULL, NULL);
+  setBackgroundHandling(newSocketNum, handler.conditionSet, handler.handlerProc, handler.clientData);
+}
+
+#else
+
+EpollTaskScheduler* EpollTaskScheduler::createNew(Boolean /*useHeapDelayQueue*/) {
+  return NULL; // "epoll()" is Linux-specific
+}
+
+EpollTaskScheduler::EpollTaskScheduler(int epollFd, Boolean useHeapDelayQueue)
+  : BasicTaskScheduler0(useHeapDelayQueue),
+    fEpollFd(epollFd), fSocketTable(NULL), fSocketTableSize(0) {
+}
+
+EpollTaskScheduler::~EpollTaskScheduler() {
+}
+
+void EpollTaskScheduler::SingleStep(unsigned /*maxDelayTime*/) {
+}
+
+void EpollTaskScheduler
+  ::setBackgroundHandling(int /*socketNum*/, int /*conditionSet*/, BackgroundHandlerProc* /*handlerProc*/, void* /*clientData*/) {
+}
+
+void EpollTaskScheduler::moveSocketHandling(int /*oldSocketNum*/, int /*newSocketNum*/) {
+}
+
+Boolean EpollTaskScheduler::growSocketTable(int /*socketNum*/) {
+  return False;
+}
+
+#endif
@@ -46,11 +46,11 @@ protected:
 
 class BasicTaskScheduler: public BasicTaskScheduler0 {
 public:
-  static BasicTaskScheduler* createNew();
+  static BasicTaskScheduler* createNew(Boolean useHeapDelayQueue = False);
   virtual ~BasicTaskScheduler();
 
 protected:
-  BasicTaskScheduler();
+  BasicTaskScheduler(Boolean useHeapDelayQueue);
       // called only by "createNew()"
 
 protected:
@@ -68,4 +68,41 @@ protected:
   fd_set fExceptionSet;
 };
 
+
+// A task scheduler that uses Linux "epoll()" instead of "select()", and so is
+// not limited to FD_SETSIZE sockets, and does not copy (or scan) socket sets
+// on each step.  It is intended for servers with many concurrent clients.
+class EpollTaskScheduler: public BasicTaskScheduler0 {
+public:
+  static EpollTaskScheduler* createNew(Boolean useHeapDelayQueue = True);
+      // Returns NULL if "epoll()" is not available (in which case the caller
+      // should fall back to "BasicTaskScheduler")
+  virtual ~EpollTaskScheduler();
+
+protected:
+  EpollTaskScheduler(int epollFd, Boolean useHeapDelayQueue);
+      // called only by "createNew()"
+
+protected:
+  // Redefined virtual functions:
+  virtual void SingleStep(unsigned maxDelayTime);
+
+  virtual void setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData);
+  virtual void moveSocketHandling(int oldSocketNum, int newSocketNum);
+
+private:
+  struct SocketHandler {
+    int conditionSet;
+    BackgroundHandlerProc* handlerProc;
+    void* clientData;
+    unsigned generation; // changed each time the socket's handling changes
+  };
+  Boolean growSocketTable(int socketNum);
+
+private:
+  int fEpollFd;
+  SocketHandler* fSocketTable; // indexed by socket number
+  int fSocketTableSize;
+};
+
 #endif
@@ -93,7 +93,10 @@ public:
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
 
 protected:
-  BasicTaskScheduler0();
+  BasicTaskScheduler0(Boolean useHeapDelayQueue = False);
+
+  void handleTriggeredEvents();
+      // called by "SingleStep()" implementations, once per step
 
 protected:
   // To implement delayed operations:
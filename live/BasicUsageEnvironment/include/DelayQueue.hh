@@ -23,6 +23,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _NET_COMMON_H
 #include "NetCommon.h"
 #endif
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
 
 #ifdef TIME_BASE
 typedef TIME_BASE time_base_seconds;
@@ -151,15 +154,26 @@ private:
   DelayQueueEntry* fPrev;
   DelayInterval fDeltaTimeRemaining;
 
+  // Used instead of the above when the queue is a binary heap:
+  EventTime fDeadline;
+  unsigned fHeapIndex;
+
   intptr_t fToken;
   static intptr_t tokenCounter;
 };
 
 ///// DelayQueue /////
 
+class HashTable; // forward
+
 class DelayQueue: public DelayQueueEntry {
 public:
-  DelayQueue();
+  DelayQueue(Boolean useHeap = False);
+      // If "useHeap" is True, entries are kept in a binary heap ordered by
+      // absolute deadline, with a token -> entry hash table, rather than in
+      // a linear list of time deltas.  Adding, removing or rescheduling an
+      // entry is then O(log n) instead of O(n), which matters once there are
+      // thousands of pending tasks (e.g., one per RTSP client session).
   virtual ~DelayQueue();
 
   void addEntry(DelayQueueEntry* newEntry); // returns a token for the entry
@@ -177,6 +191,19 @@ private:
   void synchronize(); // bring the 'time remaining' fields up-to-date
 
   EventTime fLastSyncTime;
+
+private:
+  // Binary heap implementation:
+  Boolean heapLess(unsigned i, unsigned j) const;
+  void heapSet(unsigned index, DelayQueueEntry* entry);
+  void heapSiftUp(unsigned index);
+  void heapSiftDown(unsigned index);
+
+  Boolean fUseHeap;
+  DelayQueueEntry** fHeap;
+  unsigned fHeapSize, fHeapMaxSize;
+  HashTable* fTokenTable;
+  DelayInterval fTimeToNextAlarm;
 };
 
 #endif
@@ -26,6 +26,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <sstream>
 #endif
 #include <stdio.h>
+#if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
+#else
+#include <pthread.h>
+#endif
 
 ///////// OutputSocket //////////
 
@@ -70,6 +74,34 @@ Boolean OutputSocket::write(netAddressBits address, Port port, u_int8_t ttl,
   return True;
 }
 
+Boolean OutputSocket::write(netAddressBits address, Port port, u_int8_t ttl,
+			    packetPieces const* datagrams, unsigned numDatagrams) {
+  if (ttl == fLastSentTTL) {
+    // Optimization: So we don't do a 'set TTL' system call again
+    ttl = 0;
+  } else {
+    fLastSentTTL = ttl;
+  }
+  struct in_addr destAddr; destAddr.s_addr = address;
+  if (!writeSocket(env(), socketNum(), destAddr, port, ttl,
+		   datagrams, numDatagrams))
+    return False;
+
+  if (sourcePortNum() == 0) {
+    // Now that we've sent a packet, we can find out what the
+    // kernel chose as our ephemeral source port number:
+    if (!getSourcePort(env(), socketNum(), fSourcePort)) {
+      if (DebugLevel >= 1)
+	env() << *this
+	     << ": failed to get source port: "
+	     << env().getResultMsg() << "\n";
+      return False;
+    }
+  }
+
+  return True;
+}
+
 // By default, we don't do reads:
 Boolean OutputSocket
 ::handleRead(unsigned char* /*buffer*/, unsigned /*bufferMaxSize*/,
@@ -98,6 +130,20 @@ NetInterfaceTrafficStats Groupsock::statsOutgoing;
 NetInterfaceTrafficStats Groupsock::statsRelayedIncoming;
 NetInterfaceTrafficStats Groupsock::statsRelayedOutgoing;
 
+// The static statistics are shared by every "UsageEnvironment" - and so by every thread that runs one
+// (e.g., each "RTSPServerWorkerPool" worker) - so are updated under a lock:
+static void countSharedPacket(NetInterfaceTrafficStats& stats, unsigned packetSize) {
+#if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
+  stats.countPacket(packetSize);
+#else
+  static pthread_mutex_t statsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+  pthread_mutex_lock(&statsMutex);
+  stats.countPacket(packetSize);
+  pthread_mutex_unlock(&statsMutex);
+#endif
+}
+
 // Constructor for a source-independent multicast group
 Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
 		     Port port, u_int8_t ttl)
@@ -261,7 +307,7 @@ Boolean Groupsock::output(UsageEnvironment& env, u_int8_t ttlToSend,
       }
     }
     if (!writeSuccess) break;
-    statsOutgoing.countPacket(bufferSize);
+    countSharedPacket(statsOutgoing, bufferSize);
     statsGroupOutgoing.countPacket(bufferSize);
 
     // Then, forward to our members:
@@ -291,6 +337,68 @@ Boolean Groupsock::output(UsageEnvironment& env, u_int8_t ttlToSend,
   return False;
 }
 
+Boolean Groupsock::output(UsageEnvironment& env, u_int8_t ttlToSend,
+			  packetPieces const* datagrams, unsigned numDatagrams,
+			  DirectedNetInterface* interfaceNotToFwdBackTo) {
+  do {
+    // First, do the datagram sends, to each destination:
+    Boolean writeSuccess = True;
+    for (destRecord* dests = fDests; dests != NULL; dests = dests->fNext) {
+      if (!write(dests->fGroupEId.groupAddress().s_addr, dests->fPort, ttlToSend,
+		 datagrams, numDatagrams)) {
+	writeSuccess = False;
+	break;
+      }
+    }
+    if (!writeSuccess) break;
+
+    unsigned totalSize = 0;
+    for (unsigned i = 0; i < numDatagrams; ++i) {
+      unsigned size = datagrams[i].totalSize();
+      countSharedPacket(statsOutgoing, size);
+      statsGroupOutgoing.countPacket(size);
+      totalSize += size;
+    }
+
+    // Then, forward to our members.  (This is rare, so we just copy each datagram into a single buffer.)
+    int numMembers = 0;
+    if (!members().IsEmpty()) {
+      unsigned char buffer[65536];
+      unsigned const maxPacketSize = sizeof buffer;
+      for (unsigned i = 0; i < numDatagrams; ++i) {
+	unsigned size = 0;
+	for (unsigned j = 0; j < datagrams[i].numPieces && size < maxPacketSize; ++j) {
+	  unsigned pieceSize = datagrams[i].pieceSize[j];
+	  if (pieceSize > maxPacketSize - size) pieceSize = maxPacketSize - size;
+	  memcpy(&buffer[size], datagrams[i].piece[j], pieceSize);
+	  size += pieceSize;
+	}
+	numMembers =
+	  outputToAllMembersExcept(interfaceNotToFwdBackTo,
+				   ttlToSend, buffer, size,
+				   ourIPAddress(env));
+	if (numMembers < 0) break;
+      }
+      if (numMembers < 0) break;
+    }
+
+    if (DebugLevel >= 3) {
+      env << *this << ": wrote " << numDatagrams << " packets (" << totalSize << " bytes), ttl "
+	  << (unsigned)ttlToSend;
+      if (numMembers > 0) {
+	env << "; relayed to " << numMembers << " members";
+      }
+      env << "\n";
+    }
+    return True;
+  } while (0);
+
+  if (DebugLevel >= 0) { // this is a fatal error
+    env.setResultMsg("Groupsock write failed: ", env.getResultMsg());
+  }
+  return False;
+}
+
 Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 			      unsigned& bytesRead,
 			      struct sockaddr_in& fromAddress) {
@@ -323,14 +431,14 @@ Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 
   int numMembers = 0;
   if (!wasLoopedBackFromUs(env(), fromAddress)) {
-    statsIncoming.countPacket(numBytes);
+    countSharedPacket(statsIncoming, numBytes);
     statsGroupIncoming.countPacket(numBytes);
     numMembers =
       outputToAllMembersExcept(NULL, ttl(),
 			       buffer, bytesRead,
 			       fromAddress.sin_addr.s_addr);
     if (numMembers > 0) {
-      statsRelayedIncoming.countPacket(numBytes);
+      countSharedPacket(statsRelayedIncoming, numBytes);
       statsGroupRelayedIncoming.countPacket(numBytes);
     }
   }
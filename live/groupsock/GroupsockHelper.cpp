@@ -27,7 +27,11 @@ extern "C" int initializeWinsockIfNecessary();
 #include <stdarg.h>
 #include <time.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #define initializeWinsockIfNecessary() 1
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+#define HAVE_SENDMMSG 1
+#endif
 #endif
 #include <stdio.h>
 
@@ -297,6 +301,22 @@ int readSocket(UsageEnvironment& env,
   return bytesRead;
 }
 
+static Boolean setMulticastTTL(UsageEnvironment& env, int socket, u_int8_t ttlArg) {
+#if defined(__WIN32__) || defined(_WIN32)
+#define TTL_TYPE int
+#else
+#define TTL_TYPE u_int8_t
+#endif
+  TTL_TYPE ttl = (TTL_TYPE)ttlArg;
+  if (setsockopt(socket, IPPROTO_IP, IP_MULTICAST_TTL,
+		 (const char*)&ttl, sizeof ttl) < 0) {
+    socketErr(env, "setsockopt(IP_MULTICAST_TTL) error: ");
+    return False;
+  }
+
+  return True;
+}
+
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, Port port,
 		    u_int8_t ttlArg,
@@ -304,17 +324,7 @@ Boolean writeSocket(UsageEnvironment& env,
 	do {
 		if (ttlArg != 0) {
 			// Before sending, set the socket's TTL:
-#if defined(__WIN32__) || defined(_WIN32)
-#define TTL_TYPE int
-#else
-#define TTL_TYPE u_int8_t
-#endif
-			TTL_TYPE ttl = (TTL_TYPE)ttlArg;
-			if (setsockopt(socket, IPPROTO_IP, IP_MULTICAST_TTL,
-				       (const char*)&ttl, sizeof ttl) < 0) {
-				socketErr(env, "setsockopt(IP_MULTICAST_TTL) error: ");
-				break;
-			}
+			if (!setMulticastTTL(env, socket, ttlArg)) break;
 		}
 
 		MAKE_SOCKADDR_IN(dest, address.s_addr, port.num());
@@ -333,6 +343,113 @@ Boolean writeSocket(UsageEnvironment& env,
 	return False;
 }
 
+#if defined(__WIN32__) || defined(_WIN32)
+// Windows has no "sendmsg()", so we gather the pieces into a buffer, and send that:
+static unsigned gatherPieces(packetPieces const& data, unsigned char* buffer, unsigned bufferSize) {
+  unsigned size = 0;
+  for (unsigned i = 0; i < data.numPieces; ++i) {
+    unsigned pieceSize = data.pieceSize[i];
+    if (pieceSize > bufferSize - size) pieceSize = bufferSize - size; // shouldn't happen
+    memcpy(&buffer[size], data.piece[i], pieceSize);
+    size += pieceSize;
+  }
+  return size;
+}
+#else
+static void setUpIOVecs(packetPieces const& data, struct iovec* iov) {
+  for (unsigned i = 0; i < data.numPieces; ++i) {
+    iov[i].iov_base = (void*)data.piece[i];
+    iov[i].iov_len = data.pieceSize[i];
+  }
+}
+#endif
+
+#define MAX_DATAGRAMS_PER_SYSTEM_CALL 64
+
+Boolean writeSocket(UsageEnvironment& env,
+		    int socket, struct in_addr address, Port port,
+		    u_int8_t ttlArg,
+		    packetPieces const* datagrams, unsigned numDatagrams) {
+  if (ttlArg != 0) {
+    // Before sending, set the socket's TTL:
+    if (!setMulticastTTL(env, socket, ttlArg)) return False;
+  }
+
+  MAKE_SOCKADDR_IN(dest, address.s_addr, port.num());
+  while (numDatagrams > 0) {
+    unsigned numToSend = numDatagrams < MAX_DATAGRAMS_PER_SYSTEM_CALL ? numDatagrams : MAX_DATAGRAMS_PER_SYSTEM_CALL;
+    int numSent;
+#if defined(__WIN32__) || defined(_WIN32)
+    unsigned char buffer[65536];
+    unsigned size = gatherPieces(datagrams[0], buffer, sizeof buffer);
+    numSent = sendto(socket, (char*)buffer, size, 0, (struct sockaddr*)&dest, sizeof dest) == (int)size ? 1 : -1;
+#else
+    struct iovec iov[MAX_DATAGRAMS_PER_SYSTEM_CALL][MAX_PACKET_PIECES];
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[MAX_DATAGRAMS_PER_SYSTEM_CALL];
+    memset(msgs, 0, numToSend*sizeof msgs[0]);
+    for (unsigned i = 0; i < numToSend; ++i) {
+      setUpIOVecs(datagrams[i], iov[i]);
+      msgs[i].msg_hdr.msg_name = &dest;
+      msgs[i].msg_hdr.msg_namelen = sizeof dest;
+      msgs[i].msg_hdr.msg_iov = iov[i];
+      msgs[i].msg_hdr.msg_iovlen = datagrams[i].numPieces;
+    }
+    numSent = sendmmsg(socket, msgs, numToSend, 0);
+    if (numSent < 0 && errno == ENOSYS) // the kernel is older than the C library; send just one datagram instead:
+#endif
+    {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof msg);
+      setUpIOVecs(datagrams[0], iov[0]);
+      msg.msg_name = &dest;
+      msg.msg_namelen = sizeof dest;
+      msg.msg_iov = iov[0];
+      msg.msg_iovlen = datagrams[0].numPieces;
+      numSent = sendmsg(socket, &msg, 0) == (int)datagrams[0].totalSize() ? 1 : -1;
+    }
+#endif
+    if (numSent <= 0) {
+      char tmpBuf[100];
+      sprintf(tmpBuf, "writeSocket(%d), failed to send %u datagram(s): ", socket, numDatagrams);
+      socketErr(env, tmpBuf);
+      return False;
+    }
+
+    datagrams += numSent;
+    numDatagrams -= numSent;
+  }
+
+  return True;
+}
+
+int writeStreamSocket(UsageEnvironment& env, int socket, packetPieces const& data) {
+  int bytesSent;
+#if defined(__WIN32__) || defined(_WIN32)
+  unsigned char buffer[65536+4];
+  unsigned size = gatherPieces(data, buffer, sizeof buffer);
+  bytesSent = send(socket, (char*)buffer, size, 0);
+#else
+  struct iovec iov[MAX_PACKET_PIECES];
+  setUpIOVecs(data, iov);
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = data.numPieces;
+  bytesSent = sendmsg(socket, &msg, 0);
+#endif
+  if (bytesSent < 0) {
+    int err = env.getErrno();
+    if (err == EAGAIN || err == EWOULDBLOCK) {
+      // The (non-blocking) socket's send buffer is full:
+      return 0;
+    }
+    socketErr(env, "writeStreamSocket(): send() error: ");
+  }
+
+  return bytesSent;
+}
+
 static unsigned getBufferSize(UsageEnvironment& env, int bufOptName,
 			      int socket) {
   unsigned curSize;
@@ -33,6 +33,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "GroupEId.hh"
 #endif
 
+struct packetPieces; // defined in "GroupsockHelper.hh"
+
 // An "OutputSocket" is (by default) used only to send packets.
 // No packets are received on it (unless a subclass arranges this)
 
@@ -43,6 +45,9 @@ public:
 
   Boolean write(netAddressBits address, Port port, u_int8_t ttl,
 		unsigned char* buffer, unsigned bufferSize);
+  Boolean write(netAddressBits address, Port port, u_int8_t ttl,
+		packetPieces const* datagrams, unsigned numDatagrams);
+      // sends several datagrams (each gathered from pieces) at once
 
 protected:
   OutputSocket(UsageEnvironment& env, Port port);
@@ -119,6 +124,11 @@ public:
   Boolean output(UsageEnvironment& env, u_int8_t ttl,
 		 unsigned char* buffer, unsigned bufferSize,
 		 DirectedNetInterface* interfaceNotToFwdBackTo = NULL);
+  Boolean output(UsageEnvironment& env, u_int8_t ttl,
+		 packetPieces const* datagrams, unsigned numDatagrams,
+		 DirectedNetInterface* interfaceNotToFwdBackTo = NULL);
+      // Like the above, but outputs several datagrams - each made up of separate pieces - at once,
+      // without first copying each one into a single buffer.
 
   DirectedNetInterfaceSet& members() { return fMembers; }
 
@@ -38,6 +38,37 @@ Boolean writeSocket(UsageEnvironment& env,
 		    u_int8_t ttlArg,
 		    unsigned char* buffer, unsigned bufferSize);
 
+// A packet that is made up of several separate pieces of data (e.g., a header, followed by payload
+// data that's referenced in place), and that can be sent without first being copied together:
+#define MAX_PACKET_PIECES 4
+struct packetPieces {
+  unsigned numPieces;
+  unsigned char const* piece[MAX_PACKET_PIECES];
+  unsigned pieceSize[MAX_PACKET_PIECES];
+
+  void reset() { numPieces = 0; }
+  void add(unsigned char const* data, unsigned size) {
+    piece[numPieces] = data; pieceSize[numPieces] = size; ++numPieces;
+  }
+  unsigned totalSize() const {
+    unsigned result = 0;
+    for (unsigned i = 0; i < numPieces; ++i) result += pieceSize[i];
+    return result;
+  }
+};
+
+Boolean writeSocket(UsageEnvironment& env,
+		    int socket, struct in_addr address, Port port,
+		    u_int8_t ttlArg,
+		    packetPieces const* datagrams, unsigned numDatagrams);
+    // Sends each of "datagrams" (gathered from its pieces) to the same destination.
+    // (Where possible, this is done using a single "sendmmsg()" system call.)
+
+int writeStreamSocket(UsageEnvironment& env, int socket, packetPieces const& data);
+    // Writes "data" (gathered from its pieces) to a (connected) stream socket, using a single system call.
+    // Returns the number of bytes written - which, for a non-blocking socket, may be less than
+    // the size of "data" (or 0, if its send buffer is full) - or -1 on error.
+
 unsigned getSendBufferSize(UsageEnvironment& env, int socket);
 unsigned getReceiveBufferSize(UsageEnvironment& env, int socket);
 unsigned setSendBufferTo(UsageEnvironment& env,
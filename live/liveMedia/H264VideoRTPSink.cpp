@@ -53,7 +53,8 @@ Boolean H264VideoRTPSink::continuePlaying() {
   // If not, create it now:
   if (fOurFragmenter == NULL) {
     fOurFragmenter = new H264FUAFragmenter(envir(), fSource, OutPacketBuffer::maxSize,
-					   ourMaxPacketSize() - 12/*RTP hdr size*/);
+					   ourMaxPacketSize() - 12/*RTP hdr size*/,
+					   True/*we send fragments from its buffer*/);
     fSource = fOurFragmenter;
   }
 
@@ -97,6 +98,15 @@ Boolean H264VideoRTPSink
   return False;
 }
 
+unsigned char const* H264VideoRTPSink
+::frameDataInPlace(unsigned& numBytesInPlace, Boolean& isKeptForNextFrame) {
+  if (fOurFragmenter == NULL) return MultiFramedRTPSink::frameDataInPlace(numBytesInPlace, isKeptForNextFrame);
+
+  // Our fragmenter overwrites its buffer only when it reads a new NAL unit:
+  isKeptForNextFrame = !fOurFragmenter->lastFragmentCompletedNALUnit();
+  return fOurFragmenter->fragmentDataInPlace(numBytesInPlace);
+}
+
 char const* H264VideoRTPSink::auxSDPLine() {
   // Generate a new "a=fmtp:" line each time, using parameters from
   // our framer source (in case they've changed since the last time that
@@ -146,11 +156,13 @@ char const* H264VideoRTPSink::auxSDPLine() {
 H264FUAFragmenter::H264FUAFragmenter(UsageEnvironment& env,
 				     FramedSource* inputSource,
 				     unsigned inputBufferMax,
-				     unsigned maxOutputPacketSize)
+				     unsigned maxOutputPacketSize,
+				     Boolean leaveFragmentsInPlace)
   : FramedFilter(env, inputSource),
     fInputBufferSize(inputBufferMax+1), fMaxOutputPacketSize(maxOutputPacketSize),
     fNumValidDataBytes(1), fCurDataOffset(1), fSaveNumTruncatedBytes(0),
-    fLastFragmentCompletedNALUnit(True) {
+    fLastFragmentCompletedNALUnit(True), fLeaveFragmentsInPlace(leaveFragmentsInPlace),
+    fDataInPlace(NULL), fNumBytesInPlace(0) {
   fInputBuffer = new unsigned char[fInputBufferSize];
 }
 
@@ -160,6 +172,7 @@ H264FUAFragmenter::~H264FUAFragmenter() {
 }
 
 void H264FUAFragmenter::doGetNextFrame() {
+  fDataInPlace = NULL; fNumBytesInPlace = 0;
   if (fNumValidDataBytes == 1) {
     // We have no NAL unit data currently in the buffer.  Read a new one:
     fInputSource->getNextFrame(&fInputBuffer[1], fInputBufferSize - 1,
@@ -195,7 +208,13 @@ void H264FUAFragmenter::doGetNextFrame() {
 	// of the packet (reusing the existing NAL header byte for the FU header).
 	fInputBuffer[0] = (fInputBuffer[1] & 0xE0) | 28; // FU indicator
 	fInputBuffer[1] = 0x80 | (fInputBuffer[1] & 0x1F); // FU header (with S bit)
-	memmove(fTo, fInputBuffer, fMaxSize);
+	if (fLeaveFragmentsInPlace) {
+	  // Deliver just the two header bytes; the rest of the fragment is sent from our buffer:
+	  fTo[0] = fInputBuffer[0]; fTo[1] = fInputBuffer[1];
+	  fDataInPlace = &fInputBuffer[2]; fNumBytesInPlace = fMaxSize - 2;
+	} else {
+	  memmove(fTo, fInputBuffer, fMaxSize);
+	}
 	fFrameSize = fMaxSize;
 	fCurDataOffset += fMaxSize - 1;
 	fLastFragmentCompletedNALUnit = False;
@@ -206,8 +225,11 @@ void H264FUAFragmenter::doGetNextFrame() {
       // FU indicator and FU header bytes to the front.  (We reuse these bytes that
       // we already sent for the first fragment, but clear the S bit, and add the E
       // bit if this is the last fragment.)
-      fInputBuffer[fCurDataOffset-2] = fInputBuffer[0]; // FU indicator
-      fInputBuffer[fCurDataOffset-1] = fInputBuffer[1]&~0x80; // FU header (no S bit)
+      // (When fragments are left in place, the two header bytes are written to "fTo" instead of in
+      // front of the fragment, because that's where the end of the previous fragment still is.)
+      unsigned char* fuHeader = fLeaveFragmentsInPlace ? fTo : &fInputBuffer[fCurDataOffset-2];
+      fuHeader[0] = fInputBuffer[0]; // FU indicator
+      fuHeader[1] = fInputBuffer[1]&~0x80; // FU header (no S bit)
       unsigned numBytesToSend = 2 + fNumValidDataBytes - fCurDataOffset;
       if (numBytesToSend > fMaxSize) {
 	// We can't send all of the remaining data this time:
@@ -215,10 +237,14 @@ void H264FUAFragmenter::doGetNextFrame() {
 	fLastFragmentCompletedNALUnit = False;
       } else {
 	// This is the last fragment:
-	fInputBuffer[fCurDataOffset-1] |= 0x40; // set the E bit in the FU header
+	fuHeader[1] |= 0x40; // set the E bit in the FU header
 	fNumTruncatedBytes = fSaveNumTruncatedBytes;
       }
-      memmove(fTo, &fInputBuffer[fCurDataOffset-2], numBytesToSend);
+      if (fLeaveFragmentsInPlace) {
+	fDataInPlace = &fInputBuffer[fCurDataOffset]; fNumBytesInPlace = numBytesToSend - 2;
+      } else {
+	memmove(fTo, &fInputBuffer[fCurDataOffset-2], numBytesToSend);
+      }
       fFrameSize = numBytesToSend;
       fCurDataOffset += numBytesToSend - 2;
     }
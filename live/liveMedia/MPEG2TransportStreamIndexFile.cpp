@@ -23,21 +23,137 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MPEG2TransportStreamIndexFile.hh"
 #include "InputFile.hh"
+#include <string.h>
+
+#if defined(__WIN32__) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+////////// MPEG2TransportStreamIndexFile::IndexRecords //////////
+
+// An index file is read into memory just once, and its contents are then shared - read-only, and
+// reference-counted - by every "MPEG2TransportStreamIndexFile" that uses it (even if these are in
+// different threads (see "RTSPServerWorkerPool")).
+
+class MPEG2TransportStreamIndexFile::IndexRecords {
+public:
+  static IndexRecords* lookupOrLoad(UsageEnvironment& env, char const* indexFileName);
+  void release();
+
+  unsigned long numRecords() const { return fNumRecords; }
+  unsigned char const* record(unsigned long recordNum) const { return &fData[recordNum*INDEX_RECORD_SIZE]; }
+
+private:
+  IndexRecords(char const* indexFileName, u_int64_t fileSize);
+  ~IndexRecords();
+
+private:
+  static IndexRecords* allIndexRecords; // those that are currently in use (protected by "indexRecordsLock")
+  IndexRecords* fNext; // in "allIndexRecords"
+  unsigned fReferenceCount;
+  char* fFileName;
+  u_int64_t fFileSize;
+  unsigned char* fData;
+  unsigned long fNumRecords;
+};
+
+MPEG2TransportStreamIndexFile::IndexRecords* MPEG2TransportStreamIndexFile::IndexRecords::allIndexRecords = NULL;
+
+#if defined(__WIN32__) || defined(_WIN32)
+static class IndexRecordsLock {
+public:
+  IndexRecordsLock() { InitializeCriticalSection(&fCriticalSection); }
+  ~IndexRecordsLock() { DeleteCriticalSection(&fCriticalSection); }
+  void lock() { EnterCriticalSection(&fCriticalSection); }
+  void unlock() { LeaveCriticalSection(&fCriticalSection); }
+private:
+  CRITICAL_SECTION fCriticalSection;
+} indexRecordsLock;
+#else
+static class IndexRecordsLock {
+public:
+  void lock() { pthread_mutex_lock(&fMutex); }
+  void unlock() { pthread_mutex_unlock(&fMutex); }
+  pthread_mutex_t fMutex;
+} indexRecordsLock = { PTHREAD_MUTEX_INITIALIZER };
+#endif
+
+MPEG2TransportStreamIndexFile::IndexRecords*
+MPEG2TransportStreamIndexFile::IndexRecords::lookupOrLoad(UsageEnvironment& env, char const* indexFileName) {
+  u_int64_t indexFileSize = GetFileSize(indexFileName, NULL);
+  if (indexFileSize < INDEX_RECORD_SIZE) return NULL; // the index file is empty or non-existent
+
+  indexRecordsLock.lock();
+
+  // If the file is already in use - and it hasn't changed size since it was read - then share it.
+  // (An index file that's still being written will be read again; those who read it earlier
+  //  keep their older - shorter - copy until they're done with it.)
+  IndexRecords* records;
+  for (records = allIndexRecords; records != NULL; records = records->fNext) {
+    if (strcmp(records->fFileName, indexFileName) == 0 && records->fFileSize == indexFileSize) break;
+  }
+
+  if (records != NULL) {
+    ++records->fReferenceCount;
+  } else {
+    if (indexFileSize % INDEX_RECORD_SIZE != 0) {
+      env << "Warning: Size of the index file \"" << indexFileName
+	  << "\" (" << (unsigned)indexFileSize
+	  << ") is not a multiple of the index record size ("
+	  << INDEX_RECORD_SIZE << ")\n";
+    }
+
+    records = new IndexRecords(indexFileName, indexFileSize);
+    FILE* fid = OpenInputFile(env, indexFileName);
+    if (fid == NULL
+	|| fread(records->fData, INDEX_RECORD_SIZE, records->fNumRecords, fid) != records->fNumRecords) {
+      delete records;
+      records = NULL;
+    } else {
+      records->fNext = allIndexRecords;
+      allIndexRecords = records;
+    }
+    if (fid != NULL) CloseInputFile(fid);
+  }
+
+  indexRecordsLock.unlock();
+  return records;
+}
+
+void MPEG2TransportStreamIndexFile::IndexRecords::release() {
+  indexRecordsLock.lock();
+
+  if (--fReferenceCount == 0) {
+    IndexRecords** ptr = &allIndexRecords;
+    while (*ptr != this) ptr = &(*ptr)->fNext;
+    *ptr = fNext;
+    delete this;
+  }
+
+  indexRecordsLock.unlock();
+}
+
+MPEG2TransportStreamIndexFile::IndexRecords::IndexRecords(char const* indexFileName, u_int64_t fileSize)
+  : fNext(NULL), fReferenceCount(1), fFileName(strDup(indexFileName)), fFileSize(fileSize), fData(NULL),
+    fNumRecords((unsigned long)(fileSize/INDEX_RECORD_SIZE)) {
+  fData = new unsigned char[fNumRecords*INDEX_RECORD_SIZE];
+}
+
+MPEG2TransportStreamIndexFile::IndexRecords::~IndexRecords() {
+  delete[] fData;
+  delete[] fFileName;
+}
+
+////////// MPEG2TransportStreamIndexFile //////////
 
 MPEG2TransportStreamIndexFile
 ::MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName)
   : Medium(env),
-    fFileName(strDup(indexFileName)), fFid(NULL), fMPEGVersion(0), fCurrentIndexRecordNum(0),
+    fIndexRecords(IndexRecords::lookupOrLoad(env, indexFileName)), fMPEGVersion(0),
     fCachedPCR(0.0f), fCachedTSPacketNumber(0), fNumIndexRecords(0) {
-  // Get the file size, to determine how many index records it contains:
-  u_int64_t indexFileSize = GetFileSize(indexFileName, NULL);
-  if (indexFileSize % INDEX_RECORD_SIZE != 0) {
-    env << "Warning: Size of the index file \"" << indexFileName
- 	<< "\" (" << (unsigned)indexFileSize
-	<< ") is not a multiple of the index record size ("
-	<< INDEX_RECORD_SIZE << ")\n";
-  }
-  fNumIndexRecords = (unsigned long)(indexFileSize/INDEX_RECORD_SIZE);
+  if (fIndexRecords != NULL) fNumIndexRecords = fIndexRecords->numRecords();
 }
 
 MPEG2TransportStreamIndexFile* MPEG2TransportStreamIndexFile
@@ -56,8 +172,7 @@ MPEG2TransportStreamIndexFile* MPEG2TransportStreamIndexFile
 }
 
 MPEG2TransportStreamIndexFile::~MPEG2TransportStreamIndexFile() {
-  closeFid();
-  delete[] fFileName;
+  if (fIndexRecords != NULL) fIndexRecords->release();
 }
 
 void MPEG2TransportStreamIndexFile
@@ -122,7 +237,6 @@ void MPEG2TransportStreamIndexFile
     npt = 0.0f;
     tsPacketNumber = indexRecordNumber = 0;
   }
-  closeFid();
 }
 
 void MPEG2TransportStreamIndexFile
@@ -192,7 +306,6 @@ void MPEG2TransportStreamIndexFile
     pcr = 0.0f;
     indexRecordNumber = 0;
   }
-  closeFid();
 }
 
 Boolean MPEG2TransportStreamIndexFile
@@ -210,7 +323,7 @@ Boolean MPEG2TransportStreamIndexFile
 }
 
 float MPEG2TransportStreamIndexFile::getPlayingDuration() {
-  if (fNumIndexRecords == 0 || !readOneIndexRecord(fNumIndexRecords-1)) return 0.0f;
+  if (fNumIndexRecords == 0 || !readIndexRecord(fNumIndexRecords-1)) return 0.0f;
 
   return pcrFromBuf();
 }
@@ -219,56 +332,17 @@ int MPEG2TransportStreamIndexFile::mpegVersion() {
   if (fMPEGVersion != 0) return fMPEGVersion; // we already know it
 
   // Read the first index record, and figure out the MPEG version from its type:
-  if (!readOneIndexRecord(0)) return 0; // unknown; perhaps the indecx file is empty?	
+  if (!readIndexRecord(0)) return 0; // unknown; perhaps the indecx file is empty?	
 
   setMPEGVersionFromRecordType(recordTypeFromBuf());
   return fMPEGVersion;
 }
 
-Boolean MPEG2TransportStreamIndexFile::openFid() {
-  if (fFid == NULL && fFileName != NULL) {
-    if ((fFid = OpenInputFile(envir(), fFileName)) != NULL) {
-      fCurrentIndexRecordNum = 0;
-    }
-  }
-
-  return fFid != NULL;
-}
-
-Boolean MPEG2TransportStreamIndexFile::seekToIndexRecord(unsigned long indexRecordNumber) {
-  if (!openFid()) return False;
-
-  if (indexRecordNumber == fCurrentIndexRecordNum) return True; // we're already there
-
-  if (SeekFile64(fFid, (int64_t)(indexRecordNumber*INDEX_RECORD_SIZE), SEEK_SET) != 0) return False;
-  fCurrentIndexRecordNum = indexRecordNumber;
-  return True;
-}
-
 Boolean MPEG2TransportStreamIndexFile::readIndexRecord(unsigned long indexRecordNum) {
-  do {
-    if (!seekToIndexRecord(indexRecordNum)) break;
-    if (fread(fBuf, INDEX_RECORD_SIZE, 1, fFid) != 1) break;
-    ++fCurrentIndexRecordNum;
-
-    return True;
-  } while (0);
-
-  return False; // an error occurred
-}
+  if (indexRecordNum >= fNumIndexRecords) return False;
 
-Boolean MPEG2TransportStreamIndexFile::readOneIndexRecord(unsigned long indexRecordNum) {
-  Boolean result = readIndexRecord(indexRecordNum);
-  closeFid();
-
-  return result;
-}
-
-void MPEG2TransportStreamIndexFile::closeFid() {
-  if (fFid != NULL) {
-    CloseInputFile(fFid);
-    fFid = NULL;
-  }
+  memcpy(fBuf, fIndexRecords->record(indexRecordNum), INDEX_RECORD_SIZE);
+  return True;
 }
 
 float MPEG2TransportStreamIndexFile::pcrFromBuf() {
@@ -107,10 +107,11 @@ Boolean MediaSink::isRTPSink() const {
 unsigned OutPacketBuffer::maxSize = 60000; // by default
 
 OutPacketBuffer::OutPacketBuffer(unsigned preferredPacketSize,
-				 unsigned maxPacketSize)
+				 unsigned maxPacketSize,
+				 unsigned numExtraPackets)
   : fPreferred(preferredPacketSize), fMax(maxPacketSize),
     fOverflowDataSize(0) {
-  unsigned maxNumPackets = (maxSize + (maxPacketSize-1))/maxPacketSize;
+  unsigned maxNumPackets = (maxSize + (maxPacketSize-1))/maxPacketSize + numExtraPackets;
   fLimit = maxNumPackets*maxPacketSize;
   fBuf = new unsigned char[fLimit];
   resetPacketStart();
@@ -29,8 +29,9 @@ void MultiFramedRTPSink::setPacketSizes(unsigned preferredPacketSize,
   if (preferredPacketSize > maxPacketSize || preferredPacketSize == 0) return;
       // sanity check
 
+  if (fOutBuf != NULL) sendPendingPackets();
   delete fOutBuf;
-  fOutBuf = new OutPacketBuffer(preferredPacketSize, maxPacketSize);
+  fOutBuf = new OutPacketBuffer(preferredPacketSize, maxPacketSize, MAX_PENDING_RTP_PACKETS);
   fOurMaxPacketSize = maxPacketSize; // save value, in case subclasses need it
 }
 
@@ -43,7 +44,9 @@ MultiFramedRTPSink::MultiFramedRTPSink(UsageEnvironment& env,
   : RTPSink(env, rtpGS, rtpPayloadType, rtpTimestampFrequency,
 	    rtpPayloadFormatName, numChannels),
     fOutBuf(NULL), fCurFragmentationOffset(0), fPreviousFrameEndedFragmentation(False),
-    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL) {
+    fFrameDataInPlace(NULL), fNumFrameBytesInPlace(0), fFrameDataInPlaceIsKept(False),
+    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL),
+    fNumPendingPackets(0), fPendingDataInPlaceExpires(False), fFrameWasDeliveredPtr(NULL) {
   setPacketSizes(1000, 1448);
       // Default max packet size (1500, minus allowance for IP, UDP, UMTP headers)
       // (Also, make it a multiple of 4 bytes, just in case that matters.)
@@ -95,6 +98,14 @@ unsigned MultiFramedRTPSink::computeOverflowForNewFrame(unsigned newFrameSize) c
   return fOutBuf->numOverflowBytes(newFrameSize);
 }
 
+unsigned char const* MultiFramedRTPSink::frameDataInPlace(unsigned& numBytesInPlace,
+							  Boolean& isKeptForNextFrame) {
+  // default implementation: Our source delivers all of each frame into our buffer:
+  numBytesInPlace = 0;
+  isKeptForNextFrame = False;
+  return NULL;
+}
+
 void MultiFramedRTPSink::setMarkerBit() {
   unsigned rtpHdr = fOutBuf->extractWord(0);
   rtpHdr |= 0x00800000;
@@ -154,6 +165,8 @@ Boolean MultiFramedRTPSink::continuePlaying() {
 }
 
 void MultiFramedRTPSink::stopPlaying() {
+  sendPendingPackets();
+  fFrameDataInPlace = NULL; fNumFrameBytesInPlace = 0;
   fOutBuf->resetPacketStart();
   fOutBuf->resetOffset();
   fOutBuf->resetOverflowData();
@@ -212,8 +225,23 @@ void MultiFramedRTPSink::packFrame() {
     fOutBuf->skipBytes(fCurFrameSpecificHeaderSize);
     fTotalFrameSpecificHeaderSizes += fCurFrameSpecificHeaderSize;
 
+    if (fPendingDataInPlaceExpires) {
+      // Our source is about to overwrite payload data that pending packets still refer to:
+      sendPendingPackets();
+    }
+
+    // Note whether the frame (or closure) gets delivered before "getNextFrame()" returns.  If not
+    // (i.e., the source has to wait for data), then we send any pending packets now, rather than
+    // holding them back until the new frame arrives.  (We check this using a variable on our stack,
+    // because if the source *did* deliver synchronously, then we might since have been deleted.)
+    Boolean frameWasDelivered = False;
+    fFrameWasDeliveredPtr = &frameWasDelivered;
     fSource->getNextFrame(fOutBuf->curPtr(), fOutBuf->totalBytesAvailable(),
 			  afterGettingFrame, this, ourHandleClosure, this);
+    if (!frameWasDelivered) {
+      fFrameWasDeliveredPtr = NULL;
+      sendPendingPackets();
+    }
   }
 }
 
@@ -223,14 +251,35 @@ void MultiFramedRTPSink
 		    struct timeval presentationTime,
 		    unsigned durationInMicroseconds) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)clientData;
+  sink->checkFrameDataInPlace(numBytesRead);
   sink->afterGettingFrame1(numBytesRead, numTruncatedBytes,
 			   presentationTime, durationInMicroseconds);
 }
 
+void MultiFramedRTPSink::checkFrameDataInPlace(unsigned frameSize) {
+  fFrameDataInPlace = frameDataInPlace(fNumFrameBytesInPlace, fFrameDataInPlaceIsKept);
+  if (fFrameDataInPlace == NULL || fNumFrameBytesInPlace == 0 || fNumFrameBytesInPlace > frameSize) {
+    fFrameDataInPlace = NULL; fNumFrameBytesInPlace = 0;
+    return;
+  }
+
+  if (fNumFramesUsedSoFar > 0 || fOutBuf->wouldOverflow(frameSize)) {
+    // This frame can't be sent from where it is, in a packet of its own, so we copy the rest of it
+    // into our buffer after all.  (The source was given room for the whole frame.)
+    memmove(fOutBuf->curPtr() + (frameSize - fNumFrameBytesInPlace), fFrameDataInPlace,
+	    fNumFrameBytesInPlace);
+    fFrameDataInPlace = NULL; fNumFrameBytesInPlace = 0;
+  }
+}
+
 void MultiFramedRTPSink
 ::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
+  if (fFrameWasDeliveredPtr != NULL) {
+    *fFrameWasDeliveredPtr = True;
+    fFrameWasDeliveredPtr = NULL;
+  }
   if (fIsFirstPacket) {
     // Record the fact that we're starting to play now:
     gettimeofday(&fNextSendTime, NULL);
@@ -298,7 +347,7 @@ void MultiFramedRTPSink
   } else {
     // Use this frame in our outgoing packet:
     unsigned char* frameStart = fOutBuf->curPtr();
-    fOutBuf->increment(numFrameBytesToUse);
+    fOutBuf->increment(numFrameBytesToUse - fNumFrameBytesInPlace); // the rest (if any) is sent in place
         // do this now, in case "doSpecialFrameHandling()" calls "setFramePadding()" to append padding bytes
 
     // Here's where any payload format specific processing gets done:
@@ -323,8 +372,10 @@ void MultiFramedRTPSink
     //      read would overflow the packet, or
     // (iii) it contains the last fragment of a fragmented frame, and we
     //      don't allow anything else to follow this or
-    // (iv) one frame per packet is allowed:
-    if (fOutBuf->isPreferredSize()
+    // (iv) one frame per packet is allowed, or
+    // (v) the end of the frame was left in place by our source:
+    if (fNumFrameBytesInPlace > 0
+        || fOutBuf->isPreferredSize()
         || fOutBuf->wouldOverflow(numFrameBytesToUse)
         || (fPreviousFrameEndedFragmentation &&
             !allowOtherFramesAfterLastFragment())
@@ -351,21 +402,38 @@ Boolean MultiFramedRTPSink::isTooBigForAPacket(unsigned numBytes) const {
 
 void MultiFramedRTPSink::sendPacketIfNecessary() {
   if (fNumFramesUsedSoFar > 0) {
-    // Send the packet:
+    // Queue the packet, to be sent (along with any others that are due at the same time) below:
 #ifdef TEST_LOSS
     if ((our_random()%10) != 0) // simulate 10% packet loss #####
 #endif
-      if (!fRTPInterface.sendPacket(fOutBuf->packet(), fOutBuf->curPacketSize())) {
-	// if failure handler has been specified, call it
-	if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
-      }
+      queuePacket();
     ++fPacketCount;
-    fTotalOctetCount += fOutBuf->curPacketSize();
-    fOctetCount += fOutBuf->curPacketSize()
+    fTotalOctetCount += fOutBuf->curPacketSize() + fNumFrameBytesInPlace;
+    fOctetCount += fOutBuf->curPacketSize() + fNumFrameBytesInPlace
       - rtpHeaderSize - fSpecialHeaderSize - fTotalFrameSpecificHeaderSizes;
 
     ++fSeqNo; // for next time
   }
+  fFrameDataInPlace = NULL; fNumFrameBytesInPlace = 0;
+
+  // Figure out when the next frame is due to start playing, so that we wait this long
+  // before sending the next packet:
+  int64_t uSecondsToGo = 0;
+  if (!fNoFramesLeft) {
+    struct timeval timeNow;
+    gettimeofday(&timeNow, NULL);
+    int secsDiff = fNextSendTime.tv_sec - timeNow.tv_sec;
+    uSecondsToGo = secsDiff*1000000 + (fNextSendTime.tv_usec - timeNow.tv_usec);
+    if (uSecondsToGo < 0 || secsDiff < 0) { // sanity check: Make sure that the time-to-delay is non-negative:
+      uSecondsToGo = 0;
+    }
+  }
+
+  // Unless the next packet is due right away (and we have room to hold it back), send our
+  // pending packet(s) now:
+  if (fNoFramesLeft || uSecondsToGo > 0 || fNumPendingPackets >= MAX_PENDING_RTP_PACKETS) {
+    sendPendingPackets();
+  }
 
   if (fOutBuf->haveOverflowData()
       && fOutBuf->totalBytesAvailable() > fOutBuf->totalBufferSize()/2) {
@@ -375,9 +443,17 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
     // into place when building the next packet:
     unsigned newPacketStart = fOutBuf->curPacketSize()
       - (rtpHeaderSize + fSpecialHeaderSize + frameSpecificHeaderSize());
+    // (This overwrites the end of the packet that we just built, so if it's still pending, save its end first.)
+    if (!savePendingPacketTail(newPacketStart)) sendPendingPackets();
     fOutBuf->adjustPacketStart(newPacketStart);
+  } else if (fNumPendingPackets > 0 && !fOutBuf->haveOverflowData()
+	     && fOutBuf->totalBytesAvailable() >= OutPacketBuffer::maxSize) {
+    // Build the next packet just after the pending one(s).  (We still leave room for a
+    // full-sized frame, so that the source never has to truncate one.)
+    fOutBuf->adjustPacketStart(fOutBuf->curPacketSize());
   } else {
     // Normal case: Reset the packet start pointer back to the start:
+    sendPendingPackets();
     fOutBuf->resetPacketStart();
   }
   fOutBuf->resetOffset();
@@ -387,22 +463,58 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
     // We're done:
     onSourceClosure(this);
   } else {
-    // We have more frames left to send.  Figure out when the next frame
-    // is due to start playing, then make sure that we wait this long before
-    // sending the next packet.
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
-    int secsDiff = fNextSendTime.tv_sec - timeNow.tv_sec;
-    int64_t uSecondsToGo = secsDiff*1000000 + (fNextSendTime.tv_usec - timeNow.tv_usec);
-    if (uSecondsToGo < 0 || secsDiff < 0) { // sanity check: Make sure that the time-to-delay is non-negative:
-      uSecondsToGo = 0;
-    }
-
-    // Delay this amount of time:
+    // We have more frames left to send.  Delay until the next packet is due:
     nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, (TaskFunc*)sendNext, this);
   }
 }
 
+void MultiFramedRTPSink::queuePacket() {
+  pendingPacket& packet = fPendingPackets[fNumPendingPackets++];
+  packet.data = fOutBuf->packet();
+  packet.size = fOutBuf->curPacketSize();
+  packet.dataInPlace = fFrameDataInPlace;
+  packet.numBytesInPlace = fNumFrameBytesInPlace;
+  packet.savedTailSize = 0;
+  if (fNumFrameBytesInPlace > 0 && !fFrameDataInPlaceIsKept) fPendingDataInPlaceExpires = True;
+}
+
+Boolean MultiFramedRTPSink::savePendingPacketTail(unsigned nextPacketStart) {
+  if (fNumPendingPackets == 0) return True; // nothing to save
+
+  pendingPacket& packet = fPendingPackets[fNumPendingPackets-1];
+  if (packet.data != fOutBuf->packet() || packet.size != fOutBuf->curPacketSize()) {
+    return True; // the last pending packet isn't the one that we just built, so won't be overwritten
+  }
+
+  unsigned tailSize = packet.size - nextPacketStart;
+  if (tailSize > sizeof packet.savedTail) return False;
+
+  memcpy(packet.savedTail, &packet.data[nextPacketStart], tailSize);
+  packet.savedTailSize = tailSize;
+  return True;
+}
+
+void MultiFramedRTPSink::sendPendingPackets() {
+  if (fNumPendingPackets == 0) return;
+
+  packetPieces packets[MAX_PENDING_RTP_PACKETS];
+  for (unsigned i = 0; i < fNumPendingPackets; ++i) {
+    pendingPacket const& packet = fPendingPackets[i];
+    packets[i].reset();
+    packets[i].add(packet.data, packet.size - packet.savedTailSize);
+    if (packet.savedTailSize > 0) packets[i].add(packet.savedTail, packet.savedTailSize);
+    if (packet.numBytesInPlace > 0) packets[i].add(packet.dataInPlace, packet.numBytesInPlace);
+  }
+
+  unsigned numPackets = fNumPendingPackets;
+  fNumPendingPackets = 0;
+  fPendingDataInPlaceExpires = False;
+  if (!fRTPInterface.sendPackets(packets, numPackets)) {
+    // if failure handler has been specified, call it
+    if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
+  }
+}
+
 // The following is called after each delay between packet sends:
 void MultiFramedRTPSink::sendNext(void* firstArg) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)firstArg;
@@ -411,6 +523,10 @@ void MultiFramedRTPSink::sendNext(void* firstArg) {
 
 void MultiFramedRTPSink::ourHandleClosure(void* clientData) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)clientData;
+  if (sink->fFrameWasDeliveredPtr != NULL) {
+    *sink->fFrameWasDeliveredPtr = True;
+    sink->fFrameWasDeliveredPtr = NULL;
+  }
   // There are no frames left, but we may have a partially built packet
   //  to send
   sink->fNoFramesLeft = True;
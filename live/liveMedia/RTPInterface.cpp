@@ -23,19 +23,22 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTPInterface.hh"
 #include <GroupsockHelper.hh>
 #include <stdio.h>
+#include <string.h>
 
 ////////// Helper Functions - Definition //////////
 
 // Helper routines and data structures, used to implement
 // sending/receiving RTP/RTCP over a TCP socket:
 
-static Boolean sendRTPOverTCP(unsigned char* packet, unsigned packetSize,
+static Boolean sendRTPOverTCP(UsageEnvironment& env, packetPieces const& packet,
 			      int socketNum, unsigned char streamChannelId);
 
 // Reading RTP-over-TCP is implemented using two levels of hash tables.
 // The top-level hash table maps TCP socket numbers to a
 // "SocketDescriptor" that contains a hash table for each of the
 // sub-channels that are reading from this socket.
+// The "SocketDescriptor" also keeps any data that could not yet be written
+// to the socket, because its send buffer was full.
 
 static HashTable* socketHashTable(UsageEnvironment& env, Boolean createIfNotPresent = True) {
   _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
@@ -63,9 +66,17 @@ public:
     fServerRequestAlternativeByteHandlerClientData = clientData;
   }
 
+  Boolean writePacket(packetPieces const& data);
+      // Writes a (framed) packet to the socket.  If the socket's send buffer is full, the
+      // unwritten part of the packet is kept, and written once the socket becomes writable.
+      // Returns False if the packet was dropped (or on error).
+
 private:
-  static void tcpReadHandler(SocketDescriptor*, int mask);
+  static void tcpHandler(SocketDescriptor*, int mask);
   void tcpReadHandler1(int mask);
+  void flushPendingData();
+  Boolean keepPendingData(packetPieces const& data, unsigned numBytesToSkip);
+  void updateBackgroundHandling();
 
 private:
   UsageEnvironment& fEnv;
@@ -75,8 +86,14 @@ private:
   void* fServerRequestAlternativeByteHandlerClientData;
   u_int8_t fStreamChannelId, fSizeByte1;
   enum { AWAITING_DOLLAR, AWAITING_STREAM_CHANNEL_ID, AWAITING_SIZE1, AWAITING_SIZE2, AWAITING_PACKET_DATA } fTCPReadingState;
+  unsigned char* fPendingData; // data not yet written to the socket
+  unsigned fPendingSize;
 };
 
+// The most data that we keep for a socket whose send buffer is full.
+// (This is always enough for the remainder of one packet.)
+#define MAX_PENDING_DATA_SIZE (256*1024)
+
 static SocketDescriptor* lookupSocketDescriptor(UsageEnvironment& env, int sockNum, Boolean createIfNotFound = True) {
   HashTable* table = socketHashTable(env, createIfNotFound);
   if (table == NULL) return NULL;
@@ -183,17 +200,28 @@ void RTPInterface
 
 
 Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
+  packetPieces pieces;
+  pieces.reset();
+  pieces.add(packet, packetSize);
+
+  return sendPackets(&pieces, 1);
+}
+
+Boolean RTPInterface::sendPackets(packetPieces const* packets, unsigned numPackets) {
   Boolean success = True; // we'll return False instead if any of the sends fail
 
-  // Normal case: Send as a UDP packet:
-  if (!fGS->output(envir(), fGS->ttl(), packet, packetSize)) success = False;
+  // Normal case: Send as UDP packets:
+  if (!fGS->output(envir(), fGS->ttl(), packets, numPackets)) success = False;
 
   // Also, send over each of our TCP sockets:
   for (tcpStreamRecord* streams = fTCPStreams; streams != NULL;
        streams = streams->fNext) {
-    if (!sendRTPOverTCP(packet, packetSize,
-			streams->fStreamSocketNum, streams->fStreamChannelId)) {
-      success = False;
+    for (unsigned i = 0; i < numPackets; ++i) {
+      if (!sendRTPOverTCP(envir(), packets[i],
+			  streams->fStreamSocketNum, streams->fStreamChannelId)) {
+	success = False;
+	break;
+      }
     }
   }
 
@@ -273,32 +301,37 @@ void RTPInterface::stopNetworkReading() {
 
 ////////// Helper Functions - Implementation /////////
 
-Boolean sendRTPOverTCP(unsigned char* packet, unsigned packetSize,
-                    int socketNum, unsigned char streamChannelId) {
+Boolean sendRTPOverTCP(UsageEnvironment& env, packetPieces const& packet,
+		       int socketNum, unsigned char streamChannelId) {
+  unsigned packetSize = packet.totalSize();
 #ifdef DEBUG
   fprintf(stderr, "sendRTPOverTCP: %d bytes over channel %d (socket %d)\n",
 	  packetSize, streamChannelId, socketNum); fflush(stderr);
 #endif
   // Send RTP over TCP, using the encoding defined in
-  // RFC 2326, section 10.12:
-  do {
-    char const dollar = '$';
-    if (send(socketNum, &dollar, 1, 0) != 1) break;
-    if (send(socketNum, (char*)&streamChannelId, 1, 0) != 1) break;
-
-    char netPacketSize[2];
-    netPacketSize[0] = (char) ((packetSize&0xFF00)>>8);
-    netPacketSize[1] = (char) (packetSize&0xFF);
-    if (send(socketNum, netPacketSize, 2, 0) != 2) break;
-
-    if (send(socketNum, (char*)packet, packetSize, 0) != (int)packetSize) break;
+  // RFC 2326, section 10.12.  The 4-byte framing header and the packet are sent
+  // using a single system call, through the socket's "SocketDescriptor"
+  // (which keeps whatever could not be written yet):
+  unsigned char framingHeader[4];
+  framingHeader[0] = '$';
+  framingHeader[1] = streamChannelId;
+  framingHeader[2] = (unsigned char) ((packetSize&0xFF00)>>8);
+  framingHeader[3] = (unsigned char) (packetSize&0xFF);
+
+  packetPieces data;
+  data.reset();
+  data.add(framingHeader, 4);
+  for (unsigned i = 0; i < packet.numPieces && data.numPieces < MAX_PACKET_PIECES; ++i) {
+    data.add(packet.piece[i], packet.pieceSize[i]);
+  }
 
+  if (data.numPieces == packet.numPieces + 1
+      && lookupSocketDescriptor(env, socketNum)->writePacket(data)) {
 #ifdef DEBUG
     fprintf(stderr, "sendRTPOverTCP: completed\n"); fflush(stderr);
 #endif
-
     return True;
-  } while (0);
+  }
 
 #ifdef DEBUG
   fprintf(stderr, "sendRTPOverTCP: failed!\n"); fflush(stderr);
@@ -310,11 +343,12 @@ SocketDescriptor::SocketDescriptor(UsageEnvironment& env, int socketNum)
   :fEnv(env), fOurSocketNum(socketNum),
     fSubChannelHashTable(HashTable::create(ONE_WORD_HASH_KEYS)),
    fServerRequestAlternativeByteHandler(NULL), fServerRequestAlternativeByteHandlerClientData(NULL),
-   fTCPReadingState(AWAITING_DOLLAR) {
+   fTCPReadingState(AWAITING_DOLLAR), fPendingData(NULL), fPendingSize(0) {
 }
 
 SocketDescriptor::~SocketDescriptor() {
   delete fSubChannelHashTable;
+  delete[] fPendingData;
 }
 
 void SocketDescriptor::registerRTPInterface(unsigned char streamChannelId,
@@ -324,11 +358,8 @@ void SocketDescriptor::registerRTPInterface(unsigned char streamChannelId,
 			    rtpInterface);
 
   if (isFirstRegistration) {
-    // Arrange to handle reads on this TCP socket:
-    TaskScheduler::BackgroundHandlerProc* handler
-      = (TaskScheduler::BackgroundHandlerProc*)&tcpReadHandler;
-    fEnv.taskScheduler().
-      turnOnBackgroundReadHandling(fOurSocketNum, handler, this);
+    // Arrange to handle reads (and any pending writes) on this TCP socket:
+    updateBackgroundHandling();
   }
 }
 
@@ -350,8 +381,84 @@ void SocketDescriptor
   }
 }
 
-void SocketDescriptor::tcpReadHandler(SocketDescriptor* socketDescriptor, int mask) {
-  socketDescriptor->tcpReadHandler1(mask);
+Boolean SocketDescriptor::writePacket(packetPieces const& data) {
+  if (fPendingSize > 0) {
+    // Earlier data must be written first:
+    flushPendingData();
+    if (fPendingSize > 0) return keepPendingData(data, 0);
+  }
+
+  int bytesSent = writeStreamSocket(fEnv, fOurSocketNum, data);
+  if (bytesSent < 0) return False;
+  if ((unsigned)bytesSent == data.totalSize()) return True;
+
+  // The socket's send buffer is full.  Keep the rest of the packet (so that the framing
+  // of the TCP stream stays intact), and write it once the socket becomes writable:
+  return keepPendingData(data, (unsigned)bytesSent);
+}
+
+Boolean SocketDescriptor::keepPendingData(packetPieces const& data, unsigned numBytesToSkip) {
+  unsigned size = data.totalSize() - numBytesToSkip;
+  if (size > MAX_PENDING_DATA_SIZE - fPendingSize) {
+    // No room; drop the whole packet (this can't happen once part of it has been written):
+    return False;
+  }
+
+  if (fPendingData == NULL) fPendingData = new unsigned char[MAX_PENDING_DATA_SIZE];
+  for (unsigned i = 0; i < data.numPieces; ++i) {
+    unsigned pieceSize = data.pieceSize[i];
+    unsigned char const* piece = data.piece[i];
+    if (numBytesToSkip >= pieceSize) {
+      numBytesToSkip -= pieceSize;
+      continue;
+    }
+    piece += numBytesToSkip; pieceSize -= numBytesToSkip;
+    numBytesToSkip = 0;
+
+    memcpy(&fPendingData[fPendingSize], piece, pieceSize);
+    fPendingSize += pieceSize;
+  }
+
+  updateBackgroundHandling();
+  return True;
+}
+
+void SocketDescriptor::flushPendingData() {
+  packetPieces data;
+  data.reset();
+  data.add(fPendingData, fPendingSize);
+
+  int bytesSent = writeStreamSocket(fEnv, fOurSocketNum, data);
+  if (bytesSent < 0) {
+    // The connection has failed; there's no point in keeping its data:
+    fPendingSize = 0;
+  } else {
+    fPendingSize -= bytesSent;
+    memmove(fPendingData, &fPendingData[bytesSent], fPendingSize);
+  }
+
+  if (fPendingSize == 0) updateBackgroundHandling();
+}
+
+void SocketDescriptor::updateBackgroundHandling() {
+  // If no sub-channel is reading from this socket, its reads are handled elsewhere
+  // (e.g., by the RTSP server), so we can't take over its handling.  Instead, any pending
+  // data gets written before the next packet (e.g., the next RTCP report):
+  if (fSubChannelHashTable->IsEmpty()) return;
+
+  int conditionSet = SOCKET_READABLE;
+  if (fPendingSize > 0) conditionSet |= SOCKET_WRITABLE;
+  fEnv.taskScheduler().setBackgroundHandling(fOurSocketNum, conditionSet,
+					     (TaskScheduler::BackgroundHandlerProc*)&tcpHandler, this);
+}
+
+void SocketDescriptor::tcpHandler(SocketDescriptor* socketDescriptor, int mask) {
+  if ((mask&SOCKET_WRITABLE) != 0 && socketDescriptor->fPendingSize > 0) {
+    socketDescriptor->flushPendingData();
+  }
+  if ((mask&SOCKET_READABLE) != 0) {
+    socketDescriptor->tcpReadHandler1(mask); // Note: This may delete "socketDescriptor"
+  }
 }
 
 void SocketDescriptor::tcpReadHandler1(int mask) {
@@ -186,10 +186,15 @@ Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd)
 }
 
 char const* dateHeader() {
-  static char buf[200];
+  static RESULT_BUFFER_PER_THREAD char buf[200];
 #if !defined(_WIN32_WCE)
   time_t tt = time(NULL);
+#ifdef HAVE_GMTIME_R
+  struct tm tmBuf;
+  strftime(buf, sizeof buf, "Date: %a, %b %d %Y %H:%M:%S GMT\r\n", gmtime_r(&tt, &tmBuf));
+#else
   strftime(buf, sizeof buf, "Date: %a, %b %d %Y %H:%M:%S GMT\r\n", gmtime(&tt));
+#endif
 #else
   // WinCE apparently doesn't have "time()", "strftime()", or "gmtime()",
   // so generate the "Date:" header a different, WinCE-specific way.
@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "RTSPServer.hh"
+#include "RTSPServerWorkerPool.hh"
 #include "RTSPCommon.hh"
 #include "Base64.hh"
 #include <GroupsockHelper.hh>
@@ -197,7 +198,7 @@ RTSPServer::RTSPServer(UsageEnvironment& env,
     fRTSPServerSocket(ourSocket), fRTSPServerPort(ourPort),
     fHTTPServerSocket(-1), fHTTPServerPort(0), fClientSessionsForHTTPTunneling(NULL),
     fAuthDB(authDatabase), fReclamationTestSeconds(reclamationTestSeconds),
-    fServerMediaSessions(HashTable::create(STRING_HASH_KEYS)) {
+    fServerMediaSessions(HashTable::create(STRING_HASH_KEYS)), fWorkerPool(NULL) {
 #ifdef USE_SIGNALS
   // Ignore the SIGPIPE signal, so that clients on the same host that are killed
   // don't also kill us:
@@ -211,11 +212,15 @@ RTSPServer::RTSPServer(UsageEnvironment& env,
 
 RTSPServer::~RTSPServer() {
   // Turn off background read handling:
-  envir().taskScheduler().turnOffBackgroundReadHandling(fRTSPServerSocket);
-  ::closeSocket(fRTSPServerSocket);
+  if (fRTSPServerSocket >= 0) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fRTSPServerSocket);
+    ::closeSocket(fRTSPServerSocket);
+  }
 
-  envir().taskScheduler().turnOffBackgroundReadHandling(fHTTPServerSocket);
-  ::closeSocket(fHTTPServerSocket);
+  if (fHTTPServerSocket >= 0) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fHTTPServerSocket);
+    ::closeSocket(fHTTPServerSocket);
+  }
 
   delete fClientSessionsForHTTPTunneling;
 
@@ -269,6 +274,16 @@ void RTSPServer::incomingConnectionHandler(int serverSocket) {
   envir() << "accept()ed connection from " << AddressString(clientAddr).val() << "\n";
 #endif
 
+  // If we have worker servers, then let one of them handle this connection.  (Connections to our
+  // RTSP-over-HTTP tunneling port are assigned by client address, so that the two connections of a
+  // tunnel ("GET" and "POST") end up at the same worker.)
+  if (fWorkerPool != NULL
+      && fWorkerPool->handOffConnection(clientSocket, clientAddr, serverSocket == fHTTPServerSocket)) return;
+
+  addClientConnection(clientSocket, clientAddr);
+}
+
+void RTSPServer::addClientConnection(int clientSocket, struct sockaddr_in clientAddr) {
   // Create a new object for this RTSP session.
   // (Choose a random 32-bit integer for the session id (it will be encoded as a 8-digit hex number).  We don't bother checking for
   //  a collision; the probability of two concurrent sessions getting the same session id is very low.)
@@ -58,7 +58,7 @@ RTSPServerSupportingHTTPStreaming::RTSPClientSessionSupportingHTTPStreaming::~RT
 }
 
 static char const* lastModifiedHeader(char const* fileName) {
-  static char buf[200];
+  static RESULT_BUFFER_PER_THREAD char buf[200];
 
   struct stat sb;
   int statResult = stat(fileName, &sb);
@@ -66,7 +66,12 @@ static char const* lastModifiedHeader(char const* fileName) {
     // Failed to 'stat' the file; return an empty string
     buf[0] = '\0';
   } else {
+#ifdef HAVE_GMTIME_R
+    struct tm tmBuf;
+    strftime(buf, sizeof buf, "Last-Modified: %a, %b %d %Y %H:%M:%S GMT\r\n", gmtime_r((const time_t*)&sb.st_mtime, &tmBuf));
+#else
     strftime(buf, sizeof buf, "Last-Modified: %a, %b %d %Y %H:%M:%S GMT\r\n", gmtime((const time_t*)&sb.st_mtime));
+#endif
   }
 
   return buf;
@@ -0,0 +1,254 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2012 Live Networks, Inc.  All rights reserved.
+// A pool of RTSP servers - each running its own event loop, in its own thread - to which
+// an 'acceptor' RTSP server hands off its incoming client connections.
+// Implementation
+
+#include "RTSPServerWorkerPool.hh"
+#include <GroupsockHelper.hh>
+
+#if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#define USE_WORKER_THREADS 1
+#endif
+
+#ifdef USE_WORKER_THREADS
+
+// How long the acceptor waits for a worker to make room for a connection that only that worker can take:
+#define MAX_HAND_OFF_WAIT_MILLISECS 2000
+
+// A connection is handed off to a worker by writing one of these to the worker's pipe.
+// (Because this is much smaller than PIPE_BUF, each such write is atomic.)
+struct connectionHandOff {
+  int clientSocket;
+  struct sockaddr_in clientAddr;
+};
+
+class RTSPServerWorkerPool::Worker {
+public:
+  Worker(RTSPServer* server, int handOffReadFd, int handOffWriteFd);
+  virtual ~Worker();
+
+  Boolean start();
+  Boolean handOff(int clientSocket, struct sockaddr_in const& clientAddr, unsigned maxWaitMillisecs);
+
+private:
+  static void* threadMain(void* worker);
+  static void incomingHandOffHandler(void* worker, int /*mask*/);
+  void incomingHandOffHandler1();
+  void closeHandOffReadFd();
+
+private:
+  RTSPServer* fServer;
+  int fHandOffReadFd, fHandOffWriteFd;
+  pthread_t fThread;
+  Boolean fThreadIsRunning;
+  char fStopFlag; // the "watchVariable" for the worker's event loop
+};
+
+RTSPServerWorkerPool::Worker::Worker(RTSPServer* server, int handOffReadFd, int handOffWriteFd)
+  : fServer(server), fHandOffReadFd(handOffReadFd), fHandOffWriteFd(handOffWriteFd),
+    fThreadIsRunning(False), fStopFlag(0) {
+  fServer->envir().taskScheduler().turnOnBackgroundReadHandling(fHandOffReadFd,
+      (TaskScheduler::BackgroundHandlerProc*)&incomingHandOffHandler, this);
+}
+
+RTSPServerWorkerPool::Worker::~Worker() {
+  if (fThreadIsRunning) {
+    // Tell the thread to leave its event loop.  (Closing our end of the pipe also makes its
+    // end readable, so that the thread notices this without having to wait for a timeout.)
+    fStopFlag = 1;
+    close(fHandOffWriteFd); fHandOffWriteFd = -1;
+    pthread_join(fThread, NULL);
+  }
+  if (fHandOffWriteFd >= 0) close(fHandOffWriteFd);
+
+  // Close any connections that were handed off to us, but not yet taken by our server:
+  if (fHandOffReadFd >= 0) {
+    struct connectionHandOff msg;
+    while (read(fHandOffReadFd, &msg, sizeof msg) == (ssize_t)sizeof msg) ::closeSocket(msg.clientSocket);
+    closeHandOffReadFd();
+  }
+
+  // Note: Client sessions that are still open at this point are abandoned (not closed).
+  UsageEnvironment& env = fServer->envir();
+  TaskScheduler* scheduler = &env.taskScheduler();
+  Medium::close(fServer);
+  env.reclaim();
+  delete scheduler;
+}
+
+Boolean RTSPServerWorkerPool::Worker::start() {
+  fThreadIsRunning = pthread_create(&fThread, NULL, threadMain, this) == 0;
+  return fThreadIsRunning;
+}
+
+Boolean RTSPServerWorkerPool::Worker
+::handOff(int clientSocket, struct sockaddr_in const& clientAddr, unsigned maxWaitMillisecs) {
+  struct connectionHandOff msg;
+  msg.clientSocket = clientSocket;
+  msg.clientAddr = clientAddr;
+
+  // Our end of the pipe is non-blocking, so if the worker has fallen far behind, this fails
+  // (rather than stalling the acceptor) - unless we've been told to wait for room in the pipe:
+  while (write(fHandOffWriteFd, &msg, sizeof msg) != (ssize_t)sizeof msg) {
+    if (errno == EINTR) continue;
+    if (errno != EAGAIN || maxWaitMillisecs == 0) return False;
+
+    struct pollfd pfd;
+    pfd.fd = fHandOffWriteFd;
+    pfd.events = POLLOUT;
+    int result = poll(&pfd, 1, maxWaitMillisecs);
+    if (result == 0) return False; // timed out
+    if (result < 0 && errno != EINTR) return False;
+  }
+  return True;
+}
+
+void* RTSPServerWorkerPool::Worker::threadMain(void* worker) {
+  Worker* us = (Worker*)worker;
+  us->fServer->envir().taskScheduler().doEventLoop(&us->fStopFlag);
+  return NULL;
+}
+
+void RTSPServerWorkerPool::Worker::incomingHandOffHandler(void* worker, int /*mask*/) {
+  ((Worker*)worker)->incomingHandOffHandler1();
+}
+
+void RTSPServerWorkerPool::Worker::incomingHandOffHandler1() {
+  while (1) {
+    struct connectionHandOff msg;
+    ssize_t result = read(fHandOffReadFd, &msg, sizeof msg);
+    if (result == (ssize_t)sizeof msg) {
+      fServer->addClientConnection(msg.clientSocket, msg.clientAddr);
+    } else {
+      if (result == 0) closeHandOffReadFd(); // the pool is being deleted
+      break; // (otherwise, there are no more connections waiting (EAGAIN))
+    }
+  }
+}
+
+void RTSPServerWorkerPool::Worker::closeHandOffReadFd() {
+  fServer->envir().taskScheduler().turnOffBackgroundReadHandling(fHandOffReadFd);
+  close(fHandOffReadFd);
+  fHandOffReadFd = -1;
+}
+
+////////// RTSPServerWorkerPool implementation //////////
+
+RTSPServerWorkerPool*
+RTSPServerWorkerPool::createNew(unsigned numWorkers, Port ourPort,
+				createWorkerServerFunc* createWorkerServer, void* clientData) {
+  if (numWorkers == 0 || createWorkerServer == NULL) return NULL;
+
+  RTSPServerWorkerPool* pool = new RTSPServerWorkerPool(numWorkers);
+  for (unsigned i = 0; i < numWorkers; ++i) {
+    RTSPServer* server = (*createWorkerServer)(ourPort, clientData);
+    if (server == NULL) break;
+
+    if (i == 0) {
+      // Make sure that our IP address has been looked up (and remembered) before any worker
+      // thread needs it, because that lookup is not thread-safe:
+      (void)ourIPAddress(server->envir());
+    }
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+      server->envir().setResultErrMsg("pipe() failed: ");
+      Worker* worker = new Worker(server, -1, -1); // so that "server" gets reclaimed
+      delete worker;
+      break;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0)|O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0)|O_NONBLOCK);
+
+    Worker* worker = new Worker(server, fds[0], fds[1]);
+    if (!worker->start()) {
+      delete worker;
+      break;
+    }
+    pool->fWorkers[pool->fNumWorkers++] = worker;
+  }
+
+  if (pool->fNumWorkers == 0) {
+    delete pool;
+    return NULL;
+  }
+  return pool;
+}
+
+RTSPServerWorkerPool::RTSPServerWorkerPool(unsigned numWorkers)
+  : fNumWorkers(0), fWorkers(new Worker*[numWorkers]), fNextWorker(0) {
+}
+
+RTSPServerWorkerPool::~RTSPServerWorkerPool() {
+  for (unsigned i = 0; i < fNumWorkers; ++i) delete fWorkers[i];
+  delete[] fWorkers;
+}
+
+Boolean RTSPServerWorkerPool::handOffConnection(int clientSocket, struct sockaddr_in const& clientAddr,
+						Boolean assignByClientAddress) {
+  unsigned workerNum;
+  if (assignByClientAddress) {
+    workerNum = (((unsigned)clientAddr.sin_addr.s_addr)*2654435761u)%fNumWorkers;
+  } else {
+    workerNum = fNextWorker;
+    fNextWorker = (fNextWorker + 1)%fNumWorkers;
+  }
+
+  if (!assignByClientAddress) return fWorkers[workerNum]->handOff(clientSocket, clientAddr, 0);
+
+  // This connection must not be handled by the acceptor instead, because the other connection from the
+  // same client (e.g., the other half of a RTSP-over-HTTP tunnel) may have been handed off to the worker.
+  // So we wait for the worker to make room for it, and if it doesn't, we close the connection (and the
+  // client will have to try again):
+  if (!fWorkers[workerNum]->handOff(clientSocket, clientAddr, MAX_HAND_OFF_WAIT_MILLISECS)) {
+    ::closeSocket(clientSocket);
+  }
+  return True;
+}
+
+#else
+
+class RTSPServerWorkerPool::Worker {
+};
+
+RTSPServerWorkerPool*
+RTSPServerWorkerPool::createNew(unsigned /*numWorkers*/, Port /*ourPort*/,
+				createWorkerServerFunc* /*createWorkerServer*/, void* /*clientData*/) {
+  return NULL; // not implemented for this platform
+}
+
+RTSPServerWorkerPool::RTSPServerWorkerPool(unsigned /*numWorkers*/)
+  : fNumWorkers(0), fWorkers(NULL), fNextWorker(0) {
+}
+
+RTSPServerWorkerPool::~RTSPServerWorkerPool() {
+}
+
+Boolean RTSPServerWorkerPool::handOffConnection(int /*clientSocket*/, struct sockaddr_in const& /*clientAddr*/,
+						Boolean /*assignByClientAddress*/) {
+  return False;
+}
+
+#endif
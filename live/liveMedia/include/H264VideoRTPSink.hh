@@ -57,6 +57,8 @@ private: // redefined virtual functions:
                                       unsigned numRemainingBytes);
   virtual Boolean frameCanAppearAfterPacketStart(unsigned char const* frameStart,
 						 unsigned numBytesInFrame) const;
+  virtual unsigned char const* frameDataInPlace(unsigned& numBytesInPlace,
+						Boolean& isKeptForNextFrame);
 
 protected:
   H264FUAFragmenter* fOurFragmenter;
@@ -78,10 +80,19 @@ private:
 class H264FUAFragmenter: public FramedFilter {
 public:
   H264FUAFragmenter(UsageEnvironment& env, FramedSource* inputSource,
-		    unsigned inputBufferMax, unsigned maxOutputPacketSize);
+		    unsigned inputBufferMax, unsigned maxOutputPacketSize,
+		    Boolean leaveFragmentsInPlace = False);
+      // If "leaveFragmentsInPlace" is True, each FU-A fragment is delivered as just its two header
+      // bytes; the rest stays in our input buffer (see "fragmentDataInPlace()").
   virtual ~H264FUAFragmenter();
 
   Boolean lastFragmentCompletedNALUnit() const { return fLastFragmentCompletedNALUnit; }
+  unsigned char const* fragmentDataInPlace(unsigned& numBytes) const {
+    // returns the rest of the most recently delivered fragment, if it was left in our input buffer.
+    // It stays there until we read the next NAL unit, i.e., until a frame is requested after the
+    // last fragment of this one.
+    numBytes = fNumBytesInPlace; return fNumBytesInPlace > 0 ? fDataInPlace : NULL;
+  }
 
 private: // redefined virtual functions:
   virtual void doGetNextFrame();
@@ -104,6 +115,9 @@ private:
   unsigned fCurDataOffset;
   unsigned fSaveNumTruncatedBytes;
   Boolean fLastFragmentCompletedNALUnit;
+  Boolean fLeaveFragmentsInPlace;
+  unsigned char const* fDataInPlace;
+  unsigned fNumBytesInPlace;
 };
 
 
@@ -57,7 +57,7 @@ public:
 				unsigned long& transportPacketNum, u_int8_t& offset,
 				u_int8_t& size, float& pcr, u_int8_t& recordType);
   float getPlayingDuration();
-  void stopReading() { closeFid(); }
+  void stopReading() {} // (Nothing to do: The index records are read from memory.  See "IndexRecords" below.)
 
   int mpegVersion();
       // returns the best guess for the version of MPEG being used for data within the underlying Transport Stream file.
@@ -66,11 +66,7 @@ public:
 private:
   MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName);
 
-  Boolean openFid();
-  Boolean seekToIndexRecord(unsigned long indexRecordNumber);
   Boolean readIndexRecord(unsigned long indexRecordNum); // into "fBuf"
-  Boolean readOneIndexRecord(unsigned long indexRecordNum); // closes "fFid" at end
-  void closeFid();
 
   u_int8_t recordTypeFromBuf() { return fBuf[0]; }
   u_int8_t offsetFromBuf() { return fBuf[1]; }
@@ -83,10 +79,9 @@ private:
       // used to implement "lookupTSPacketNumber()"
 
 private:
-  char* fFileName;
-  FILE* fFid; // used internally when reading from the file
+  class IndexRecords; // the contents of an index file - read once, then shared by each object that uses the file
+  IndexRecords* fIndexRecords;
   int fMPEGVersion;
-  unsigned long fCurrentIndexRecordNum; // within "fFid"
   float fCachedPCR;
   unsigned long fCachedTSPacketNumber, fCachedIndexRecordNumber;
   unsigned long fNumIndexRecords;
@@ -69,7 +69,10 @@ private:
 // A data structure that a sink may use for an output packet:
 class OutPacketBuffer {
 public:
-  OutPacketBuffer(unsigned preferredPacketSize, unsigned maxPacketSize);
+  OutPacketBuffer(unsigned preferredPacketSize, unsigned maxPacketSize,
+		  unsigned numExtraPackets = 0);
+      // "numExtraPackets" (if non-zero) adds room for this many more packets beyond "maxSize" bytes,
+      // so that several packets can be built (and kept) one after another before being sent.
   ~OutPacketBuffer();
 
   static unsigned maxSize;
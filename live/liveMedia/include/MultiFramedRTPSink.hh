@@ -26,6 +26,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTPSink.hh"
 #endif
 
+// Packets that are due to be sent at the same time are built one after another in our output buffer,
+// and then sent together (using a single system call, where possible).  A source that fragments frames
+// for us (see "frameDataInPlace()" below) can leave the payload of each fragment in its own buffer; it
+// is then sent from there, with only the headers being in our output buffer.  This is the most packets
+// that we'll hold back before sending:
+#define MAX_PENDING_RTP_PACKETS 8
+#define MAX_PENDING_RTP_PACKET_SAVED_TAIL_SIZE 64
+
 class MultiFramedRTPSink: public RTPSink {
 public:
   void setPacketSizes(unsigned preferredPacketSize, unsigned maxPacketSize);
@@ -72,6 +80,13 @@ protected:
       // frame of size "newFrameSize" to the current RTP packet.
       // (By default, this just calls "numOverflowBytes()", but subclasses can redefine
       // this to (e.g.) impose a granularity upon RTP payload fragments.)
+  virtual unsigned char const* frameDataInPlace(unsigned& numBytesInPlace,
+						Boolean& isKeptForNextFrame);
+      // called each time our source delivers a frame.  If the source delivered only the start of the
+      // frame to us, and left its last "numBytesInPlace" bytes in its own buffer, this returns where
+      // they are.  They must stay there, unchanged, until we next ask the source for a frame - or, if
+      // "isKeptForNextFrame", for as long as those of the next frame have to.  Such a frame is sent in
+      // a packet of its own, and "doSpecialFrameHandling()" sees only its start.  (default: NULL)
 
   // Functions that might be called by doSpecialFrameHandling(), or other subclass virtual functions:
   Boolean isFirstPacket() const { return fIsFirstPacket; }
@@ -101,6 +116,10 @@ private:
   void buildAndSendPacket(Boolean isFirstPacket);
   void packFrame();
   void sendPacketIfNecessary();
+  void checkFrameDataInPlace(unsigned frameSize);
+  void queuePacket();
+  Boolean savePendingPacketTail(unsigned nextPacketStart);
+  void sendPendingPackets();
   static void sendNext(void* firstArg);
   friend void sendNext(void*);
 
@@ -132,9 +151,27 @@ private:
   unsigned fCurFrameSpecificHeaderSize; // size in bytes of cur frame-specific header
   unsigned fTotalFrameSpecificHeaderSizes; // size of all frame-specific hdrs in pkt
   unsigned fOurMaxPacketSize;
+  unsigned char const* fFrameDataInPlace; // the end of the current frame, if left in place by our source
+  unsigned fNumFrameBytesInPlace;
+  Boolean fFrameDataInPlaceIsKept;
 
   onSendErrorFunc* fOnSendErrorFunc;
   void* fOnSendErrorData;
+
+  // Packets that have been built, but not yet sent:
+  struct pendingPacket {
+    unsigned char const* data; // in "fOutBuf"
+    unsigned size;
+    // The payload that follows, if it was left in place by our source:
+    unsigned char const* dataInPlace;
+    unsigned numBytesInPlace;
+    // The last few bytes of the packet, if they have since been overwritten (by the header of the next packet):
+    unsigned char savedTail[MAX_PENDING_RTP_PACKET_SAVED_TAIL_SIZE];
+    unsigned savedTailSize;
+  } fPendingPackets[MAX_PENDING_RTP_PACKETS];
+  unsigned fNumPendingPackets;
+  Boolean fPendingDataInPlaceExpires; // whether our source overwrites it when we ask for the next frame
+  Boolean* fFrameWasDeliveredPtr; // used by "packFrame()" to tell whether the source delivered synchronously
 };
 
 #endif
@@ -65,6 +65,9 @@ public:
   void setServerRequestAlternativeByteHandler(int socketNum, ServerRequestAlternativeByteHandler* handler, void* clientData);
 
   Boolean sendPacket(unsigned char* packet, unsigned packetSize);
+  Boolean sendPackets(packetPieces const* packets, unsigned numPackets);
+      // Sends several packets at once, each gathered from separate pieces of data
+      // (so that the caller need not first copy each packet into a single buffer).
   void startNetworkReading(TaskScheduler::BackgroundHandlerProc*
                            handlerProc);
   Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
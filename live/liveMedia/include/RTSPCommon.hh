@@ -53,5 +53,14 @@ Boolean parseRangeParam(char const* paramStr, double& rangeStart, double& rangeE
 Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd);
 
 char const* dateHeader(); // A "Date:" header that can be used in a RTSP (or HTTP) response 
+    // (The result is in a per-thread buffer on systems where RTSP servers can run in several threads;
+    //  see "RTSPServerWorkerPool".)
+
+#if defined(__WIN32__) || defined(_WIN32) || defined(_QNX4)
+#define RESULT_BUFFER_PER_THREAD
+#else
+#define RESULT_BUFFER_PER_THREAD __thread
+#define HAVE_GMTIME_R 1
+#endif
 
 #endif
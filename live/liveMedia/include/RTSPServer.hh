@@ -59,6 +59,8 @@ protected:
 
 #define RTSP_BUFFER_SIZE 10000 // for incoming requests, and outgoing responses
 
+class RTSPServerWorkerPool; // forward
+
 class RTSPServer: public Medium {
 public:
   static RTSPServer* createNew(UsageEnvironment& env, Port ourPort = 554,
@@ -101,12 +103,22 @@ public:
       // Note: RTSP-over-HTTP tunneling is described in http://developer.apple.com/quicktime/icefloe/dispatch028.html
   portNumBits httpServerPortNum() const; // in host byte order.  (Returns 0 if not present.)
 
+  void setWorkerPool(RTSPServerWorkerPool* workerPool) { fWorkerPool = workerPool; }
+      // If "workerPool" is non-NULL, then each newly-accepted connection is handed off to one of its
+      // worker servers (each running in its own thread) instead of being handled by us.
+      // (The caller remains responsible for deleting "workerPool", after first calling "setWorkerPool(NULL)".)
+  void addClientConnection(int clientSocket, struct sockaddr_in clientAddr);
+      // Starts handling a connection that has already been "accept()"ed (possibly by another server);
+      // used by "RTSPServerWorkerPool".
+
 protected:
   RTSPServer(UsageEnvironment& env,
 	     int ourSocket, Port ourPort,
 	     UserAuthenticationDatabase* authDatabase,
 	     unsigned reclamationTestSeconds);
       // called only by createNew();
+      // (A server that is to be used only as a "RTSPServerWorkerPool" worker has no socket of its own;
+      //  "ourSocket" is then -1, and "ourPort" is the port number that its acceptor server listens on.)
   virtual ~RTSPServer();
 
   static int setUpOurSocket(UsageEnvironment& env, Port& ourPort);
@@ -241,6 +253,7 @@ private:
   UserAuthenticationDatabase* fAuthDB;
   unsigned fReclamationTestSeconds;
   HashTable* fServerMediaSessions;
+  RTSPServerWorkerPool* fWorkerPool;
 };
 
 #endif
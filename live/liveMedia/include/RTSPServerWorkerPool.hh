@@ -0,0 +1,83 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2012 Live Networks, Inc.  All rights reserved.
+// A pool of RTSP servers - each running its own event loop, in its own thread - to which
+// an 'acceptor' RTSP server hands off its incoming client connections.
+// C++ header
+
+#ifndef _RTSP_SERVER_WORKER_POOL_HH
+#define _RTSP_SERVER_WORKER_POOL_HH
+
+#ifndef _RTSP_SERVER_HH
+#include "RTSPServer.hh"
+#endif
+
+// Each worker has its own "TaskScheduler", "UsageEnvironment" and "RTSPServer" (and therefore its own
+// "ServerMediaSession"s, sources and sinks), so no "liveMedia" object is ever used by more than one thread.
+// The data shared between workers is either read-only, and reference-counted (e.g., the contents of
+// Transport Stream index files - see "MPEG2TransportStreamIndexFile"), or updated atomically or under a
+// lock: the "DelayQueueEntry" token counter, and the static "Groupsock" traffic statistics.
+//
+// Usage:
+//   acceptor = RTSPServer::createNew(env, port, ...); // or a subclass; this is the only server that listens
+//   pool = RTSPServerWorkerPool::createNew(numWorkers, port, createWorkerServer, clientData);
+//   if (pool != NULL) acceptor->setWorkerPool(pool);
+//
+// Note: Worker pools are currently implemented only on POSIX systems (using "pthreads" and pipes);
+// elsewhere, "createNew()" returns NULL, and the acceptor handles all connections itself.
+
+class RTSPServerWorkerPool {
+public:
+  typedef RTSPServer* (createWorkerServerFunc)(Port ourPort, void* clientData);
+      // Called - once for each worker, by the thread that calls "createNew()" - to create the worker's server.
+      // It must create a new "TaskScheduler" and "UsageEnvironment" (that will then be used only by the
+      // worker's thread), and a server (in that environment) that has no socket of its own
+      // (i.e., constructed with "ourSocket" == -1, and "ourPort" == the acceptor's port).
+      // The pool becomes responsible for closing the server, and for reclaiming its environment and scheduler.
+
+  static RTSPServerWorkerPool* createNew(unsigned numWorkers, Port ourPort,
+					 createWorkerServerFunc* createWorkerServer, void* clientData);
+      // Returns NULL if no worker could be started.
+
+  virtual ~RTSPServerWorkerPool();
+      // Stops each worker's thread, and then closes its server.  (This is intended for use at shutdown:
+      // client sessions that are still open at that point are abandoned, rather than closed.)
+
+  unsigned numWorkers() const { return fNumWorkers; }
+
+  Boolean handOffConnection(int clientSocket, struct sockaddr_in const& clientAddr,
+			    Boolean assignByClientAddress = False);
+      // Called by the acceptor server, for each "accept()"ed connection.  The connection is assigned to the
+      // workers in turn, unless "assignByClientAddress" is True (in which case each client IP address
+      // is always assigned to the same worker).
+      // Returns False (leaving "clientSocket" open) if the chosen worker cannot take the connection now.
+      // A connection that is assigned by client address is never returned to the acceptor, though (the
+      // client's other connections may be with the worker): if the worker still cannot take it after a
+      // short wait, it is closed instead.
+
+private:
+  RTSPServerWorkerPool(unsigned numWorkers);
+
+  class Worker; // defined in the ".cpp" file
+
+private:
+  unsigned fNumWorkers;
+  Worker** fWorkers;
+  unsigned fNextWorker;
+};
+
+#endif
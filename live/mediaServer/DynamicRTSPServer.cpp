@@ -32,6 +32,13 @@ DynamicRTSPServer::createNew(UsageEnvironment& env, Port ourPort,
   return new DynamicRTSPServer(env, ourSocket, ourPort, authDatabase, reclamationTestSeconds);
 }
 
+DynamicRTSPServer*
+DynamicRTSPServer::createNewWorker(UsageEnvironment& env, Port ourPort,
+				   UserAuthenticationDatabase* authDatabase,
+				   unsigned reclamationTestSeconds) {
+  return new DynamicRTSPServer(env, -1, ourPort, authDatabase, reclamationTestSeconds);
+}
+
 DynamicRTSPServer::DynamicRTSPServer(UsageEnvironment& env, int ourSocket,
 				     Port ourPort,
 				     UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds)
@@ -30,6 +30,10 @@ public:
   static DynamicRTSPServer* createNew(UsageEnvironment& env, Port ourPort,
 				      UserAuthenticationDatabase* authDatabase,
 				      unsigned reclamationTestSeconds = 65);
+  static DynamicRTSPServer* createNewWorker(UsageEnvironment& env, Port ourPort,
+					    UserAuthenticationDatabase* authDatabase,
+					    unsigned reclamationTestSeconds = 65);
+      // creates a server (without a socket of its own) for use in a "RTSPServerWorkerPool"
 
 protected:
   DynamicRTSPServer(UsageEnvironment& env, int ourSocket, Port ourPort,
@@ -19,13 +19,50 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include <BasicUsageEnvironment.hh>
 #include "DynamicRTSPServer.hh"
+#include "RTSPServerWorkerPool.hh"
 #include "version.hh"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__WIN32__) || defined(_WIN32)
+#else
+#include <unistd.h>
+#endif
+
+static TaskScheduler* createTaskScheduler() {
+  // Prefer the "epoll()"-based scheduler, which is not limited to FD_SETSIZE sockets (i.e., about 1000 clients):
+  TaskScheduler* scheduler = EpollTaskScheduler::createNew();
+  if (scheduler == NULL) scheduler = BasicTaskScheduler::createNew();
+  return scheduler;
+}
+
+static RTSPServer* createWorkerServer(Port ourPort, void* authDB) {
+  TaskScheduler* scheduler = createTaskScheduler();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+  return DynamicRTSPServer::createNewWorker(*env, ourPort, (UserAuthenticationDatabase*)authDB);
+}
+
+static unsigned defaultNumThreads() {
+#if defined(_SC_NPROCESSORS_ONLN)
+  long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  if (numCPUs > 1) return (unsigned)numCPUs;
+#endif
+  return 1;
+}
 
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
-  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  TaskScheduler* scheduler = createTaskScheduler();
   UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
 
+  // By default, we stream from one thread per CPU; "-t <number-of-threads>" overrides this:
+  unsigned numThreads = defaultNumThreads();
+  if (argc == 3 && strcmp(argv[1], "-t") == 0 && atoi(argv[2]) > 0) {
+    numThreads = (unsigned)atoi(argv[2]);
+  } else if (argc != 1) {
+    *env << "Usage: " << argv[0] << " [-t <number-of-threads>]\n";
+    exit(1);
+  }
+
   UserAuthenticationDatabase* authDB = NULL;
 #ifdef ACCESS_CONTROL
   // To implement client access control to the RTSP server, do the following:
@@ -49,6 +86,14 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
+  // If we're using more than one thread, then our server just accepts connections, and each
+  // connection is then handled by one of several "worker" servers, each running in its own thread:
+  RTSPServerWorkerPool* workerPool = NULL;
+  if (numThreads > 1) {
+    workerPool = RTSPServerWorkerPool::createNew(numThreads, rtspServerPortNum, createWorkerServer, authDB);
+    if (workerPool != NULL) rtspServer->setWorkerPool(workerPool);
+  }
+
   *env << "LIVE555 Media Server\n";
   *env << "\tversion " << MEDIA_SERVER_VERSION_STRING
        << " (LIVE555 Streaming Media library version "
@@ -83,6 +128,10 @@ int main(int argc, char** argv) {
     *env << "(RTSP-over-HTTP tunneling is not available.)\n";
   }
 
+  if (workerPool != NULL) {
+    *env << "(Clients are served by " << workerPool->numWorkers() << " threads.)\n";
+  }
+
   env->taskScheduler().doEventLoop(); // does not return
 
   return 0; // only to prevent compiler warning
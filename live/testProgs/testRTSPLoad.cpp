@@ -0,0 +1,269 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2012, Live Networks, Inc.  All rights reserved
+// A load test for RTSP servers: opens many concurrent RTSP sessions on the same "rtsp://" URL
+// (DESCRIBE, SETUP, PLAY), receives (and discards) their data for a while, and reports how many
+// sessions reached the "PLAY" state, how long that took, and how much data each received.
+// main program
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh" // for "gettimeofday()"
+#include <stdlib.h>
+#include <string.h>
+
+// Parameters (set from the command line):
+static unsigned numSessions = 1000;
+static unsigned sessionsPerSecond = 200; // how quickly new sessions are started
+static unsigned testDuration = 30; // seconds, counted from the start of the first session
+static Boolean streamUsingTCP = False;
+static Boolean useSelect = False;
+
+// Statistics:
+static unsigned numStarted = 0, numPlaying = 0, numFailed = 0;
+static double totalSetupTime = 0.0, maxSetupTime = 0.0; // seconds, from "DESCRIBE" to the "PLAY" response
+static u_int64_t totalBytesReceived = 0;
+static struct timeval startTime;
+static char const* rtspURL = NULL;
+static char const* progName = NULL;
+
+static double secondsSince(struct timeval const& since) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - since.tv_sec) + (now.tv_usec - since.tv_usec)/1000000.0;
+}
+
+// Per-session state:
+
+class LoadRTSPClient: public RTSPClient {
+public:
+  static LoadRTSPClient* createNew(UsageEnvironment& env, char const* url) {
+    return new LoadRTSPClient(env, url);
+  }
+
+protected:
+  LoadRTSPClient(UsageEnvironment& env, char const* url)
+    : RTSPClient(env, url, 0, progName, 0),
+      iter(NULL), session(NULL), subsession(NULL) {
+    gettimeofday(&fStartTime, NULL);
+  }
+  virtual ~LoadRTSPClient() {
+    delete iter;
+    if (session != NULL) {
+      MediaSubsessionIterator it(*session);
+      MediaSubsession* sub;
+      while ((sub = it.next()) != NULL) Medium::close(sub->sink);
+      Medium::close(session);
+    }
+  }
+
+public:
+  MediaSubsessionIterator* iter;
+  MediaSession* session;
+  MediaSubsession* subsession;
+  struct timeval fStartTime;
+};
+
+// A sink that just counts (and discards) the data that it receives:
+
+class CountingSink: public MediaSink {
+public:
+  static CountingSink* createNew(UsageEnvironment& env) {
+    return new CountingSink(env);
+  }
+
+private:
+  CountingSink(UsageEnvironment& env) : MediaSink(env) {
+    fReceiveBuffer = new u_int8_t[RECEIVE_BUFFER_SIZE];
+  }
+  virtual ~CountingSink() {
+    delete[] fReceiveBuffer;
+  }
+
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+				struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    totalBytesReceived += frameSize;
+    ((CountingSink*)clientData)->continuePlaying();
+  }
+
+  virtual Boolean continuePlaying() {
+    if (fSource == NULL) return False;
+    fSource->getNextFrame(fReceiveBuffer, RECEIVE_BUFFER_SIZE,
+			  afterGettingFrame, this, onSourceClosure, this);
+    return True;
+  }
+
+private:
+  enum { RECEIVE_BUFFER_SIZE = 100000 };
+  u_int8_t* fReceiveBuffer;
+};
+
+static void sessionFailed(RTSPClient* rtspClient, char const* what, char const* why) {
+  UsageEnvironment& env = rtspClient->envir();
+  if (numFailed < 10) env << "Session failed (" << what << "): " << (why == NULL ? env.getResultMsg() : why) << "\n";
+  ++numFailed;
+  Medium::close(rtspClient);
+}
+
+static void setupNextSubsession(RTSPClient* rtspClient);
+
+static void continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  LoadRTSPClient* client = (LoadRTSPClient*)rtspClient;
+  if (resultCode != 0) {
+    sessionFailed(rtspClient, "PLAY", resultString);
+  } else {
+    double setupTime = secondsSince(client->fStartTime);
+    totalSetupTime += setupTime;
+    if (setupTime > maxSetupTime) maxSetupTime = setupTime;
+    ++numPlaying;
+  }
+  delete[] resultString;
+}
+
+static void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  LoadRTSPClient* client = (LoadRTSPClient*)rtspClient;
+  delete[] resultString;
+  if (resultCode != 0) {
+    sessionFailed(rtspClient, "SETUP", NULL);
+    return;
+  }
+
+  client->subsession->sink = CountingSink::createNew(rtspClient->envir());
+  if (client->subsession->sink != NULL) {
+    client->subsession->sink->startPlaying(*(client->subsession->readSource()), NULL, NULL);
+  }
+  setupNextSubsession(rtspClient);
+}
+
+static void setupNextSubsession(RTSPClient* rtspClient) {
+  LoadRTSPClient* client = (LoadRTSPClient*)rtspClient;
+
+  while ((client->subsession = client->iter->next()) != NULL) {
+    if (!client->subsession->initiate()) continue; // skip this subsession
+
+    rtspClient->sendSetupCommand(*client->subsession, continueAfterSETUP, False, streamUsingTCP);
+    return;
+  }
+
+  // We've finished setting up all of the subsessions.  Now, send a RTSP "PLAY" command to start the streaming:
+  rtspClient->sendPlayCommand(*client->session, continueAfterPLAY);
+}
+
+static void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString) {
+  LoadRTSPClient* client = (LoadRTSPClient*)rtspClient;
+  if (resultCode != 0) {
+    sessionFailed(rtspClient, "DESCRIBE", resultString);
+    delete[] resultString;
+    return;
+  }
+
+  client->session = MediaSession::createNew(rtspClient->envir(), resultString);
+  delete[] resultString;
+  if (client->session == NULL || !client->session->hasSubsessions()) {
+    sessionFailed(rtspClient, "SDP", NULL);
+    return;
+  }
+
+  client->iter = new MediaSubsessionIterator(*client->session);
+  setupNextSubsession(rtspClient);
+}
+
+static void startNextSessions(void* clientData) {
+  UsageEnvironment& env = *(UsageEnvironment*)clientData;
+
+  // Start sessions at the requested rate, 10 times a second:
+  unsigned toStart = sessionsPerSecond/10;
+  if (toStart == 0) toStart = 1;
+  for (unsigned i = 0; i < toStart && numStarted < numSessions; ++i) {
+    RTSPClient* rtspClient = LoadRTSPClient::createNew(env, rtspURL);
+    ++numStarted;
+    if (rtspClient == NULL) {
+      ++numFailed;
+      continue;
+    }
+    rtspClient->sendDescribeCommand(continueAfterDESCRIBE);
+  }
+
+  if (numStarted < numSessions) {
+    env.taskScheduler().scheduleDelayedTask(100000, startNextSessions, clientData);
+  }
+}
+
+static void printReport(UsageEnvironment& env) {
+  double elapsed = secondsSince(startTime);
+  char line[300];
+
+  sprintf(line, "%.1fs: %u started, %u playing, %u failed; setup time avg %.3fs, max %.3fs; received %.1f kBytes/s per playing session\n",
+	  elapsed, numStarted, numPlaying, numFailed,
+	  numPlaying == 0 ? 0.0 : totalSetupTime/numPlaying, maxSetupTime,
+	  (numPlaying == 0 || elapsed <= 0.0) ? 0.0 : totalBytesReceived/1000.0/elapsed/numPlaying);
+  env << line;
+}
+
+static void reportTask(void* clientData) {
+  UsageEnvironment& env = *(UsageEnvironment*)clientData;
+  printReport(env);
+  env.taskScheduler().scheduleDelayedTask(5000000, reportTask, clientData);
+}
+
+static char endOfTest = 0;
+static void endTest(void* /*clientData*/) {
+  endOfTest = 1;
+}
+
+static void usage(UsageEnvironment& env) {
+  env << "Usage: " << progName << " [-n <number-of-sessions>] [-r <new-sessions-per-second>] [-d <test-duration-seconds>] [-t] [-s] <rtsp-url>\n";
+  env << "\t-t: stream RTP over the RTSP TCP connection\n";
+  env << "\t-s: use the \"select()\"-based task scheduler, even if \"epoll()\" is available\n";
+}
+
+int main(int argc, char** argv) {
+  progName = argv[0];
+
+  int i;
+  for (i = 1; i < argc && argv[i][0] == '-'; ++i) {
+    char const* opt = argv[i];
+    if (strcmp(opt, "-t") == 0) streamUsingTCP = True;
+    else if (strcmp(opt, "-s") == 0) useSelect = True;
+    else if (i+1 < argc && strcmp(opt, "-n") == 0) numSessions = atoi(argv[++i]);
+    else if (i+1 < argc && strcmp(opt, "-r") == 0) sessionsPerSecond = atoi(argv[++i]);
+    else if (i+1 < argc && strcmp(opt, "-d") == 0) testDuration = atoi(argv[++i]);
+    else break;
+  }
+
+  TaskScheduler* scheduler = useSelect ? NULL : EpollTaskScheduler::createNew();
+  if (scheduler == NULL) scheduler = BasicTaskScheduler::createNew();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+  if (i != argc-1) {
+    usage(*env);
+    return 1;
+  }
+  rtspURL = argv[i];
+  // Note: Each session uses a RTSP socket, plus (unless "-t") 2 sockets per subsession, so the
+  // process's file descriptor limit ("ulimit -n") may need to be raised.
+
+  *env << "Starting " << numSessions << " sessions on \"" << rtspURL << "\", for " << testDuration << " seconds\n";
+
+  gettimeofday(&startTime, NULL);
+  startNextSessions(env);
+  scheduler->scheduleDelayedTask(5000000, reportTask, env);
+  scheduler->scheduleDelayedTask(testDuration*1000000LL, endTest, NULL);
+  env->taskScheduler().doEventLoop(&endOfTest);
+
+  printReport(*env);
+  return (numPlaying + numFailed == 0 || numFailed > 0) ? 1 : 0;
+}
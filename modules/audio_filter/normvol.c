@@ -59,6 +59,7 @@ struct filter_sys_t
     int i_nb;
     float *p_last;
     float f_max;
+    const vlc_var_handle_t *p_max_level; /* "norm-max-level", read per block */
 };
 
 /*****************************************************************************
@@ -106,6 +107,7 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
     p_sys->i_nb = var_CreateGetInteger( p_filter->p_parent, "norm-buff-size" );
     p_sys->f_max = var_CreateGetFloat( p_filter->p_parent, "norm-max-level" );
+    p_sys->p_max_level = var_Handle( "norm-max-level" );
 
     if( p_sys->f_max <= 0 ) p_sys->f_max = 0.01;
 
@@ -187,7 +189,7 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
         f_average = f_average / p_sys->i_nb;
 
         /* Seuil arbitraire */
-        p_sys->f_max = var_GetFloat( p_filter->p_parent, "norm-max-level" );
+        p_sys->f_max = var_GetFloatFast( p_filter->p_parent, p_sys->p_max_level );
 
         //fprintf(stderr,"Average %f, max %f\n", f_average, p_sys->f_max );
         if( f_average > p_sys->f_max )
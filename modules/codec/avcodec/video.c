@@ -61,6 +61,11 @@ struct decoder_sys_t
     bool b_hurry_up;
     enum AVDiscard i_skip_frame;// ֡
     enum AVDiscard i_skip_idct;
+    enum AVDiscard i_skip_loop_filter;
+
+    /* degradation level chosen from the video output feedback */
+    int     i_hurry_level;
+    mtime_t i_hurry_date;
 
     /* how many decoded frames are late */
     int     i_late_frames;
@@ -105,6 +110,7 @@ struct decoder_sys_t
  *****************************************************************************/
 static void ffmpeg_InitCodec      ( decoder_t * );
 static void ffmpeg_CopyPicture    ( decoder_t *, picture_t *, AVFrame * );
+static void ffmpeg_HurryUp        ( decoder_t *, block_t * );
 static int  ffmpeg_GetFrameBuf    ( struct AVCodecContext *, AVFrame * );
 static void ffmpeg_ReleaseFrameBuf( struct AVCodecContext *, AVFrame * );
 static enum PixelFormat ffmpeg_GetFormat( AVCodecContext *,
@@ -176,6 +182,24 @@ static inline picture_t *ffmpeg_NewPictBuf( decoder_t *p_dec,
         p_dec->fmt_out.video.i_frame_rate_base = p_context->time_base.num * __MAX( p_context->ticks_per_frame, 1 );
     }
 
+    /* Ask the video output for pictures libavcodec can decode into */
+    if( p_sys->b_direct_rendering && !p_sys->p_va )
+    {
+        int i_width = p_context->width;
+        int i_height = p_context->height;
+        int pi_linesize_align[AV_NUM_DATA_POINTERS];
+        unsigned i_align = 16;
+
+        avcodec_align_dimensions2( p_context, &i_width, &i_height,
+                                   pi_linesize_align );
+        for( int i = 0; i < AV_NUM_DATA_POINTERS; i++ )
+            i_align = __MAX( i_align, (unsigned)pi_linesize_align[i] );
+
+        p_dec->picture_layout.i_align  = i_align;
+        p_dec->picture_layout.i_width  = i_width;
+        p_dec->picture_layout.i_height = i_height;
+    }
+
     return decoder_NewPicture( p_dec );
 }
 
@@ -227,6 +251,7 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     else if( i_val == 3 ) p_sys->p_context->skip_loop_filter = AVDISCARD_NONKEY;
     else if( i_val == 2 ) p_sys->p_context->skip_loop_filter = AVDISCARD_BIDIR;
     else if( i_val == 1 ) p_sys->p_context->skip_loop_filter = AVDISCARD_NONREF;
+    p_sys->i_skip_loop_filter = p_sys->p_context->skip_loop_filter;
 
     if( var_CreateGetBool( p_dec, "avcodec-fast" ) )
         p_sys->p_context->flags2 |= CODEC_FLAG2_FAST;
@@ -376,6 +401,8 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     p_sys->b_first_frame = true;
     p_sys->b_flush = false;
     p_sys->i_late_frames = 0;
+    p_sys->i_hurry_level = 0;
+    p_sys->i_hurry_date = 0;
 
     /* Set output properties */
     p_dec->fmt_out.i_cat = VIDEO_ES;
@@ -498,6 +525,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         }
         block_Release( p_block );
         p_sys->i_late_frames--;
+        p_dec->i_skipped_pictures++;
         return NULL;
     }
 
@@ -518,6 +546,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
             /* picture too late, won't decode
              * but break picture until a new I, and for mpeg4 ...*/
             p_sys->i_late_frames--; /* needed else it will never be decrease */
+            p_dec->i_skipped_pictures++;
             block_Release( p_block );
             return NULL;
         }
@@ -525,7 +554,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
     else
     {
         if( p_sys->b_hurry_up )
-            p_context->skip_frame = p_sys->i_skip_frame;
+            ffmpeg_HurryUp( p_dec, p_block );
         if( !(p_block->i_flags & BLOCK_FLAG_PREROLL) )
             b_drawpicture = 1;
         else
@@ -601,6 +630,12 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         }
         wait_mt( p_sys );
 
+        /* Every packet gives a picture once the pipeline of the decoder is
+         * full, so a missing one while hurrying up has been skipped */
+        if( i_used > 0 && !b_gotpicture &&
+            p_context->skip_frame > p_sys->i_skip_frame )
+            p_dec->i_skipped_pictures++;
+
         if( p_sys->b_flush )
             p_sys->b_first_frame = true;
 
@@ -706,6 +741,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
             /* Fill p_picture_t from AVVideoFrame and do chroma conversion
              * if needed */
             ffmpeg_CopyPicture( p_dec, p_pic, p_sys->p_ff_pic );
+            p_dec->i_copied_pictures++;
         }
         else
         {
@@ -847,6 +883,75 @@ static void ffmpeg_InitCodec( decoder_t *p_dec )
     }
 }
 
+/*****************************************************************************
+ * ffmpeg_HurryUp: choose what to skip from the video output feedback
+ *****************************************************************************
+ * The level is raised as soon as the displayed pictures get late and it is
+ * lowered slowly once the video output keeps up again:
+ *  1: no loop filter on non reference pictures,
+ *  2: no non reference pictures,
+ *  3: no loop filter at all.
+ * Independently, a non reference picture is skipped when it cannot be
+ * decoded and rendered before its display date.
+ *****************************************************************************/
+#define HURRY_UP_LEVEL_MAX      3
+#define HURRY_UP_LATE           INT64_C(20000)
+#define HURRY_UP_RAISE_DELAY    INT64_C(250000)
+#define HURRY_UP_LOWER_DELAY    INT64_C(2000000)
+
+static void ffmpeg_HurryUp( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    AVCodecContext *p_context = p_sys->p_context;
+    decoder_feedback_t feedback;
+    bool b_late = false;
+
+    if( !p_dec->b_pace_control && !(p_block->i_flags & BLOCK_FLAG_PREROLL) &&
+        !decoder_GetDisplayFeedback( p_dec, &feedback ) )
+    {
+        const mtime_t i_now = mdate();
+        const mtime_t i_elapsed = i_now - p_sys->i_hurry_date;
+        int i_level = p_sys->i_hurry_level;
+
+        if( feedback.i_late > HURRY_UP_LATE &&
+            i_level < HURRY_UP_LEVEL_MAX && i_elapsed > HURRY_UP_RAISE_DELAY )
+            i_level++;
+        else if( feedback.i_late < HURRY_UP_LATE / 4 &&
+                 i_level > 0 && i_elapsed > HURRY_UP_LOWER_DELAY )
+            i_level--;
+
+        if( i_level != p_sys->i_hurry_level )
+        {
+            msg_Dbg( p_dec, "hurry up level %d -> %d (late %"PRId64" ms, "
+                     "render %"PRId64" ms)", p_sys->i_hurry_level, i_level,
+                     feedback.i_late / 1000, feedback.i_render / 1000 );
+            p_sys->i_hurry_level = i_level;
+            p_sys->i_hurry_date = i_now;
+        }
+
+        if( p_block->i_pts > VLC_TS_INVALID )
+        {
+            const mtime_t i_date = decoder_GetDisplayDate( p_dec, p_block->i_pts );
+            b_late = i_date > VLC_TS_INVALID &&
+                     i_date - feedback.i_render < i_now;
+        }
+    }
+
+    const int i_level = p_sys->i_hurry_level;
+    enum AVDiscard i_skip_frame = p_sys->i_skip_frame;
+    enum AVDiscard i_skip_loop_filter = p_sys->i_skip_loop_filter;
+
+    if( (i_level >= 2 || b_late) && i_skip_frame < AVDISCARD_NONREF )
+        i_skip_frame = AVDISCARD_NONREF;
+    if( i_level >= 3 )
+        i_skip_loop_filter = AVDISCARD_ALL;
+    else if( i_level >= 1 && i_skip_loop_filter < AVDISCARD_NONREF )
+        i_skip_loop_filter = AVDISCARD_NONREF;
+
+    p_context->skip_frame = i_skip_frame;
+    p_context->skip_loop_filter = i_skip_loop_filter;
+}
+
 /*****************************************************************************
  * ffmpeg_CopyPicture: copy a picture from ffmpeg internal buffers to a
  *                     picture_t structure (when not in direct rendering mode).
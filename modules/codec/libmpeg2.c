@@ -388,6 +388,10 @@ static picture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                                        p_info->sequence->flags & SEQ_FLAG_LOW_DELAY );
 
 
+            decoder_feedback_t feedback;
+            if( decoder_GetDisplayFeedback( p_dec, &feedback ) )
+                feedback.i_render = 0;
+
             bool b_skip = false;
             if( !p_dec->b_pace_control && !p_sys->b_preroll &&
                 !(p_sys->b_slice_i
@@ -396,7 +400,7 @@ static picture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                    && !decoder_SynchroChoose( p_sys->p_synchro,
                               p_current->flags
                                 & PIC_MASK_CODING_TYPE,
-                              /*p_sys->p_vout->render_time*/ 0 /*FIXME*/,
+                              feedback.i_render,
                               p_info->sequence->flags & SEQ_FLAG_LOW_DELAY ) )
             {
                 b_skip = true;
@@ -409,6 +409,13 @@ static block_t *DecodeFrame( decoder_t *p_dec, block_t **pp_block )
 
         if( p_sys->i_chans_to_reorder )
         {
+            /* The payload may be shared with the recorder */
+            p_block = block_Unshare( p_block );
+            if( p_block == NULL )
+            {
+                block_Release( p_aout_buffer );
+                return NULL;
+            }
             aout_ChannelReorder( p_block->p_buffer, p_block->i_buffer,
                                  p_sys->i_chans_to_reorder, p_sys->pi_chan_table,
                                  p_dec->fmt_out.i_codec );
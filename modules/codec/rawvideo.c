@@ -355,6 +355,11 @@ static block_t *SendFrame( decoder_t *p_dec, block_t *p_block )
 
     if( p_sys->b_invert )
     {
+        /* The picture is flipped in place */
+        p_block = block_Unshare( p_block );
+        if( p_block == NULL )
+            return NULL;
+
         picture_t pic;
         uint8_t *p_tmp, *p_pixels;
         int i, j;
@@ -134,6 +134,13 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define FAST_ZAP_TEXT N_("Fast channel change")
+#define FAST_ZAP_LONGTEXT N_( \
+    "Keep receiving the programs which are not selected and cache their " \
+    "data from the last video key frame, so that switching to one of them " \
+    "starts playing from that cache instead of waiting for the next key " \
+    "frame. It needs more CPU and memory (up to 8 MiB per program)." )
+
 
 vlc_module_begin ()
     set_description( N_("MPEG Transport Stream demuxer") )
@@ -157,6 +164,7 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-fast-zap", false, FAST_ZAP_TEXT, FAST_ZAP_LONGTEXT, true )
 
     add_obsolete_bool( "ts-silent" );
 
@@ -207,6 +215,30 @@ typedef struct
 
 } iod_descriptor_t;
 
+/* Data of a program which is not selected, cached from the last video key
+ * frame for the fast channel change (ts-fast-zap). The cache belongs to the
+ * demuxer: it is lost when the input is re-created (a VLM media stopped and
+ * started again, for instance). */
+#define TS_ZAP_MAX_SIZE (8 * 1024 * 1024)         /* per program */
+#define TS_ZAP_MAX_TOTAL_SIZE (32 * 1024 * 1024)  /* for all the programs */
+
+typedef struct
+{
+    es_out_id_t     *id;    /* NULL for a PCR */
+    block_t         *p_block;
+    mtime_t         i_pcr;
+} ts_zap_entry_t;
+
+typedef struct
+{
+    bool            b_keyframe;
+    int             i_entries;
+    int             i_alloc;
+    ts_zap_entry_t  *p_entries;
+    size_t          i_size;
+    size_t          *pi_total_size; /* of all the programs */
+} ts_zap_t;
+
 typedef struct
 {
     dvbpsi_handle   handle;
@@ -218,6 +250,9 @@ typedef struct
     /* IOD stuff (mpeg4) */
     iod_descriptor_t *iod;
 
+    /* Fast channel change */
+    ts_zap_t        zap;
+
 } ts_prg_psi_t;
 
 typedef struct
@@ -251,6 +286,9 @@ typedef struct
 
     es_mpeg4_descriptor_t *p_mpeg4desc;
 
+    /* random_access_indicator of the PES being gathered */
+    bool        b_random_access;
+
 } ts_es_t;
 
 typedef struct
@@ -310,6 +348,8 @@ struct demux_sys_t
     csa_t       *csa;
     int         i_csa_pkt_size;
     bool        b_split_es;
+    bool        b_fast_zap;
+    size_t      i_zap_size; /* cached by all the programs */
 
     bool        b_udp_out;
     int         fd; /* udp socket */
@@ -368,6 +408,14 @@ static void GetLastPCR( demux_t *p_demux );
 static void CheckPCR( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, block_t * );
 
+static void ZapReset( ts_zap_t * );
+static bool ZapAppend( demux_sys_t *, ts_zap_t *, es_out_id_t *, block_t *,
+                       mtime_t i_pcr );
+static void ZapReplay( demux_t *, ts_prg_psi_t * );
+static ts_prg_psi_t *ZapProgram( demux_t *, ts_pid_t * );
+static bool ZapIsKeyFrame( const ts_es_t *, const block_t * );
+static bool ProgramIsSelected( demux_t *, uint16_t i_pgrm );
+
 static void              IODFree( iod_descriptor_t * );
 
 #define TS_USER_PMT_NUMBER (0)
@@ -784,6 +832,7 @@ static int Open( vlc_object_t *p_this )
     free( psz_string );
 
     p_sys->b_split_es = var_InheritBool( p_demux, "ts-split-es" );
+    p_sys->b_fast_zap = var_InheritBool( p_demux, "ts-fast-zap" );
 
     p_sys->i_pid_ref_pcr = -1;
     p_sys->i_first_pcr = -1;
@@ -1162,8 +1211,17 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( i_int > 0 )
         {
+            const bool b_changed = p_sys->i_current_program != i_int;
+
             p_sys->i_current_program = i_int;
             SetPrgFilter( p_demux, p_sys->i_current_program, true );
+            if( b_changed && p_sys->b_fast_zap )
+            {
+                for( int i = 0; i < p_sys->i_pmt; i++ )
+                    for( int i_prg = 0; i_prg < p_sys->pmt[i]->psi->i_prg; i_prg++ )
+                        if( p_sys->pmt[i]->psi->prg[i_prg]->i_number == i_int )
+                            ZapReplay( p_demux, p_sys->pmt[i]->psi->prg[i_prg] );
+            }
         }
         else if( i_int < 0 )
         {
@@ -1391,6 +1449,10 @@ static void SetPrgFilter( demux_t *p_demux, int i_prg_id, bool b_selected )
         return;
     assert( p_prg );
 
+    /* Unselected programs are still received to be cached */
+    if( !b_selected && p_sys->b_fast_zap )
+        return;
+
     SetPIDFilter( p_demux, i_pmt_pid, b_selected );
     if( p_prg->i_pid_pcr > 0 )
         SetPIDFilter( p_demux, p_prg->i_pid_pcr, b_selected );
@@ -1454,6 +1516,7 @@ static void PIDInit( ts_pid_t *pid, bool b_psi, ts_psi_t *p_owner )
             prg->i_pcr_value= -1;
             prg->iod        = NULL;
             prg->handle     = NULL;
+            memset( &prg->zap, 0, sizeof( prg->zap ) );
 
             TAB_APPEND( (ts_prg_psi_t **), pid->psi->i_prg, pid->psi->prg, prg );			// sunqueen modify
         }
@@ -1493,6 +1556,8 @@ static void PIDClean( demux_t *p_demux, ts_pid_t *pid )
         {
             if( pid->psi->prg[i]->iod )
                 IODFree( pid->psi->prg[i]->iod );
+            ZapReset( &pid->psi->prg[i]->zap );
+            free( pid->psi->prg[i]->zap.p_entries );
             if( pid->psi->prg[i]->handle )
             {
 #if (DVBPSI_VERSION_INT >= DVBPSI_VERSION_WANTED(1,0,0))
@@ -1752,6 +1817,37 @@ static void ParsePES( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
             }
         }
 
+        ts_prg_psi_t *p_zap_prg = ZapProgram( p_demux, pid );
+        if( p_zap_prg )
+        {
+            /* Not selected: keep it if it belongs to the last GOP */
+            ts_zap_t *p_zap = &p_zap_prg->zap;
+
+            if( pid->es->fmt.i_cat == VIDEO_ES &&
+                ZapIsKeyFrame( pid->es, p_block ) )
+            {
+                ZapReset( p_zap );
+                p_zap->b_keyframe = true;
+            }
+            if( p_zap->b_keyframe )
+            {
+                bool b_ok = true;
+                for( int i = 0; b_ok && i < pid->i_extra_es; i++ )
+                {
+                    block_t *p_dup = block_Duplicate( p_block );
+                    b_ok = p_dup && ZapAppend( p_demux->p_sys, p_zap,
+                                               pid->extra_es[i]->id, p_dup, -1 );
+                }
+                if( b_ok && ZapAppend( p_demux->p_sys, p_zap, pid->es->id,
+                                       p_block, -1 ) )
+                    return;
+                /* Too much data since the key frame */
+                ZapReset( p_zap );
+            }
+            block_Release( p_block );
+            return;
+        }
+
         for( int i = 0; i < pid->i_extra_es; i++ )
         {
             es_out_Send( p_demux->out, pid->extra_es[i]->id,
@@ -1766,6 +1862,170 @@ static void ParsePES( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
     }
 }
 
+/*****************************************************************************
+ * Fast channel change
+ *****************************************************************************/
+static void ZapReset( ts_zap_t *p_zap )
+{
+    for( int i = 0; i < p_zap->i_entries; i++ )
+    {
+        if( p_zap->p_entries[i].p_block )
+            block_Release( p_zap->p_entries[i].p_block );
+    }
+    if( p_zap->pi_total_size )
+        *p_zap->pi_total_size -= p_zap->i_size;
+    p_zap->i_entries = 0;
+    p_zap->i_size = 0;
+    p_zap->b_keyframe = false;
+}
+
+/* Takes p_block (or a PCR if NULL), returns false if the cache is full.
+ * When all the programs together reach their budget, the program which
+ * cannot append waits for its next key frame. */
+static bool ZapAppend( demux_sys_t *p_sys, ts_zap_t *p_zap, es_out_id_t *id,
+                       block_t *p_block, mtime_t i_pcr )
+{
+    if( p_block )
+    {
+        if( p_zap->i_size + p_block->i_buffer > TS_ZAP_MAX_SIZE ||
+            p_sys->i_zap_size + p_block->i_buffer > TS_ZAP_MAX_TOTAL_SIZE )
+        {
+            block_Release( p_block );
+            return false;
+        }
+        p_zap->pi_total_size = &p_sys->i_zap_size;
+        p_zap->i_size += p_block->i_buffer;
+        p_sys->i_zap_size += p_block->i_buffer;
+    }
+
+    if( p_zap->i_entries >= p_zap->i_alloc )
+    {
+        const int i_alloc = __MAX( 2 * p_zap->i_alloc, 256 );
+        ts_zap_entry_t *p_entries = (ts_zap_entry_t *)realloc( p_zap->p_entries,
+                                        i_alloc * sizeof( *p_entries ) );
+        if( !p_entries )
+        {
+            if( p_block )
+                block_Release( p_block );
+            return false;
+        }
+        p_zap->p_entries = p_entries;
+        p_zap->i_alloc = i_alloc;
+    }
+
+    ts_zap_entry_t *p_entry = &p_zap->p_entries[p_zap->i_entries++];
+    p_entry->id = id;
+    p_entry->p_block = p_block;
+    p_entry->i_pcr = i_pcr;
+    return true;
+}
+
+/* Returns the program owning pid if its data must be cached instead of
+ * being sent */
+static ts_prg_psi_t *ZapProgram( demux_t *p_demux, ts_pid_t *pid )
+{
+    if( !p_demux->p_sys->b_fast_zap || !pid->p_owner )
+        return NULL;
+
+    for( int i = 0; i < pid->p_owner->i_prg; i++ )
+    {
+        ts_prg_psi_t *prg = pid->p_owner->prg[i];
+
+        if( pid->i_owner_number == prg->i_number )
+            return ProgramIsSelected( p_demux, prg->i_number ) ? NULL : prg;
+    }
+    return NULL;
+}
+
+static bool ZapIsKeyFrame( const ts_es_t *es, const block_t *p_block )
+{
+    if( es->b_random_access )
+        return true;
+
+    /* Not all muxers set the random_access_indicator, look for the start
+     * of an access unit at the beginning of the PES */
+    const uint8_t *p = p_block->p_buffer;
+    const size_t i_size = __MIN( p_block->i_buffer, 1024 );
+
+    for( size_t i = 0; i + 3 < i_size; i++ )
+    {
+        if( p[i] != 0 || p[i+1] != 0 || p[i+2] != 1 )
+            continue;
+
+        if( es->fmt.i_codec == VLC_CODEC_H264 )
+        {
+            const int i_nal = p[i+3] & 0x1f;
+            if( i_nal == 5 || i_nal == 7 ) /* IDR, SPS */
+                return true;
+        }
+        else if( es->fmt.i_codec == VLC_CODEC_MPGV )
+        {
+            if( p[i+3] == 0xb3 ) /* sequence header */
+                return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/* Sends the data cached for prg, which has just been selected */
+static void ZapReplay( demux_t *p_demux, ts_prg_psi_t *prg )
+{
+    ts_zap_t *p_zap = &prg->zap;
+    mtime_t i_first_pcr = -1;
+    mtime_t i_last_pcr = -1;
+    mtime_t i_duration;
+
+    if( !p_zap->b_keyframe )
+    {
+        ZapReset( p_zap );
+        return;
+    }
+
+    for( int i = 0; i < p_zap->i_entries; i++ )
+    {
+        if( p_zap->p_entries[i].p_block )
+            continue;
+        if( i_first_pcr < 0 )
+            i_first_pcr = p_zap->p_entries[i].i_pcr;
+        i_last_pcr = p_zap->p_entries[i].i_pcr;
+    }
+
+    if( i_first_pcr >= 0 )
+    {
+        /* The PCR is 33 bits, it may have wrapped around in the cache */
+        i_duration = ( i_last_pcr - i_first_pcr ) & INT64_C(0x1FFFFFFFF);
+        msg_Dbg( p_demux, "fast zap to program %d (%d blocks, %"PRId64" ms)",
+                 prg->i_number, p_zap->i_entries, i_duration / 90 );
+
+        /* The decoders have been (re)created for this program: play the
+         * cached data, starting once it has been buffered */
+        es_out_Control( p_demux->out, ES_OUT_RESTART_BUFFERING,
+                        (int64_t)(i_duration * 100 / 9) );
+
+        for( int i = 0; i < p_zap->i_entries; i++ )
+        {
+            ts_zap_entry_t *p_entry = &p_zap->p_entries[i];
+
+            if( p_entry->p_block )
+            {
+                es_out_Send( p_demux->out, p_entry->id, p_entry->p_block );
+                p_entry->p_block = NULL;
+            }
+            else
+            {
+                es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR,
+                                (int)prg->i_number,
+                                (int64_t)(VLC_TS_0 + p_entry->i_pcr * 100 / 9) );
+            }
+        }
+    }
+    ZapReset( p_zap );
+}
+
 static void ParseTableSection( demux_t *p_demux, ts_pid_t *pid, block_t *p_data )
 {
     block_t *p_content = block_ChainGather( p_data );
@@ -2182,7 +2442,15 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
         for( int i_prg = 0; i_prg < p_sys->pmt[i]->psi->i_prg; i_prg++ )
             if( pid->i_pid == p_sys->pmt[i]->psi->prg[i_prg]->i_pid_pcr )
             {
+                ts_zap_t *p_zap = &p_sys->pmt[i]->psi->prg[i_prg]->zap;
+
                 p_sys->pmt[i]->psi->prg[i_prg]->i_pcr_value = i_pcr;
+                if( p_zap->b_keyframe )
+                {
+                    if( ProgramIsSelected( p_demux, p_sys->pmt[i]->psi->prg[i_prg]->i_number ) ||
+                        !ZapAppend( p_sys, p_zap, NULL, NULL, i_pcr ) )
+                        ZapReset( p_zap );
+                }
                 es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR,
                                 (int)p_sys->pmt[i]->psi->prg[i_prg]->i_number,
                                 (int64_t)(VLC_TS_0 + i_pcr * 100 / 9) );
@@ -2345,6 +2613,7 @@ static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
             ParseData( p_demux, pid );
             i_ret = true;
         }
+        pid->es->b_random_access = b_adaptation && p[4] > 0 && (p[5]&0x40);
 
         block_ChainLastAppend( &pid->es->pp_last, p_bk );
         if( pid->es->data_type == TS_ES_DATA_PES )
@@ -4009,6 +4278,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
         IODFree( prg->iod );
         prg->iod = NULL;
     }
+    /* The cached data refer to the ES being removed */
+    ZapReset( &prg->zap );
 
     msg_Dbg( p_demux, "new PMT program number=%d version=%d pid_pcr=%d",
              p_pmt->i_program_number, p_pmt->i_version, p_pmt->i_pcr_pid );
@@ -4016,7 +4287,7 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
     prg->i_version = p_pmt->i_version;
 
     ValidateDVBMeta( p_demux, prg->i_pid_pcr );
-    if( ProgramIsSelected( p_demux, prg->i_number ) )
+    if( ProgramIsSelected( p_demux, prg->i_number ) || p_sys->b_fast_zap )
         SetPIDFilter( p_demux, prg->i_pid_pcr, true ); /* Set demux filter */
 
     /* Parse descriptor */
@@ -4194,7 +4465,7 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_pmt )
                      (p_dr->p_data[0] << 8) | p_dr->p_data[1] );
         }
 
-        if( ProgramIsSelected( p_demux, prg->i_number ) &&
+        if( ( ProgramIsSelected( p_demux, prg->i_number ) || p_sys->b_fast_zap ) &&
             ( pid->es->id != NULL || p_sys->b_udp_out ) )
             SetPIDFilter( p_demux, p_es->i_pid, true ); /* Set demux filter */
     }
@@ -4369,6 +4640,10 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_pat )
             if( SetPIDFilter( p_demux, p_program->i_pid, true ) )
                 p_sys->b_access_control = false;
         }
+        else if( p_sys->b_fast_zap )
+        {
+            SetPIDFilter( p_demux, p_program->i_pid, true );
+        }
     }
     pat->psi->i_pat_version = p_pat->i_version;
 
@@ -182,6 +182,28 @@ static int Open ( vlc_object_t *p_this )
         }
     }
 
+    /* A local .sub file is mapped (see block_File) and read in place.
+     * psz_file is derived from the location whatever the access is, so it
+     * is only a local path when the access is the file one: on Windows,
+     * http://host/dir/x.idx would otherwise become \\host\dir\x.sub. */
+    if( p_demux->psz_file != NULL
+     && ( !*p_demux->psz_access || !strcmp( p_demux->psz_access, "file" ) ) )
+    {
+        psz_vobname = strdup( p_demux->psz_file );
+        if( psz_vobname == NULL )
+            goto error;
+
+        i_len = strlen( psz_vobname );
+        if( i_len >= 4 ) memcpy( psz_vobname + i_len - 4, ".sub", 4 );
+
+        block_t *p_block = block_FilePath( psz_vobname );
+        if( p_block != NULL )
+            p_sys->p_vobsub_stream = stream_BlockNew( p_demux, p_block );
+        free( psz_vobname );
+        if( p_sys->p_vobsub_stream != NULL )
+            goto done;
+    }
+
     if( asprintf( &psz_vobname, "%s://%s", p_demux->psz_access, p_demux->psz_location ) == -1 )
         goto error;
 
@@ -199,6 +221,7 @@ static int Open ( vlc_object_t *p_this )
     }
     free( psz_vobname );
 
+done:
     p_demux->pf_demux = Demux;
     p_demux->pf_control = Control;
 
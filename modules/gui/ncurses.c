@@ -824,6 +824,10 @@ static int DrawStats(intf_thread_t *intf)
                 p_stats->i_displayed_pictures);
         MainBoxWrite(sys, l++, _("| frames lost      :    %5"PRIi64),
                 p_stats->i_lost_pictures);
+        MainBoxWrite(sys, l++, _("| frames copied    :    %5"PRIi64),
+                p_stats->i_copied_pictures);
+        MainBoxWrite(sys, l++, _("| frames skipped   :    %5"PRIi64),
+                p_stats->i_skipped_pictures);
     }
     /* Audio*/
     if (i_audio) {
@@ -46,6 +46,7 @@
 
 #define MAX_ASF_TRACKS 128
 #define ASF_DATA_PACKET_SIZE 4096  // deprecated -- added sout-asf-packet-size
+#define ASF_MUX_BLOCKS 16          // packets muxed per output write
 
 /*****************************************************************************
  * Module descriptor
@@ -692,57 +693,56 @@ static int Mux( sout_mux_t *p_mux )
         p_sys->b_write_header = false;
     }
 
-    for( ;; )
+    sout_mux_block_t blocks[ASF_MUX_BLOCKS];
+    int i_blocks;
+
+    /* Take the packets to mux in dts order, several at a time */
+    while( ( i_blocks = sout_MuxPull( p_mux, 1, blocks, ASF_MUX_BLOCKS ) ) > 0 )
     {
-        sout_input_t  *p_input;
-        asf_track_t   *tk;
-        mtime_t       i_dts;
-        block_t *data;
-        block_t *pk;
-
-        int i_stream = sout_MuxGetStream( p_mux, 1, &i_dts );
-        if( i_stream < 0 )
-        {
-            /* not enough data */
-            return VLC_SUCCESS;
-        }
+        block_t *p_out = NULL;
 
-        if( p_sys->i_dts_first <= VLC_TS_INVALID )
-        {
-            p_sys->i_dts_first = i_dts;
-        }
-        if( p_sys->i_dts_last < i_dts )
+        for( int i = 0; i < i_blocks; i++ )
         {
-            p_sys->i_dts_last = i_dts;
-        }
-
-        p_input = p_mux->pp_inputs[i_stream];
-        tk      = (asf_track_t*)p_input->p_sys;
+            asf_track_t *tk = (asf_track_t*)blocks[i].p_input->p_sys;
+            block_t *data = blocks[i].p_block;
+            const mtime_t i_dts = data->i_dts;
+            block_t *pk;
 
-        data = block_FifoGet( p_input->p_fifo );
+            if( p_sys->i_dts_first <= VLC_TS_INVALID )
+            {
+                p_sys->i_dts_first = i_dts;
+            }
+            if( p_sys->i_dts_last < i_dts )
+            {
+                p_sys->i_dts_last = i_dts;
+            }
 
-        /* Convert VC1 to ASF special format */
-        if( tk->i_fourcc == VLC_FOURCC( 'W', 'V', 'C', '1' ) )
-        {
-            while( data->i_buffer >= 4 &&
-                   ( data->p_buffer[0] != 0x00 || data->p_buffer[1] != 0x00 ||
-                     data->p_buffer[2] != 0x01 ||
-                     ( data->p_buffer[3] != 0x0D && data->p_buffer[3] != 0x0C ) ) )
+            /* Convert VC1 to ASF special format */
+            if( tk->i_fourcc == VLC_FOURCC( 'W', 'V', 'C', '1' ) )
             {
-                data->i_buffer--;
-                data->p_buffer++;
+                while( data->i_buffer >= 4 &&
+                       ( data->p_buffer[0] != 0x00 || data->p_buffer[1] != 0x00 ||
+                         data->p_buffer[2] != 0x01 ||
+                         ( data->p_buffer[3] != 0x0D && data->p_buffer[3] != 0x0C ) ) )
+                {
+                    data->i_buffer--;
+                    data->p_buffer++;
+                }
+                if( data->i_buffer >= 4 )
+                {
+                    data->i_buffer -= 4;
+                    data->p_buffer += 4;
+                }
             }
-            if( data->i_buffer >= 4 )
+
+            if( ( pk = asf_packet_create( p_mux, tk, data ) ) )
             {
-                data->i_buffer -= 4;
-                data->p_buffer += 4;
+                block_ChainAppend( &p_out, pk );
             }
         }
 
-        if( ( pk = asf_packet_create( p_mux, tk, data ) ) )
-        {
-            sout_AccessOutWrite( p_mux->p_access, pk );
-        }
+        if( p_out )
+            sout_AccessOutWrite( p_mux->p_access, p_out );
     }
 
     return VLC_SUCCESS;
@@ -50,6 +50,25 @@
     "Create \"Fast Start\" files. " \
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
+#define FRAGMENTED_TEXT N_("Create fragmented files")
+#define FRAGMENTED_LONGTEXT N_( \
+    "Write the samples in movie fragments as they come, after an " \
+    "initialization segment. The file can be played while it is written, " \
+    "and does not need to be rewritten when it is closed.")
+#define FRAGDURATION_TEXT N_("Fragment duration (ms)")
+#define FRAGDURATION_LONGTEXT N_( \
+    "Minimum duration of the fragments. A fragment always starts on a key " \
+    "frame of the video track.")
+#define CMAF_TEXT N_("CMAF constraints")
+#define CMAF_LONGTEXT N_( \
+    "Create fragmented files following the Common Media Application Format " \
+    "constraints: a single track, and fragments starting with a key frame.")
+#define SIDX_TEXT N_("Segment index")
+#define SIDX_LONGTEXT N_( \
+    "Write a segment index (sidx) before each fragment.")
+#define MFRA_TEXT N_("Fragment random access index")
+#define MFRA_LONGTEXT N_( \
+    "Write a random access index (mfra) at the end of fragmented files.")
 
 static int  Open   ( vlc_object_t * );
 static void Close  ( vlc_object_t * );
@@ -65,6 +84,21 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "faststart", true,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "fragmented", false,
+              FRAGMENTED_TEXT, FRAGMENTED_LONGTEXT,
+              true )
+    add_integer( SOUT_CFG_PREFIX "fragment-duration", 2000,
+                 FRAGDURATION_TEXT, FRAGDURATION_LONGTEXT,
+                 true )
+    add_bool( SOUT_CFG_PREFIX "cmaf", false,
+              CMAF_TEXT, CMAF_LONGTEXT,
+              true )
+    add_bool( SOUT_CFG_PREFIX "sidx", false,
+              SIDX_TEXT, SIDX_LONGTEXT,
+              true )
+    add_bool( SOUT_CFG_PREFIX "mfra", true,
+              MFRA_TEXT, MFRA_LONGTEXT,
+              true )
     set_capability( "sout mux", 5 )
     add_shortcut( "mp4", "mov", "3gp" )
     set_callbacks( Open, Close )
@@ -74,7 +108,8 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "fragmented", "fragment-duration", "cmaf", "sidx",
+    "mfra", NULL
 };
 
 static int Control( sout_mux_t *, int, va_list );
@@ -96,6 +131,14 @@ typedef struct
 
 } mp4_entry_t;
 
+typedef struct
+{
+    uint64_t i_time;
+    uint64_t i_moof_pos;
+    uint8_t  i_traf;
+
+} mp4_tfra_t;
+
 typedef struct
 {
     es_format_t   fmt;
@@ -108,6 +151,7 @@ typedef struct
     int64_t      i_length_neg;
 
     /* stats */
+    bool         b_started;
     int64_t      i_dts_start;
     int64_t      i_duration;
 
@@ -118,6 +162,20 @@ typedef struct
     /* for spu */
     int64_t i_last_dts;
 
+    /* for fragmented files: samples of the pending fragment */
+    block_t  *p_frag;
+    block_t  **pp_frag_last;
+    int64_t  i_frag_dts;
+    uint64_t i_frag_base;
+    uint64_t i_frag_length;
+    uint32_t i_frag_size;
+    int      i_trun_pos;
+
+    /* for the mfra */
+    unsigned int i_tfra_count;
+    unsigned int i_tfra_max;
+    mp4_tfra_t   *tfra;
+
 } mp4_stream_t;
 
 struct sout_mux_sys_t
@@ -134,6 +192,18 @@ struct sout_mux_sys_t
 
     int          i_nb_streams;
     mp4_stream_t **pp_streams;
+
+    /* fragmented files */
+    bool b_fragmented;
+    bool b_cmaf;
+    bool b_sidx;
+    bool b_mfra;
+    bool b_init_sent;
+
+    mtime_t  i_frag_duration;
+    mtime_t  i_frag_start;
+    uint32_t i_frag_seq;
+    mp4_stream_t *p_frag_ref;
 };
 
 typedef struct bo_t
@@ -171,6 +241,12 @@ static block_t *bo_to_sout( bo_t *box );
 
 static bo_t *GetMoovBox( sout_mux_t *p_mux );
 
+static void WriteInitSegment( sout_mux_t *p_mux );
+static void WriteFragment( sout_mux_t *p_mux );
+static void WriteMfra( sout_mux_t *p_mux );
+
+static void WriteSample( sout_mux_t *, mp4_stream_t *, block_t * );
+
 static block_t *ConvertSUBT( block_t *);
 static block_t *ConvertAVC1( block_t * );
 
@@ -201,6 +277,48 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_3gp        = p_mux->psz_mux && !strcmp( p_mux->psz_mux, "3gp" );
     p_sys->i_dts_start  = 0;
 
+    p_sys->b_cmaf       = var_GetBool( p_mux, SOUT_CFG_PREFIX "cmaf" );
+    p_sys->b_fragmented = p_sys->b_cmaf ||
+                          var_GetBool( p_mux, SOUT_CFG_PREFIX "fragmented" );
+    p_sys->b_sidx       = var_GetBool( p_mux, SOUT_CFG_PREFIX "sidx" );
+    p_sys->b_mfra       = var_GetBool( p_mux, SOUT_CFG_PREFIX "mfra" );
+    p_sys->b_init_sent  = false;
+    p_sys->i_frag_duration = INT64_C(1000) *
+        __MAX( var_GetInteger( p_mux, SOUT_CFG_PREFIX "fragment-duration" ), 0 );
+    p_sys->i_frag_start = 0;
+    p_sys->i_frag_seq   = 1;
+    p_sys->p_frag_ref   = NULL;
+
+    if( p_sys->b_fragmented && p_sys->b_mov )
+    {
+        msg_Warn( p_mux, "fragmented files are not supported in .mov" );
+        p_sys->b_fragmented = p_sys->b_cmaf = false;
+    }
+
+    if( p_sys->b_fragmented )
+    {
+        /* Movie fragments with tfdt and default-base-is-moof */
+        box = box_new( "ftyp" );
+        if( p_sys->b_cmaf ) bo_add_fourcc( box, "cmfc" );
+        else if( p_sys->b_3gp ) bo_add_fourcc( box, "3gp6" );
+        else bo_add_fourcc( box, "iso6" );
+        bo_add_32be  ( box, 0 );
+        bo_add_fourcc( box, "iso6" );
+        bo_add_fourcc( box, "iso5" );
+        if( p_sys->b_cmaf ) bo_add_fourcc( box, "cmfc" );
+        if( p_sys->b_3gp ) bo_add_fourcc( box, "3gp6" );
+        if( p_sys->b_sidx ) bo_add_fourcc( box, "dash" );
+        bo_add_fourcc( box, "mp41" );
+        box_fix( box );
+
+        p_sys->i_pos += box->i_buffer;
+        p_sys->b_64_ext = false;
+
+        box_send( p_mux, box );
+
+        /* The moov is written with the first samples */
+        return VLC_SUCCESS;
+    }
 
     if( !p_sys->b_mov )
     {
@@ -252,6 +370,17 @@ static void Close( vlc_object_t * p_this )
 
     msg_Dbg( p_mux, "Close" );
 
+    if( p_sys->b_fragmented )
+    {
+        /* Only the pending fragment is left, nothing is rewritten */
+        if( !p_sys->b_init_sent )
+            WriteInitSegment( p_mux );
+        WriteFragment( p_mux );
+        if( p_sys->b_mfra )
+            WriteMfra( p_mux );
+        goto clean;
+    }
+
     /* Update mdat size */
     bo_init( &bo, 0, NULL, true );
     if( p_sys->i_pos - p_sys->i_mdat_pos >= (((uint64_t)1)<<32) )
@@ -350,12 +479,15 @@ static void Close( vlc_object_t * p_this )
     sout_AccessOutSeek( p_mux->p_access, i_moov_pos );
     box_send( p_mux, moov );
 
+clean:
     /* Clean-up */
     for( i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++ )
     {
         mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
 
         es_format_Clean( &p_stream->fmt );
+        block_ChainRelease( p_stream->p_frag );
+        free( p_stream->tfra );
         free( p_stream->entry );
         free( p_stream );
     }
@@ -368,8 +500,8 @@ static void Close( vlc_object_t * p_this )
  *****************************************************************************/
 static int Control( sout_mux_t *p_mux, int i_query, va_list args )
 {
-    VLC_UNUSED(p_mux);
     bool *pb_bool;
+    char **ppsz;
 
     switch( i_query )
     {
@@ -383,7 +515,14 @@ static int Control( sout_mux_t *p_mux, int i_query, va_list args )
             *pb_bool = true;
             return VLC_SUCCESS;
 
-        case MUX_GET_MIME:   /* Not needed, as not streamable */
+        case MUX_GET_MIME:
+            /* Only fragmented files are streamable */
+            if( !p_mux->p_sys->b_fragmented )
+                return VLC_EGENERIC;
+            ppsz = (char**)va_arg( args, char ** );
+            *ppsz = strdup( "video/mp4" );
+            return VLC_SUCCESS;
+
         default:
             return VLC_EGENERIC;
     }
@@ -423,6 +562,12 @@ static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
             return VLC_EGENERIC;
     }
 
+    if( p_sys->b_cmaf && p_sys->i_nb_streams > 0 )
+    {
+        msg_Err( p_mux, "CMAF files have a single track" );
+        return VLC_EGENERIC;
+    }
+
     p_stream                = (mp4_stream_t *)malloc( sizeof( mp4_stream_t ) );			// sunqueen modify
     if( !p_stream )
         return VLC_ENOMEM;
@@ -433,8 +578,14 @@ static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
     p_stream->i_entry_max   = 1000;
     p_stream->entry         = (mp4_entry_t *)
         calloc( p_stream->i_entry_max, sizeof( mp4_entry_t ) );			// sunqueen modify
+    p_stream->b_started     = false;
     p_stream->i_dts_start   = 0;
     p_stream->i_duration    = 0;
+    p_stream->p_frag        = NULL;
+    p_stream->pp_frag_last  = &p_stream->p_frag;
+    p_stream->i_tfra_count  = 0;
+    p_stream->i_tfra_max    = 0;
+    p_stream->tfra          = NULL;
 
     p_input->p_sys          = p_stream;
 
@@ -461,6 +612,9 @@ static int Mux( sout_mux_t *p_mux )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
 
+    if( p_sys->b_fragmented && !p_sys->b_init_sent )
+        WriteInitSegment( p_mux );
+
     for( ;; )
     {
         sout_input_t    *p_input;
@@ -517,14 +671,36 @@ again:
             }
         }
 
+        if( p_sys->b_fragmented && p_stream == p_sys->p_frag_ref &&
+            ( p_stream->fmt.i_cat != VIDEO_ES ||
+              ( p_data->i_flags & BLOCK_FLAG_TYPE_I ) ) )
+        {
+            /* Cut the fragments on the key frames of the reference track */
+            if( p_sys->i_frag_start > 0 &&
+                p_data->i_dts - p_sys->i_frag_start >= p_sys->i_frag_duration )
+                WriteFragment( p_mux );
+            if( p_sys->i_frag_start <= 0 )
+                p_sys->i_frag_start = p_data->i_dts;
+        }
+        else if( p_sys->b_cmaf && p_stream == p_sys->p_frag_ref &&
+                 p_sys->i_frag_start <= 0 )
+        {
+            /* CMAF fragments start with a sync sample */
+            block_Release( p_data );
+            continue;
+        }
+
         /* Save starting time */
-        if( p_stream->i_entry_count == 0 )
+        if( !p_stream->b_started )
         {
+            p_stream->b_started = true;
             p_stream->i_dts_start = p_data->i_dts;
 
-            /* Update global dts_start */
+            /* Update global dts_start (the fragments already written
+             * use it as time origin) */
             if( p_sys->i_dts_start <= 0 ||
-                p_stream->i_dts_start < p_sys->i_dts_start )
+                ( !p_sys->b_fragmented &&
+                  p_stream->i_dts_start < p_sys->i_dts_start ) )
             {
                 p_sys->i_dts_start = p_stream->i_dts_start;
             }
@@ -549,6 +725,8 @@ again:
 
 
         /* add index entry */
+        if( p_stream->i_entry_count == 0 )
+            p_stream->i_frag_dts = p_data->i_dts;
         p_stream->entry[p_stream->i_entry_count].i_pos    = p_sys->i_pos;
         p_stream->entry[p_stream->i_entry_count].i_size   = p_data->i_buffer;
         p_stream->entry[p_stream->i_entry_count].i_pts_dts=
@@ -567,13 +745,12 @@ again:
 
         /* update */
         p_stream->i_duration = p_stream->i_last_dts - p_stream->i_dts_start + p_data->i_length;
-        p_sys->i_pos += p_data->i_buffer;
 
         /* Save the DTS */
         p_stream->i_last_dts = p_data->i_dts;
 
         /* write data */
-        sout_AccessOutWrite( p_mux->p_access, p_data );
+        WriteSample( p_mux, p_stream, p_data );
 
         if( p_stream->fmt.i_cat == SPU_ES )
         {
@@ -603,9 +780,7 @@ again:
                 p_data->p_buffer[1] = 1;
                 p_data->p_buffer[2] = ' ';
 
-                p_sys->i_pos += p_data->i_buffer;
-
-                sout_AccessOutWrite( p_mux->p_access, p_data );
+                WriteSample( p_mux, p_stream, p_data );
             }
 
             /* Fix duration */
@@ -616,6 +791,22 @@ again:
     return( VLC_SUCCESS );
 }
 
+static void WriteSample( sout_mux_t *p_mux, mp4_stream_t *p_stream,
+                         block_t *p_data )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    if( p_sys->b_fragmented )
+    {
+        /* Kept until the fragment is complete */
+        block_ChainLastAppend( &p_stream->pp_frag_last, p_data );
+        return;
+    }
+
+    p_sys->i_pos += p_data->i_buffer;
+    sout_AccessOutWrite( p_mux->p_access, p_data );
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -635,6 +826,11 @@ static block_t *ConvertSUBT( block_t *p_block )
 
 static block_t *ConvertAVC1( block_t *p_block )
 {
+    /* The start codes are replaced in place */
+    p_block = block_Unshare( p_block );
+    if( p_block == NULL )
+        return NULL;
+
     uint8_t *last = p_block->p_buffer;  /* Assume it starts with 0x00000001 */
     uint8_t *dat  = &p_block->p_buffer[4];
     uint8_t *end = &p_block->p_buffer[p_block->i_buffer];
@@ -1884,6 +2080,27 @@ static bo_t *GetMoovBox( sout_mux_t *p_mux )
         box_gather( moov, trak );
     }
 
+    /* Announce the movie fragments */
+    if( p_sys->b_fragmented )
+    {
+        bo_t *mvex = box_new( "mvex" );
+
+        for( i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++ )
+        {
+            bo_t *trex = box_full_new( "trex", 0, 0 );
+
+            bo_add_32be( trex, p_sys->pp_streams[i_trak]->i_track_id );
+            bo_add_32be( trex, 1 );     // sample-description-index
+            bo_add_32be( trex, 0 );     // default-sample-duration
+            bo_add_32be( trex, 0 );     // default-sample-size
+            bo_add_32be( trex, 0 );     // default-sample-flags
+            box_fix( trex );
+            box_gather( mvex, trex );
+        }
+        box_fix( mvex );
+        box_gather( moov, mvex );
+    }
+
     /* Add user data tags */
     box_gather( moov, GetUdtaTag( p_mux ) );
 
@@ -1891,6 +2108,296 @@ static bo_t *GetMoovBox( sout_mux_t *p_mux )
     return moov;
 }
 
+/****************************************************************************
+ * Fragmented files
+ ****************************************************************************/
+static uint32_t GetTimescale( const mp4_stream_t *p_stream )
+{
+    if( p_stream->fmt.i_cat == AUDIO_ES )
+        return p_stream->fmt.audio.i_rate;
+    return CLOCK_FREQ;
+}
+
+static void WriteInitSegment( sout_mux_t *p_mux )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bo_t *moov;
+    int i;
+
+    /* The fragments are cut on the key frames of the first video track */
+    for( i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+
+        if( p_sys->p_frag_ref == NULL ||
+            ( p_stream->fmt.i_cat == VIDEO_ES &&
+              p_sys->p_frag_ref->fmt.i_cat != VIDEO_ES ) )
+            p_sys->p_frag_ref = p_stream;
+    }
+
+    /* No sample yet: the tables are empty, mvex announces the fragments */
+    moov = GetMoovBox( p_mux );
+    p_sys->i_pos += moov->i_buffer;
+    box_send( p_mux, moov );
+
+    p_sys->b_init_sent = true;
+}
+
+/* All the samples of the non video tracks are sync samples */
+static bool IsSyncSample( const mp4_stream_t *p_stream,
+                          const mp4_entry_t *p_entry )
+{
+    return p_stream->fmt.i_cat != VIDEO_ES ||
+           ( p_entry->i_flags & BLOCK_FLAG_TYPE_I );
+}
+
+static bo_t *GetTrafBox( sout_mux_t *p_mux, mp4_stream_t *p_stream )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const uint32_t i_timescale = GetTimescale( p_stream );
+    const bool b_video = p_stream->fmt.i_cat == VIDEO_ES;
+    bo_t *traf, *tfhd, *tfdt, *trun;
+    int64_t i_dts, i_dts_q;
+    unsigned int i;
+
+    traf = box_new( "traf" );
+
+    /* default-base-is-moof: the data offsets are relative to the moof */
+    tfhd = box_full_new( "tfhd", 0, 0x020000 );
+    bo_add_32be( tfhd, p_stream->i_track_id );
+    box_fix( tfhd );
+    box_gather( traf, tfhd );
+
+    /* The dates of the samples are not accumulated from the previous
+     * fragments, so that the timeline cannot drift */
+    p_stream->i_frag_base = __MAX( p_stream->i_frag_dts - p_sys->i_dts_start, 0 ) *
+                            (int64_t)i_timescale / INT64_C(1000000);
+    tfdt = box_full_new( "tfdt", 1, 0 );
+    bo_add_64be( tfdt, p_stream->i_frag_base );     // base-media-decode-time
+    box_fix( tfdt );
+    box_gather( traf, tfdt );
+
+    /* data-offset, sample-duration, sample-size, sample-flags
+     * and sample-composition-time-offset for video */
+    trun = box_full_new( "trun", 0, b_video ? 0x000f01 : 0x000701 );
+    bo_add_32be( trun, p_stream->i_entry_count );   // sample-count
+    bo_add_32be( trun, 0 );                         // data-offset (fixed later)
+
+    p_stream->i_frag_size = 0;
+    for( i = 0, i_dts = 0, i_dts_q = 0; i < p_stream->i_entry_count; i++ )
+    {
+        const mp4_entry_t *p_entry = &p_stream->entry[i];
+        int64_t i_length_q;
+
+        /* quantify the length without accumulating the rounding errors */
+        i_dts += p_entry->i_length;
+        i_length_q = i_dts * (int64_t)i_timescale / INT64_C(1000000) - i_dts_q;
+        i_dts_q += i_length_q;
+
+        bo_add_32be( trun, i_length_q );            // sample-duration
+        bo_add_32be( trun, p_entry->i_size );       // sample-size
+        if( IsSyncSample( p_stream, p_entry ) )
+            bo_add_32be( trun, 0x02000000 );        // sync sample
+        else
+            bo_add_32be( trun, 0x01010000 );        // depends on others
+        if( b_video )
+            bo_add_32be( trun, p_entry->i_pts_dts * (int64_t)i_timescale /
+                               INT64_C(1000000) );  // composition offset
+
+        p_stream->i_frag_size += p_entry->i_size;
+    }
+    p_stream->i_frag_length = i_dts_q;
+    box_fix( trun );
+
+    p_stream->i_trun_pos = traf->i_buffer + 16;
+    box_gather( traf, trun );
+
+    box_fix( traf );
+    return traf;
+}
+
+static bo_t *GetSidxBox( mp4_stream_t *p_stream, uint32_t i_size )
+{
+    const bool b_sap = IsSyncSample( p_stream, &p_stream->entry[0] );
+    const uint32_t i_timescale = GetTimescale( p_stream );
+    bo_t *sidx = box_full_new( "sidx", 1, 0 );
+
+    bo_add_32be( sidx, p_stream->i_track_id );      // reference-id
+    bo_add_32be( sidx, i_timescale );               // timescale
+    bo_add_64be( sidx, p_stream->i_frag_base +
+                 p_stream->entry[0].i_pts_dts * (int64_t)i_timescale /
+                 INT64_C(1000000) );                // earliest-presentation-time
+    bo_add_64be( sidx, 0 );                         // first-offset
+    bo_add_16be( sidx, 0 );                         // reserved
+    bo_add_16be( sidx, 1 );                         // reference-count
+
+    /* The following moof and mdat */
+    bo_add_32be( sidx, i_size & 0x7fffffff );       // reference-type=0|size
+    bo_add_32be( sidx, p_stream->i_frag_length );   // subsegment-duration
+    if( b_sap )
+        bo_add_32be( sidx, 0x90000000 );            // starts-with-SAP=1|type=1
+    else
+        bo_add_32be( sidx, 0 );                     // starts-with-SAP=0
+    box_fix( sidx );
+
+    return sidx;
+}
+
+static void WriteFragment( sout_mux_t *p_mux )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bo_t            *moof, *mfhd;
+    block_t         *p_chain = NULL, **pp_last = &p_chain, *p_hdr;
+    uint32_t        i_offset, i_moof_size;
+    uint8_t         i_traf = 0;
+    int             i;
+
+    for( i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        if( p_sys->pp_streams[i]->i_entry_count > 0 )
+            break;
+    }
+    if( i >= p_sys->i_nb_streams )
+        return;
+
+    moof = box_new( "moof" );
+
+    mfhd = box_full_new( "mfhd", 0, 0 );
+    bo_add_32be( mfhd, p_sys->i_frag_seq );        // sequence-number
+    box_fix( mfhd );
+    box_gather( moof, mfhd );
+
+    for( i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+        bo_t *traf;
+
+        if( p_stream->i_entry_count == 0 )
+            continue;
+
+        traf = GetTrafBox( p_mux, p_stream );
+        p_stream->i_trun_pos += moof->i_buffer;
+        box_gather( moof, traf );
+    }
+    box_fix( moof );
+    i_moof_size = moof->i_buffer;
+
+    /* Fix data offsets: the samples follow the mdat header, by track */
+    i_offset = i_moof_size + 8;
+    for( i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+
+        if( p_stream->i_entry_count == 0 )
+            continue;
+
+        bo_fix_32be( moof, p_stream->i_trun_pos, i_offset );
+        i_offset += p_stream->i_frag_size;
+    }
+
+    if( p_sys->b_sidx && p_sys->p_frag_ref->i_entry_count > 0 )
+    {
+        bo_t *sidx = GetSidxBox( p_sys->p_frag_ref, i_offset );
+
+        p_sys->i_pos += sidx->i_buffer;
+        block_ChainLastAppend( &pp_last, bo_to_sout( sidx ) );
+        box_free( sidx );
+    }
+
+    /* Random access points: the fragments starting with a sync sample */
+    for( i = 0; i < p_sys->i_nb_streams && p_sys->b_mfra; i++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+        mp4_tfra_t   *p_tfra;
+
+        if( p_stream->i_entry_count == 0 )
+            continue;
+        i_traf++;
+        if( !IsSyncSample( p_stream, &p_stream->entry[0] ) )
+            continue;
+
+        if( p_stream->i_tfra_count >= p_stream->i_tfra_max )
+        {
+            p_stream->i_tfra_max += 100;
+            p_stream->tfra = (mp4_tfra_t *)xrealloc( p_stream->tfra,
+                         p_stream->i_tfra_max * sizeof( mp4_tfra_t ) );
+        }
+        p_tfra = &p_stream->tfra[p_stream->i_tfra_count++];
+        p_tfra->i_time     = p_stream->i_frag_base;
+        p_tfra->i_moof_pos = p_sys->i_pos;
+        p_tfra->i_traf     = i_traf;
+    }
+
+    block_ChainLastAppend( &pp_last, bo_to_sout( moof ) );
+    box_free( moof );
+
+    p_hdr = block_Alloc( 8 );
+    SetDWBE( p_hdr->p_buffer, i_offset - i_moof_size );
+    memcpy( &p_hdr->p_buffer[4], "mdat", 4 );
+    block_ChainLastAppend( &pp_last, p_hdr );
+
+    for( i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+
+        if( p_stream->p_frag )
+            block_ChainLastAppend( &pp_last, p_stream->p_frag );
+        p_stream->p_frag = NULL;
+        p_stream->pp_frag_last = &p_stream->p_frag;
+        p_stream->i_entry_count = 0;
+    }
+    p_sys->i_pos += i_offset;
+
+    sout_AccessOutWrite( p_mux->p_access, p_chain );
+
+    p_sys->i_frag_seq++;
+    p_sys->i_frag_start = 0;
+}
+
+static void WriteMfra( sout_mux_t *p_mux )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bo_t *mfra, *mfro;
+    unsigned int i;
+    int i_trak;
+
+    mfra = box_new( "mfra" );
+
+    for( i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++ )
+    {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
+        bo_t *tfra;
+
+        if( p_stream->i_tfra_count == 0 )
+            continue;
+
+        tfra = box_full_new( "tfra", 1, 0 );
+        bo_add_32be( tfra, p_stream->i_track_id );
+        bo_add_32be( tfra, 0 );     // 8 bits traf, trun and sample numbers
+        bo_add_32be( tfra, p_stream->i_tfra_count );
+        for( i = 0; i < p_stream->i_tfra_count; i++ )
+        {
+            bo_add_64be( tfra, p_stream->tfra[i].i_time );
+            bo_add_64be( tfra, p_stream->tfra[i].i_moof_pos );
+            bo_add_8   ( tfra, p_stream->tfra[i].i_traf );
+            bo_add_8   ( tfra, 1 );     // trun-number
+            bo_add_8   ( tfra, 1 );     // sample-number
+        }
+        box_fix( tfra );
+        box_gather( mfra, tfra );
+    }
+
+    /* The mfro is the last box of the file, to find the mfra backward */
+    mfro = box_full_new( "mfro", 0, 0 );
+    bo_add_32be( mfro, mfra->i_buffer + 16 );
+    box_fix( mfro );
+    box_gather( mfra, mfro );
+
+    box_fix( mfra );
+    p_sys->i_pos += mfra->i_buffer;
+    box_send( p_mux, mfra );
+}
+
 /****************************************************************************/
 
 static void bo_init( bo_t *p_bo, int i_size, uint8_t *p_buffer,
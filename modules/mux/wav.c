@@ -293,9 +293,15 @@ static int Mux( sout_mux_t *p_mux )
 
         /* Do the channel reordering */
         if( p_sys->i_chans_to_reorder )
+        {
+            /* The samples are reordered in place */
+            p_block = block_Unshare( p_block );
+            if( p_block == NULL )
+                continue;
             aout_ChannelReorder( p_block->p_buffer, p_block->i_buffer,
                                  p_sys->i_chans_to_reorder,
                                  p_sys->pi_chan_table, p_input->p_fmt->i_codec );
+        }
 
         sout_AccessOutWrite( p_mux->p_access, p_block );
     }
@@ -362,6 +362,7 @@ typedef struct in_sout_stream_sys_t
     mtime_t i_delay;
 
     char *psz_name;
+    const vlc_var_handle_t *p_name; /* handle of psz_name, used per block */
 
     bool b_placeholder;
     bool b_switch_on_iframe;
@@ -412,6 +413,7 @@ static int OpenIn( vlc_object_t *p_this )
         return VLC_ENOMEM;
     }
     free( val.psz_string );
+    p_sys->p_name = var_Handle( p_sys->psz_name );
 
     var_Get( p_stream, SOUT_CFG_PREFIX_IN "placeholder", &val );
     p_sys->b_placeholder = val.b_bool;
@@ -521,7 +523,7 @@ static int SendIn( sout_stream_t *p_stream, sout_stream_id_t *id,
     /* Then check all bridged streams */
     vlc_mutex_lock( &lock );
 
-    p_bridge = (bridge_t *)var_GetAddress( p_stream->p_libvlc, p_sys->psz_name );			// sunqueen modify
+    p_bridge = (bridge_t *)var_GetAddressFast( p_stream->p_libvlc, p_sys->p_name );			// sunqueen modify
 
     if( p_bridge )
     {
@@ -41,6 +41,8 @@
  *****************************************************************************/
 static int      Open    ( vlc_object_t * );
 static void     Close   ( vlc_object_t * );
+static int      OpenFanout ( vlc_object_t * );
+static void     CloseFanout( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Duplicate stream output") )
@@ -49,6 +51,12 @@ vlc_module_begin ()
     set_category( CAT_SOUT )
     set_subcategory( SUBCAT_SOUT_STREAM )
     set_callbacks( Open, Close )
+
+    add_submodule ()
+    set_description( N_("Fan-out stream output") )
+    set_capability( "sout stream", 0 )
+    add_shortcut( "fanout" )
+    set_callbacks( OpenFanout, CloseFanout )
 vlc_module_end ()
 
 
@@ -59,6 +67,10 @@ static sout_stream_id_t *Add ( sout_stream_t *, es_format_t * );
 static int               Del ( sout_stream_t *, sout_stream_id_t * );
 static int               Send( sout_stream_t *, sout_stream_id_t *,
                                block_t* );
+static sout_stream_id_t *AddFanout ( sout_stream_t *, es_format_t * );
+static int               DelFanout ( sout_stream_t *, sout_stream_id_t * );
+static int               SendFanout( sout_stream_t *, sout_stream_id_t *,
+                                     block_t* );
 
 struct sout_stream_sys_t
 {
@@ -70,6 +82,9 @@ struct sout_stream_sys_t
 
     int             i_nb_select;
     char            **ppsz_select;
+
+    /* fanout: where the streams go (set up by the owner of the input) */
+    sout_fanout_t   *p_fanout;
 };
 
 struct sout_stream_id_t
@@ -283,7 +298,8 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
 
             if( id->pp_ids[i_stream] )
             {
-                block_t *p_dup = block_Duplicate( p_buffer );
+                /* The payload is shared by all the outputs */
+                block_t *p_dup = block_Share( p_buffer );
 
                 if( p_dup )
                     sout_StreamIdSend( p_dup_stream, (sout_stream_id_t *)id->pp_ids[i_stream], p_dup );			// sunqueen modify
@@ -476,3 +492,64 @@ static bool ESSelected( es_format_t *fmt, char *psz_select )
     }
     return false;
 }
+
+/*****************************************************************************
+ * Fan-out: the streams are passed on to the owner of the input (see
+ * sout_fanout_t), which feeds them to outputs that can come and go while
+ * the input is running.
+ *****************************************************************************/
+static int OpenFanout( vlc_object_t *p_this )
+{
+    sout_stream_t     *p_stream = (sout_stream_t*)p_this;
+    sout_stream_sys_t *p_sys;
+
+    sout_fanout_t *p_fanout = (sout_fanout_t *)var_InheritAddress( p_stream, "sout-fanout" );
+    if( !p_fanout )
+    {
+        msg_Err( p_stream, "fanout is only usable by shared inputs" );
+        return VLC_EGENERIC;
+    }
+
+    p_sys = (sout_stream_sys_t *)calloc( 1, sizeof( sout_stream_sys_t ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+    p_sys->p_fanout = p_fanout;
+
+    p_stream->pf_add    = AddFanout;
+    p_stream->pf_del    = DelFanout;
+    p_stream->pf_send   = SendFanout;
+
+    p_stream->p_sys     = p_sys;
+
+    return VLC_SUCCESS;
+}
+
+static void CloseFanout( vlc_object_t *p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t*)p_this;
+
+    free( p_stream->p_sys );
+}
+
+static sout_stream_id_t *AddFanout( sout_stream_t *p_stream, es_format_t *p_fmt )
+{
+    sout_fanout_t *p_fanout = p_stream->p_sys->p_fanout;
+
+    return (sout_stream_id_t *)p_fanout->pf_add( p_fanout, p_fmt );
+}
+
+static int DelFanout( sout_stream_t *p_stream, sout_stream_id_t *id )
+{
+    sout_fanout_t *p_fanout = p_stream->p_sys->p_fanout;
+
+    p_fanout->pf_del( p_fanout, id );
+    return VLC_SUCCESS;
+}
+
+static int SendFanout( sout_stream_t *p_stream, sout_stream_id_t *id,
+                       block_t *p_buffer )
+{
+    sout_fanout_t *p_fanout = p_stream->p_sys->p_fanout;
+
+    return p_fanout->pf_send( p_fanout, id, p_buffer );
+}
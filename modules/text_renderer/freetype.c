@@ -334,6 +334,57 @@ struct font_stack_t
     font_stack_t  *p_next;
 };
 
+/* Faces loaded for the text styles, kept across renders in a LRU list */
+#define FACE_CACHE_MAX    16
+typedef struct
+{
+    char          *psz_fontname;
+    int            i_style_flags;
+    FT_Face        p_face;      /* NULL if the default face is used */
+    uint64_t       i_last_use;
+} face_cache_t;
+
+/* Rendered glyphs, kept in a LRU list */
+#define GLYPH_CACHE_MAX   1024
+#define GLYPH_CACHE_HASH  256
+
+typedef struct glyph_cache_t glyph_cache_t;
+struct glyph_cache_t
+{
+    glyph_cache_t *p_hash_next;
+    glyph_cache_t *p_lru_prev;
+    glyph_cache_t *p_lru_next;
+
+    /* Key */
+    FT_Face        p_face;
+    int            i_font_size;
+    int            i_style_flags;
+    int            i_glyph_index;
+    int            i_outline_radius;
+    FT_Vector      pen;         /* sub pixel position (26.6) */
+
+    /* Glyphs rendered at the sub pixel position */
+    FT_Glyph       glyph;
+    FT_BBox        glyph_bbox;
+    FT_Glyph       outline;
+    FT_BBox        outline_bbox;
+    FT_Glyph       shadow;
+    FT_BBox        shadow_bbox;
+    FT_Vector      advance;
+};
+
+/* Laid out lines, keyed by the text and its styles */
+#define LINE_CACHE_MAX    8
+typedef struct
+{
+    uint8_t       *p_key;
+    size_t         i_key;
+
+    line_desc_t   *p_lines;
+    FT_BBox        bbox;
+    int            i_max_face_height;
+} line_cache_t;
+
 /*****************************************************************************
  * filter_sys_t: freetype local data
  *****************************************************************************
@@ -368,6 +419,24 @@ struct filter_sys_t
 
     input_attachment_t **pp_font_attachments;
     int                  i_font_attachments;
+
+    int            i_outline_radius;
+
+    face_cache_t   p_face_cache[FACE_CACHE_MAX];
+    int            i_face_cache;
+    uint64_t       i_face_use;        /* last use of a cached face */
+    uint64_t       i_face_render;     /* last use before the current render */
+
+    const vlc_var_handle_t *p_elapsed;  /* "spu-elapsed" */
+    const vlc_var_handle_t *p_rerender; /* "text-rerender" */
+
+    glyph_cache_t *pp_glyph_hash[GLYPH_CACHE_HASH];
+    glyph_cache_t *p_glyph_lru_first;
+    glyph_cache_t *p_glyph_lru_last;
+    int            i_glyph_cache;
+
+    line_cache_t   p_line_cache[LINE_CACHE_MAX];    /* most recent first */
+    int            i_line_cache;
 };
 
 /* */
@@ -2126,19 +2195,19 @@ static int GetGlyph( filter_t *p_filter,
     return VLC_SUCCESS;
 }
 
-static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, FT_Face face, const FT_Vector *p_pen )
+static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, const FT_Vector *p_advance, const FT_Vector *p_pen )
 {
     FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
     if( p_bbox->xMin >= p_bbox->xMax )
     {
         p_bbox->xMin = FT_CEIL(p_pen->x);
-        p_bbox->xMax = FT_CEIL(p_pen->x + face->glyph->advance.x);
+        p_bbox->xMax = FT_CEIL(p_pen->x + p_advance->x);
         glyph_bmp->left = p_bbox->xMin;
     }
     if( p_bbox->yMin >= p_bbox->yMax )
     {
         p_bbox->yMax = FT_CEIL(p_pen->y);
-        p_bbox->yMin = FT_CEIL(p_pen->y + face->glyph->advance.y);
+        p_bbox->yMin = FT_CEIL(p_pen->y + p_advance->y);
         glyph_bmp->top  = p_bbox->yMax;
     }
 }
@@ -2151,6 +2220,445 @@ static void BBoxEnlarge( FT_BBox *p_max, const FT_BBox *p )
     p_max->yMax = __MAX(p_max->yMax, p->yMax);
 }
 
+/*****************************************************************************
+ * Face cache
+ *****************************************************************************/
+static void GlyphCacheClear( filter_sys_t *p_sys );
+static void GlyphCacheRemoveFace( filter_sys_t *p_sys, FT_Face p_face );
+
+static FT_Face GetFace( filter_t *p_filter, const text_style_t *p_style )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_style_flags = p_style->i_style_flags & (STYLE_BOLD | STYLE_ITALIC);
+
+    for( int i = 0; i < p_sys->i_face_cache; i++ )
+    {
+        face_cache_t *p_cache = &p_sys->p_face_cache[i];
+        if( p_cache->i_style_flags == i_style_flags &&
+            !strcmp( p_cache->psz_fontname, p_style->psz_fontname ) )
+        {
+            p_cache->i_last_use = ++p_sys->i_face_use;
+            return p_cache->p_face;
+        }
+    }
+
+    face_cache_t *p_cache;
+    if( p_sys->i_face_cache < FACE_CACHE_MAX )
+        p_cache = &p_sys->p_face_cache[p_sys->i_face_cache];
+    else
+    {
+        /* Replace the least recently used face, unless the current text
+         * uses all of them (its glyphs are being laid out) */
+        p_cache = &p_sys->p_face_cache[0];
+        for( int i = 1; i < p_sys->i_face_cache; i++ )
+            if( p_sys->p_face_cache[i].i_last_use < p_cache->i_last_use )
+                p_cache = &p_sys->p_face_cache[i];
+        if( p_cache->i_last_use > p_sys->i_face_render )
+            return NULL;
+    }
+
+    char *psz_fontname = strdup( p_style->psz_fontname );
+    if( !psz_fontname )
+        return NULL;
+
+    if( p_sys->i_face_cache < FACE_CACHE_MAX )
+        p_sys->i_face_cache++;
+    else
+    {
+        /* The rendered glyphs are keyed by face */
+        if( p_cache->p_face )
+        {
+            GlyphCacheRemoveFace( p_sys, p_cache->p_face );
+            FT_Done_Face( p_cache->p_face );
+        }
+        free( p_cache->psz_fontname );
+    }
+    p_cache->psz_fontname  = psz_fontname;
+    p_cache->i_style_flags = i_style_flags;
+    p_cache->p_face        = LoadFace( p_filter, p_style );
+    p_cache->i_last_use    = ++p_sys->i_face_use;
+    return p_cache->p_face;
+}
+
+static void FaceCacheClear( filter_sys_t *p_sys )
+{
+    /* The rendered glyphs are keyed by face */
+    GlyphCacheClear( p_sys );
+
+    for( int i = 0; i < p_sys->i_face_cache; i++ )
+    {
+        face_cache_t *p_cache = &p_sys->p_face_cache[i];
+        if( p_cache->p_face )
+            FT_Done_Face( p_cache->p_face );
+        free( p_cache->psz_fontname );
+    }
+    p_sys->i_face_cache = 0;
+}
+
+/*****************************************************************************
+ * Glyph cache
+ *****************************************************************************/
+static unsigned GlyphCacheHash( FT_Face p_face, int i_font_size, int i_glyph_index,
+                                const FT_Vector *p_pen )
+{
+    unsigned i_hash = (unsigned)(uintptr_t)p_face >> 4;
+    i_hash = i_hash * 31 + i_font_size;
+    i_hash = i_hash * 31 + i_glyph_index;
+    i_hash = i_hash * 31 + (unsigned)(p_pen->x * 64 + p_pen->y);
+    return i_hash % GLYPH_CACHE_HASH;
+}
+
+static void GlyphCacheUnlink( filter_sys_t *p_sys, glyph_cache_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_sys->p_glyph_lru_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_sys->p_glyph_lru_last = p_entry->p_lru_prev;
+}
+
+static void GlyphCachePushFront( filter_sys_t *p_sys, glyph_cache_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_sys->p_glyph_lru_first;
+    if( p_sys->p_glyph_lru_first )
+        p_sys->p_glyph_lru_first->p_lru_prev = p_entry;
+    else
+        p_sys->p_glyph_lru_last = p_entry;
+    p_sys->p_glyph_lru_first = p_entry;
+}
+
+static void GlyphCacheDelete( glyph_cache_t *p_entry )
+{
+    FT_Done_Glyph( p_entry->glyph );
+    if( p_entry->outline )
+        FT_Done_Glyph( p_entry->outline );
+    if( p_entry->shadow )
+        FT_Done_Glyph( p_entry->shadow );
+    free( p_entry );
+}
+
+static glyph_cache_t *GlyphCacheGet( filter_sys_t *p_sys,
+                                     FT_Face p_face, int i_font_size, int i_style_flags,
+                                     int i_glyph_index, const FT_Vector *p_pen )
+{
+    const unsigned i_hash = GlyphCacheHash( p_face, i_font_size, i_glyph_index, p_pen );
+
+    for( glyph_cache_t *p_entry = p_sys->pp_glyph_hash[i_hash];
+         p_entry != NULL; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->p_face == p_face &&
+            p_entry->i_font_size == i_font_size &&
+            p_entry->i_style_flags == i_style_flags &&
+            p_entry->i_glyph_index == i_glyph_index &&
+            p_entry->i_outline_radius == p_sys->i_outline_radius &&
+            p_entry->pen.x == p_pen->x && p_entry->pen.y == p_pen->y )
+        {
+            GlyphCacheUnlink( p_sys, p_entry );
+            GlyphCachePushFront( p_sys, p_entry );
+            return p_entry;
+        }
+    }
+    return NULL;
+}
+
+static void GlyphCacheAdd( filter_sys_t *p_sys, glyph_cache_t *p_entry )
+{
+    /* Drop the least recently used glyph */
+    if( p_sys->i_glyph_cache >= GLYPH_CACHE_MAX )
+    {
+        glyph_cache_t *p_old = p_sys->p_glyph_lru_last;
+        glyph_cache_t **pp = &p_sys->pp_glyph_hash[GlyphCacheHash( p_old->p_face, p_old->i_font_size,
+                                                                   p_old->i_glyph_index, &p_old->pen )];
+        while( *pp != p_old )
+            pp = &(*pp)->p_hash_next;
+        *pp = p_old->p_hash_next;
+
+        GlyphCacheUnlink( p_sys, p_old );
+        GlyphCacheDelete( p_old );
+        p_sys->i_glyph_cache--;
+    }
+
+    const unsigned i_hash = GlyphCacheHash( p_entry->p_face, p_entry->i_font_size,
+                                            p_entry->i_glyph_index, &p_entry->pen );
+    p_entry->p_hash_next = p_sys->pp_glyph_hash[i_hash];
+    p_sys->pp_glyph_hash[i_hash] = p_entry;
+    GlyphCachePushFront( p_sys, p_entry );
+    p_sys->i_glyph_cache++;
+}
+
+static void GlyphCacheRemoveFace( filter_sys_t *p_sys, FT_Face p_face )
+{
+    for( int i = 0; i < GLYPH_CACHE_HASH; i++ )
+    {
+        glyph_cache_t **pp = &p_sys->pp_glyph_hash[i];
+        while( *pp != NULL )
+        {
+            glyph_cache_t *p_entry = *pp;
+            if( p_entry->p_face != p_face )
+            {
+                pp = &p_entry->p_hash_next;
+                continue;
+            }
+            *pp = p_entry->p_hash_next;
+            GlyphCacheUnlink( p_sys, p_entry );
+            GlyphCacheDelete( p_entry );
+            p_sys->i_glyph_cache--;
+        }
+    }
+}
+
+static void GlyphCacheClear( filter_sys_t *p_sys )
+{
+    for( glyph_cache_t *p_entry = p_sys->p_glyph_lru_first; p_entry != NULL; )
+    {
+        glyph_cache_t *p_next = p_entry->p_lru_next;
+        GlyphCacheDelete( p_entry );
+        p_entry = p_next;
+    }
+    for( int i = 0; i < GLYPH_CACHE_HASH; i++ )
+        p_sys->pp_glyph_hash[i] = NULL;
+    p_sys->p_glyph_lru_first = NULL;
+    p_sys->p_glyph_lru_last  = NULL;
+    p_sys->i_glyph_cache     = 0;
+}
+
+static FT_Glyph GlyphCopy( FT_Glyph glyph, const FT_BBox *p_bbox,
+                           int i_dx, int i_dy, FT_BBox *p_bbox_copy )
+{
+    FT_Glyph copy;
+    if( FT_Glyph_Copy( glyph, &copy ) )
+        return NULL;
+
+    FT_BitmapGlyph copy_bmp = (FT_BitmapGlyph)copy;
+    copy_bmp->left += i_dx;
+    copy_bmp->top  += i_dy;
+
+    p_bbox_copy->xMin = p_bbox->xMin + i_dx;
+    p_bbox_copy->xMax = p_bbox->xMax + i_dx;
+    p_bbox_copy->yMin = p_bbox->yMin + i_dy;
+    p_bbox_copy->yMax = p_bbox->yMax + i_dy;
+    return copy;
+}
+
+/* Same as GetGlyph() followed by FixGlyph(), but the bitmaps are rendered
+ * only once per face, size, style, glyph and sub pixel pen position */
+static int GetCachedGlyph( filter_t *p_filter,
+                           FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
+                           FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
+                           FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+                           FT_Vector *p_advance,
+
+                           FT_Face  p_face,
+                           int i_font_size,
+                           int i_glyph_index,
+                           int i_style_flags,
+                           const FT_Vector *p_pen,
+                           const FT_Vector *p_pen_shadow )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    i_style_flags &= STYLE_BOLD | STYLE_ITALIC;
+
+    /* The glyphs only depend on the fractional part of the pen position */
+    FT_Vector pen;
+    pen.x = p_pen->x & 63;
+    pen.y = p_pen->y & 63;
+    const int i_dx = (p_pen->x - pen.x) / 64;
+    const int i_dy = (p_pen->y - pen.y) / 64;
+
+    glyph_cache_t *p_entry = GlyphCacheGet( p_sys, p_face, i_font_size, i_style_flags,
+                                            i_glyph_index, &pen );
+    if( !p_entry )
+    {
+        p_entry = (glyph_cache_t *)calloc( 1, sizeof(*p_entry) );
+        if( !p_entry )
+            return VLC_ENOMEM;
+
+        FT_Vector pen_shadow;
+        pen_shadow.x = pen.x + p_pen_shadow->x - p_pen->x;
+        pen_shadow.y = pen.y + p_pen_shadow->y - p_pen->y;
+
+        if( GetGlyph( p_filter,
+                      &p_entry->glyph, &p_entry->glyph_bbox,
+                      &p_entry->outline, &p_entry->outline_bbox,
+                      &p_entry->shadow, &p_entry->shadow_bbox,
+                      p_face, i_glyph_index, i_style_flags,
+                      &pen, &pen_shadow ) )
+        {
+            free( p_entry );
+            return VLC_EGENERIC;
+        }
+        p_entry->advance = p_face->glyph->advance;
+
+        FixGlyph( p_entry->glyph, &p_entry->glyph_bbox, &p_entry->advance, &pen );
+        if( p_entry->outline )
+            FixGlyph( p_entry->outline, &p_entry->outline_bbox, &p_entry->advance, &pen );
+        if( p_entry->shadow )
+            FixGlyph( p_entry->shadow, &p_entry->shadow_bbox, &p_entry->advance, &pen_shadow );
+
+        p_entry->p_face           = p_face;
+        p_entry->i_font_size      = i_font_size;
+        p_entry->i_style_flags    = i_style_flags;
+        p_entry->i_glyph_index    = i_glyph_index;
+        p_entry->i_outline_radius = p_sys->i_outline_radius;
+        p_entry->pen              = pen;
+        GlyphCacheAdd( p_sys, p_entry );
+    }
+
+    /* The lines own their glyphs: give them moved copies */
+    FT_Glyph glyph = GlyphCopy( p_entry->glyph, &p_entry->glyph_bbox, i_dx, i_dy, p_glyph_bbox );
+    FT_Glyph outline = NULL;
+    FT_Glyph shadow = NULL;
+    if( p_entry->outline )
+        outline = GlyphCopy( p_entry->outline, &p_entry->outline_bbox, i_dx, i_dy, p_outline_bbox );
+    if( p_entry->shadow )
+        shadow = GlyphCopy( p_entry->shadow, &p_entry->shadow_bbox, i_dx, i_dy, p_shadow_bbox );
+
+    if( !glyph || (p_entry->outline && !outline) || (p_entry->shadow && !shadow) )
+    {
+        if( glyph )
+            FT_Done_Glyph( glyph );
+        if( outline )
+            FT_Done_Glyph( outline );
+        if( shadow )
+            FT_Done_Glyph( shadow );
+        return VLC_ENOMEM;
+    }
+    *pp_glyph   = glyph;
+    *pp_outline = outline;
+    *pp_shadow  = shadow;
+    *p_advance  = p_entry->advance;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Line cache
+ *****************************************************************************/
+static void LineCacheKeyAppend( uint8_t *p_key, size_t *pi_key, const void *p_data, size_t i_data )
+{
+    if( p_key )
+        memcpy( &p_key[*pi_key], p_data, i_data );
+    *pi_key += i_data;
+}
+
+static size_t LineCacheKeyFill( filter_t *p_filter, uint8_t *p_key,
+                                const uni_char_t *psz_text, text_style_t **pp_styles,
+                                const uint32_t *pi_k_dates, int i_len,
+                                int64_t i_elapsed )
+{
+    size_t i_key = 0;
+
+    /* Everything else ProcessLines() depends on */
+    const int pi_header[3] = {
+        (int)p_filter->fmt_out.video.i_visible_width,
+        (int)p_filter->fmt_out.video.i_visible_height,
+        p_filter->p_sys->p_stroker ? (int)var_InheritInteger( p_filter, "freetype-outline-thickness" ) : 0,
+    };
+    LineCacheKeyAppend( p_key, &i_key, pi_header, sizeof(pi_header) );
+
+    const text_style_t *p_previous_style = NULL;
+    for( int i = 0; i < i_len; i++ )
+    {
+        const text_style_t *p_style = pp_styles[i];
+        const uint8_t i_flags = (p_style != p_previous_style ? 1 : 0) |
+                                (pi_k_dates && pi_k_dates[i] >= i_elapsed ? 2 : 0);
+
+        LineCacheKeyAppend( p_key, &i_key, &psz_text[i], sizeof(*psz_text) );
+        LineCacheKeyAppend( p_key, &i_key, &i_flags, sizeof(i_flags) );
+        if( p_style != p_previous_style && p_style )
+        {
+            /* All the integer properties, then the font name */
+            LineCacheKeyAppend( p_key, &i_key, &p_style->i_font_size,
+                                offsetof(text_style_t, i_spacing) + sizeof(p_style->i_spacing) -
+                                offsetof(text_style_t, i_font_size) );
+            LineCacheKeyAppend( p_key, &i_key, p_style->psz_fontname,
+                                strlen( p_style->psz_fontname ) + 1 );
+        }
+        p_previous_style = p_style;
+    }
+    return i_key;
+}
+
+static uint8_t *LineCacheKey( filter_t *p_filter, size_t *pi_key,
+                              const uni_char_t *psz_text, text_style_t **pp_styles,
+                              const uint32_t *pi_k_dates, int i_len )
+{
+    const int64_t i_elapsed = pi_k_dates ? var_GetTimeFast( p_filter, p_filter->p_sys->p_elapsed ) / 1000 : 0;
+
+    for( int i = 0; i < i_len; i++ )
+    {
+        if( pp_styles[i] && !pp_styles[i]->psz_fontname )
+            return NULL;
+    }
+
+    const size_t i_key = LineCacheKeyFill( p_filter, NULL, psz_text, pp_styles,
+                                           pi_k_dates, i_len, i_elapsed );
+    uint8_t *p_key = (uint8_t *)malloc( i_key );
+    if( !p_key )
+        return NULL;
+    LineCacheKeyFill( p_filter, p_key, psz_text, pp_styles, pi_k_dates, i_len, i_elapsed );
+
+    *pi_key = i_key;
+    return p_key;
+}
+
+static const line_cache_t *LineCacheGet( filter_sys_t *p_sys, const uint8_t *p_key, size_t i_key )
+{
+    for( int i = 0; i < p_sys->i_line_cache; i++ )
+    {
+        line_cache_t cache = p_sys->p_line_cache[i];
+        if( cache.i_key != i_key || memcmp( cache.p_key, p_key, i_key ) )
+            continue;
+
+        /* Move it to the front */
+        memmove( &p_sys->p_line_cache[1], &p_sys->p_line_cache[0],
+                 i * sizeof(*p_sys->p_line_cache) );
+        p_sys->p_line_cache[0] = cache;
+        return &p_sys->p_line_cache[0];
+    }
+    return NULL;
+}
+
+/* On success, the cache owns p_key and p_lines */
+static int LineCacheAdd( filter_sys_t *p_sys, uint8_t *p_key, size_t i_key,
+                         line_desc_t *p_lines, const FT_BBox *p_bbox, int i_max_face_height )
+{
+    if( !p_lines )
+        return VLC_EGENERIC;
+
+    if( p_sys->i_line_cache >= LINE_CACHE_MAX )
+    {
+        line_cache_t *p_old = &p_sys->p_line_cache[--p_sys->i_line_cache];
+        FreeLines( p_old->p_lines );
+        free( p_old->p_key );
+    }
+
+    memmove( &p_sys->p_line_cache[1], &p_sys->p_line_cache[0],
+             p_sys->i_line_cache * sizeof(*p_sys->p_line_cache) );
+    line_cache_t *p_cache = &p_sys->p_line_cache[0];
+    p_cache->p_key             = p_key;
+    p_cache->i_key             = i_key;
+    p_cache->p_lines           = p_lines;
+    p_cache->bbox              = *p_bbox;
+    p_cache->i_max_face_height = i_max_face_height;
+    p_sys->i_line_cache++;
+    return VLC_SUCCESS;
+}
+
+static void LineCacheClear( filter_sys_t *p_sys )
+{
+    for( int i = 0; i < p_sys->i_line_cache; i++ )
+    {
+        FreeLines( p_sys->p_line_cache[i].p_lines );
+        free( p_sys->p_line_cache[i].p_key );
+    }
+    p_sys->i_line_cache = 0;
+}
+
 static int ProcessLines( filter_t *p_filter,
                          line_desc_t **pp_lines,
                          FT_BBox     *p_bbox,
@@ -2240,7 +2748,7 @@ static int ProcessLines( filter_t *p_filter,
         pi_karaoke_bar = (uint8_t *)malloc( i_len * sizeof(*pi_karaoke_bar));			// sunqueen modify
         if( pi_karaoke_bar )
         {
-            int64_t i_elapsed  = var_GetTime( p_filter, "spu-elapsed" ) / 1000;
+            int64_t i_elapsed  = var_GetTimeFast( p_filter, p_filter->p_sys->p_elapsed ) / 1000;
             for( int i = 0; i < i_len; i++ )
             {
                 unsigned i_bar = p_new_positions ? p_new_positions[i] : i;
@@ -2333,11 +2841,9 @@ static int ProcessLines( filter_t *p_filter,
             /* (Re)load/reconfigure the face if needed */
             if( !FaceStyleEquals( p_current_style, p_previous_style ) )
             {
-                if( p_face )
-                    FT_Done_Face( p_face );
                 p_previous_style = NULL;
 
-                p_face = LoadFace( p_filter, p_current_style );
+                p_face = GetFace( p_filter, p_current_style );
             }
             FT_Face p_current_face = p_face ? p_face : p_sys->p_face;
             if( !p_previous_style || p_previous_style->i_font_size != p_current_style->i_font_size )
@@ -2349,6 +2855,7 @@ static int ProcessLines( filter_t *p_filter,
                     double f_outline_thickness = var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
                     f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
                     int i_radius = (p_current_style->i_font_size << 6) * f_outline_thickness;
+                    p_sys->i_outline_radius = i_radius;
                     FT_Stroker_Set( p_sys->p_stroker,
                                     i_radius,
                                     FT_STROKER_LINECAP_ROUND,
@@ -2393,21 +2900,18 @@ static int ProcessLines( filter_t *p_filter,
                 FT_BBox  outline_bbox;
                 FT_Glyph shadow;
                 FT_BBox  shadow_bbox;
-
-                if( GetGlyph( p_filter,
-                              &glyph, &glyph_bbox,
-                              &outline, &outline_bbox,
-                              &shadow, &shadow_bbox,
-                              p_current_face, i_glyph_index, p_glyph_style->i_style_flags,
-                              &pen_new, &pen_shadow_new ) )
+                FT_Vector advance;
+
+                if( GetCachedGlyph( p_filter,
+                                    &glyph, &glyph_bbox,
+                                    &outline, &outline_bbox,
+                                    &shadow, &shadow_bbox,
+                                    &advance,
+                                    p_current_face, p_current_style->i_font_size,
+                                    i_glyph_index, p_glyph_style->i_style_flags,
+                                    &pen_new, &pen_shadow_new ) )
                     goto next;
 
-                FixGlyph( glyph, &glyph_bbox, p_current_face, &pen_new );
-                if( outline )
-                    FixGlyph( outline, &outline_bbox, p_current_face, &pen_new );
-                if( shadow )
-                    FixGlyph( shadow, &shadow_bbox, p_current_face, &pen_shadow_new );
-
                 /* FIXME and what about outline */
 
                 bool     b_karaoke = pi_karaoke_bar && pi_karaoke_bar[i_index] != 0;
@@ -2516,8 +3020,8 @@ static int ProcessLines( filter_t *p_filter,
 				p_line->i_character_count++;
 				// sunqueen modify end
 
-                pen.x = pen_new.x + p_current_face->glyph->advance.x;
-                pen.y = pen_new.y + p_current_face->glyph->advance.y;
+                pen.x = pen_new.x + advance.x;
+                pen.y = pen_new.y + advance.y;
                 line_bbox = line_bbox_new;
             next:
                 i_glyph_last = i_glyph_index;
@@ -2582,8 +3086,6 @@ static int ProcessLines( filter_t *p_filter,
             break;
         }
     }
-    if( p_face )
-        FT_Done_Face( p_face );
 
     free( pp_fribidi_styles );
     free( p_fribidi_string );
@@ -2627,12 +3129,16 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
     /* Reset the default fontsize in case screen metrics have changed */
     p_filter->p_sys->i_font_size = GetFontSize( p_filter );
 
+    /* The faces used from now on cannot be replaced until the next render */
+    p_sys->i_face_render = p_sys->i_face_use;
+
     /* */
     int rv = VLC_SUCCESS;
     int i_text_length = 0;
     FT_BBox bbox;
     int i_max_face_height;
     line_desc_t *p_lines = NULL;
+    bool b_lines_cached = false;
 
     uint32_t *pi_k_durations   = NULL;
 
@@ -2729,9 +3235,29 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
 
     if( !rv && i_text_length > 0 )
     {
-        rv = ProcessLines( p_filter,
-                           &p_lines, &bbox, &i_max_face_height,
-                           psz_text, pp_styles, pi_k_durations, i_text_length );
+        size_t i_key;
+        uint8_t *p_key = LineCacheKey( p_filter, &i_key,
+                                       psz_text, pp_styles, pi_k_durations, i_text_length );
+        const line_cache_t *p_cache = p_key ? LineCacheGet( p_sys, p_key, i_key ) : NULL;
+        if( p_cache )
+        {
+            p_lines = p_cache->p_lines;
+            bbox = p_cache->bbox;
+            i_max_face_height = p_cache->i_max_face_height;
+            b_lines_cached = true;
+            free( p_key );
+        }
+        else
+        {
+            rv = ProcessLines( p_filter,
+                               &p_lines, &bbox, &i_max_face_height,
+                               psz_text, pp_styles, pi_k_durations, i_text_length );
+            if( !rv && p_key )
+                b_lines_cached = !LineCacheAdd( p_sys, p_key, i_key,
+                                                p_lines, &bbox, i_max_face_height );
+            else
+                free( p_key );
+        }
     }
 
     p_region_out->i_x = p_region_in->i_x;
@@ -2777,10 +3303,11 @@ static int RenderCommon( filter_t *p_filter, subpicture_region_t *p_region_out,
          * of times to show the progress marker on the text.
          */
         if( pi_k_durations )
-            var_SetBool( p_filter, "text-rerender", true );
+            var_SetBoolFast( p_filter, p_sys->p_rerender, true );
     }
 
-    FreeLines( p_lines );
+    if( !b_lines_cached )
+        FreeLines( p_lines );
 
     free( psz_text );
     for( int i = 0; i < i_text_length; i++ )
@@ -2839,6 +3366,18 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library        = 0;
     p_sys->i_font_size      = 0;
     p_sys->i_display_height = 0;
+    p_sys->i_outline_radius = 0;
+    p_sys->i_face_cache     = 0;
+    p_sys->i_face_use       = 0;
+    p_sys->i_face_render    = 0;
+    p_sys->p_elapsed        = var_Handle( "spu-elapsed" );
+    p_sys->p_rerender       = var_Handle( "text-rerender" );
+    for( int i = 0; i < GLYPH_CACHE_HASH; i++ )
+        p_sys->pp_glyph_hash[i] = NULL;
+    p_sys->p_glyph_lru_first = NULL;
+    p_sys->p_glyph_lru_last  = NULL;
+    p_sys->i_glyph_cache     = 0;
+    p_sys->i_line_cache      = 0;
 
     /*
      * The following variables should not be cached, as they might be changed on-the-fly:
@@ -3025,6 +3564,9 @@ static void Destroy( vlc_object_t *p_this )
         free( p_sys->pp_font_attachments );
     }
 
+    LineCacheClear( p_sys );
+    FaceCacheClear( p_sys );
+
     if( p_sys->p_xml ) xml_ReaderDelete( p_sys->p_xml );
     free( p_sys->psz_fontfamily );
     free( p_sys->psz_monofontfamily );
@@ -41,6 +41,9 @@
 
 #include "../video_chroma/i420_rgb.h"			// sunqueen modify
 #if defined (MODULE_NAME_IS_i420_rgb)
+#   include "yuv_rgb.h"
+#endif
+#if defined (MODULE_NAME_IS_i420_rgb)
 #   include "i420_rgb_c.h"
     static picture_t *I420_RGB8_Filter         ( filter_t *, picture_t * );
 //    static picture_t *I420_RGB16_dither_Filter ( filter_t *, picture_t * );
@@ -99,6 +102,13 @@ vlc_module_begin ()
 # define vlc_CPU_capable() vlc_CPU_SSE2()
 #endif
     set_callbacks( Activate, Deactivate )
+#if defined (MODULE_NAME_IS_i420_rgb)
+    add_submodule ()
+    set_description( N_("Sliced I420,YV12,J420,I422,J422,NV12 to "
+                       "RV16,RV24,RV32 conversions") )
+    set_capability( "video filter2", 160 )
+    set_callbacks( yuv_rgb_Open, yuv_rgb_Close )
+#endif
 vlc_module_end ()
 
 /*****************************************************************************
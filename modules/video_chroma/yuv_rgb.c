@@ -0,0 +1,504 @@
+/*****************************************************************************
+ * yuv_rgb.c : sliced YUV to RGB conversions
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "stdafx.h"
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+#include <vlc_slices.h>
+
+#include "yuv_rgb.h"
+
+/*****************************************************************************
+ * Matrix
+ *****************************************************************************/
+void yuv_rgb_SetMatrix( yuv_rgb_matrix_t *p_matrix, bool b_bt709,
+                        bool b_full_range )
+{
+    const double kr = b_bt709 ? 0.2126 : 0.299;
+    const double kb = b_bt709 ? 0.0722 : 0.114;
+    const double kg = 1. - kr - kb;
+    /* Limited range chroma spans 16-240, and luma 16-235 */
+    const double cs = b_full_range ? 1. : 255. / 224.;
+    const double ys = b_full_range ? 1. : 255. / 219.;
+
+#define Q13( f ) ((int16_t)((f) * 8192. + .5))
+    p_matrix->i_y_offset = b_full_range ? 0 : 16;
+    p_matrix->i_y   = Q13( ys );
+    p_matrix->i_v_r = Q13( 2. * (1. - kr) * cs );
+    p_matrix->i_u_g = Q13( 2. * (1. - kb) * kb / kg * cs );
+    p_matrix->i_v_g = Q13( 2. * (1. - kr) * kr / kg * cs );
+    p_matrix->i_u_b = Q13( 2. * (1. - kb) * cs );
+#undef Q13
+}
+
+/*****************************************************************************
+ * C line converters
+ *****************************************************************************/
+#define MULHI( a, b ) (((int)(a) * (int)(b)) >> 16)
+
+static inline uint8_t Clip8( int i )
+{
+    return i < 0 ? 0 : i > 255 ? 255 : i;
+}
+
+/* Converts one pixel: all the converters share it for bit exactness */
+static inline void YuvToRgb( const yuv_rgb_matrix_t *m, int i_y, int i_u,
+                             int i_v, uint8_t *r, uint8_t *g, uint8_t *b )
+{
+    const int y = MULHI( (i_y - m->i_y_offset) * 64, m->i_y );
+    const int u = (i_u - 128) * 64;
+    const int v = (i_v - 128) * 64;
+
+    *r = Clip8( (y + MULHI( v, m->i_v_r ) + 4) >> 3 );
+    *g = Clip8( (y - MULHI( u, m->i_u_g ) - MULHI( v, m->i_v_g ) + 4) >> 3 );
+    *b = Clip8( (y + MULHI( u, m->i_u_b ) + 4) >> 3 );
+}
+
+/* i_step is the distance between two chroma samples: 1 for planar, 2 for
+ * NV12. The pixels are stored by the STORE macro. */
+#define LINE_C( name, bpp, STORE )                                          \
+static void name( uint8_t *p_dst, const uint8_t *p_y, const uint8_t *p_u,   \
+                  const uint8_t *p_v, unsigned i_width,                     \
+                  const yuv_rgb_matrix_t *m, unsigned i_step )              \
+{                                                                           \
+    for( unsigned x = 0; x < i_width; x++, p_dst += bpp )                   \
+    {                                                                       \
+        uint8_t r, g, b;                                                    \
+        const unsigned c = (x / 2) * i_step;                                \
+                                                                            \
+        YuvToRgb( m, p_y[x], p_u[c], p_v[c], &r, &g, &b );                  \
+        STORE;                                                              \
+    }                                                                       \
+}
+
+LINE_C( LineBGRX, 4, p_dst[0] = b; p_dst[1] = g; p_dst[2] = r; p_dst[3] = 0xff )
+LINE_C( LineRGBX, 4, p_dst[0] = r; p_dst[1] = g; p_dst[2] = b; p_dst[3] = 0xff )
+LINE_C( LineBGR, 3, p_dst[0] = b; p_dst[1] = g; p_dst[2] = r )
+LINE_C( LineRGB, 3, p_dst[0] = r; p_dst[1] = g; p_dst[2] = b )
+LINE_C( Line565, 2, *(uint16_t *)p_dst = ((r & 0xf8) << 8)
+                                       | ((g & 0xfc) << 3) | (b >> 3) )
+
+#define LINE_C_WRAPPERS( name )                                             \
+static void name##_C( uint8_t *p_dst, const uint8_t *p_y,                   \
+                      const uint8_t *p_u, const uint8_t *p_v,               \
+                      unsigned i_width, const yuv_rgb_matrix_t *m )         \
+{                                                                           \
+    name( p_dst, p_y, p_u, p_v, i_width, m, 1 );                            \
+}                                                                           \
+static void name##_NV12_C( uint8_t *p_dst, const uint8_t *p_y,              \
+                           const uint8_t *p_uv, const uint8_t *p_unused,    \
+                           unsigned i_width, const yuv_rgb_matrix_t *m )    \
+{                                                                           \
+    VLC_UNUSED(p_unused);                                                   \
+    name( p_dst, p_y, p_uv, p_uv + 1, i_width, m, 2 );                      \
+}
+
+LINE_C_WRAPPERS( LineBGRX )
+LINE_C_WRAPPERS( LineRGBX )
+LINE_C_WRAPPERS( LineBGR )
+LINE_C_WRAPPERS( LineRGB )
+LINE_C_WRAPPERS( Line565 )
+
+/*****************************************************************************
+ * SSE2 line converters
+ *****************************************************************************
+ * They convert 8 pixels per iteration in 16 bits lanes, and leave the
+ * remaining pixels to the C converters.
+ *****************************************************************************/
+#ifdef CAN_COMPILE_SSE2
+/* Loads 8 luma samples and the 4 chroma samples pairs covering them, with
+ * each chroma sample doubled. */
+static inline void LoadSSE2( const uint8_t *p_y, const uint8_t *p_u,
+                             const uint8_t *p_v, unsigned x, bool b_nv12,
+                             __m128i *y, __m128i *u, __m128i *v )
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    *y = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)&p_y[x] ), zero );
+
+    if( b_nv12 )
+    {
+        /* 32 bits lanes of U | V << 16 */
+        const __m128i uv = _mm_unpacklo_epi8(
+                _mm_loadl_epi64( (const __m128i *)&p_u[x] ), zero );
+        const __m128i cu = _mm_and_si128( uv, _mm_set1_epi32( 0xffff ) );
+        const __m128i cv = _mm_srli_epi32( uv, 16 );
+
+        *u = _mm_or_si128( cu, _mm_slli_epi32( cu, 16 ) );
+        *v = _mm_or_si128( cv, _mm_slli_epi32( cv, 16 ) );
+    }
+    else
+    {
+        const __m128i cu = _mm_cvtsi32_si128( *(const int *)&p_u[x / 2] );
+        const __m128i cv = _mm_cvtsi32_si128( *(const int *)&p_v[x / 2] );
+
+        *u = _mm_unpacklo_epi8( _mm_unpacklo_epi8( cu, cu ), zero );
+        *v = _mm_unpacklo_epi8( _mm_unpacklo_epi8( cv, cv ), zero );
+    }
+}
+
+/* Same arithmetic as YuvToRgb(), the results are clipped to [0, 255] */
+static inline void ConvertSSE2( const yuv_rgb_matrix_t *m, __m128i y,
+                                __m128i u, __m128i v,
+                                __m128i *r, __m128i *g, __m128i *b )
+{
+    const __m128i round = _mm_set1_epi16( 4 );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16( 255 );
+
+    y = _mm_sub_epi16( y, _mm_set1_epi16( m->i_y_offset ) );
+    y = _mm_mulhi_epi16( _mm_slli_epi16( y, 6 ), _mm_set1_epi16( m->i_y ) );
+    y = _mm_add_epi16( y, round );
+    u = _mm_slli_epi16( _mm_sub_epi16( u, _mm_set1_epi16( 128 ) ), 6 );
+    v = _mm_slli_epi16( _mm_sub_epi16( v, _mm_set1_epi16( 128 ) ), 6 );
+
+    __m128i tr = _mm_add_epi16( y,
+                     _mm_mulhi_epi16( v, _mm_set1_epi16( m->i_v_r ) ) );
+    __m128i tg = _mm_sub_epi16( y,
+                     _mm_mulhi_epi16( u, _mm_set1_epi16( m->i_u_g ) ) );
+    tg = _mm_sub_epi16( tg,
+                     _mm_mulhi_epi16( v, _mm_set1_epi16( m->i_v_g ) ) );
+    __m128i tb = _mm_add_epi16( y,
+                     _mm_mulhi_epi16( u, _mm_set1_epi16( m->i_u_b ) ) );
+
+    *r = _mm_min_epi16( _mm_max_epi16( _mm_srai_epi16( tr, 3 ), zero ), max );
+    *g = _mm_min_epi16( _mm_max_epi16( _mm_srai_epi16( tg, 3 ), zero ), max );
+    *b = _mm_min_epi16( _mm_max_epi16( _mm_srai_epi16( tb, 3 ), zero ), max );
+}
+
+/* Interleaves 8 pixels as 4 bytes c0 c1 c2 0xff, in order */
+static inline void Pack32SSE2( __m128i c0, __m128i c1, __m128i c2,
+                               __m128i *p_lo, __m128i *p_hi )
+{
+    const __m128i c01 = _mm_or_si128( c0, _mm_slli_epi16( c1, 8 ) );
+    const __m128i c2x = _mm_or_si128( c2, _mm_set1_epi16( (short)0xff00 ) );
+
+    *p_lo = _mm_unpacklo_epi16( c01, c2x );
+    *p_hi = _mm_unpackhi_epi16( c01, c2x );
+}
+
+/* Drops the 4th byte of the 8 pixels packed by Pack32SSE2() */
+static inline void Store24SSE2( uint8_t *p_dst, __m128i lo, __m128i hi )
+{
+    /* 6 bytes in each quadword */
+    const __m128i first = _mm_set_epi32( 0, 0x00ffffff, 0, 0x00ffffff );
+    const __m128i second = _mm_set_epi32( 0x00ffffff, 0, 0x00ffffff, 0 );
+    lo = _mm_or_si128( _mm_and_si128( lo, first ),
+                       _mm_srli_epi64( _mm_and_si128( lo, second ), 8 ) );
+    hi = _mm_or_si128( _mm_and_si128( hi, first ),
+                       _mm_srli_epi64( _mm_and_si128( hi, second ), 8 ) );
+
+    uint64_t q[4], out[3];
+    _mm_storeu_si128( (__m128i *)&q[0], lo );
+    _mm_storeu_si128( (__m128i *)&q[2], hi );
+    out[0] = q[0] | (q[1] << 48);
+    out[1] = (q[1] >> 16) | (q[2] << 32);
+    out[2] = (q[2] >> 32) | (q[3] << 16);
+    memcpy( p_dst, out, 24 );
+}
+
+#define LINE_SSE2( name, tail, bpp, nv12, STORE )                           \
+static void name##_SSE2( uint8_t *p_dst, const uint8_t *p_y,                \
+                         const uint8_t *p_u, const uint8_t *p_v,            \
+                         unsigned i_width, const yuv_rgb_matrix_t *m )      \
+{                                                                           \
+    unsigned x = 0;                                                         \
+                                                                            \
+    for( ; x + 8 <= i_width; x += 8 )                                       \
+    {                                                                       \
+        __m128i y, u, v, r, g, b;                                           \
+        uint8_t *p_out = &p_dst[x * bpp];                                   \
+                                                                            \
+        LoadSSE2( p_y, p_u, p_v, x, nv12, &y, &u, &v );                     \
+        ConvertSSE2( m, y, u, v, &r, &g, &b );                              \
+        STORE;                                                              \
+    }                                                                       \
+                                                                            \
+    if( x < i_width )                                                       \
+    {                                                                       \
+        if( nv12 )                                                          \
+            tail( &p_dst[x * bpp], &p_y[x], &p_u[x], &p_u[x + 1],           \
+                  i_width - x, m, 2 );                                      \
+        else                                                                \
+            tail( &p_dst[x * bpp], &p_y[x], &p_u[x / 2], &p_v[x / 2],       \
+                  i_width - x, m, 1 );                                      \
+    }                                                                       \
+}
+
+#define STORE32( c0, c1, c2 )                                               \
+    do {                                                                    \
+        __m128i lo, hi;                                                     \
+        Pack32SSE2( c0, c1, c2, &lo, &hi );                                 \
+        _mm_storeu_si128( (__m128i *)&p_out[0], lo );                       \
+        _mm_storeu_si128( (__m128i *)&p_out[16], hi );                      \
+    } while(0)
+
+#define STORE24( c0, c1, c2 )                                               \
+    do {                                                                    \
+        __m128i lo, hi;                                                     \
+        Pack32SSE2( c0, c1, c2, &lo, &hi );                                 \
+        Store24SSE2( p_out, lo, hi );                                       \
+    } while(0)
+
+#define STORE565()                                                          \
+    do {                                                                    \
+        __m128i px = _mm_slli_epi16(                                        \
+            _mm_and_si128( r, _mm_set1_epi16( 0xf8 ) ), 8 );                \
+        px = _mm_or_si128( px, _mm_slli_epi16(                              \
+            _mm_and_si128( g, _mm_set1_epi16( 0xfc ) ), 3 ) );              \
+        px = _mm_or_si128( px, _mm_srli_epi16( b, 3 ) );                    \
+        _mm_storeu_si128( (__m128i *)p_out, px );                           \
+    } while(0)
+
+/* The bool argument is a constant: each function loads one chroma layout */
+LINE_SSE2( LineBGRX, LineBGRX, 4, false, STORE32( b, g, r ) )
+LINE_SSE2( LineRGBX, LineRGBX, 4, false, STORE32( r, g, b ) )
+LINE_SSE2( LineBGR, LineBGR, 3, false, STORE24( b, g, r ) )
+LINE_SSE2( LineRGB, LineRGB, 3, false, STORE24( r, g, b ) )
+LINE_SSE2( Line565, Line565, 2, false, STORE565() )
+LINE_SSE2( LineBGRX_NV12, LineBGRX, 4, true, STORE32( b, g, r ) )
+LINE_SSE2( LineRGBX_NV12, LineRGBX, 4, true, STORE32( r, g, b ) )
+LINE_SSE2( LineBGR_NV12, LineBGR, 3, true, STORE24( b, g, r ) )
+LINE_SSE2( LineRGB_NV12, LineRGB, 3, true, STORE24( r, g, b ) )
+LINE_SSE2( Line565_NV12, Line565, 2, true, STORE565() )
+#endif
+
+yuv_rgb_line_t yuv_rgb_GetLine( yuv_rgb_output_t output, bool b_nv12,
+                                bool b_simd )
+{
+    static const yuv_rgb_line_t c[][2] = {
+        { LineBGRX_C, LineBGRX_NV12_C },
+        { LineRGBX_C, LineRGBX_NV12_C },
+        { LineBGR_C,  LineBGR_NV12_C },
+        { LineRGB_C,  LineRGB_NV12_C },
+        { Line565_C,  Line565_NV12_C },
+    };
+
+    if( !b_simd )
+        return c[output][b_nv12];
+#ifdef CAN_COMPILE_SSE2
+    static const yuv_rgb_line_t sse2[][2] = {
+        { LineBGRX_SSE2, LineBGRX_NV12_SSE2 },
+        { LineRGBX_SSE2, LineRGBX_NV12_SSE2 },
+        { LineBGR_SSE2,  LineBGR_NV12_SSE2 },
+        { LineRGB_SSE2,  LineRGB_NV12_SSE2 },
+        { Line565_SSE2,  Line565_NV12_SSE2 },
+    };
+
+    if( vlc_CPU_SSE2() )
+        return sse2[output][b_nv12];
+#endif
+    return NULL;
+}
+
+/*****************************************************************************
+ * Filter
+ *****************************************************************************/
+struct filter_sys_t
+{
+    yuv_rgb_matrix_t matrix;
+    yuv_rgb_line_t   pf_line;
+    bool             b_420;
+    bool             b_nv12;
+};
+
+typedef struct
+{
+    filter_t        *p_filter;
+    const picture_t *p_src;
+    picture_t       *p_dst;
+} yuv_rgb_job_t;
+
+static void ConvertSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    const yuv_rgb_job_t *p_job = (const yuv_rgb_job_t *)opaque;
+    const filter_sys_t *p_sys = p_job->p_filter->p_sys;
+    const picture_t *p_src = p_job->p_src;
+    const plane_t *p_out = &p_job->p_dst->p[0];
+    const unsigned i_width = p_job->p_filter->fmt_in.video.i_width;
+    int i_first, i_end;
+
+    /* Even bands, so that 4:2:0 chroma lines are not shared */
+    vlc_slice_Lines( i_slice, i_slices,
+                     __MIN( p_job->p_filter->fmt_in.video.i_height,
+                            (unsigned)p_out->i_visible_lines ),
+                     2, &i_first, &i_end );
+
+    for( int y = i_first; y < i_end; y++ )
+    {
+        const int cy = p_sys->b_420 ? y / 2 : y;
+        const uint8_t *p_u, *p_v;
+
+        if( p_sys->b_nv12 )
+        {
+            p_u = &p_src->p[1].p_pixels[cy * p_src->p[1].i_pitch];
+            p_v = p_u + 1;
+        }
+        else
+        {
+            p_u = &p_src->U_PIXELS[cy * p_src->p[U_PLANE].i_pitch];
+            p_v = &p_src->V_PIXELS[cy * p_src->p[V_PLANE].i_pitch];
+        }
+        p_sys->pf_line( &p_out->p_pixels[y * p_out->i_pitch],
+                        &p_src->Y_PIXELS[y * p_src->p[Y_PLANE].i_pitch],
+                        p_u, p_v, i_width, &p_sys->matrix );
+    }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic = filter_NewPicture( p_filter );
+    if( p_outpic )
+    {
+        yuv_rgb_job_t job = { p_filter, p_pic, p_outpic };
+
+        vlc_slices_Run( p_filter, ConvertSlice, &job,
+                        vlc_slices_Count( p_filter ) );
+        picture_CopyProperties( p_outpic, p_pic );
+    }
+    picture_Release( p_pic );
+    return p_outpic;
+}
+
+static int GetOutput( const video_format_t *p_fmt, yuv_rgb_output_t *p_output )
+{
+    switch( p_fmt->i_chroma )
+    {
+        case VLC_CODEC_RGB32:
+            if( p_fmt->i_rmask == 0x00ff0000 && p_fmt->i_gmask == 0x0000ff00
+             && p_fmt->i_bmask == 0x000000ff )
+                *p_output = YUV_RGB_BGRX;
+            else if( p_fmt->i_rmask == 0x000000ff
+                  && p_fmt->i_gmask == 0x0000ff00
+                  && p_fmt->i_bmask == 0x00ff0000 )
+                *p_output = YUV_RGB_RGBX;
+            else
+                return VLC_EGENERIC;
+            return VLC_SUCCESS;
+        case VLC_CODEC_RGB24:
+            if( p_fmt->i_rmask == 0xff0000 && p_fmt->i_gmask == 0x00ff00
+             && p_fmt->i_bmask == 0x0000ff )
+                *p_output = YUV_RGB_BGR;
+            else if( p_fmt->i_rmask == 0x0000ff && p_fmt->i_gmask == 0x00ff00
+                  && p_fmt->i_bmask == 0xff0000 )
+                *p_output = YUV_RGB_RGB;
+            else
+                return VLC_EGENERIC;
+            return VLC_SUCCESS;
+        case VLC_CODEC_RGB16:
+            if( p_fmt->i_rmask != 0xf800 || p_fmt->i_gmask != 0x07e0
+             || p_fmt->i_bmask != 0x001f )
+                return VLC_EGENERIC;
+            *p_output = YUV_RGB_565;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+/*****************************************************************************
+ * yuv_rgb_Open: check the formats and allocate the converter
+ *****************************************************************************/
+int yuv_rgb_Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+    bool b_420 = true, b_nv12 = false, b_full_range = false;
+    yuv_rgb_output_t output;
+
+    /* No scaling */
+    if( p_in->i_width != p_out->i_width || p_in->i_height != p_out->i_height
+     || (p_in->i_width & 1) || (p_in->i_height & 1) )
+        return VLC_EGENERIC;
+
+    switch( p_in->i_chroma )
+    {
+        case VLC_CODEC_J420:
+            b_full_range = true;
+        case VLC_CODEC_I420:
+        case VLC_CODEC_YV12:
+            break;
+        case VLC_CODEC_J422:
+            b_full_range = true;
+        case VLC_CODEC_I422:
+            b_420 = false;
+            break;
+        case VLC_CODEC_NV12:
+            b_nv12 = true;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    if( GetOutput( p_out, &output ) )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = (filter_sys_t *)malloc( sizeof( *p_sys ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    /* The format does not tell the color space: HD is BT.709, like in the
+     * OpenGL output */
+    const bool b_bt709 = p_in->i_height > 576;
+
+    yuv_rgb_SetMatrix( &p_sys->matrix, b_bt709, b_full_range );
+    /* The C converters are used without SSE2 */
+    p_sys->pf_line = yuv_rgb_GetLine( output, b_nv12, true );
+    if( !p_sys->pf_line )
+        p_sys->pf_line = yuv_rgb_GetLine( output, b_nv12, false );
+    p_sys->b_420   = b_420;
+    p_sys->b_nv12  = b_nv12;
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Filter;
+
+    msg_Dbg( p_filter, "%s %4.4s to %4.4s, %s %s range",
+             p_sys->pf_line == yuv_rgb_GetLine( output, b_nv12, false )
+                 ? "C" : "SSE2",
+             (const char *)&p_in->i_chroma, (const char *)&p_out->i_chroma,
+             b_bt709 ? "BT.709" : "BT.601", b_full_range ? "full" : "limited" );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * yuv_rgb_Close: free the converter
+ *****************************************************************************/
+void yuv_rgb_Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
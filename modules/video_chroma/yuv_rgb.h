@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * yuv_rgb.h : YUV to RGB line converters
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_YUV_RGB_H
+#define VLC_YUV_RGB_H 1
+
+/**
+ * YUV to RGB matrix.
+ *
+ * The coefficients are in 3.13 fixed point. The C and SIMD converters use
+ * the same 16 bits arithmetic, so that they give the same results:
+ *  y' = ((Y - y_offset) << 6) * y >> 16
+ *  R  = (y' + ((V - 128) << 6) * v_r >> 16 + 4) >> 3
+ *  G  = (y' - ((U - 128) << 6) * u_g >> 16 - ((V - 128) << 6) * v_g >> 16 + 4) >> 3
+ *  B  = (y' + ((U - 128) << 6) * u_b >> 16 + 4) >> 3
+ */
+typedef struct
+{
+    int16_t i_y_offset; /**< 16 for limited range, 0 for full range */
+    int16_t i_y;        /**< luma gain */
+    int16_t i_v_r;      /**< V contribution to red */
+    int16_t i_u_g;      /**< U contribution to green (subtracted) */
+    int16_t i_v_g;      /**< V contribution to green (subtracted) */
+    int16_t i_u_b;      /**< U contribution to blue */
+} yuv_rgb_matrix_t;
+
+/**
+ * Computes the matrix of BT.601 or BT.709, for limited (16-235) or full
+ * (0-255) range YUV.
+ */
+void yuv_rgb_SetMatrix( yuv_rgb_matrix_t *, bool b_bt709, bool b_full_range );
+
+/**
+ * Output pixel layouts
+ */
+typedef enum
+{
+    YUV_RGB_BGRX,  /**< RV32, red mask 0x00ff0000 */
+    YUV_RGB_RGBX,  /**< RV32, red mask 0x000000ff */
+    YUV_RGB_BGR,   /**< RV24, red mask 0xff0000 */
+    YUV_RGB_RGB,   /**< RV24, red mask 0x0000ff */
+    YUV_RGB_565,   /**< RV16, R5G6B5 */
+} yuv_rgb_output_t;
+
+/**
+ * Converts one line of i_width pixels. The chroma is subsampled
+ * horizontally by 2. For NV12, p_u points to the interleaved chroma and
+ * p_v is p_u + 1.
+ */
+typedef void (*yuv_rgb_line_t)( uint8_t *p_dst, const uint8_t *p_y,
+                                const uint8_t *p_u, const uint8_t *p_v,
+                                unsigned i_width, const yuv_rgb_matrix_t * );
+
+/**
+ * Returns the line converter for an output layout and a chroma layout
+ * (planar or NV12), or NULL if the instruction set is not available.
+ *
+ * @param b_simd false for the C reference, true for the SSE2 version
+ */
+yuv_rgb_line_t yuv_rgb_GetLine( yuv_rgb_output_t, bool b_nv12, bool b_simd );
+
+/**
+ * Sliced "video filter2" converter, a submodule of i420_rgb
+ */
+int  yuv_rgb_Open ( vlc_object_t * );
+void yuv_rgb_Close( vlc_object_t * );
+
+#endif
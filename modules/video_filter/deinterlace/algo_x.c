@@ -36,6 +36,8 @@
 #include <vlc_common.h>
 #include <vlc_cpu.h>
 #include <vlc_picture.h>
+#include <vlc_filter.h>
+#include <vlc_slices.h>
 
 #include "deinterlace.h" /* filter_sys_t */
 
@@ -572,18 +574,23 @@ static inline void XDeintBand8x8MMXEXT( uint8_t *dst, int i_dst,
 }
 #endif
 
-/*****************************************************************************
- * Public functions
- *****************************************************************************/
+typedef struct
+{
+    picture_t *p_outpic;
+    picture_t *p_pic;
+} x_job_t;
 
-void RenderX( picture_t *p_outpic, picture_t *p_pic )
+/* Process a band of 8 line blocks of each plane */
+static void XSlice( void *opaque, unsigned i_slice, unsigned i_slices )
 {
+    const x_job_t *p_job = (const x_job_t *)opaque;
+    picture_t *p_outpic = p_job->p_outpic;
+    picture_t *p_pic = p_job->p_pic;
     int i_plane;
 #if defined (CAN_COMPILE_MMXEXT)
     const bool mmxext = vlc_CPU_MMXEXT();
 #endif
 
-    /* Copy image and skip lines */
     for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
         const int i_mby = ( p_outpic->p[i_plane].i_visible_lines + 7 )/8 - 1;
@@ -595,9 +602,14 @@ void RenderX( picture_t *p_outpic, picture_t *p_pic )
         const int i_dst = p_outpic->p[i_plane].i_pitch;
         const int i_src = p_pic->p[i_plane].i_pitch;
 
+        /* The last (partial) block line is counted in the bands */
+        int i_first, i_end;
+        vlc_slice_Lines( i_slice, i_slices, i_mby + (i_mody ? 1 : 0), 1,
+                         &i_first, &i_end );
+
         int y, x;
 
-        for( y = 0; y < i_mby; y++ )
+        for( y = i_first; y < __MIN(i_end, i_mby); y++ )
         {
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
@@ -611,10 +623,10 @@ void RenderX( picture_t *p_outpic, picture_t *p_pic )
         }
 
         /* Last line (C only)*/
-        if( i_mody )
+        if( i_mody && i_end > i_mby )
         {
-            uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
-            uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
+            uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*i_mby*i_dst];
+            uint8_t *src = &p_pic->p[i_plane].p_pixels[8*i_mby*i_src];
 
             for( x = 0; x < i_mbx; x++ )
             {
@@ -634,3 +646,16 @@ void RenderX( picture_t *p_outpic, picture_t *p_pic )
         emms();
 #endif
 }
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+void RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    /* The blocks are independent: process bands of them in parallel */
+    x_job_t job;
+    job.p_outpic = p_outpic;
+    job.p_pic    = p_pic;
+    vlc_slices_Run( p_filter, XSlice, &job, vlc_slices_Count( p_filter ) );
+}
@@ -35,6 +35,7 @@
 #include <vlc_cpu.h>
 #include <vlc_picture.h>
 #include <vlc_filter.h>
+#include <vlc_slices.h>
 
 #include "deinterlace.h" /* filter_sys_t  */
 #include "common.h"      /* FFMIN3 et al. */
@@ -49,6 +50,79 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef void (*yadif_filter_line_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
+                                    int w, int prefs, int mrefs, int parity, int mode);
+
+typedef struct
+{
+    picture_t *p_dst;
+    picture_t *p_prev;
+    picture_t *p_cur;
+    picture_t *p_next;
+    int i_field;
+    int i_parity;
+    yadif_filter_line_t filter;
+} yadif_job_t;
+
+/* Filter a band of lines of each plane */
+static void YadifSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    const yadif_job_t *p_job = (const yadif_job_t *)opaque;
+    const int i_field = p_job->i_field;
+    const int yadif_parity = p_job->i_parity;
+
+    for( int n = 0; n < p_job->p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &p_job->p_prev->p[n];
+        const plane_t *curp  = &p_job->p_cur->p[n];
+        const plane_t *nextp = &p_job->p_next->p[n];
+        plane_t *dstp        = &p_job->p_dst->p[n];
+
+        /* The first and last lines are not in any band */
+        if( dstp->i_visible_lines <= 2 )
+            continue;
+        int y_start, y_end;
+        vlc_slice_Lines( i_slice, i_slices, dstp->i_visible_lines - 2, 1,
+                         &y_start, &y_end );
+
+        for( int y = 1 + y_start; y < 1 + y_end; y++ )
+        {
+            if( (y % 2) == i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                p_job->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                               &prevp->p_pixels[y * prevp->i_pitch],
+                               &curp->p_pixels[y * curp->i_pitch],
+                               &nextp->p_pixels[y * nextp->i_pitch],
+                               dstp->i_visible_pitch,
+                               y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                               y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                               yadif_parity,
+                               mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == dstp->i_visible_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+}
+
 int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
                  int i_order, int i_field )
 {
@@ -107,9 +181,13 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     if( p_prev && p_cur && p_next )
     {
         /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        yadif_filter_line_t filter;
 
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
             filter = yadif_filter_line_ssse3;
@@ -128,51 +206,18 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
             filter = yadif_filter_line_c;
 
         if( p_sys->chroma->pixel_size == 2 )
-            filter = (void (__cdecl *)(uint8_t *,uint8_t *,uint8_t *,uint8_t *,int,int,int,int,int))yadif_filter_line_c_16bit;			// sunqueen modify
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
-        {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
-        }
+            filter = (yadif_filter_line_t)yadif_filter_line_c_16bit;
+
+        /* The lines are independent: filter bands of them in parallel */
+        yadif_job_t job;
+        job.p_dst    = p_dst;
+        job.p_prev   = p_prev;
+        job.p_cur    = p_cur;
+        job.p_next   = p_next;
+        job.i_field  = i_field;
+        job.i_parity = yadif_parity;
+        job.filter   = filter;
+        vlc_slices_Run( p_filter, YadifSlice, &job, vlc_slices_Count( p_filter ) );
 
         p_sys->i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
@@ -184,7 +229,7 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
                  as set by Open() or SetFilterMethod(). It is always 0. */
 
         /* FIXME not good as it does not use i_order/i_field */
-        RenderX( p_dst, p_next );
+        RenderX( p_filter, p_dst, p_next );
         return VLC_SUCCESS;
     }
     else
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * avx2.c : AVX2 routines for the VLC deinterlacer
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The AVX2 routines live in their own file: they need the 256-bit integer
+ * intrinsics, which Visual C++ only has from 2012 (_MSC_VER 1700) on, and
+ * GCC only lets them through with the avx2 target. With an older compiler
+ * this file builds to nothing and CAN_COMPILE_AVX2 stays undefined, so the
+ * callers keep the SSE2/SSSE3/MMX routines. They are selected at run time
+ * with vlc_CPU_AVX2(). */
+
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+
+#if defined(__GNUC__) && !defined(__AVX2__)
+#   pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <vlc_common.h>
+#include "merge.h"
+
+/*****************************************************************************
+ * Merge (line blending) routines
+ *****************************************************************************/
+
+void Merge8BitAVX2( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                    size_t i_bytes )
+{
+    uint8_t *p_dest = (uint8_t *)_p_dest;
+    const uint8_t *p_s1 = (const uint8_t *)_p_s1;
+    const uint8_t *p_s2 = (const uint8_t *)_p_s2;
+
+    for( ; i_bytes >= 64; i_bytes -= 64 )
+    {
+        __m256i a0 = _mm256_loadu_si256( (const __m256i *)p_s1 );
+        __m256i a1 = _mm256_loadu_si256( (const __m256i *)(p_s1 + 32) );
+        __m256i b0 = _mm256_loadu_si256( (const __m256i *)p_s2 );
+        __m256i b1 = _mm256_loadu_si256( (const __m256i *)(p_s2 + 32) );
+        _mm256_storeu_si256( (__m256i *)p_dest, _mm256_avg_epu8( a0, b0 ) );
+        _mm256_storeu_si256( (__m256i *)(p_dest + 32), _mm256_avg_epu8( a1, b1 ) );
+        p_dest += 64;
+        p_s1 += 64;
+        p_s2 += 64;
+    }
+
+    for( ; i_bytes >= 16; i_bytes -= 16 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)p_s1 );
+        __m128i b = _mm_loadu_si128( (const __m128i *)p_s2 );
+        _mm_storeu_si128( (__m128i *)p_dest, _mm_avg_epu8( a, b ) );
+        p_dest += 16;
+        p_s1 += 16;
+        p_s2 += 16;
+    }
+
+    for( ; i_bytes > 0; i_bytes-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+
+void Merge16BitAVX2( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                     size_t i_bytes )
+{
+    uint16_t *p_dest = (uint16_t *)_p_dest;
+    const uint16_t *p_s1 = (const uint16_t *)_p_s1;
+    const uint16_t *p_s2 = (const uint16_t *)_p_s2;
+
+    size_t i_words = i_bytes / 2;
+    for( ; i_words >= 16; i_words -= 16 )
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i *)p_s1 );
+        __m256i b = _mm256_loadu_si256( (const __m256i *)p_s2 );
+        _mm256_storeu_si256( (__m256i *)p_dest, _mm256_avg_epu16( a, b ) );
+        p_dest += 16;
+        p_s1 += 16;
+        p_s2 += 16;
+    }
+
+    for( ; i_words > 0; i_words-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+
+void EndAVX2( void )
+{
+    _mm256_zeroupper();
+}
+
+/*****************************************************************************
+ * Yadif line filter
+ *****************************************************************************/
+
+/* Same algorithm as FILTER in yadif.h, 16 pixels at a time in 16-bit lanes */
+
+static inline __m256i yadif_load_avx2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+static inline __m256i yadif_avg_avx2(__m256i a, __m256i b)
+{
+    return _mm256_srli_epi16(_mm256_add_epi16(a, b), 1);
+}
+
+/* Score and prediction of the spatial direction j */
+static inline __m256i yadif_score_avx2(const uint8_t *cur, int mrefs, int prefs,
+                                       int j, __m256i *pred)
+{
+    __m256i m0 = yadif_load_avx2(&cur[mrefs-1+j]);
+    __m256i p0 = yadif_load_avx2(&cur[prefs-1-j]);
+    __m256i m1 = yadif_load_avx2(&cur[mrefs  +j]);
+    __m256i p1 = yadif_load_avx2(&cur[prefs  -j]);
+    __m256i m2 = yadif_load_avx2(&cur[mrefs+1+j]);
+    __m256i p2 = yadif_load_avx2(&cur[prefs+1-j]);
+
+    *pred = yadif_avg_avx2(m1, p1);
+    return _mm256_add_epi16(_mm256_add_epi16(_mm256_abs_epi16(_mm256_sub_epi16(m0, p0)),
+                                             _mm256_abs_epi16(_mm256_sub_epi16(m1, p1))),
+                            _mm256_abs_epi16(_mm256_sub_epi16(m2, p2)));
+}
+
+int yadif_filter_line_avx2_x16(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    int x;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        __m256i c  = yadif_load_avx2(&cur[mrefs]);
+        __m256i e  = yadif_load_avx2(&cur[prefs]);
+        __m256i p2 = yadif_load_avx2(prev2);
+        __m256i n2 = yadif_load_avx2(next2);
+        __m256i d  = yadif_avg_avx2(p2, n2);
+
+        __m256i temporal_diff0 = _mm256_abs_epi16(_mm256_sub_epi16(p2, n2));
+        __m256i temporal_diff1 = _mm256_srli_epi16(_mm256_add_epi16(
+                _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&prev[mrefs]), c)),
+                _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&prev[prefs]), e))), 1);
+        __m256i temporal_diff2 = _mm256_srli_epi16(_mm256_add_epi16(
+                _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&next[mrefs]), c)),
+                _mm256_abs_epi16(_mm256_sub_epi16(yadif_load_avx2(&next[prefs]), e))), 1);
+        __m256i diff = _mm256_max_epi16(_mm256_srli_epi16(temporal_diff0, 1),
+                                        _mm256_max_epi16(temporal_diff1, temporal_diff2));
+
+        /* Spatial prediction: the -2 (resp. 2) direction is only tried
+         * where the -1 (resp. 1) direction was better */
+        __m256i spatial_pred;
+        __m256i spatial_score = _mm256_sub_epi16(
+                yadif_score_avx2(cur, mrefs, prefs, 0, &spatial_pred),
+                _mm256_set1_epi16(1));
+
+        for (int side = -1; side <= 1; side += 2) {
+            __m256i pred, score, better, better2;
+
+            score  = yadif_score_avx2(cur, mrefs, prefs, side, &pred);
+            better = _mm256_cmpgt_epi16(spatial_score, score);
+            spatial_score = _mm256_blendv_epi8(spatial_score, score, better);
+            spatial_pred  = _mm256_blendv_epi8(spatial_pred, pred, better);
+
+            score   = yadif_score_avx2(cur, mrefs, prefs, 2 * side, &pred);
+            better2 = _mm256_and_si256(better, _mm256_cmpgt_epi16(spatial_score, score));
+            spatial_score = _mm256_blendv_epi8(spatial_score, score, better2);
+            spatial_pred  = _mm256_blendv_epi8(spatial_pred, pred, better2);
+        }
+
+        if (mode < 2) {
+            __m256i b = yadif_avg_avx2(yadif_load_avx2(&prev2[2*mrefs]),
+                                       yadif_load_avx2(&next2[2*mrefs]));
+            __m256i f = yadif_avg_avx2(yadif_load_avx2(&prev2[2*prefs]),
+                                       yadif_load_avx2(&next2[2*prefs]));
+            __m256i de = _mm256_sub_epi16(d, e);
+            __m256i dc = _mm256_sub_epi16(d, c);
+            __m256i bc = _mm256_sub_epi16(b, c);
+            __m256i fe = _mm256_sub_epi16(f, e);
+            __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc), _mm256_min_epi16(bc, fe));
+            __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc), _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(), max));
+        }
+
+        spatial_pred = _mm256_min_epi16(spatial_pred, _mm256_add_epi16(d, diff));
+        spatial_pred = _mm256_max_epi16(spatial_pred, _mm256_sub_epi16(d, diff));
+
+        spatial_pred = _mm256_permute4x64_epi64(_mm256_packus_epi16(spatial_pred, spatial_pred), 0xd8);
+        _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(spatial_pred));
+
+        dst += 16;
+        cur += 16;
+        prev += 16;
+        next += 16;
+        prev2 += 16;
+        next2 += 16;
+    }
+    _mm256_zeroupper();
+
+    return x;
+}
+
+#endif /* CAN_COMPILE_AVX2 */
@@ -158,6 +158,27 @@ void Merge8BitSSE2( void *, const void *, const void *, size_t );
 void Merge16BitSSE2( void *, const void *, const void *, size_t );
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+/**
+ * AVX2 routine to blend pixels from two picture lines.
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge8BitAVX2( void *, const void *, const void *, size_t );
+/**
+ * AVX2 routine to blend pixels from two picture lines.
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge16BitAVX2( void *, const void *, const void *, size_t );
+#endif
+
 #if defined(CAN_COMPILE_ARM)
 /**
  * ARM NEON routine to blend pixels from two picture lines.
@@ -189,6 +210,21 @@ void merge16_armv6 (void *, const void *, const void *, size_t);
 void EndMMX       ( void );
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+/**
+ * AVX2 merge finalization routine.
+ *
+ * Must be called after an AVX2 merge is finished.
+ * This clears the upper halves of the YMM registers (by executing the
+ * "vzeroupper" instruction), so that the following SSE code does not pay
+ * for the transition.
+ *
+ * The EndMerge() macro detects whether this is needed, and calls if it is,
+ * so just use that.
+ */
+void EndAVX2      ( void );
+#endif
+
 #if defined(CAN_COMPILE_3DNOW)
 /**
  * 3DNow merge finalization routine.
@@ -147,3 +147,18 @@ static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *c
     prefs /= 2;
     FILTER
 }
+
+#ifdef CAN_COMPILE_AVX2
+// ================ AVX2 =================
+/* The vector loop is in avx2.c; it returns how many pixels it did */
+#define HAVE_YADIF_AVX2
+
+int yadif_filter_line_avx2_x16(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode);
+
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    int x = yadif_filter_line_avx2_x16(dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+
+    if (x < w)
+        yadif_filter_line_c(dst + x, prev + x, cur + x, next + x, w - x, prefs, mrefs, parity, mode);
+}
+#endif
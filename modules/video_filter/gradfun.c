@@ -37,6 +37,7 @@
 #include <vlc_plugin.h>
 #include <vlc_cpu.h>
 #include <vlc_filter.h>
+#include <vlc_slices.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -75,6 +76,7 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 #define FFMAX(a,b) __MAX(a,b)
+#define FFMIN(a,b) __MIN(a,b)
 #ifdef CAN_COMPILE_MMXEXT
 #   define HAVE_MMX2 1
 #else
@@ -136,6 +138,7 @@ static int Open(vlc_object_t *object)
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
     cfg->radius      = 0;
+    cfg->slices      = 0;
     cfg->buf         = NULL;
 
 #if HAVE_SSE2 && HAVE_6REGS
@@ -173,6 +176,52 @@ static void Close(vlc_object_t *object)
     free(sys);
 }
 
+typedef struct
+{
+    filter_sys_t *sys;
+    const video_format_t *fmt;
+    picture_t    *src;
+    picture_t    *dst;
+    size_t        buf_size; /* of each slice */
+} gradfun_job_t;
+
+/* The planes smaller than the blur are copied */
+static bool PlaneFiltered(const video_format_t *fmt, filter_sys_t *sys, int i,
+                          int *w, int *h, int *r)
+{
+    const vlc_chroma_description_t *chroma = sys->chroma;
+
+    *w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+    *h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+    *r = (sys->cfg.radius * chroma->p[i].w.num / chroma->p[i].w.den +
+          sys->cfg.radius * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+    *r = VLC_CLIP((*r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+    return __MIN(*w, *h) > 2 * *r;
+}
+
+/* Filter a band of lines of each plane */
+static void FilterSlice(void *opaque, unsigned slice, unsigned slices)
+{
+    const gradfun_job_t *job = (const gradfun_job_t *)opaque;
+    filter_sys_t *sys = job->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < job->dst->i_planes; i++) {
+        const plane_t *srcp = &job->src->p[i];
+        plane_t       *dstp = &job->dst->p[i];
+        int w, h, r, y_start, y_end;
+
+        if (!PlaneFiltered(job->fmt, sys, i, &w, &h, &r))
+            continue;
+        vlc_slice_Lines(slice, slices, h, 2, &y_start, &y_end);
+        if (y_start < y_end)
+            filter_plane(cfg, cfg->buf + slice * job->buf_size,
+                         dstp->p_pixels, srcp->p_pixels,
+                         w, h, dstp->i_pitch, srcp->i_pitch, r,
+                         y_start, y_end);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -190,30 +239,34 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
 
     const video_format_t *fmt = &filter->fmt_in.video;
     struct vf_priv_s *cfg = &sys->cfg;
+    const int slices = vlc_slices_Count(filter);
+    /* One blur buffer per slice, a multiple of 16 bytes */
+    const size_t buf_size = ((fmt->i_width + 15) & ~15) * (radius + 1) / 2 + 32;
 
     cfg->thresh = (1 << 15) / strength;
-    if (cfg->radius != radius) {
+    if (cfg->radius != radius || cfg->slices != slices) {
         cfg->radius = radius;
+        cfg->slices = slices;
+        vlc_free(cfg->buf);
         cfg->buf    = (uint16_t *)vlc_memalign(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));			// sunqueen modify
+                                   slices * buf_size * sizeof(*cfg->buf));			// sunqueen modify
     }
 
     for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
-        }
+        int w, h, r;
+
+        if (!PlaneFiltered(fmt, sys, i, &w, &h, &r) || !cfg->buf)
+            plane_CopyPixels(&dst->p[i], &src->p[i]);
+    }
+
+    if (cfg->buf) {
+        gradfun_job_t job;
+        job.sys      = sys;
+        job.fmt      = fmt;
+        job.src      = src;
+        job.dst      = dst;
+        job.buf_size = buf_size;
+        vlc_slices_Run(filter, FilterSlice, &job, slices);
     }
 
     picture_CopyProperties(dst, src);
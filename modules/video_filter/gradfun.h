@@ -33,6 +33,7 @@
 struct vf_priv_s {
     int thresh;
     int radius;
+    int slices;
     uint16_t *buf;
     void (*filter_line)(uint8_t *dst, uint8_t *src, uint16_t *dc,
                         int width, int thresh, const uint16_t *dithers);
@@ -235,45 +236,65 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
-static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
-                         int width, int height, int dstride, int sstride, int r)
+/* Sum of the r pairs of lines ending with the pair k (kept in a ring of
+ * cumulative sums), then blurred horizontally */
+static void blur_plane_line(struct vf_priv_s *ctx, uint16_t *dc, uint16_t *buf,
+                            uint8_t *src, int width, int sstride, int r, int k)
 {
     int bstride = ((width+15)&~15)/2;
-    int y;
     uint32_t dc_factor = (1<<21)/(r*r);
-    uint16_t *dc = ctx->buf+16;
-    uint16_t *buf = ctx->buf+bstride+32;
+    int mod = k%r;
+    uint16_t *buf0 = buf+mod*bstride;
+    uint16_t *buf1 = buf+(mod?mod-1:r-1)*bstride;
+    int x, v;
+    ctx->blur_line(dc, buf0, buf1, src+2*k*sstride, sstride, width/2);
+    for (x=v=0; x<r; x++)
+        v += dc[x];
+    for (; x<width/2; x++) {
+        v += dc[x] - dc[x-r];
+        dc[x-r] = v * dc_factor >> 16;
+    }
+    for (; x<(width+r+1)/2; x++)
+        dc[x-r] = v * dc_factor >> 16;
+    for (x=-r/2; x<0; x++)
+        dc[x] = dc[0];
+}
+
+/* Filters the lines [y_start, y_end) of a plane, y_start being even. Each
+ * band of lines has its own buffer (of the size of ctx->buf), so that the
+ * bands can be processed in parallel: a band starts its vertical blur from
+ * scratch on the r pairs of lines it needs, which gives the same sums as
+ * the running ones of a whole plane (the sums wrap around in 16 bits). */
+static void filter_plane(struct vf_priv_s *ctx, uint16_t *ctx_buf,
+                         uint8_t *dst, uint8_t *src,
+                         int width, int height, int dstride, int sstride, int r,
+                         int y_start, int y_end)
+{
+    int bstride = ((width+15)&~15)/2;
+    int y, k = -1;
+    uint16_t *dc = ctx_buf+16;
+    uint16_t *buf = ctx_buf+bstride+32;
     int thresh = ctx->thresh;
+    /* The first r lines use the blur of the line r, and the blur is not
+     * updated for the last r lines */
+    int y_last = (height-r-1)&~1;
+
+    for (y=y_start; y<y_end; y++) {
+        int yb = FFMAX(r, FFMIN(y&~1, y_last));
+        int kb = (yb+r)/2;
 
-    memset(dc, 0, (bstride+16)*sizeof(*buf));
-    for (y=0; y<r; y++)
-        ctx->blur_line(dc, buf+y*bstride, buf+(y-1)*bstride, src+2*y*sstride, sstride, width/2);
-    for (;;) {
-        if (y < height-r) {
-            int mod = ((y+r)/2)%r;
-            uint16_t *buf0 = buf+mod*bstride;
-            uint16_t *buf1 = buf+(mod?mod-1:r-1)*bstride;
-            int x, v;
-            ctx->blur_line(dc, buf0, buf1, src+(y+r)*sstride, sstride, width/2);
-            for (x=v=0; x<r; x++)
-                v += dc[x];
-            for (; x<width/2; x++) {
-                v += dc[x] - dc[x-r];
-                dc[x-r] = v * dc_factor >> 16;
+        if (kb != k) {
+            if (k >= 0 && kb == k+1) {
+                blur_plane_line(ctx, dc, buf, src, width, sstride, r, kb);
+            } else {
+                /* The pair kb-r is the origin of the sums */
+                memset(buf+(kb%r)*bstride, 0, bstride*sizeof(*buf));
+                for (k=kb-r+1; k<=kb; k++)
+                    blur_plane_line(ctx, dc, buf, src, width, sstride, r, k);
             }
-            for (; x<(width+r+1)/2; x++)
-                dc[x-r] = v * dc_factor >> 16;
-            for (x=-r/2; x<0; x++)
-                dc[x] = dc[0];
+            k = kb;
         }
-        if (y == r) {
-            for (y=0; y<r; y++)
-                ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        }
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        if (++y >= height) break;
         ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
-        if (++y >= height) break;
     }
 }
 
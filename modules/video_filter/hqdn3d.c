@@ -34,6 +34,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 
 
@@ -142,10 +143,19 @@ static int Open(vlc_object_t *_this)			// sunqueen modify
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = (unsigned int *)malloc(wmax*sizeof(int));			// sunqueen modify
-    if (!cfg->Line) {
-        free(sys);
-        return VLC_ENOMEM;
+    /* One line buffer per plane for the vertical pass, as the planes are
+     * denoised in parallel, and the horizontally filtered planes */
+    for (int i = 0; i < 3; ++i) {
+        cfg->Line[i] = (unsigned int *)malloc(wmax*sizeof(int));
+        cfg->Spat[i] = (unsigned int *)malloc(sys->w[i]*sys->h[i]*sizeof(int));
+        if (!cfg->Line[i] || !cfg->Spat[i]) {
+            for (int j = 0; j <= i; ++j) {
+                free(cfg->Line[j]);
+                free(cfg->Spat[j]);
+            }
+            free(sys);
+            return VLC_ENOMEM;
+        }
     }
 
     filter->p_sys = sys;
@@ -182,14 +192,74 @@ static void Close(vlc_object_t *_this)			// sunqueen modify
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(cfg->Line[i]);
+        free(cfg->Spat[i]);
     }
-    free(cfg->Line);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+typedef struct
+{
+    filter_sys_t *sys;
+    picture_t    *src;
+    picture_t    *dst;
+} denoise_job_t;
+
+/* Bands of lines: the horizontal pass, or the whole filter if it is only
+ * temporal */
+static void DenoiseLines(void *opaque, unsigned slice, unsigned slices)
+{
+    const denoise_job_t *job = (const denoise_job_t *)opaque;
+    filter_sys_t *sys = job->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < 3; i++) {
+        const plane_t *srcp = &job->src->p[i];
+        const plane_t *dstp = &job->dst->p[i];
+        const int coefs = i == 0 ? 0 : 2;
+        int y_start, y_end;
+
+        vlc_slice_Lines(slice, slices, sys->h[i], 1, &y_start, &y_end);
+        if (!cfg->Coefs[coefs][0])
+            deNoiseTemporal(&srcp->p_pixels[y_start * srcp->i_pitch],
+                            &dstp->p_pixels[y_start * dstp->i_pitch],
+                            &cfg->Frame[i][y_start * sys->w[i]],
+                            sys->w[i], y_end - y_start,
+                            srcp->i_pitch, dstp->i_pitch,
+                            cfg->Coefs[coefs + 1]);
+        else
+            deNoiseHorizontal(srcp->p_pixels, cfg->Spat[i], sys->w[i],
+                              y_start, y_end, srcp->i_pitch,
+                              cfg->Coefs[coefs], cfg->Coefs[coefs + 1]);
+    }
+}
+
+/* Bands of columns: the vertical and temporal passes */
+static void DenoiseColumns(void *opaque, unsigned slice, unsigned slices)
+{
+    const denoise_job_t *job = (const denoise_job_t *)opaque;
+    filter_sys_t *sys = job->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (int i = 0; i < 3; i++) {
+        const plane_t *dstp = &job->dst->p[i];
+        const int coefs = i == 0 ? 0 : 2;
+        int x_start, x_end;
+
+        if (!cfg->Coefs[coefs][0])
+            continue;
+        /* Whole cache lines of the destination */
+        vlc_slice_Lines(slice, slices, sys->w[i], 64, &x_start, &x_end);
+        deNoiseVertical(cfg->Spat[i], dstp->p_pixels, cfg->Line[i],
+                        cfg->Frame[i], sys->w[i], sys->h[i],
+                        x_start, x_end, dstp->i_pitch,
+                        cfg->Coefs[coefs], cfg->Coefs[coefs + 1]);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -204,24 +274,21 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
         return NULL;
     }
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    for (int i = 0; i < 3; i++) {
+        if (!deNoiseInit(src->p[i].p_pixels, &cfg->Frame[i],
+                         sys->w[i], sys->h[i], src->p[i].i_pitch)) {
+            picture_Release(dst);
+            picture_Release(src);
+            return NULL;
+        }
+    }
+
+    denoise_job_t job;
+    job.sys = sys;
+    job.src = src;
+    job.dst = dst;
+    vlc_slices_Run(filter, DenoiseLines, &job, vlc_slices_Count(filter));
+    vlc_slices_Run(filter, DenoiseColumns, &job, vlc_slices_Count(filter));
 
     return CopyInfoAndRelease(dst, src);
 }
@@ -32,7 +32,8 @@
 
 struct vf_priv_s {
         int Coefs[4][512*16];
-        unsigned int *Line;
+        unsigned int *Line[3];
+        unsigned int *Spat[3];
         unsigned short *Frame[3];
 };
 
@@ -68,115 +69,88 @@ static void deNoiseTemporal(
     }
 }
 
-static void deNoiseSpacial(
+/* The spatial filter is recursive along the lines (Horizontal) and then
+ * along the columns (Vertical). It is run as two passes so that both can
+ * be split: the lines are independent in the first one, the columns in the
+ * second one. */
+
+static void deNoiseHorizontal(
                     unsigned char *Frame,        // mpi->planes[x]
+                    unsigned int *FrameSpat,     // vf->priv->Spat (W*H)
+                    int W, int Y0, int Y1, int sStride,
+                    int *Horizontal, int *Temporal)
+{
+    long X, Y;
+
+    for (Y = Y0; Y < Y1; Y++){
+        unsigned char *Src = &Frame[Y*sStride];
+        unsigned int *Dst = &FrameSpat[Y*W];
+        /* First pixel on each line doesn't have previous pixel */
+        unsigned int PixelAnt = Dst[0] = Src[0]<<16;
+
+        /* Without the temporal filter, the pixels of the first line have
+         * always been filtered against the first pixel only */
+        if (Y == 0 && !Temporal[0]){
+            for (X = 1; X < W; X++)
+                Dst[X] = LowPassMul(PixelAnt, Src[X]<<16, Horizontal);
+            continue;
+        }
+        for (X = 1; X < W; X++)
+            PixelAnt = Dst[X] = LowPassMul(PixelAnt, Src[X]<<16, Horizontal);
+    }
+}
+
+static void deNoiseVertical(
+                    unsigned int *FrameSpat,     // vf->priv->Spat (W*H)
                     unsigned char *FrameDest,    // dmpi->planes[x]
                     unsigned int *LineAnt,       // vf->priv->Line (width bytes)
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical)
+                    unsigned short *FrameAnt,
+                    int W, int H, int X0, int X1, int dStride,
+                    int *Vertical, int *Temporal)
 {
     long X, Y;
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
     unsigned int PixelDst;
 
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+    /* First line has no top neighbor */
+    for (X = X0; X < X1; X++)
+        LineAnt[X] = FrameSpat[X];
 
-    /* First line has no top neighbor, only left. */
-    for (X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+    for (Y = 0; Y < H; Y++){
+        unsigned int *LineSpat = &FrameSpat[Y*W];
+        unsigned short *LinePrev = &FrameAnt[Y*W];
+        unsigned char *LineDest = &FrameDest[Y*dStride];
+
+        for (X = X0; X < X1; X++){
+            if (Y > 0)
+                LineAnt[X] = LowPassMul(LineAnt[X], LineSpat[X], Vertical);
+            if (Temporal[0]){
+                PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
+                LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            } else
+                PixelDst = LineAnt[X];
+            LineDest[X]= ((PixelDst+0x10007FFF)>>16);
         }
     }
 }
 
-static void deNoise(unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical, int *Temporal)
+/* The previous frame, for the temporal filter */
+static unsigned short *deNoiseInit(unsigned char *Frame, unsigned short **FrameAntPtr,
+                                   int W, int H, int sStride)
 {
     long X, Y;
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
     unsigned short* FrameAnt=(*FrameAntPtr);
 
     if(!FrameAnt){
         (*FrameAntPtr)=FrameAnt=(unsigned short *)malloc(W*H*sizeof(unsigned short));			// sunqueen modify
+        if(!FrameAnt)
+            return NULL;
         for (Y = 0; Y < H; Y++){
             unsigned short* dst=&FrameAnt[Y*W];
             unsigned char* src=Frame+Y*sStride;
             for (X = 0; X < W; X++) dst[X]=src[X]<<8;
         }
     }
-
-    if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
-    }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
-        return;
-    }
-
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
-        }
-    }
+    return FrameAnt;
 }
 
 
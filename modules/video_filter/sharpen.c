@@ -43,6 +43,7 @@
 #include <vlc_plugin.h>
 
 #include <vlc_filter.h>
+#include <vlc_slices.h>
 #include "filter_picture.h"
 
 #define SIG_TEXT N_("Sharpen strength (0-2)")
@@ -162,53 +163,44 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
-/*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************
- * This function send the currently rendered image to Invert image, waits
- * until it is displayed and switch the two rendering buffers, preparing next
- * frame.
- *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+typedef struct
 {
-    picture_t *p_outpic;
+    filter_sys_t *p_sys;
+    picture_t    *p_src;
+    picture_t    *p_dst;
+} sharpen_job_t;
+
+/* Convolution of a band of lines of the Y plane */
+static void SharpenSlice( void *opaque, unsigned i_slice, unsigned i_slices )
+{
+    const sharpen_job_t *p_job = (const sharpen_job_t *)opaque;
+    const int *tab_precalc = p_job->p_sys->tab_precalc;
+    const uint8_t *p_src = p_job->p_src->p[Y_PLANE].p_pixels;
+    uint8_t *p_out = p_job->p_dst->p[Y_PLANE].p_pixels;
+    const int i_src_pitch = p_job->p_src->p[Y_PLANE].i_pitch;
+    const int i_out_pitch = p_job->p_dst->p[Y_PLANE].i_pitch;
+    const int i_lines = p_job->p_src->p[Y_PLANE].i_visible_lines;
+    const int i_pitch = p_job->p_src->p[Y_PLANE].i_visible_pitch;
+    int i_start, i_end;
     int i, j;
-    uint8_t *p_src = NULL;
-    uint8_t *p_out = NULL;
-    int i_src_pitch;
-    int i_out_pitch;
     int pix;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    /* process the Y plane */
-    p_src = p_pic->p[Y_PLANE].p_pixels;
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-    i_src_pitch = p_pic->p[Y_PLANE].i_pitch;
-    i_out_pitch = p_outpic->p[Y_PLANE].i_pitch;
+    vlc_slice_Lines( i_slice, i_slices, i_lines, 1, &i_start, &i_end );
 
     /* perform convolution only on Y plane. Avoid border line. */
-    vlc_mutex_lock( &p_filter->p_sys->lock );
-    for( i = 0; i < p_pic->p[Y_PLANE].i_visible_lines; i++ )
+    for( i = i_start; i < i_end; i++ )
     {
-        if( (i == 0) || (i == p_pic->p[Y_PLANE].i_visible_lines - 1) )
+        if( (i == 0) || (i == i_lines - 1) )
         {
-            for( j = 0; j < p_pic->p[Y_PLANE].i_visible_pitch; j++ )
+            for( j = 0; j < i_pitch; j++ )
                 p_out[i * i_out_pitch + j] = clip( p_src[i * i_src_pitch + j] );
             continue ;
         }
-        for( j = 0; j < p_pic->p[Y_PLANE].i_visible_pitch; j++ )
+        for( j = 0; j < i_pitch; j++ )
         {
-            if( (j == 0) || (j == p_pic->p[Y_PLANE].i_visible_pitch - 1) )
+            if( (j == 0) || (j == i_pitch - 1) )
             {
                 p_out[i * i_out_pitch + j] = p_src[i * i_src_pitch + j];
                 continue ;
@@ -226,9 +218,41 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
            pix = pix >= 0 ? clip(pix) : -clip(pix * -1);
            p_out[i * i_out_pitch + j] = clip( p_src[i * i_src_pitch + j] +
-               p_filter->p_sys->tab_precalc[pix + 256] );
+               tab_precalc[pix + 256] );
         }
     }
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************
+ * This function send the currently rendered image to Invert image, waits
+ * until it is displayed and switch the two rendering buffers, preparing next
+ * frame.
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    sharpen_job_t job;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    job.p_sys = p_filter->p_sys;
+    job.p_src = p_pic;
+    job.p_dst = p_outpic;
+
+    /* The bands of lines are independent. The lock keeps the table
+     * unchanged while they are processed. */
+    vlc_mutex_lock( &p_filter->p_sys->lock );
+    vlc_slices_Run( p_filter, SharpenSlice, &job,
+                    vlc_slices_Count( p_filter ) );
     vlc_mutex_unlock( &p_filter->p_sys->lock );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
@@ -101,6 +101,18 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Period of the drift measurements */
+#define CR_DRIFT_PERIOD (CLOCK_FREQ/5)
+
+/* Number of drift measurements used by the drift regression, and minimal
+ * number of them before the regression is used */
+#define CR_REGRESSION_COUNT (64)
+#define CR_REGRESSION_MIN (8)
+
+/* Maximal speed (in 1/1000 of the elapsed time) at which the low latency
+ * mode reduces or restores the caching */
+#define CR_LATENCY_RATE (5)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -124,6 +136,24 @@ static void    AvgUpdate( average_t *, mtime_t i_value );
 static mtime_t AvgGet( average_t * );
 static void    AvgRescale( average_t *, int i_divider );
 
+/**
+ * This structure holds a least squares fit of the drift measurements
+ */
+typedef struct
+{
+    mtime_t  pi_system[CR_REGRESSION_COUNT];
+    mtime_t  pi_drift[CR_REGRESSION_COUNT];
+    unsigned i_count;
+    unsigned i_index;
+
+    /* Fitted drift at the last measurement */
+    mtime_t  i_value;
+    /* Peak to peak deviation of the measurements from the fit */
+    mtime_t  i_jitter;
+} regression_t;
+static void    RegReset( regression_t * );
+static void    RegUpdate( regression_t *, mtime_t i_system, mtime_t i_drift );
+
 /* */
 typedef struct
 {
@@ -166,6 +196,12 @@ struct input_clock_t
     /* Clock drift */
     mtime_t i_next_drift_update;
     average_t drift;
+    regression_t regression;
+
+    /* Low latency mode: caching removed from i_pts_delay */
+    bool    b_low_latency;
+    mtime_t i_latency_min;
+    mtime_t i_latency_cut;
 
     /* Late statistics */
     struct
@@ -193,6 +229,9 @@ static mtime_t ClockStreamToSystem( input_clock_t *, mtime_t i_stream );
 static mtime_t ClockSystemToStream( input_clock_t *, mtime_t i_system );
 
 static mtime_t ClockGetTsOffset( input_clock_t * );
+static mtime_t ClockGetDrift( input_clock_t * );
+static mtime_t ClockGetDelay( input_clock_t * );
+static void    ClockUpdateLatency( input_clock_t *, mtime_t i_duration );
 
 /*****************************************************************************
  * input_clock_New: create a new clock
@@ -216,6 +255,11 @@ input_clock_t *input_clock_New( int i_rate )
 
     cl->i_next_drift_update = VLC_TS_INVALID;
     AvgInit( &cl->drift, 10 );
+    RegReset( &cl->regression );
+
+    cl->b_low_latency = false;
+    cl->i_latency_min = 0;
+    cl->i_latency_cut = 0;
 
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -281,6 +325,7 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     {
         cl->i_next_drift_update = VLC_TS_INVALID;
         AvgReset( &cl->drift );
+        RegReset( &cl->regression );
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -296,8 +341,12 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         const mtime_t i_converted = ClockSystemToStream( cl, i_ck_system );
 
         AvgUpdate( &cl->drift, i_converted - i_ck_stream );
+        RegUpdate( &cl->regression, i_ck_system, i_converted - i_ck_stream );
 
-        cl->i_next_drift_update = i_ck_system + CLOCK_FREQ/5; /* FIXME why that */
+        if( cl->b_low_latency && cl->i_next_drift_update > VLC_TS_INVALID )
+            ClockUpdateLatency( cl, i_ck_system - cl->i_next_drift_update + CR_DRIFT_PERIOD );
+
+        cl->i_next_drift_update = i_ck_system + CR_DRIFT_PERIOD; /* FIXME why that */
     }
 
     /* Update the extra buffering value */
@@ -323,8 +372,8 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
-    const mtime_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
-    const mtime_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
+    const mtime_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + ClockGetDrift( cl ) );
+    const mtime_t i_late = ( i_ck_system - ClockGetDelay( cl ) ) - i_system_expected;
     *pb_late = i_late > 0;
     if( i_late > 0 )
     {
@@ -347,6 +396,9 @@ void input_clock_Reset( input_clock_t *cl )
     cl->b_has_external_clock = false;
     cl->i_ts_max = VLC_TS_INVALID;
 
+    /* The buffering is done again with the whole caching */
+    cl->i_latency_cut = 0;
+
     vlc_mutex_unlock( &cl->lock );
 }
 
@@ -364,6 +416,7 @@ void input_clock_ChangeRate( input_clock_t *cl, int i_rate )
         cl->ref.i_system = cl->last.i_system - (cl->last.i_system - cl->ref.i_system) * i_rate / cl->i_rate;
     }
     cl->i_rate = i_rate;
+    RegReset( &cl->regression );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -388,6 +441,7 @@ void input_clock_ChangePause( input_clock_t *cl, bool b_paused, mtime_t i_date )
     }
     cl->i_pause_date = i_date;
     cl->b_paused = b_paused;
+    RegReset( &cl->regression );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -403,7 +457,7 @@ mtime_t input_clock_GetWakeup( input_clock_t *cl )
 
     /* Synchronized, we can wait */
     if( cl->b_has_reference )
-        i_wakeup = ClockStreamToSystem( cl, cl->last.i_stream + AvgGet( &cl->drift ) - cl->i_buffering_duration );
+        i_wakeup = ClockStreamToSystem( cl, cl->last.i_stream + ClockGetDrift( cl ) - cl->i_buffering_duration );
 
     vlc_mutex_unlock( &cl->lock );
 
@@ -434,12 +488,12 @@ int input_clock_ConvertTS( input_clock_t *cl,
 
     /* */
     const mtime_t i_ts_buffering = cl->i_buffering_duration * cl->i_rate / INPUT_RATE_DEFAULT;
-    const mtime_t i_ts_delay = cl->i_pts_delay + ClockGetTsOffset( cl );
+    const mtime_t i_ts_delay = ClockGetDelay( cl ) + ClockGetTsOffset( cl );
 
     /* */
     if( *pi_ts0 > VLC_TS_INVALID )
     {
-        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + AvgGet( &cl->drift ) );
+        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + ClockGetDrift( cl ) );
         if( *pi_ts0 > cl->i_ts_max )
             cl->i_ts_max = *pi_ts0;
         *pi_ts0 += i_ts_delay;
@@ -448,7 +502,7 @@ int input_clock_ConvertTS( input_clock_t *cl,
     /* XXX we do not ipdate i_ts_max on purpose */
     if( pi_ts1 && *pi_ts1 > VLC_TS_INVALID )
     {
-        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + AvgGet( &cl->drift ) ) +
+        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + ClockGetDrift( cl ) ) +
                   i_ts_delay;
     }
 
@@ -520,6 +574,8 @@ void input_clock_ChangeSystemOrigin( input_clock_t *cl, bool b_absolute, mtime_t
 
     cl->ref.i_system += i_offset;
     cl->last.i_system += i_offset;
+    if( i_offset != 0 )
+        RegReset( &cl->regression );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -532,7 +588,7 @@ void input_clock_GetSystemOrigin( input_clock_t *cl, mtime_t *pi_system, mtime_t
 
     *pi_system = cl->ref.i_system;
     if( pi_delay )
-        *pi_delay  = cl->i_pts_delay;
+        *pi_delay  = ClockGetDelay( cl );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -599,6 +655,30 @@ mtime_t input_clock_GetJitter( input_clock_t *cl )
     return i_pts_delay + i_late_median;
 }
 
+void input_clock_SetLowLatency( input_clock_t *cl, bool b_enabled,
+                                mtime_t i_latency_min )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    cl->b_low_latency = b_enabled;
+    cl->i_latency_min = i_latency_min;
+    if( !b_enabled )
+        cl->i_latency_cut = 0;
+
+    vlc_mutex_unlock( &cl->lock );
+}
+
+void input_clock_GetLatency( input_clock_t *cl,
+                             mtime_t *pi_latency, mtime_t *pi_jitter )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    *pi_latency = ClockGetDelay( cl );
+    *pi_jitter = cl->regression.i_jitter;
+
+    vlc_mutex_unlock( &cl->lock );
+}
+
 /*****************************************************************************
  * ClockStreamToSystem: converts a movie clock to system date
  *****************************************************************************/
@@ -632,6 +712,53 @@ static mtime_t ClockGetTsOffset( input_clock_t *cl )
     return cl->i_pts_delay * ( cl->i_rate - INPUT_RATE_DEFAULT ) / INPUT_RATE_DEFAULT;
 }
 
+/**
+ * It returns the drift to apply to the stream dates.
+ * The low latency mode uses the regression, which follows the drift
+ * without the lag of the average.
+ */
+static mtime_t ClockGetDrift( input_clock_t *cl )
+{
+    if( cl->b_low_latency && cl->regression.i_count >= CR_REGRESSION_MIN )
+        return cl->regression.i_value;
+    return AvgGet( &cl->drift );
+}
+
+/**
+ * It returns the delay actually added to the converted dates.
+ */
+static mtime_t ClockGetDelay( input_clock_t *cl )
+{
+    return cl->i_pts_delay - cl->i_latency_cut;
+}
+
+/**
+ * It moves the delay toward the measured jitter in low latency mode.
+ *
+ * The delay changes by at most CR_LATENCY_RATE/1000 of the elapsed time:
+ * the dates are converted slightly faster (or slower) and the audio output
+ * follows them by resampling, as for any other drift.
+ */
+static void ClockUpdateLatency( input_clock_t *cl, mtime_t i_duration )
+{
+    if( cl->regression.i_count < CR_REGRESSION_MIN )
+        return;
+
+    /* Keep twice the jitter seen, so that a single larger spike does not
+     * trigger a rebuffering */
+    const mtime_t i_target = __MIN( cl->i_pts_delay,
+                                    cl->i_latency_min + 2 * cl->regression.i_jitter );
+    const mtime_t i_step = __MAX( i_duration, 0 ) * CR_LATENCY_RATE / 1000;
+    const mtime_t i_delay = ClockGetDelay( cl );
+
+    if( i_delay > i_target )
+        cl->i_latency_cut += __MIN( i_delay - i_target, i_step );
+    else if( i_delay < i_target )
+        cl->i_latency_cut -= __MIN( i_target - i_delay, i_step );
+
+    cl->i_latency_cut = __MAX( cl->i_latency_cut, 0 );
+}
+
 /*****************************************************************************
  * Long term average helpers
  *****************************************************************************/
@@ -674,3 +801,58 @@ static void AvgRescale( average_t *p_avg, int i_divider )
     p_avg->i_value   = i_tmp / p_avg->i_divider;
     p_avg->i_residue = i_tmp % p_avg->i_divider;
 }
+
+/*****************************************************************************
+ * Drift regression helpers
+ *****************************************************************************/
+static void RegReset( regression_t *p_reg )
+{
+    p_reg->i_count = 0;
+    p_reg->i_index = 0;
+    p_reg->i_value = 0;
+    p_reg->i_jitter = 0;
+}
+static void RegUpdate( regression_t *p_reg, mtime_t i_system, mtime_t i_drift )
+{
+    p_reg->pi_system[p_reg->i_index] = i_system;
+    p_reg->pi_drift[p_reg->i_index] = i_drift;
+    p_reg->i_index = ( p_reg->i_index + 1 ) % CR_REGRESSION_COUNT;
+    if( p_reg->i_count < CR_REGRESSION_COUNT )
+        p_reg->i_count++;
+
+    /* Least squares fit of drift = a + b * system, relative to the last
+     * measurement to keep the precision */
+    const unsigned n = p_reg->i_count;
+    double f_sx = 0., f_sy = 0., f_sxx = 0., f_sxy = 0.;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        const double x = p_reg->pi_system[i] - i_system;
+        const double y = p_reg->pi_drift[i] - i_drift;
+
+        f_sx += x;
+        f_sy += y;
+        f_sxx += x * x;
+        f_sxy += x * y;
+    }
+
+    const double f_den = n * f_sxx - f_sx * f_sx;
+    const double f_b = f_den > 0. ? ( n * f_sxy - f_sx * f_sy ) / f_den : 0.;
+    const double f_a = ( f_sy - f_b * f_sx ) / n;
+
+    /* Peak to peak residual */
+    double f_min = 0., f_max = 0.;
+    for( unsigned i = 0; i < n; i++ )
+    {
+        const double x = p_reg->pi_system[i] - i_system;
+        const double r = p_reg->pi_drift[i] - i_drift - ( f_a + f_b * x );
+
+        if( i == 0 || r < f_min )
+            f_min = r;
+        if( i == 0 || r > f_max )
+            f_max = r;
+    }
+
+    p_reg->i_value = i_drift + (mtime_t)f_a;
+    p_reg->i_jitter = (mtime_t)( f_max - f_min );
+}
@@ -135,4 +135,24 @@ void input_clock_SetJitter( input_clock_t *,
  */
 mtime_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function enables or disables the low latency mode.
+ *
+ * In this mode, the delay added to the dates is slowly reduced from the
+ * pts_delay down to i_latency_min plus the measured jitter, and the drift
+ * is estimated with a linear regression instead of an average.
+ * It is only done when the input does not control its pace.
+ */
+void input_clock_SetLowLatency( input_clock_t *, bool b_enabled,
+                                mtime_t i_latency_min );
+
+/**
+ * This function returns the delay currently added to the dates and the
+ * jitter (peak to peak) of the clock references.
+ * The jitter is only measured when the input does not control its pace,
+ * it is 0 otherwise.
+ */
+void input_clock_GetLatency( input_clock_t *,
+                             mtime_t *pi_latency, mtime_t *pi_jitter );
+
 #endif
@@ -61,6 +61,13 @@ static decoder_t *CreateDecoder( vlc_object_t *, input_thread_t *,
 static void       DeleteDecoder( decoder_t * );
 
 static void      *DecoderThread( void * );
+static bool       DecoderRun( void * );
+static bool       DecoderIsRunnable( decoder_t * );
+static void       DecoderPlaySpu( decoder_t *, subpicture_t * );
+#ifdef ENABLE_SOUT
+static void       DecoderPlaySout( decoder_t *, block_t * );
+#endif
+static void       DecoderSchedule( decoder_t * );
 static void       DecoderProcess( decoder_t *, block_t * );
 static void       DecoderError( decoder_t *p_dec, block_t *p_block );
 static void       DecoderOutputChangePause( decoder_t *, bool b_paused, mtime_t i_date );
@@ -99,12 +106,18 @@ struct decoder_owner_sys_t
 
     vlc_thread_t     thread;
 
+    /* Shared decoder threads, used instead of the thread if not NULL */
+    decoder_pool_t  *p_pool;
+    decoder_task_t  task;
+    bool            b_pool_wake; /* protected by lock */
+
     /* Some decoders require already packetized data (ie. not truncated) */
     decoder_t *p_packetizer;
     bool b_packetizer;
 
     /* Current format in use by the output */
     video_format_t video;
+    picture_layout_t video_layout;
     audio_format_t audio;
     es_format_t    sout;
 
@@ -113,6 +126,10 @@ struct decoder_owner_sys_t
     es_format_t    fmt_description;
     vlc_meta_t     *p_description;
 
+    /* Incremented on each change of the format, the closed captions or the
+     * stream output (see input_DecoderGetChangeCount) */
+    atomic_uint    changes;
+
     /* fifo */
     block_fifo_t *p_fifo;
 
@@ -184,6 +201,10 @@ struct decoder_owner_sys_t
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION ((int)(0.200*CLOCK_FREQ))
 
+/* Maximum number of blocks processed by a shared decoder thread before
+ * switching to the next decoder */
+#define DECODER_TASK_QUANTUM (8)
+
 
 /*****************************************************************************
  * Public functions
@@ -258,6 +279,15 @@ int decoder_GetDisplayRate( decoder_t *p_dec )
 
     return p_dec->pf_get_display_rate( p_dec );
 }
+/* decoder_GetDisplayFeedback:
+ */
+int decoder_GetDisplayFeedback( decoder_t *p_dec, decoder_feedback_t *p_feedback )
+{
+    if( !p_dec->pf_get_display_feedback )
+        return VLC_EGENERIC;
+
+    return p_dec->pf_get_display_feedback( p_dec, p_feedback );
+}
 
 /* TODO: pass p_sout through p_resource? -- Courmisch */
 static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
@@ -297,6 +327,26 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
     else
         i_priority = VLC_THREAD_PRIORITY_VIDEO;
 
+    /* The subtitle decoders and the packetizers never wait for the output
+     * clock, so they can share threads. Audio and video keep their own. */
+    if( p_sout != NULL || p_dec->fmt_out.i_cat == SPU_ES )
+        p_dec->p_owner->p_pool = decoder_pool_Get( p_parent );
+    if( p_dec->p_owner->p_pool != NULL )
+    {
+        int i_task_priority;
+
+        if( p_dec->fmt_out.i_cat == VIDEO_ES )
+            i_task_priority = DECODER_TASK_PRIORITY_VIDEO;
+        else if( p_dec->fmt_out.i_cat == AUDIO_ES )
+            i_task_priority = DECODER_TASK_PRIORITY_AUDIO;
+        else
+            i_task_priority = DECODER_TASK_PRIORITY_SPU;
+
+        decoder_task_Init( &p_dec->p_owner->task, i_task_priority,
+                           DecoderRun, p_dec );
+        return p_dec;
+    }
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_dec->p_owner->thread, DecoderThread, p_dec, i_priority ) )
     {
@@ -346,7 +396,8 @@ void input_DecoderDelete( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
-    vlc_cancel( p_owner->thread );
+    if( !p_owner->p_pool )
+        vlc_cancel( p_owner->thread );
 
     /* Make sure we aren't paused/buffering/waiting/decoding anymore */
     vlc_mutex_lock( &p_owner->lock );
@@ -358,7 +409,10 @@ void input_DecoderDelete( decoder_t *p_dec )
     vlc_cond_signal( &p_owner->wait_request );
     vlc_mutex_unlock( &p_owner->lock );
 
-    vlc_join( p_owner->thread, NULL );
+    if( p_owner->p_pool )
+        decoder_pool_Cancel( p_owner->p_pool, &p_owner->task );
+    else
+        vlc_join( p_owner->thread, NULL );
     p_owner->b_paused = b_was_paused;
 
     module_unneed( p_dec, p_dec->p_module );
@@ -409,6 +463,7 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     }
 
     block_FifoPut( p_owner->p_fifo, p_block );
+    DecoderSchedule( p_dec );
 }
 
 bool input_DecoderIsEmpty( decoder_t * p_dec )
@@ -523,6 +578,7 @@ void input_DecoderChangePause( decoder_t *p_dec, bool b_paused, mtime_t i_date )
         p_owner->pause.i_date = i_date;
         p_owner->pause.i_ignore = 0;
         vlc_cond_signal( &p_owner->wait_request );
+        DecoderSchedule( p_dec );
 
         DecoderOutputChangePause( p_dec, b_paused, i_date );
     }
@@ -569,6 +625,7 @@ void input_DecoderStartBuffering( decoder_t *p_dec )
     p_owner->b_buffering = true;
 
     vlc_cond_signal( &p_owner->wait_request );
+    DecoderSchedule( p_dec );
 
     vlc_mutex_unlock( &p_owner->lock );
 }
@@ -582,6 +639,7 @@ void input_DecoderStopBuffering( decoder_t *p_dec )
     p_owner->b_buffering = false;
 
     vlc_cond_signal( &p_owner->wait_request );
+    DecoderSchedule( p_dec );
 
     vlc_mutex_unlock( &p_owner->lock );
 }
@@ -594,7 +652,14 @@ void input_DecoderWaitBuffering( decoder_t *p_dec )
 
     while( p_owner->b_buffering && !p_owner->buffer.b_full )
     {
-        block_FifoWake( p_owner->p_fifo );
+        if( p_owner->p_pool )
+        {
+            /* Full once the fifo has been drained (see DecoderRun) */
+            p_owner->b_pool_wake = true;
+            DecoderSchedule( p_dec );
+        }
+        else
+            block_FifoWake( p_owner->p_fifo );
         vlc_cond_wait( &p_owner->wait_acknowledge, &p_owner->lock );
     }
 
@@ -615,6 +680,7 @@ void input_DecoderFrameNext( decoder_t *p_dec, mtime_t *pi_duration )
             vout_NextPicture( p_owner->p_vout, pi_duration );
             p_owner->pause.i_ignore++;
             vlc_cond_signal( &p_owner->wait_request );
+            DecoderSchedule( p_dec );
         }
     }
     else
@@ -653,6 +719,13 @@ bool input_DecoderHasFormatChanged( decoder_t *p_dec, es_format_t *p_fmt, vlc_me
     return b_changed;
 }
 
+unsigned input_DecoderGetChangeCount( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    return atomic_load( &p_owner->changes );
+}
+
 size_t input_DecoderGetFifoSize( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -712,6 +785,22 @@ static int DecoderGetDisplayRate( decoder_t *p_dec )
         return INPUT_RATE_DEFAULT;
     return input_clock_GetRate( p_owner->p_clock );
 }
+static int DecoderGetDisplayFeedback( decoder_t *p_dec,
+                                      decoder_feedback_t *p_feedback )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->p_vout && !p_owner->b_buffering && !p_owner->b_paused )
+    {
+        vout_GetDisplayFeedback( p_owner->p_vout, &p_feedback->i_render,
+                                 &p_feedback->i_late );
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_owner->lock );
+    return i_ret;
+}
 
 /* */
 static void DecoderUnsupportedCodec( decoder_t *p_dec, vlc_fourcc_t codec )
@@ -807,6 +896,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_dec->pf_get_attachments  = DecoderGetInputAttachments;
     p_dec->pf_get_display_date = DecoderGetDisplayDate;
     p_dec->pf_get_display_rate = DecoderGetDisplayRate;
+    p_dec->pf_get_display_feedback = DecoderGetDisplayFeedback;
 
     /* Find a suitable decoder/packetizer module */
     if( !b_packetizer )
@@ -866,9 +956,13 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_fmt_description = false;
     es_format_Init( &p_owner->fmt_description, UNKNOWN_ES, 0 );
     p_owner->p_description = NULL;
+    atomic_init( &p_owner->changes, 0 );
 
     p_owner->b_exit = false;
 
+    p_owner->p_pool = NULL;
+    p_owner->b_pool_wake = false;
+
     p_owner->b_paused = false;
     p_owner->pause.i_date = VLC_TS_INVALID;
     p_owner->pause.i_ignore = 0;
@@ -947,6 +1041,92 @@ static void *DecoderThread( void *p_data )
     return NULL;
 }
 
+/* Whether DecoderWaitUnblock() would return at once. The lock must be held. */
+static bool DecoderIsRunnable( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_assert_locked( &p_owner->lock );
+
+    if( p_owner->b_flushing || p_owner->b_exit )
+        return true;
+    if( p_owner->b_paused )
+        return ( p_owner->b_buffering && !p_owner->buffer.b_full ) ||
+               p_owner->pause.i_ignore > 0;
+    return !p_owner->b_buffering || !p_owner->buffer.b_full;
+}
+
+/**
+ * The decoding loop of the decoders run by the shared decoder threads.
+ * It returns instead of waiting, and is scheduled again by any change of
+ * the fifo or of the state (pause, buffering, flush, exit).
+ *
+ * \param p_data the decoder
+ * \return true if there are blocks left to decode
+ */
+static bool DecoderRun( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    /* Output kept while the decoder could not run (paused or buffered) */
+#ifdef ENABLE_SOUT
+    if( p_owner->b_packetizer )
+        DecoderPlaySout( p_dec, NULL );
+    else
+#endif
+    if( p_dec->fmt_out.i_cat == SPU_ES )
+        DecoderPlaySpu( p_dec, NULL );
+
+    for( int i = 0; i < DECODER_TASK_QUANTUM; i++ )
+    {
+        vlc_mutex_lock( &p_owner->lock );
+        if( !DecoderIsRunnable( p_dec ) )
+        {
+            vlc_mutex_unlock( &p_owner->lock );
+            return false;
+        }
+        vlc_mutex_unlock( &p_owner->lock );
+
+        block_t *p_block = block_FifoTryGet( p_owner->p_fifo );
+        if( !p_block )
+        {
+            /* Same as a forced wake up of DecoderThread */
+            vlc_mutex_lock( &p_owner->lock );
+            const bool b_wake = p_owner->b_pool_wake;
+            p_owner->b_pool_wake = false;
+            vlc_mutex_unlock( &p_owner->lock );
+
+            if( b_wake )
+                DecoderSignalBuffering( p_dec, true );
+            return false;
+        }
+        DecoderSignalBuffering( p_dec, false );
+
+        if( p_block->i_flags & BLOCK_FLAG_CORE_EOS )
+        {
+            /* calling DecoderProcess() with NULL block will make
+             * decoders/packetizers flush their buffers */
+            block_Release( p_block );
+            p_block = NULL;
+        }
+
+        if( p_dec->b_error )
+            DecoderError( p_dec, p_block );
+        else
+            DecoderProcess( p_dec, p_block );
+    }
+    return block_FifoCount( p_owner->p_fifo ) > 0;
+}
+
+static void DecoderSchedule( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_owner->p_pool )
+        decoder_pool_Schedule( p_owner->p_pool, &p_owner->task );
+}
+
 static block_t *DecoderBlockFlushNew()
 {
     block_t *p_null = block_Alloc( 128 );
@@ -1255,6 +1435,33 @@ static void DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
     vlc_mutex_unlock( &p_owner->lock );
 }
 
+/* Returns the date at which a decoder call starts, if it is to be timed */
+static mtime_t DecoderStartTiming( decoder_t *p_dec )
+{
+    input_thread_t *p_input = p_dec->p_owner->p_input;
+
+    if( p_input == NULL || p_input->p->counters.p_decode_time == NULL )
+        return VLC_TS_INVALID;
+    return mdate();
+}
+
+static void DecoderStopTiming( decoder_t *p_dec, mtime_t i_start )
+{
+    if( i_start <= VLC_TS_INVALID )
+        return;
+    stats_Update( p_dec->p_owner->p_input->p->counters.p_decode_time,
+                  mdate() - i_start, NULL );
+}
+
+static block_t *DecoderCallAudio( decoder_t *p_dec, block_t **pp_block )
+{
+    mtime_t i_start = DecoderStartTiming( p_dec );
+    block_t *p_aout_buf = p_dec->pf_decode_audio( p_dec, pp_block );
+
+    DecoderStopTiming( p_dec, i_start );
+    return p_aout_buf;
+}
+
 static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -1263,7 +1470,7 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_played = 0;
 
-    while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
+    while( (p_aout_buf = DecoderCallAudio( p_dec, &p_block )) )
     {
         audio_output_t *p_aout = p_owner->p_aout;
 
@@ -1301,11 +1508,9 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
 
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_played > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock);
         stats_Update( p_input->p->counters.p_lost_abuffers, i_lost, NULL );
         stats_Update( p_input->p->counters.p_played_abuffers, i_played, NULL );
         stats_Update( p_input->p->counters.p_decoded_audio, i_decoded, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock);
     }
 }
 static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
@@ -1330,7 +1535,11 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
     vlc_mutex_lock( &p_owner->lock );
     for( i = 0, i_cc_decoder = 0; i < 4; i++ )
     {
-        p_owner->cc.pb_present[i] |= pb_present[i];
+        if( pb_present[i] && !p_owner->cc.pb_present[i] )
+        {
+            p_owner->cc.pb_present[i] = true;
+            atomic_fetch_add( &p_owner->changes, 1u );
+        }
         if( p_owner->cc.pp_decoder[i] )
             i_cc_decoder++;
     }
@@ -1342,6 +1551,7 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
 
         block_FifoPut( p_owner->cc.pp_decoder[i]->p_owner->p_fifo,
             (i_cc_decoder > 1) ? block_Duplicate(p_cc) : p_cc);
+        DecoderSchedule( p_owner->cc.pp_decoder[i] );
 
         i_cc_decoder--;
         b_processed = true;
@@ -1353,7 +1563,8 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
 }
 
 static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
-                              int *pi_played_sum, int *pi_lost_sum )
+                              int *pi_played_sum, int *pi_lost_sum,
+                              int *pi_copied_sum )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t  *p_vout = p_owner->p_vout;
@@ -1444,6 +1655,12 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
                 vout_Flush( p_vout, p_picture->date );
                 p_owner->i_last_rate = i_rate;
             }
+            if( p_owner->p_input != NULL && b_dated )
+            {
+                mtime_t i_late = mdate() - p_picture->date;
+                stats_Update( p_owner->p_input->p->counters.p_display_lateness,
+                              i_late > 0 ? i_late : 0, NULL );
+            }
             vout_PutPicture( p_vout, p_picture );
         }
         else
@@ -1458,10 +1675,13 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
         }
         int i_tmp_display;
         int i_tmp_lost;
-        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost );
+        int i_tmp_copied;
+        vout_GetResetStatistic( p_vout, &i_tmp_display, &i_tmp_lost,
+                                &i_tmp_copied );
 
         *pi_played_sum += i_tmp_display;
         *pi_lost_sum += i_tmp_lost;
+        *pi_copied_sum += i_tmp_copied;
 
         if( !b_has_more || b_buffering_first )
             break;
@@ -1475,6 +1695,15 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     }
 }
 
+static picture_t *DecoderCallVideo( decoder_t *p_dec, block_t **pp_block )
+{
+    mtime_t i_start = DecoderStartTiming( p_dec );
+    picture_t *p_pic = p_dec->pf_decode_video( p_dec, pp_block );
+
+    DecoderStopTiming( p_dec, i_start );
+    return p_pic;
+}
+
 static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -1482,8 +1711,10 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    int i_copied = 0;
+    int i_skipped;
 
-    while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
+    while( (p_pic = DecoderCallVideo( p_dec, &p_block )) )
     {
         vout_thread_t  *p_vout = p_owner->p_vout;
         if( DecoderIsExitRequested( p_dec ) )
@@ -1516,30 +1747,37 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             ( !p_owner->p_packetizer || !p_owner->p_packetizer->pf_get_cc ) )
             DecoderGetCc( p_dec, p_dec );
 		// ͼ񣬷ͼfifoȴȾ߳ȡȾ
-        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost );
+        DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost, &i_copied );
     }
+    i_copied += p_dec->i_copied_pictures;
+    p_dec->i_copied_pictures = 0;
+    i_skipped = p_dec->i_skipped_pictures;
+    p_dec->i_skipped_pictures = 0;
 
     /* Update ugly stat */
     input_thread_t *p_input = p_owner->p_input;
 
-    if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_displayed > 0) )
+    if( p_input != NULL &&
+        (i_decoded > 0 || i_lost > 0 || i_displayed > 0 || i_copied > 0 ||
+         i_skipped > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_Update( p_input->p->counters.p_decoded_video, i_decoded, NULL );
         stats_Update( p_input->p->counters.p_lost_pictures, i_lost , NULL);
         stats_Update( p_input->p->counters.p_displayed_pictures,
                       i_displayed, NULL);
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        stats_Update( p_input->p->counters.p_copied_pictures, i_copied, NULL );
+        stats_Update( p_input->p->counters.p_skipped_pictures, i_skipped, NULL );
     }
 }
 
+/* A NULL subpicture plays the subpictures kept by a pooled decoder */
 static void DecoderPlaySpu( decoder_t *p_dec, subpicture_t *p_subpic )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t *p_vout = p_owner->p_spu_vout;
 
     /* */
-    if( p_subpic->i_start <= VLC_TS_INVALID )
+    if( p_subpic && p_subpic->i_start <= VLC_TS_INVALID )
     {
         msg_Warn( p_dec, "non-dated spu buffer received" );
         subpicture_Delete( p_subpic );
@@ -1549,7 +1787,16 @@ static void DecoderPlaySpu( decoder_t *p_dec, subpicture_t *p_subpic )
     /* */
     vlc_mutex_lock( &p_owner->lock );
 
-    if( p_owner->b_buffering || p_owner->buffer.p_subpic )
+    if( !p_subpic )
+    {
+        if( !p_owner->buffer.p_subpic )
+        {
+            vlc_mutex_unlock( &p_owner->lock );
+            return;
+        }
+    }
+    else if( p_owner->b_buffering || p_owner->buffer.p_subpic ||
+             p_owner->p_pool )
     {
         p_subpic->p_next = NULL;
 
@@ -1569,6 +1816,14 @@ static void DecoderPlaySpu( decoder_t *p_dec, subpicture_t *p_subpic )
     {
         bool b_has_more = false;
         bool b_reject;
+
+        /* A shared decoder thread must not wait: the subpictures are kept
+         * until the decoder is scheduled again by a change of state */
+        if( p_owner->p_pool && !DecoderIsRunnable( p_dec ) )
+        {
+            vlc_mutex_unlock( &p_owner->lock );
+            return;
+        }
         DecoderWaitUnblock( p_dec, &b_reject );
 
         if( p_owner->b_buffering )
@@ -1597,7 +1852,9 @@ static void DecoderPlaySpu( decoder_t *p_dec, subpicture_t *p_subpic )
         if( p_subpic->i_start <= VLC_TS_INVALID )
             b_reject = true;
 
-        DecoderWaitDate( p_dec, &b_reject,
+        /* The shared decoder threads do not wait: the vout keeps the
+         * subpicture until its date anyway */
+        DecoderWaitDate( p_dec, &b_reject, p_owner->p_pool ? -1 :
                          p_subpic->i_start - SPU_MAX_PREPARE_TIME );
         vlc_mutex_unlock( &p_owner->lock );
 
@@ -1623,11 +1880,21 @@ static void DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
     assert( p_owner->p_clock );
-    assert( !p_sout_block->p_next );
+    assert( !p_sout_block || !p_sout_block->p_next );
 
     vlc_mutex_lock( &p_owner->lock );
 
-    if( p_owner->b_buffering || p_owner->buffer.p_block )
+    /* A NULL block sends the blocks kept by a pooled decoder */
+    if( !p_sout_block )
+    {
+        if( !p_owner->buffer.p_block )
+        {
+            vlc_mutex_unlock( &p_owner->lock );
+            return;
+        }
+    }
+    else if( p_owner->b_buffering || p_owner->buffer.p_block ||
+             p_owner->p_pool )
     {
         block_ChainLastAppend( &p_owner->buffer.pp_block_next, p_sout_block );
 
@@ -1644,6 +1911,14 @@ static void DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
     {
         bool b_has_more = false;
         bool b_reject;
+
+        /* A shared decoder thread must not wait: the blocks are kept until
+         * the decoder is scheduled again by a change of state */
+        if( p_owner->p_pool && !DecoderIsRunnable( p_dec ) )
+        {
+            vlc_mutex_unlock( &p_owner->lock );
+            return;
+        }
         DecoderWaitUnblock( p_dec, &b_reject );
 
         if( p_owner->b_buffering )
@@ -1786,6 +2061,9 @@ static void DecoderProcessSout( decoder_t *p_dec, block_t *p_block )
                 }
                 break;
             }
+
+            /* The pace control of the stream output may have changed */
+            atomic_fetch_add( &p_owner->changes, 1u );
         }
 
         while( p_sout_block )
@@ -1915,11 +2193,7 @@ static void DecoderProcessSpu( decoder_t *p_dec, block_t *p_block, bool b_flush
     while( (p_spu = p_dec->pf_decode_sub( p_dec, p_block ? &p_block : NULL ) ) )
     {
         if( p_input != NULL )
-        {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_Update( p_input->p->counters.p_decoded_sub, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-        }
 
         p_vout = input_resource_HoldVout( p_owner->p_resource );
         if( p_vout && p_owner->p_spu_vout == p_vout )
@@ -2092,7 +2366,7 @@ static void DeleteDecoder( decoder_t * p_dec )
 
         /* */
         input_resource_RequestVout( p_owner->p_resource, p_owner->p_vout, NULL,
-                                    0, true );
+                                    0, NULL, true );
         if( p_owner->p_input != NULL )
             input_SendEventVout( p_owner->p_input );
     }
@@ -2166,6 +2440,8 @@ static void DecoderUpdateFormatLocked( decoder_t *p_dec )
         vlc_meta_Delete( p_owner->p_description );
     p_owner->p_description = p_dec->p_description;
     p_dec->p_description = NULL;
+
+    atomic_fetch_add( &p_owner->changes, 1u );
 }
 static vout_thread_t *aout_request_vout( void *p_private,
                                          vout_thread_t *p_vout, video_format_t *p_fmt, bool b_recyle )
@@ -2175,7 +2451,7 @@ static vout_thread_t *aout_request_vout( void *p_private,
     input_thread_t *p_input = p_owner->p_input;
 
     p_vout = input_resource_RequestVout( p_owner->p_resource, p_vout, p_fmt, 1,
-                                         b_recyle );
+                                         NULL, b_recyle );
     if( p_input != NULL )
         input_SendEventVout( p_input );
 
@@ -2288,7 +2564,9 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
         p_dec->fmt_out.video.i_y_offset != p_owner->video.i_y_offset  ||
         p_dec->fmt_out.i_codec != p_owner->video.i_chroma ||
         (int64_t)p_dec->fmt_out.video.i_sar_num * p_owner->video.i_sar_den !=
-        (int64_t)p_dec->fmt_out.video.i_sar_den * p_owner->video.i_sar_num )
+        (int64_t)p_dec->fmt_out.video.i_sar_den * p_owner->video.i_sar_num ||
+        memcmp( &p_dec->picture_layout, &p_owner->video_layout,
+                sizeof( p_owner->video_layout ) ) )
     {
         vout_thread_t *p_vout;
 
@@ -2302,6 +2580,7 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
         video_format_t fmt = p_dec->fmt_out.video;
         fmt.i_chroma = p_dec->fmt_out.i_codec;
         p_owner->video = fmt;
+        p_owner->video_layout = p_dec->picture_layout;
 
         if( vlc_fourcc_IsYUV( fmt.i_chroma ) )
         {
@@ -2385,7 +2664,7 @@ static picture_t *vout_new_buffer( decoder_t *p_dec )
                                              dpb_size +
                                              p_dec->i_extra_picture_buffers +
                                              1 + DECODER_MAX_BUFFERING_COUNT,
-                                             true );
+                                             &p_owner->video_layout, true );
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_vout = p_vout;
 
@@ -2449,7 +2728,8 @@ static subpicture_t *spu_new_buffer( decoder_t *p_dec,
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     vout_thread_t *p_vout = NULL;
     subpicture_t *p_subpic;
-    int i_attempts = 30;
+    /* Do not hold a shared decoder thread while there is no vout */
+    int i_attempts = p_owner->p_pool ? 1 : 30;
 
     while( i_attempts-- )
     {
@@ -2460,7 +2740,8 @@ static subpicture_t *spu_new_buffer( decoder_t *p_dec,
         if( p_vout )
             break;
 
-        msleep( DECODER_SPU_VOUT_WAIT_DURATION );
+        if( i_attempts > 0 )
+            msleep( DECODER_SPU_VOUT_WAIT_DURATION );
     }
 
     if( !p_vout )
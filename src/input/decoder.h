@@ -99,6 +99,14 @@ void input_DecoderFrameNext( decoder_t *p_dec, mtime_t *pi_duration );
  */
 bool input_DecoderHasFormatChanged( decoder_t *p_dec, es_format_t *p_fmt, vlc_meta_t **pp_meta );
 
+/**
+ * This function returns a counter incremented each time the format, the
+ * closed captions or the stream output of the decoder change. It does not
+ * lock, so that input_DecoderHasFormatChanged and input_DecoderIsCcPresent
+ * only need to be called when it moved.
+ */
+unsigned input_DecoderGetChangeCount( decoder_t *p_dec );
+
 /**
  * This function returns the current size in bytes of the decoder fifo
  */
@@ -111,4 +119,56 @@ size_t input_DecoderGetFifoSize( decoder_t *p_dec );
  */
 void input_DecoderGetObjects( decoder_t *, vout_thread_t **, audio_output_t ** );
 
+/**
+ * Decoder run by the shared decoder threads instead of its own thread.
+ * It is owned by the decoder, and only run by one thread at a time.
+ */
+typedef struct decoder_task_t decoder_task_t;
+struct decoder_task_t
+{
+    decoder_task_t *p_next;
+    int            i_priority;
+
+    /* Returns true if it must be run again */
+    bool           (*pf_run)( void * );
+    void           *p_opaque;
+
+    /* Protected by the pool lock */
+    bool           b_queued;
+    bool           b_running;
+    bool           b_again;
+    bool           b_canceled;
+};
+
+enum
+{
+    DECODER_TASK_PRIORITY_VIDEO = 0,
+    DECODER_TASK_PRIORITY_AUDIO,
+    DECODER_TASK_PRIORITY_SPU,
+
+    DECODER_TASK_PRIORITY_COUNT
+};
+
+/**
+ * This function returns the shared decoder threads, starting them if needed.
+ * It returns NULL if they are disabled (decoder-threads is 0).
+ */
+decoder_pool_t *decoder_pool_Get( vlc_object_t * );
+#define decoder_pool_Get(o) decoder_pool_Get(VLC_OBJECT(o))
+
+void decoder_task_Init( decoder_task_t *, int i_priority,
+                        bool (*pf_run)( void * ), void *p_opaque );
+
+/**
+ * This function queues the task unless it is already queued. If it is
+ * running, it will be queued again once done.
+ */
+void decoder_pool_Schedule( decoder_pool_t *, decoder_task_t * );
+
+/**
+ * This function removes the task from the pool and waits for it to be
+ * done running. It cannot be scheduled anymore.
+ */
+void decoder_pool_Cancel( decoder_pool_t *, decoder_task_t * );
+
 #endif
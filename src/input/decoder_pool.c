@@ -0,0 +1,250 @@
+/*****************************************************************************
+ * decoder_pool.c: Shared threads running the decoders
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "stdafx.h"
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../libvlc.h"
+#include "clock.h"
+#include "decoder.h"
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+struct decoder_pool_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_task;  /* a task has been queued */
+    vlc_cond_t  wait_done;  /* a task has been run */
+
+    /* Tasks to run, in FIFO order for each priority */
+    struct
+    {
+        decoder_task_t  *p_first;
+        decoder_task_t  **pp_last;
+    } queue[DECODER_TASK_PRIORITY_COUNT];
+
+    bool            b_closing;
+    unsigned        i_thread;       /* wanted threads (constant) */
+    unsigned        i_thread_started;
+    vlc_thread_t    *p_thread;
+};
+
+/* Take the next task to run, the highest priority first. The lock must be
+ * held. */
+static decoder_task_t *PoolTake( decoder_pool_t *p_pool )
+{
+    for( int i = 0; i < DECODER_TASK_PRIORITY_COUNT; i++ )
+    {
+        decoder_task_t *p_task = p_pool->queue[i].p_first;
+        if( !p_task )
+            continue;
+
+        p_pool->queue[i].p_first = p_task->p_next;
+        if( !p_pool->queue[i].p_first )
+            p_pool->queue[i].pp_last = &p_pool->queue[i].p_first;
+        p_task->p_next = NULL;
+        p_task->b_queued = false;
+        return p_task;
+    }
+    return NULL;
+}
+
+/* Queue a task. The lock must be held. */
+static void PoolQueue( decoder_pool_t *p_pool, decoder_task_t *p_task )
+{
+    assert( p_task->i_priority >= 0 &&
+            p_task->i_priority < DECODER_TASK_PRIORITY_COUNT );
+
+    *p_pool->queue[p_task->i_priority].pp_last = p_task;
+    p_pool->queue[p_task->i_priority].pp_last = &p_task->p_next;
+    p_task->b_queued = true;
+    vlc_cond_signal( &p_pool->wait_task );
+}
+
+static void *PoolThread( void *p_data )
+{
+    decoder_pool_t *p_pool = (decoder_pool_t *)p_data;
+
+    vlc_mutex_lock( &p_pool->lock );
+    for( ;; )
+    {
+        decoder_task_t *p_task;
+
+        while( !p_pool->b_closing && !(p_task = PoolTake( p_pool )) )
+            vlc_cond_wait( &p_pool->wait_task, &p_pool->lock );
+        if( p_pool->b_closing )
+            break;
+
+        /* A task is only run by one thread at a time */
+        p_task->b_running = true;
+        p_task->b_again = false;
+        vlc_mutex_unlock( &p_pool->lock );
+
+        const bool b_more = p_task->pf_run( p_task->p_opaque );
+
+        vlc_mutex_lock( &p_pool->lock );
+        p_task->b_running = false;
+        if( (b_more || p_task->b_again) && !p_task->b_canceled )
+            PoolQueue( p_pool, p_task );
+        vlc_cond_broadcast( &p_pool->wait_done );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+    return NULL;
+}
+
+decoder_pool_t *decoder_pool_New( unsigned i_thread )
+{
+    decoder_pool_t *p_pool = (decoder_pool_t *)malloc( sizeof(*p_pool) );
+    if( !p_pool )
+        return NULL;
+
+    vlc_mutex_init( &p_pool->lock );
+    vlc_cond_init( &p_pool->wait_task );
+    vlc_cond_init( &p_pool->wait_done );
+    for( int i = 0; i < DECODER_TASK_PRIORITY_COUNT; i++ )
+    {
+        p_pool->queue[i].p_first = NULL;
+        p_pool->queue[i].pp_last = &p_pool->queue[i].p_first;
+    }
+    p_pool->b_closing = false;
+
+    /* The threads are only created by the first task */
+    p_pool->i_thread = i_thread;
+    p_pool->i_thread_started = 0;
+    p_pool->p_thread = NULL;
+    return p_pool;
+}
+
+void decoder_pool_Delete( decoder_pool_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->b_closing = true;
+    vlc_cond_broadcast( &p_pool->wait_task );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    for( unsigned i = 0; i < p_pool->i_thread_started; i++ )
+        vlc_join( p_pool->p_thread[i], NULL );
+    free( p_pool->p_thread );
+
+    vlc_cond_destroy( &p_pool->wait_done );
+    vlc_cond_destroy( &p_pool->wait_task );
+    vlc_mutex_destroy( &p_pool->lock );
+    free( p_pool );
+}
+
+/* Start the threads. The lock must be held. */
+static int PoolStart( decoder_pool_t *p_pool )
+{
+    p_pool->p_thread = (vlc_thread_t *)malloc( p_pool->i_thread * sizeof(*p_pool->p_thread) );
+    if( !p_pool->p_thread )
+        return VLC_ENOMEM;
+
+    while( p_pool->i_thread_started < p_pool->i_thread )
+    {
+        if( vlc_clone( &p_pool->p_thread[p_pool->i_thread_started], PoolThread,
+                       p_pool, VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        p_pool->i_thread_started++;
+    }
+    if( p_pool->i_thread_started <= 0 )
+    {
+        free( p_pool->p_thread );
+        p_pool->p_thread = NULL;
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+#undef decoder_pool_Get
+decoder_pool_t *decoder_pool_Get( vlc_object_t *p_obj )
+{
+    decoder_pool_t *p_pool = libvlc_priv( p_obj->p_libvlc )->decoder_pool;
+
+    if( !p_pool )
+        return NULL;
+
+    vlc_mutex_lock( &p_pool->lock );
+    const bool b_started = p_pool->p_thread != NULL ||
+                           PoolStart( p_pool ) == VLC_SUCCESS;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( !b_started )
+    {
+        msg_Err( p_obj, "cannot start the decoder threads" );
+        return NULL;
+    }
+    return p_pool;
+}
+
+void decoder_task_Init( decoder_task_t *p_task, int i_priority,
+                        bool (*pf_run)( void * ), void *p_opaque )
+{
+    p_task->p_next = NULL;
+    p_task->i_priority = i_priority;
+    p_task->pf_run = pf_run;
+    p_task->p_opaque = p_opaque;
+    p_task->b_queued = false;
+    p_task->b_running = false;
+    p_task->b_again = false;
+    p_task->b_canceled = false;
+}
+
+void decoder_pool_Schedule( decoder_pool_t *p_pool, decoder_task_t *p_task )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    if( !p_task->b_canceled && !p_task->b_queued )
+    {
+        if( p_task->b_running )
+            p_task->b_again = true; /* queued again once run */
+        else
+            PoolQueue( p_pool, p_task );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+}
+
+void decoder_pool_Cancel( decoder_pool_t *p_pool, decoder_task_t *p_task )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    p_task->b_canceled = true;
+    if( p_task->b_queued )
+    {
+        decoder_task_t **pp = &p_pool->queue[p_task->i_priority].p_first;
+
+        while( *pp != p_task )
+            pp = &(*pp)->p_next;
+        *pp = p_task->p_next;
+        if( p_pool->queue[p_task->i_priority].pp_last == &p_task->p_next )
+            p_pool->queue[p_task->i_priority].pp_last = pp;
+        p_task->p_next = NULL;
+        p_task->b_queued = false;
+    }
+    while( p_task->b_running )
+        vlc_cond_wait( &p_pool->wait_done, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+}
@@ -351,6 +351,7 @@ bool decoder_SynchroChoose( decoder_synchro_t * p_synchro, int i_coding_type,
 void decoder_SynchroTrash( decoder_synchro_t * p_synchro )
 {
     p_synchro->i_trashed_pic++;
+    p_synchro->p_dec->i_skipped_pictures++;
     p_synchro->i_nb_ref = p_synchro->i_trash_nb_ref;
 }
 
@@ -27,16 +27,369 @@
 # include "config.h"
 #endif
 
+#include <ctype.h>
+
 #include "demux.h"
 #include <libvlc.h>
 #include <vlc_codec.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
+#include <vlc_fs.h>
+#include "modules/modules.h"
+#include "../config/configuration.h"
 
 static bool SkipID3Tag( demux_t * );
 static bool SkipAPETag( demux_t *p_demux );
 
+/* Size of the stream beginning read before probing. The demuxers usually
+ * peek less than that, so they all probe the same data, without waiting
+ * for the access once each. */
+#define DEMUX_PROBE_PREFETCH 4096
+
+/*****************************************************************************
+ * Probing hints
+ *****************************************************************************
+ * The demuxers that opened recently are remembered by URL, by signature (the
+ * first bytes of the stream) and by file extension, most recent first. The
+ * matching demuxer is tried first the next time, before the others.
+ *
+ * The hints are kept from one run to the next in a small text file of the
+ * user cache directory: one "key module" line per hint, in the same order.
+ *****************************************************************************/
+#define DEMUX_HINTS_MAX 64
+#define DEMUX_HINTS_FILE "demux-hints"
+#define DEMUX_HINTS_HEADER "# VLC demux hints 1\n"
+
+enum
+{
+    DEMUX_HINT_URL,
+    DEMUX_HINT_SIGNATURE,
+    DEMUX_HINT_EXTENSION,
+    DEMUX_HINT_KEYS
+};
+
+typedef struct
+{
+    uint32_t i_key;
+    char     psz_module[32];
+} demux_hint_t;
+
+struct demux_hints_t
+{
+    vlc_object_t *p_obj;
+    vlc_mutex_t  lock;
+    bool         b_changed;
+    unsigned     i_count;
+    demux_hint_t hints[DEMUX_HINTS_MAX]; /* most recently used first */
+};
+
+static char *HintsPath( void )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path;
+
+    if( psz_dir == NULL )
+        return NULL;
+    if( asprintf( &psz_path, "%s" DIR_SEP DEMUX_HINTS_FILE, psz_dir ) == -1 )
+        psz_path = NULL;
+    free( psz_dir );
+    return psz_path;
+}
+
+static void HintsLoad( demux_hints_t *p_hints )
+{
+    char *psz_path = HintsPath();
+    if( psz_path == NULL )
+        return;
+
+    FILE *file = vlc_fopen( psz_path, "rt" );
+    free( psz_path );
+    if( file == NULL )
+        return;
+
+    char psz_line[64];
+    if( fgets( psz_line, sizeof( psz_line ), file ) == NULL
+     || strcmp( psz_line, DEMUX_HINTS_HEADER ) )
+    {
+        fclose( file );
+        return;
+    }
+
+    while( p_hints->i_count < DEMUX_HINTS_MAX
+        && fgets( psz_line, sizeof( psz_line ), file ) != NULL )
+    {
+        demux_hint_t *p_hint = &p_hints->hints[p_hints->i_count];
+        char *psz_end;
+
+        p_hint->i_key = strtoul( psz_line, &psz_end, 16 );
+        if( p_hint->i_key == 0 || *psz_end != ' ' )
+            continue;
+        /* A module name, nothing else: it is only a hint */
+        strlcpy( p_hint->psz_module, psz_end + 1,
+                 sizeof( p_hint->psz_module ) );
+        p_hint->psz_module[strcspn( p_hint->psz_module, "\r\n" )] = '\0';
+        if( p_hint->psz_module[0] == '\0'
+         || p_hint->psz_module[strspn( p_hint->psz_module,
+                    "abcdefghijklmnopqrstuvwxyz0123456789_-" )] != '\0' )
+            continue;
+        p_hints->i_count++;
+    }
+    fclose( file );
+}
+
+/* Replaces the file atomically, as the configuration file */
+static void HintsSave( demux_hints_t *p_hints )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path = HintsPath();
+    char *psz_temp;
+
+    if( psz_dir == NULL || psz_path == NULL
+     || asprintf( &psz_temp, "%s.%u", psz_path, getpid() ) == -1 )
+    {
+        free( psz_path );
+        free( psz_dir );
+        return;
+    }
+    config_CreateDir( p_hints->p_obj, psz_dir );
+    free( psz_dir );
+
+    FILE *file = vlc_fopen( psz_temp, "wt" );
+    if( file == NULL )
+    {
+        msg_Dbg( p_hints->p_obj, "cannot save the demux hints to %s",
+                 psz_path );
+        goto out;
+    }
+
+    fputs( DEMUX_HINTS_HEADER, file );
+    for( unsigned i = 0; i < p_hints->i_count; i++ )
+        fprintf( file, "%08"PRIx32" %s\n", p_hints->hints[i].i_key,
+                 p_hints->hints[i].psz_module );
+    fflush( file );
+    if( ferror( file ) )
+    {
+        fclose( file );
+        vlc_unlink( psz_temp );
+        goto out;
+    }
+    fclose( file );
+#if defined (_WIN32) || defined (__OS2__)
+    /* Windows cannot overwrite existing files */
+    vlc_unlink( psz_path );
+#endif
+    if( vlc_rename( psz_temp, psz_path ) )
+        vlc_unlink( psz_temp );
+out:
+    free( psz_temp );
+    free( psz_path );
+}
+
+demux_hints_t *demux_HintsNew( vlc_object_t *p_obj )
+{
+    demux_hints_t *p_hints = (demux_hints_t *)malloc( sizeof( *p_hints ) );
+    if( unlikely(p_hints == NULL) )
+        return NULL;
+
+    p_hints->p_obj = p_obj;
+    vlc_mutex_init( &p_hints->lock );
+    p_hints->b_changed = false;
+    p_hints->i_count = 0;
+    HintsLoad( p_hints );
+    return p_hints;
+}
+
+void demux_HintsDelete( demux_hints_t *p_hints )
+{
+    if( p_hints->b_changed )
+        HintsSave( p_hints );
+    vlc_mutex_destroy( &p_hints->lock );
+    free( p_hints );
+}
+
+static uint32_t HintHash( uint32_t h, const void *p_data, size_t i_data )
+{
+    /* FNV-1a */
+    const uint8_t *p = (const uint8_t *)p_data;
+
+    for( size_t i = 0; i < i_data; i++ )
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Keys of the stream, 0 if not available */
+static void HintKeys( demux_t *p_demux, uint32_t keys[DEMUX_HINT_KEYS] )
+{
+    const uint8_t *p_peek;
+
+    memset( keys, 0, DEMUX_HINT_KEYS * sizeof( *keys ) );
+
+    /* The kind of key is in the hash basis */
+    uint32_t h = HintHash( 2166136261u + DEMUX_HINT_URL, p_demux->psz_access,
+                           strlen( p_demux->psz_access ) );
+    keys[DEMUX_HINT_URL] = HintHash( h, p_demux->psz_location,
+                                     strlen( p_demux->psz_location ) );
+
+    if( stream_Peek( p_demux->s, &p_peek, 8 ) >= 8 )
+        keys[DEMUX_HINT_SIGNATURE] =
+            HintHash( 2166136261u + DEMUX_HINT_SIGNATURE, p_peek, 8 );
+
+    const char *psz_ext = p_demux->psz_file != NULL
+                        ? strrchr( p_demux->psz_file, '.' ) : NULL;
+    if( psz_ext != NULL && strlen( ++psz_ext ) <= 5 )
+    {
+        h = 2166136261u + DEMUX_HINT_EXTENSION;
+        for( ; *psz_ext; psz_ext++ )
+        {
+            const char c = tolower( (unsigned char)*psz_ext );
+            h = HintHash( h, &c, 1 );
+        }
+        keys[DEMUX_HINT_EXTENSION] = h;
+    }
+}
+
+/* Copies the name of the demuxer hinted by the first matching key. As many
+ * files share an extension, the extension hint is only taken when it names
+ * the most recently used demuxer. */
+static bool HintsFind( demux_hints_t *p_hints,
+                       const uint32_t keys[DEMUX_HINT_KEYS],
+                       char *psz_module, size_t i_module )
+{
+    bool b_found = false;
+
+    if( p_hints == NULL )
+        return false;
+
+    vlc_mutex_lock( &p_hints->lock );
+    for( unsigned k = 0; k < DEMUX_HINT_KEYS && !b_found; k++ )
+    {
+        if( keys[k] == 0 )
+            continue;
+        for( unsigned i = 0; i < p_hints->i_count; i++ )
+        {
+            if( p_hints->hints[i].i_key == keys[k] )
+            {
+                if( k == DEMUX_HINT_EXTENSION
+                 && strcmp( p_hints->hints[i].psz_module,
+                            p_hints->hints[0].psz_module ) )
+                    break;
+                strlcpy( psz_module, p_hints->hints[i].psz_module, i_module );
+                b_found = true;
+                break;
+            }
+        }
+    }
+    vlc_mutex_unlock( &p_hints->lock );
+    return b_found;
+}
+
+static void HintsAdd( demux_hints_t *p_hints,
+                      const uint32_t keys[DEMUX_HINT_KEYS],
+                      const char *psz_module )
+{
+    if( p_hints == NULL )
+        return;
+
+    vlc_mutex_lock( &p_hints->lock );
+    for( unsigned k = DEMUX_HINT_KEYS; k-- > 0; )
+    {
+        if( keys[k] == 0 )
+            continue;
+
+        /* Move the entry (or the least recently used one) to the front */
+        unsigned i;
+        for( i = 0; i < p_hints->i_count; i++ )
+            if( p_hints->hints[i].i_key == keys[k] )
+                break;
+        if( i == p_hints->i_count )
+        {
+            if( p_hints->i_count < DEMUX_HINTS_MAX )
+                p_hints->i_count++;
+            else
+                i--;
+        }
+        memmove( &p_hints->hints[1], &p_hints->hints[0],
+                 i * sizeof( p_hints->hints[0] ) );
+        p_hints->hints[0].i_key = keys[k];
+        strlcpy( p_hints->hints[0].psz_module, psz_module,
+                 sizeof( p_hints->hints[0].psz_module ) );
+    }
+    p_hints->b_changed = true;
+    vlc_mutex_unlock( &p_hints->lock );
+}
+
+/*****************************************************************************
+ * Probing
+ *****************************************************************************/
+#define DEMUX_PROBES_MAX 16
+
+typedef struct
+{
+    demux_t  *p_demux;
+    uint64_t  i_start;  /* stream position to probe from */
+    unsigned  i_probes; /* number of candidates tried */
+    struct
+    {
+        void    *pf_activate;
+        mtime_t  i_duration;
+    } probes[DEMUX_PROBES_MAX];
+} demux_probe_t;
+
+static int DemuxProbe( void *func, va_list ap )
+{
+    demux_probe_t *p_probe = va_arg( ap, demux_probe_t * );
+    demux_t *p_demux = p_probe->p_demux;
+    int (*activate)(vlc_object_t *) = (int (*)(vlc_object_t *))func;
+
+    const mtime_t i_start = mdate();
+    int ret = activate( VLC_OBJECT(p_demux) );
+    const mtime_t i_duration = mdate() - i_start;
+
+    /* The next candidate must see the stream from the same position */
+    if( ret != VLC_SUCCESS && p_demux->s != NULL
+     && (uint64_t)stream_Tell( p_demux->s ) != p_probe->i_start )
+        stream_Seek( p_demux->s, p_probe->i_start );
+
+    if( p_probe->i_probes < DEMUX_PROBES_MAX )
+    {
+        p_probe->probes[p_probe->i_probes].pf_activate = func;
+        p_probe->probes[p_probe->i_probes].i_duration = i_duration;
+    }
+    p_probe->i_probes++;
+    return ret;
+}
+
+/* Prints the time spent by each candidate demuxer */
+static void DemuxProbeDump( demux_t *p_demux, const demux_probe_t *p_probe,
+                            const char *psz_capability )
+{
+    module_t **mods;
+    ssize_t total = module_list_cap( &mods, psz_capability );
+    const unsigned i_probes = __MIN( p_probe->i_probes, DEMUX_PROBES_MAX );
+
+    for( unsigned i = 0; i < i_probes; i++ )
+    {
+        const char *psz_name = "?";
+
+        for( ssize_t j = 0; j < total; j++ )
+            if( mods[j]->pf_activate == p_probe->probes[i].pf_activate )
+            {
+                psz_name = module_get_object( mods[j] );
+                break;
+            }
+        msg_Dbg( p_demux, "probing %s \"%s\" took %"PRId64" us",
+                 psz_capability, psz_name, p_probe->probes[i].i_duration );
+    }
+    if( p_probe->i_probes > i_probes )
+        msg_Dbg( p_demux, "and %u more candidates",
+                 p_probe->i_probes - i_probes );
+    module_list_free( mods );
+}
+
 /* Decode URL (which has had its scheme stripped earlier) to a file path. */
 /* XXX: evil code duplication from access.c */
 static char *get_path(const char *location)
@@ -105,6 +458,13 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     if( s ) psz_module = p_demux->psz_demux;
     else psz_module = p_demux->psz_access;
 
+    demux_probe_t probe;
+    const mtime_t i_probe_start = mdate();
+
+    probe.p_demux = p_demux;
+    probe.i_start = 0;
+    probe.i_probes = 0;
+
     const char *psz_ext;
 
     if( s && *psz_module == '\0'
@@ -186,15 +546,54 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
           ;
         SkipAPETag( p_demux );
 
+        /* Read the data that the candidates will probe at once */
+        const uint8_t *p_peek;
+        stream_Peek( s, &p_peek, DEMUX_PROBE_PREFETCH );
+
+        demux_hints_t *p_hints = libvlc_priv( p_obj->p_libvlc )->demux_hints;
+        uint32_t keys[DEMUX_HINT_KEYS];
+        bool b_strict = !strcmp( psz_module, p_demux->psz_demux );
+        char psz_hinted[2 * 32];
+
+        HintKeys( p_demux, keys );
+        if( *p_demux->psz_demux == '\0'
+         && HintsFind( p_hints, keys, psz_hinted, 32 ) )
+        {
+            /* Try the hinted demuxer first, then the one from the extension
+             * and then all the others */
+            if( *psz_module != '\0' && strcasecmp( psz_module, psz_hinted ) )
+            {
+                const size_t i_len = strlen( psz_hinted );
+
+                _snprintf( &psz_hinted[i_len], sizeof( psz_hinted ) - i_len,
+                           ",%s", psz_module );
+                psz_hinted[sizeof( psz_hinted ) - 1] = '\0';
+            }
+            psz_module = psz_hinted;
+            b_strict = false;
+        }
+
+        probe.i_start = stream_Tell( s );
         p_demux->p_module =
-            module_need( p_demux, "demux", psz_module,
-                         !strcmp( psz_module, p_demux->psz_demux ) );
+            vlc_module_load( p_demux, "demux", psz_module, b_strict,
+                             DemuxProbe, &probe );
+        /* Only remember what was detected, not what was forced */
+        if( p_demux->p_module != NULL && *p_demux->psz_demux == '\0' )
+            HintsAdd( p_hints, keys, module_get_object( p_demux->p_module ) );
     }
     else
     {
         p_demux->p_module =
-            module_need( p_demux, "access_demux", psz_module,
-                         !strcmp( psz_module, p_demux->psz_access ) );
+            vlc_module_load( p_demux, "access_demux", psz_module,
+                             !strcmp( psz_module, p_demux->psz_access ),
+                             DemuxProbe, &probe );
+    }
+
+    if( !b_quick )
+    {
+        msg_Dbg( p_demux, "%u candidates probed in %"PRId64" us",
+                 probe.i_probes, mdate() - i_probe_start );
+        DemuxProbeDump( p_demux, &probe, s ? "demux" : "access_demux" );
     }
 
     if( p_demux->p_module == NULL )
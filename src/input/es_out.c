@@ -95,6 +95,9 @@ struct es_out_id_t
     decoder_t   *p_dec;
     decoder_t   *p_dec_record;
 
+    /* Last input_DecoderGetChangeCount() of p_dec */
+    unsigned    i_dec_changes;
+
     /* Fields for Video with CC */
     bool  pb_cc_present[4];
     es_out_id_t  *pp_cc_es[4];
@@ -154,6 +157,8 @@ struct es_out_sys_t
     mtime_t     i_pts_jitter;
     int         i_cr_average;
     int         i_rate;
+    bool        b_low_latency;
+    mtime_t     i_latency_min;
 
     /* */
     bool        b_paused;
@@ -167,6 +172,7 @@ struct es_out_sys_t
     mtime_t     i_buffering_extra_initial;
     mtime_t     i_buffering_extra_stream;
     mtime_t     i_buffering_extra_system;
+    mtime_t     i_buffering_max; /* -1 if none */
 
     /* Record */
     sout_instance_t *p_sout_record;
@@ -293,9 +299,12 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
     p_sys->i_pause_date = -1;
 
     p_sys->i_rate = i_rate;
+    p_sys->b_low_latency = var_InheritBool( p_input, "clock-low-latency" );
+    p_sys->i_latency_min = INT64_C(1000) * var_InheritInteger( p_input, "clock-latency-min" );
 
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
+    p_sys->i_buffering_max = -1;
 
     return out;
 }
@@ -591,6 +600,7 @@ static void EsOutChangePosition( es_out_t *out )
     p_sys->i_buffering_extra_initial = 0;
     p_sys->i_buffering_extra_stream = 0;
     p_sys->i_buffering_extra_system = 0;
+    p_sys->i_buffering_max = -1;
     p_sys->i_preroll_end = -1;
 }
 
@@ -616,9 +626,11 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
     if( p_sys->i_preroll_end >= 0 )
         i_preroll_duration = __MAX( p_sys->i_preroll_end - i_stream_start, 0 );
 
-    const mtime_t i_buffering_duration = p_sys->i_pts_delay +
-                                         i_preroll_duration +
-                                         p_sys->i_buffering_extra_stream - p_sys->i_buffering_extra_initial;
+    mtime_t i_buffering_duration = p_sys->i_pts_delay +
+                                   i_preroll_duration +
+                                   p_sys->i_buffering_extra_stream - p_sys->i_buffering_extra_initial;
+    if( p_sys->i_buffering_max >= 0 )
+        i_buffering_duration = __MIN( i_buffering_duration, p_sys->i_buffering_max );
 
     if( i_stream_duration <= i_buffering_duration && !b_forced )
     {
@@ -634,6 +646,7 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
               (int)(i_stream_duration/1000), (int)(i_system_duration/1000) );
     p_sys->b_buffering = false;
     p_sys->i_preroll_end = -1;
+    p_sys->i_buffering_max = -1;
 
     if( p_sys->i_buffering_extra_initial > 0 )
     {
@@ -1049,6 +1062,8 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
     if( p_sys->b_paused )
         input_clock_ChangePause( p_pgrm->p_clock, p_sys->b_paused, p_sys->i_pause_date );
     input_clock_SetJitter( p_pgrm->p_clock, p_sys->i_pts_delay, p_sys->i_cr_average );
+    if( p_sys->b_low_latency )
+        input_clock_SetLowLatency( p_pgrm->p_clock, true, p_sys->i_latency_min );
 
     /* Append it */
     TAB_APPEND( (es_out_pgrm_t **), p_sys->i_pgrm, p_sys->pgrm, p_pgrm );			// sunqueen modify
@@ -1551,6 +1566,30 @@ static bool EsIsSelected( es_out_id_t *es )
         return es->p_dec != NULL;
     }
 }
+/* The stream output pace control only changes when a decoder creates or
+ * deletes its stream output, so it is not checked for each block */
+static void EsOutUpdatePaceControl( es_out_t *out )
+{
+    input_thread_t *p_input = out->p_sys->p_input;
+
+    if( !p_input->p->p_sout )
+        return;
+
+    /* FIXME review this, proper lock may be missing */
+    if( p_input->p->p_sout->i_out_pace_nocontrol > 0 &&
+        p_input->p->b_out_pace_control )
+    {
+        msg_Dbg( p_input, "switching to sync mode" );
+        p_input->p->b_out_pace_control = false;
+    }
+    else if( p_input->p->p_sout->i_out_pace_nocontrol <= 0 &&
+             !p_input->p->b_out_pace_control )
+    {
+        msg_Dbg( p_input, "switching to async mode" );
+        p_input->p->b_out_pace_control = true;
+    }
+}
+
 static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
 {
     es_out_sys_t   *p_sys = out->p_sys;
@@ -1559,6 +1598,8 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     p_es->p_dec = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_input->p->p_sout );
     if( p_es->p_dec )
     {
+        p_es->i_dec_changes = input_DecoderGetChangeCount( p_es->p_dec );
+
         if( p_sys->b_buffering )
             input_DecoderStartBuffering( p_es->p_dec );
 
@@ -1574,8 +1615,6 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
 }
 static void EsDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
 {
-    VLC_UNUSED(out);
-
     if( !p_es->p_dec )
         return;
 
@@ -1587,6 +1626,9 @@ static void EsDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
         input_DecoderDelete( p_es->p_dec_record );
         p_es->p_dec_record = NULL;
     }
+
+    /* The stream output of the decoder is gone */
+    EsOutUpdatePaceControl( out );
 }
 
 static void EsSelect( es_out_t *out, es_out_id_t *es )
@@ -1909,24 +1951,24 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( libvlc_stats( p_input ) )
     {
-        uint64_t i_total;
-
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
+        /* The bitrate is sampled from the total by stats_ComputeInputStats */
         stats_Update( p_input->p->counters.p_demux_read,
-                      p_block->i_buffer, &i_total );
-        stats_Update( p_input->p->counters.p_demux_bitrate, i_total, NULL );
+                      p_block->i_buffer, NULL );
 
-        /* Update number of corrupted data packats */
-        if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
-        {
-            stats_Update( p_input->p->counters.p_demux_corrupted, 1, NULL );
-        }
-        /* Update number of discontinuities */
-        if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        if( unlikely( p_block->i_flags & ( BLOCK_FLAG_CORRUPTED |
+                                           BLOCK_FLAG_DISCONTINUITY ) ) )
         {
-            stats_Update( p_input->p->counters.p_demux_discontinuity, 1, NULL );
+            /* Update number of corrupted data packats */
+            if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
+            {
+                stats_Update( p_input->p->counters.p_demux_corrupted, 1, NULL );
+            }
+            /* Update number of discontinuities */
+            if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+            {
+                stats_Update( p_input->p->counters.p_demux_discontinuity, 1, NULL );
+            }
         }
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 
     vlc_mutex_lock( &p_sys->lock );
@@ -1949,28 +1991,13 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
         return VLC_SUCCESS;
     }
 
-    /* Check for sout mode */
-    if( p_input->p->p_sout )
-    {
-        /* FIXME review this, proper lock may be missing */
-        if( p_input->p->p_sout->i_out_pace_nocontrol > 0 &&
-            p_input->p->b_out_pace_control )
-        {
-            msg_Dbg( p_input, "switching to sync mode" );
-            p_input->p->b_out_pace_control = false;
-        }
-        else if( p_input->p->p_sout->i_out_pace_nocontrol <= 0 &&
-                 !p_input->p->b_out_pace_control )
-        {
-            msg_Dbg( p_input, "switching to async mode" );
-            p_input->p->b_out_pace_control = true;
-        }
-    }
+    /* Check for sout mode, before the block is queued with it */
+    EsOutUpdatePaceControl( out );
 
     /* Decode */
     if( es->p_dec_record )
     {
-        block_t *p_dup = block_Duplicate( p_block );
+        block_t *p_dup = block_Share( p_block );
         if( p_dup )
             input_DecoderDecode( es->p_dec_record, p_dup,
                                  p_input->p->b_out_pace_control );
@@ -1978,6 +2005,15 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     input_DecoderDecode( es->p_dec, p_block,
                          p_input->p->b_out_pace_control );
 
+    /* Nothing else to do unless the decoder changed */
+    const unsigned i_changes = input_DecoderGetChangeCount( es->p_dec );
+    if( likely( i_changes == es->i_dec_changes ) )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_SUCCESS;
+    }
+    es->i_dec_changes = i_changes;
+
     es_format_t fmt_dsc;
     vlc_meta_t  *p_meta_dsc;
     if( input_DecoderHasFormatChanged( es->p_dec, &fmt_dsc, &p_meta_dsc ) )
@@ -2311,6 +2347,17 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
                             EsOutIsExtraBufferingAllowed( out ),
                             i_pcr, mdate() );
 
+        if( p_pgrm == p_sys->p_pgrm && libvlc_stats( p_sys->p_input ) )
+        {
+            mtime_t i_latency, i_jitter;
+
+            input_clock_GetLatency( p_pgrm->p_clock, &i_latency, &i_jitter );
+            stats_Update( p_sys->p_input->p->counters.p_clock_latency,
+                          __MAX( i_latency, 0 ), NULL );
+            stats_Update( p_sys->p_input->p->counters.p_clock_jitter,
+                          i_jitter, NULL );
+        }
+
         if( p_pgrm == p_sys->p_pgrm )
         {
             if( p_sys->b_buffering )
@@ -2357,6 +2404,17 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         EsOutChangePosition( out );
         return VLC_SUCCESS;
 
+    case ES_OUT_RESTART_BUFFERING:
+    {
+        const int64_t i_max = (int64_t)va_arg( args, int64_t );
+
+        msg_Dbg( p_sys->p_input, "restarting buffering (at most %d ms)",
+                 (int)(i_max/1000) );
+        EsOutChangePosition( out );
+        p_sys->i_buffering_max = __MAX( i_max, 0 );
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_SET_GROUP:
     {
         int i = va_arg( args, int );
@@ -2686,6 +2744,10 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_SEEK_TIMESHIFT:
+        /* Only handled by the timeshift es_out */
+        return VLC_EGENERIC;
+
     default:
         msg_Err( p_sys->p_input, "unknown query in es_out_Control" );
         return VLC_EGENERIC;
@@ -40,6 +40,9 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -157,23 +160,59 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Header written in the storage before the data of each block */
+typedef struct
+{
+    mtime_t  i_pts;
+    mtime_t  i_dts;
+    mtime_t  i_length;
+    uint32_t i_flags;
+    unsigned i_nb_samples;
+    size_t   i_buffer;
+} ts_block_header_t;
+
+/* Blocks are stored 8 bytes aligned */
+#define TS_BLOCK_SIZE( i_buffer ) \
+    ((sizeof(ts_block_header_t) + (i_buffer) + 7) & ~(size_t)7)
+
+/* Maximal number of commands of a storage */
+#define TS_STORAGE_COMMAND_MAX (30000)
+
+/* A key frame is only used as a seek point if it is not older than this
+ * before the requested date */
+#define TS_SEEK_KEY_MAX (INT64_C(10000000))
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
     ts_storage_t *p_next;
 
-    /* */
+    /* The file is allocated once to its maximal size and mapped in memory
+     * when possible, so that blocks are simply copied in and out. Only the
+     * storages being written and read are mapped: a storage is mapped again
+     * when the reading reaches it, or seeks back into it. The history and the
+     * storages waiting to be read are unmapped, so that the address space
+     * used does not grow with the window */
     char    *psz_file;  /* Filename */
+    int     fd;         /* File descriptor */
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
+    uint8_t *p_map;     /* Mapping of the whole file, or NULL */
+#if !defined(HAVE_MMAP) && defined(_WIN32)
+    HANDLE  h_map;
+#endif
 
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
+    int      i_cmd_played; /* Commands that have already been executed */
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
+
+    /* Send commands of blocks starting on a key frame, in increasing order */
+    int      i_key;
+    int      i_key_max;
+    int      *pi_key;
 };
 
 typedef struct
@@ -183,6 +222,7 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    int            i_history_max;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -201,17 +241,28 @@ typedef struct
     /* */
     mtime_t        i_buffering_delay;
 
-    /* */
+    /* The storages form a list: the played ones kept for seeking back
+     * (at most i_history_max), the one being read and the unread ones */
+    ts_storage_t   *p_storage_h;
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage_spare; /* Recycled storage */
+    int            i_history;
 
     mtime_t        i_cmd_delay;
+    mtime_t        i_cmd_date; /* Date of the last command read */
+
+    /* Seek state */
+    unsigned       i_seek;         /* Incremented on each seek */
+    bool           b_seek_reset;   /* Decoders must be reset */
+    mtime_t        i_skip_date;    /* Blocks sent before are dropped */
 
 } ts_thread_t;
 
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    vlc_fourcc_t i_codec; /* Used to find the key frames */
 };
 
 struct es_out_sys_t
@@ -222,6 +273,7 @@ struct es_out_sys_t
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    int            i_history_max;     /* Temporary files kept once played */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -253,22 +305,30 @@ static void         TsAutoStop( es_out_t * );
 static void         TsStop( ts_thread_t * );
 static void         TsPushCmd( ts_thread_t *, ts_cmd_t * );
 static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush );
+static bool         TsIsEmptyLocked( ts_thread_t * );
 static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, mtime_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static int          TsSeek( ts_thread_t *, mtime_t i_offset );
 
 static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static void         TsStorageMap( ts_storage_t * );
+static void         TsStorageUnmap( ts_storage_t * );
 static void         TsStorageDelete( ts_storage_t * );
+static void         TsStorageReset( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
+static bool         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStorageFindCmd( ts_storage_t *, mtime_t i_date );
+static int          TsStorageFindKey( ts_storage_t *, int i_cmd );
 
 static void CmdClean( ts_cmd_t * );
+static bool CmdCanReplay( const ts_cmd_t * );
 static void cmd_cleanup_routine( ts_cmd_t *p ) { CmdClean( p ); }				// sunqueen modify
 
 static int  CmdInitAdd    ( ts_cmd_t *, es_out_id_t *, const es_format_t *, bool b_copy );
@@ -289,7 +349,7 @@ static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
 
 /* File helpers */
 static char *GetTmpPath( char *psz_path );
-static FILE *GetTmpFile( char **ppsz_file, const char *psz_path );
+static int  GetTmpFile( char **ppsz_file, const char *psz_path );
 
 /*****************************************************************************
  * input_EsOutTimeshiftNew:
@@ -340,8 +400,18 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     char *psz_tmp_path = var_CreateGetNonEmptyString( p_input, "input-timeshift-path" );
     p_sys->psz_tmp_path = GetTmpPath( psz_tmp_path );
 
+    const int64_t i_window = var_CreateGetInteger( p_input, "input-timeshift-window" );
+    if( i_window > 0 )
+        p_sys->i_history_max = (i_window * 1024 * 1024 + p_sys->i_tmp_size_max - 1)
+                               / p_sys->i_tmp_size_max;
+    else
+        p_sys->i_history_max = 0;
+
     msg_Dbg( p_input, "using timeshift granularity of %d MiB, in path '%s'",
              (int)p_sys->i_tmp_size_max/(1024*1024), p_sys->psz_tmp_path );
+    if( p_sys->i_history_max > 0 )
+        msg_Dbg( p_input, "keeping %d MiB of played data for seeking back",
+                 (int)(p_sys->i_history_max * (p_sys->i_tmp_size_max/(1024*1024))) );
 
 #if 0
 #define S(t) msg_Err( p_input, "SIZEOF("#t")=%d", sizeof(t) )
@@ -387,11 +457,19 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
     es_out_id_t *p_es = (es_out_id_t *)malloc( sizeof( *p_es ) );			// sunqueen modify
     if( !p_es )
         return NULL;
+    p_es->p_es = NULL;
+    p_es->i_codec = p_fmt->i_codec;
 
     vlc_mutex_lock( &p_sys->lock );
 
     TsAutoStop( p_out );
 
+    /* Seeking back in a live stream needs what has already been played */
+    if( !p_sys->b_delayed && p_sys->i_history_max > 0 &&
+        !p_sys->p_input->b_preparsing &&
+        !p_sys->p_input->p->b_can_pace_control )
+        TsStart( p_out );
+
     if( CmdInitAdd( &cmd, p_es, p_fmt, p_sys->b_delayed ) )
     {
         vlc_mutex_unlock( &p_sys->lock );
@@ -441,9 +519,14 @@ static void Del( es_out_t *p_out, es_out_id_t *p_es )
 
     CmdInitDel( &cmd, p_es );
     if( p_sys->b_delayed )
+    {
         TsPushCmd( p_sys->p_ts, &cmd );
+    }
     else
+    {
         CmdExecuteDel( p_sys->p_out, &cmd );
+        free( p_es );
+    }
 
     TAB_REMOVE( p_sys->i_es, p_sys->pp_es, p_es );
 
@@ -599,6 +682,7 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     case ES_OUT_SET_PCR:
     case ES_OUT_SET_GROUP_PCR:
     case ES_OUT_RESET_PCR:
+    case ES_OUT_RESTART_BUFFERING:
     case ES_OUT_SET_NEXT_DISPLAY_TIME:
     case ES_OUT_SET_GROUP_META:
     case ES_OUT_SET_GROUP_EPG:
@@ -679,6 +763,14 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     {
         return ControlLockedSetFrameNext( p_out );
     }
+    case ES_OUT_SEEK_TIMESHIFT:
+    {
+        const mtime_t i_offset = (mtime_t)va_arg( args, mtime_t );
+
+        if( !p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return TsSeek( p_sys->p_ts, i_offset );
+    }
     case ES_OUT_GET_PCR_SYSTEM:
     {
         if( p_sys->b_delayed )
@@ -749,6 +841,7 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->i_history_max = p_sys->i_history_max;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -761,8 +854,15 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->i_cmd_date = -1;
+    p_ts->p_storage_h = NULL;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_storage_spare = NULL;
+    p_ts->i_history = 0;
+    p_ts->i_seek = 0;
+    p_ts->b_seek_reset = false;
+    p_ts->i_skip_date = -1;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -805,8 +905,15 @@ static void TsStop( ts_thread_t *p_ts )
         CmdClean( &cmd );
     }
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    while( p_ts->p_storage_h )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_h->p_next;
+
+        TsStorageDelete( p_ts->p_storage_h );
+        p_ts->p_storage_h = p_next;
+    }
+    if( p_ts->p_storage_spare )
+        TsStorageDelete( p_ts->p_storage_spare );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -817,11 +924,28 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        int64_t i_size = p_ts->i_tmp_size_max;
+        if( p_cmd->i_type == C_SEND )
+            i_size = __MAX( i_size, (int64_t)TS_BLOCK_SIZE( p_cmd->u.send.p_block->i_buffer ) );
+
+        /* Reuse the last storage released if it is large enough */
+        ts_storage_t *p_storage = p_ts->p_storage_spare;
+        p_ts->p_storage_spare = NULL;
+        if( p_storage && (int64_t)p_storage->i_file_max < i_size )
+        {
+            TsStorageDelete( p_storage );
+            p_storage = NULL;
+        }
+        if( p_storage && !p_storage->p_map )
+            TsStorageMap( p_storage );
+        if( !p_storage )
+            p_storage = TsStorageNew( p_ts->psz_tmp_path, i_size );
 
         if( !p_storage )
         {
             CmdClean( p_cmd );
+            if( p_cmd->i_type == C_DEL )
+                free( p_cmd->u.del.p_es );
             vlc_mutex_unlock( &p_ts->lock );
             /* TODO warn the user (but only once) */
             return;
@@ -829,42 +953,91 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
         if( !p_ts->p_storage_w )
         {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
+            p_ts->p_storage_h = p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
         }
         else
         {
             TsStoragePack( p_ts->p_storage_w );
+            if( p_ts->p_storage_w != p_ts->p_storage_r )
+                TsStorageUnmap( p_ts->p_storage_w );
             p_ts->p_storage_w->p_next = p_storage;
             p_ts->p_storage_w = p_storage;
         }
     }
 
+    /* TsRun only waits for a new command when it has none to execute (or
+     * when paused, as buffering may then need one) */
+    const bool b_signal = p_ts->b_paused || TsIsEmptyLocked( p_ts );
+
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage_w, p_cmd );
 
-    vlc_cond_signal( &p_ts->wait );
+    if( b_signal )
+        vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
 }
+static bool TsIsEmptyLocked( ts_thread_t *p_ts )
+{
+    for( ts_storage_t *p_storage = p_ts->p_storage_r; p_storage; p_storage = p_storage->p_next )
+    {
+        if( !TsStorageIsEmpty( p_storage ) )
+            return false;
+    }
+    return true;
+}
+static void TsTrimHistoryLocked( ts_thread_t *p_ts )
+{
+    while( p_ts->i_history > p_ts->i_history_max )
+    {
+        ts_storage_t *p_storage = p_ts->p_storage_h;
+
+        assert( p_storage != p_ts->p_storage_r );
+        p_ts->p_storage_h = p_storage->p_next;
+        p_ts->i_history--;
+
+        /* Keep one storage around to avoid creating a new file */
+        p_storage->p_next = NULL;
+        if( !p_ts->p_storage_spare )
+        {
+            TsStorageReset( p_storage );
+            p_ts->p_storage_spare = p_storage;
+        }
+        else
+        {
+            TsStorageDelete( p_storage );
+        }
+    }
+}
 static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_assert_locked( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+    for( ;; )
+    {
+        /* Only leave a storage once the command read last from it has been
+         * executed, as storages own the es_out_id_t of the deletions */
+        while( p_ts->p_storage_r && TsStorageIsEmpty( p_ts->p_storage_r ) &&
+               p_ts->p_storage_r->p_next )
+        {
+            if( p_ts->p_storage_r != p_ts->p_storage_w )
+                TsStorageUnmap( p_ts->p_storage_r );
+            p_ts->p_storage_r = p_ts->p_storage_r->p_next;
+            p_ts->i_history++;
+            if( !p_ts->p_storage_r->p_map )
+                TsStorageMap( p_ts->p_storage_r );
+        }
+        TsTrimHistoryLocked( p_ts );
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+        if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            return VLC_EGENERIC;
 
-    while( p_ts->p_storage_r && TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
+        if( TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush ) )
             break;
-
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
     }
 
+    if( !b_flush )
+        p_ts->i_cmd_date = p_cmd->i_date;
     return VLC_SUCCESS;
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
@@ -872,7 +1045,7 @@ static bool TsHasCmd( ts_thread_t *p_ts )
     bool b_cmd;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_cmd =  TsStorageIsEmpty( p_ts->p_storage_r );
+    b_cmd = !TsIsEmptyLocked( p_ts );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_cmd;
@@ -884,7 +1057,8 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->i_rate == p_ts->i_rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               p_ts->i_history_max <= 0 &&
+               TsIsEmptyLocked( p_ts );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -938,6 +1112,97 @@ static int TsChangeRate( ts_thread_t *p_ts, int i_src_rate, int i_rate )
 
     return i_ret;
 }
+static int TsSeek( ts_thread_t *p_ts, mtime_t i_offset )
+{
+    vlc_mutex_lock( &p_ts->lock );
+
+    if( p_ts->i_cmd_date < 0 || !p_ts->p_storage_h )
+    {
+        vlc_mutex_unlock( &p_ts->lock );
+        return VLC_EGENERIC;
+    }
+    const mtime_t i_target = p_ts->i_cmd_date + i_offset;
+
+    /* Find the last stored command not after the target date */
+    ts_storage_t *p_storage = NULL;
+    int i_cmd = -1;
+    for( ts_storage_t *p = p_ts->p_storage_h; p; p = p->p_next )
+    {
+        if( p->i_cmd_w <= 0 || p->p_cmd[0].i_date > i_target )
+            break;
+        p_storage = p;
+        i_cmd = TsStorageFindCmd( p, i_target );
+    }
+    if( !p_storage )
+    {
+        /* Before the oldest command kept */
+        p_storage = p_ts->p_storage_h;
+        i_cmd = 0;
+        if( p_storage->i_cmd_w <= 0 )
+        {
+            vlc_mutex_unlock( &p_ts->lock );
+            return VLC_EGENERIC;
+        }
+    }
+
+    /* Start on the previous key frame, if it is close enough */
+    ts_storage_t *p_key_storage = NULL;
+    int i_key = -1;
+    for( ts_storage_t *p = p_ts->p_storage_h; p; p = p->p_next )
+    {
+        const int i = TsStorageFindKey( p, p == p_storage ? i_cmd : p->i_cmd_w - 1 );
+        if( i >= 0 )
+        {
+            p_key_storage = p;
+            i_key = i;
+        }
+        if( p == p_storage )
+            break;
+    }
+    if( p_key_storage &&
+        p_storage->p_cmd[i_cmd].i_date - p_key_storage->p_cmd[i_key].i_date <= TS_SEEK_KEY_MAX )
+    {
+        p_storage = p_key_storage;
+        i_cmd = i_key;
+    }
+
+    const mtime_t i_date = p_storage->p_cmd[i_cmd].i_date;
+    if( i_date <= p_ts->i_cmd_date )
+    {
+        /* Replay from there: everything after it has already been read */
+        if( p_ts->p_storage_r != p_storage && p_ts->p_storage_r != p_ts->p_storage_w )
+            TsStorageUnmap( p_ts->p_storage_r );
+        p_ts->p_storage_r = p_storage;
+        /* The history is read from its mapping like the live data */
+        if( !p_storage->p_map )
+            TsStorageMap( p_storage );
+        p_storage->i_cmd_r = i_cmd;
+        for( ts_storage_t *p = p_storage->p_next; p; p = p->p_next )
+            p->i_cmd_r = 0;
+
+        p_ts->i_history = 0;
+        for( ts_storage_t *p = p_ts->p_storage_h; p != p_storage; p = p->p_next )
+            p_ts->i_history++;
+        p_ts->i_skip_date = -1;
+    }
+    else
+    {
+        /* Read up to there without waiting, dropping the blocks */
+        p_ts->i_skip_date = i_date;
+    }
+
+    /* The command at the new position is due now */
+    p_ts->i_cmd_delay += p_ts->i_rate_delay + p_ts->i_cmd_date - i_date;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+
+    p_ts->b_seek_reset = true;
+    p_ts->i_seek++;
+    vlc_cond_signal( &p_ts->wait );
+
+    vlc_mutex_unlock( &p_ts->lock );
+    return VLC_SUCCESS;
+}
 
 static void *TsRun( void *p_data )
 {
@@ -949,6 +1214,8 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         mtime_t  i_deadline;
         bool b_buffering;
+        bool b_skip;
+        unsigned i_seek;
 
         /* Pop a command to execute */
         vlc_mutex_lock( &p_ts->lock );
@@ -957,6 +1224,13 @@ static void *TsRun( void *p_data )
         for( ;; )
         {
             const int canc = vlc_savecancel();
+            if( p_ts->b_seek_reset )
+            {
+                /* Reset the decoders and clocks after a seek */
+                es_out_SetTime( p_ts->p_out, -1 );
+                p_ts->b_seek_reset = false;
+                i_buffering_date = -1;
+            }
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
             if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
@@ -1024,14 +1298,27 @@ static void *TsRun( void *p_data )
             vlc_restorecancel( canc );
         }
         i_deadline = cmd.i_date + p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay;
+        b_skip = cmd.i_date < p_ts->i_skip_date;
+        i_seek = p_ts->i_seek;
 
         vlc_cleanup_run();
 
         /* Regulate the speed of command processing to the same one than
-         * reading  */
+         * reading, unless a seek happens meanwhile */
         vlc_cleanup_push( (void (__cdecl *)(void *))cmd_cleanup_routine, &cmd );				// sunqueen modify
 
-        mwait( i_deadline );
+        if( !b_skip )
+        {
+            vlc_mutex_lock( &p_ts->lock );
+            mutex_cleanup_push( &p_ts->lock );
+
+            while( p_ts->i_seek == i_seek &&
+                   !vlc_cond_timedwait( &p_ts->wait, &p_ts->lock, i_deadline ) )
+                ;
+            b_skip = p_ts->i_seek != i_seek;
+
+            vlc_cleanup_run();
+        }
 
         vlc_cleanup_pop();
 
@@ -1044,7 +1331,8 @@ static void *TsRun( void *p_data )
             CmdCleanAdd( &cmd );
             break;
         case C_SEND:
-            CmdExecuteSend( p_ts->p_out, &cmd );
+            if( !b_skip )
+                CmdExecuteSend( p_ts->p_out, &cmd );
             CmdCleanSend( &cmd );
             break;
         case C_CONTROL:
@@ -1067,6 +1355,50 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
+static void TsStorageMap( ts_storage_t *p_storage )
+{
+    p_storage->p_map = NULL;
+#if defined(HAVE_MMAP)
+# ifdef HAVE_POSIX_FALLOCATE
+    /* Reserve the disk space, or writing to the mapping could fail later */
+    if( posix_fallocate( p_storage->fd, 0, p_storage->i_file_max ) )
+        return;
+# else
+    if( ftruncate( p_storage->fd, p_storage->i_file_max ) )
+        return;
+# endif
+    void *p_map = mmap( NULL, p_storage->i_file_max, PROT_READ|PROT_WRITE,
+                        MAP_SHARED, p_storage->fd, 0 );
+    if( p_map != MAP_FAILED )
+        p_storage->p_map = (uint8_t *)p_map;
+#elif defined(_WIN32)
+    /* The file is extended to the mapping size */
+    p_storage->h_map = CreateFileMapping( (HANDLE)_get_osfhandle( p_storage->fd ),
+                                          NULL, PAGE_READWRITE, 0,
+                                          (DWORD)p_storage->i_file_max, NULL );
+    if( !p_storage->h_map )
+        return;
+    p_storage->p_map = (uint8_t *)MapViewOfFile( p_storage->h_map, FILE_MAP_WRITE,
+                                                 0, 0, p_storage->i_file_max );
+    if( !p_storage->p_map )
+    {
+        CloseHandle( p_storage->h_map );
+        p_storage->h_map = NULL;
+    }
+#endif
+}
+static void TsStorageUnmap( ts_storage_t *p_storage )
+{
+    if( !p_storage->p_map )
+        return;
+#if defined(HAVE_MMAP)
+    munmap( p_storage->p_map, p_storage->i_file_max );
+#elif defined(_WIN32)
+    UnmapViewOfFile( p_storage->p_map );
+    CloseHandle( p_storage->h_map );
+#endif
+    p_storage->p_map = NULL;
+}
 static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
 {
     ts_storage_t *p_storage = (ts_storage_t *)calloc( 1, sizeof(ts_storage_t) );			// sunqueen modify
@@ -1079,40 +1411,52 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     /* */
     p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
-    p_storage->p_filew = GetTmpFile( &p_storage->psz_file, psz_tmp_path );
-    if( p_storage->psz_file )
-        p_storage->p_filer = vlc_fopen( p_storage->psz_file, "rb" );
+    p_storage->fd = GetTmpFile( &p_storage->psz_file, psz_tmp_path );
 
     /* */
     p_storage->i_cmd_w = 0;
     p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
+    p_storage->i_cmd_played = 0;
+    p_storage->i_cmd_max = TS_STORAGE_COMMAND_MAX;
     p_storage->p_cmd = (ts_cmd_t *)malloc( p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );			// sunqueen modify
     //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
-    if( !p_storage->p_cmd || !p_storage->p_filew || !p_storage->p_filer )
+    if( !p_storage->p_cmd || p_storage->fd < 0 )
     {
         TsStorageDelete( p_storage );
         return NULL;
     }
+
+    /* Without a mapping, the file is accessed with read/write */
+    TsStorageMap( p_storage );
     return p_storage;
 }
-static void TsStorageDelete( ts_storage_t *p_storage )
+static void TsStorageClean( ts_storage_t *p_storage )
 {
-    while( p_storage->i_cmd_r < p_storage->i_cmd_w )
-    {
-        ts_cmd_t cmd;
-
-        TsStoragePopCmd( p_storage, &cmd, true );
+    /* Only the commands not executed yet still own their data */
+    for( int i = p_storage->i_cmd_played; i < p_storage->i_cmd_w; i++ )
+        CmdClean( &p_storage->p_cmd[i] );
 
-        CmdClean( &cmd );
+    /* The storage owns the es_out_id_t deleted by its commands */
+    for( int i = 0; i < p_storage->i_cmd_w; i++ )
+    {
+        if( p_storage->p_cmd[i].i_type == C_DEL )
+            free( p_storage->p_cmd[i].u.del.p_es );
     }
+    p_storage->i_cmd_r = p_storage->i_cmd_w = p_storage->i_cmd_played = 0;
+    p_storage->i_key = 0;
+    p_storage->i_file_size = 0;
+}
+static void TsStorageDelete( ts_storage_t *p_storage )
+{
+    if( p_storage->p_cmd )
+        TsStorageClean( p_storage );
     free( p_storage->p_cmd );
+    free( p_storage->pi_key );
 
-    if( p_storage->p_filer )
-        fclose( p_storage->p_filer );
-    if( p_storage->p_filew )
-        fclose( p_storage->p_filew );
+    TsStorageUnmap( p_storage );
+    if( p_storage->fd >= 0 )
+        close( p_storage->fd );
 
     if( p_storage->psz_file )
     {
@@ -1122,6 +1466,21 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 
     free( p_storage );
 }
+static void TsStorageReset( ts_storage_t *p_storage )
+{
+    TsStorageClean( p_storage );
+
+    /* Undo TsStoragePack() */
+    if( p_storage->i_cmd_max < TS_STORAGE_COMMAND_MAX )
+    {
+        ts_cmd_t *p_new = (ts_cmd_t *)realloc( p_storage->p_cmd, TS_STORAGE_COMMAND_MAX * sizeof(*p_storage->p_cmd) );
+        if( p_new )
+        {
+            p_storage->p_cmd = p_new;
+            p_storage->i_cmd_max = TS_STORAGE_COMMAND_MAX;
+        }
+    }
+}
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
@@ -1136,11 +1495,11 @@ static void TsStoragePack( ts_storage_t *p_storage )
 }
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
+    if( p_cmd && p_cmd->i_type == C_SEND )
     {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+        size_t i_size = TS_BLOCK_SIZE( p_cmd->u.send.p_block->i_buffer );
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
+        if( p_storage->i_file_size + i_size > p_storage->i_file_max )
             return true;
     }
     return p_storage->i_cmd_w >= p_storage->i_cmd_max;
@@ -1149,7 +1508,100 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static int TsStorageWrite( ts_storage_t *p_storage, int64_t i_offset,
+                           const void *p_data, size_t i_data )
+{
+    if( i_offset + i_data > p_storage->i_file_max )
+        return VLC_EGENERIC;
+
+    if( p_storage->p_map )
+    {
+        memcpy( &p_storage->p_map[i_offset], p_data, i_data );
+        return VLC_SUCCESS;
+    }
+    if( lseek( p_storage->fd, i_offset, SEEK_SET ) != i_offset ||
+        write( p_storage->fd, p_data, i_data ) != (ssize_t)i_data )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+static int TsStorageRead( ts_storage_t *p_storage, int64_t i_offset,
+                          void *p_data, size_t i_data )
+{
+    if( i_offset + i_data > (uint64_t)p_storage->i_file_size )
+        return VLC_EGENERIC;
+
+    if( p_storage->p_map )
+    {
+        memcpy( p_data, &p_storage->p_map[i_offset], i_data );
+        return VLC_SUCCESS;
+    }
+    if( lseek( p_storage->fd, i_offset, SEEK_SET ) != i_offset ||
+        read( p_storage->fd, p_data, i_data ) != (ssize_t)i_data )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+/* Returns a pointer after the next 00 00 01 start code, or NULL */
+static const uint8_t *TsFindStartCode( const uint8_t *p, const uint8_t *p_end )
+{
+    for( p += 2; p < p_end; )
+    {
+        if( *p > 1 )
+            p += 3;
+        else if( *p == 0 )
+            p++;
+        else if( p[-1] == 0 && p[-2] == 0 )
+            return p + 1;
+        else
+            p += 3;
+    }
+    return NULL;
+}
+/* Few demuxers set BLOCK_FLAG_TYPE_I, so the key frames of the codecs most
+ * often timeshifted (broadcasts) are found in the data */
+static bool TsIsKeyFrame( vlc_fourcc_t i_codec, const block_t *p_block )
+{
+    if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+        return true;
+
+    const uint8_t *p = p_block->p_buffer;
+    const uint8_t *p_end = &p_block->p_buffer[p_block->i_buffer];
+
+    switch( i_codec )
+    {
+    case VLC_CODEC_H264:
+        /* An IDR slice (Annex B) */
+        while( (p = TsFindStartCode( p, p_end )) != NULL && p < p_end )
+        {
+            if( (p[0] & 0x1f) == 5 )
+                return true;
+        }
+        return false;
+    case VLC_CODEC_MPGV:
+        /* A picture header with picture_coding_type I */
+        while( (p = TsFindStartCode( p, p_end )) != NULL && p + 2 < p_end )
+        {
+            if( p[0] == 0x00 && ((p[2] >> 3) & 0x07) == 1 )
+                return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+static void TsStorageAddKey( ts_storage_t *p_storage, int i_cmd )
+{
+    if( p_storage->i_key >= p_storage->i_key_max )
+    {
+        const int i_max = __MAX( 2 * p_storage->i_key_max, 64 );
+        int *pi_new = (int *)realloc( p_storage->pi_key, i_max * sizeof(*pi_new) );
+        if( !pi_new )
+            return;
+        p_storage->pi_key = pi_new;
+        p_storage->i_key_max = i_max;
+    }
+    p_storage->pi_key[p_storage->i_key++] = i_cmd;
+}
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
@@ -1158,63 +1610,116 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
+        ts_block_header_t header;
+
+        header.i_pts        = p_block->i_pts;
+        header.i_dts        = p_block->i_dts;
+        header.i_length     = p_block->i_length;
+        header.i_flags      = p_block->i_flags;
+        header.i_nb_samples = p_block->i_nb_samples;
+        header.i_buffer     = p_block->i_buffer;
 
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_offset = p_storage->i_file_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        if( TsStorageWrite( p_storage, cmd.u.send.i_offset,
+                            &header, sizeof(header) ) ||
+            TsStorageWrite( p_storage, cmd.u.send.i_offset + sizeof(header),
+                            p_block->p_buffer, p_block->i_buffer ) )
         {
             block_Release( p_block );
             return;
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
-        block_Release( p_block );
+        p_storage->i_file_size += TS_BLOCK_SIZE( p_block->i_buffer );
 
-        if( b_flush )
-            fflush( p_storage->p_filew );
+        if( TsIsKeyFrame( cmd.u.send.p_es->i_codec, p_block ) )
+            TsStorageAddKey( p_storage, p_storage->i_cmd_w );
+        block_Release( p_block );
     }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+/* Returns false if the command is not to be executed again */
+static bool TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
+    const bool b_replay = p_storage->i_cmd_r < p_storage->i_cmd_played;
+
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+    if( !b_replay )
+        p_storage->i_cmd_played = p_storage->i_cmd_r;
+    else if( !CmdCanReplay( p_cmd ) )
+        return false;
+
     if( p_cmd->i_type == C_SEND )
     {
-        block_t block;
+        const int64_t i_offset = p_cmd->u.send.i_offset;
+        ts_block_header_t header;
+        block_t *p_block = NULL;
 
         if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+            !TsStorageRead( p_storage, i_offset, &header, sizeof(header) ) )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
+            p_block = block_Alloc( header.i_buffer );
+            if( p_block &&
+                TsStorageRead( p_storage, i_offset + sizeof(header),
+                               p_block->p_buffer, header.i_buffer ) )
             {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                block_Release( p_block );
+                p_block = NULL;
             }
-            p_cmd->u.send.p_block = p_block;
+        }
+        if( p_block )
+        {
+            p_block->i_dts      = header.i_dts;
+            p_block->i_pts      = header.i_pts;
+            p_block->i_flags    = header.i_flags;
+            p_block->i_length   = header.i_length;
+            p_block->i_nb_samples = header.i_nb_samples;
+        }
+        p_cmd->u.send.p_block = p_block;
+    }
+    return true;
+}
+/* Returns the last command not after i_date (the first one if none) */
+static int TsStorageFindCmd( ts_storage_t *p_storage, mtime_t i_date )
+{
+    int i_low = 0;
+    int i_high = p_storage->i_cmd_w - 1;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = (i_low + i_high + 1) / 2;
+
+        if( p_storage->p_cmd[i_mid].i_date <= i_date )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
+    }
+    return i_low;
+}
+/* Returns the last key frame command not after i_cmd, or -1 */
+static int TsStorageFindKey( ts_storage_t *p_storage, int i_cmd )
+{
+    int i_low = 0;
+    int i_high = p_storage->i_key - 1;
+    int i_key = -1;
+
+    while( i_low <= i_high )
+    {
+        const int i_mid = (i_low + i_high) / 2;
+
+        if( p_storage->pi_key[i_mid] <= i_cmd )
+        {
+            i_key = p_storage->pi_key[i_mid];
+            i_low = i_mid + 1;
         }
         else
         {
-            //fprintf( stderr, "TsStoragePopCmd: %m\n" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
+            i_high = i_mid - 1;
         }
     }
+    return i_key;
 }
 
 /*****************************************************************************
@@ -1241,6 +1746,28 @@ static void CmdClean( ts_cmd_t *p_cmd )
     }
 }
 
+/* Only the commands without allocated data may be executed again */
+static bool CmdCanReplay( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type == C_SEND )
+        return true;
+    if( p_cmd->i_type != C_CONTROL )
+        return false;
+
+    switch( p_cmd->u.control.i_query )
+    {
+    case ES_OUT_SET_PCR:
+    case ES_OUT_SET_GROUP_PCR:
+    case ES_OUT_RESET_PCR:
+    case ES_OUT_RESTART_BUFFERING:
+    case ES_OUT_SET_TIMES:
+    case ES_OUT_SET_JITTER:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static int CmdInitAdd( ts_cmd_t *p_cmd, es_out_id_t *p_es, const es_format_t *p_fmt, bool b_copy )
 {
     p_cmd->i_type = C_ADD;
@@ -1305,9 +1832,11 @@ static int CmdInitDel( ts_cmd_t *p_cmd, es_out_id_t *p_es )
 }
 static void CmdExecuteDel( es_out_t *p_out, ts_cmd_t *p_cmd )
 {
+    /* The es_out_id_t is freed by its owner: older commands kept for
+     * seeking back may still refer to it */
     if( p_cmd->u.del.p_es->p_es )
         es_out_Del( p_out, p_cmd->u.del.p_es->p_es );
-    free( p_cmd->u.del.p_es );
+    p_cmd->u.del.p_es->p_es = NULL;
 }
 
 static int CmdInitControl( ts_cmd_t *p_cmd, int i_query, va_list args, bool b_copy )
@@ -1327,6 +1856,7 @@ static int CmdInitControl( ts_cmd_t *p_cmd, int i_query, va_list args, bool b_co
 
     case ES_OUT_SET_PCR:                /* arg1=int64_t i_pcr(microsecond!) (using default group 0)*/
     case ES_OUT_SET_NEXT_DISPLAY_TIME:  /* arg1=int64_t i_pts(microsecond) */
+    case ES_OUT_RESTART_BUFFERING:      /* arg1=int64_t i_max(microsecond) */
         p_cmd->u.control.u.i_i64 = (int64_t)va_arg( args, int64_t );
         break;
 
@@ -1471,6 +2001,7 @@ static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
 
     case ES_OUT_SET_PCR:                /* arg1=int64_t i_pcr(microsecond!) (using default group 0)*/
     case ES_OUT_SET_NEXT_DISPLAY_TIME:  /* arg1=int64_t i_pts(microsecond) */
+    case ES_OUT_RESTART_BUFFERING:      /* arg1=int64_t i_max(microsecond) */
         return es_out_Control( p_out, i_query, p_cmd->u.control.u.i_i64 );
 
     case ES_OUT_SET_GROUP_PCR:          /* arg1= int i_group, arg2=int64_t i_pcr(microsecond!)*/
@@ -1600,29 +2131,17 @@ static char *GetTmpPath( char *psz_path )
     return psz_path;
 }
 
-static FILE *GetTmpFile( char **ppsz_file, const char *psz_path )
+static int GetTmpFile( char **ppsz_file, const char *psz_path )
 {
     char *psz_name;
-    int fd;
-    FILE *f;
 
     /* */
     *ppsz_file = NULL;
     if( asprintf( &psz_name, "%s/vlc-timeshift.XXXXXX", psz_path ) < 0 )
-        return NULL;
+        return -1;
 
     /* */
-    fd = vlc_mkstemp( psz_name );
     *ppsz_file = psz_name;
-
-    if( fd < 0 )
-        return NULL;
-
-    /* */
-    f = fdopen( fd, "w+b" );
-    if( !f )
-        close( fd );
-
-    return f;
+    return vlc_mkstemp( psz_name );
 }
 
@@ -464,7 +464,6 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
 
     /* */
     memset( &p_input->p->counters, 0, sizeof( p_input->p->counters ) );
-    vlc_mutex_init( &p_input->p->counters.counters_lock );
 
     p_input->p->p_es_out_display = input_EsOutNew( p_input, p_input->p->i_rate );
     p_input->p->p_es_out = NULL;
@@ -496,8 +495,6 @@ static void Destructor( input_thread_t * p_input )
 
     vlc_gc_decref( p_input->p->p_item );
 
-    vlc_mutex_destroy( &p_input->p->counters.counters_lock );
-
     for( int i = 0; i < p_input->p->i_control; i++ )
     {
         input_control_t *p_ctrl = &p_input->p->control[i];
@@ -851,9 +848,16 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( lost_abuffers, COUNTER );
         INIT_COUNTER( displayed_pictures, COUNTER );
         INIT_COUNTER( lost_pictures, COUNTER );
+        INIT_COUNTER( copied_pictures, COUNTER );
+        INIT_COUNTER( skipped_pictures, COUNTER );
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
+        INIT_COUNTER( decode_time, HISTOGRAM );
+        INIT_COUNTER( display_lateness, HISTOGRAM );
+        INIT_COUNTER( read_jitter, HISTOGRAM );
+        INIT_COUNTER( clock_latency, HISTOGRAM );
+        INIT_COUNTER( clock_jitter, HISTOGRAM );
         p_input->p->counters.p_sout_send_bitrate = NULL;
         p_input->p->counters.p_sout_sent_packets = NULL;
         p_input->p->counters.p_sout_sent_bytes = NULL;
@@ -1330,9 +1334,16 @@ error:
         EXIT_COUNTER( lost_abuffers );
         EXIT_COUNTER( displayed_pictures );
         EXIT_COUNTER( lost_pictures );
+        EXIT_COUNTER( copied_pictures );
+        EXIT_COUNTER( skipped_pictures );
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( decode_time );
+        EXIT_COUNTER( display_lateness );
+        EXIT_COUNTER( read_jitter );
+        EXIT_COUNTER( clock_latency );
+        EXIT_COUNTER( clock_jitter );
 
         if( p_input->p->p_sout )
         {
@@ -1403,9 +1414,16 @@ static void End( input_thread_t * p_input )
             CL_CO( lost_abuffers );
             CL_CO( displayed_pictures );
             CL_CO( lost_pictures );
+            CL_CO( copied_pictures );
+            CL_CO( skipped_pictures );
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
+            CL_CO( decode_time );
+            CL_CO( display_lateness );
+            CL_CO( read_jitter );
+            CL_CO( clock_latency );
+            CL_CO( clock_jitter );
         }
 
         /* Close optional stream output instance */
@@ -1723,6 +1741,15 @@ static bool Control( input_thread_t *p_input,
             if( i_time < 0 )
                 i_time = 0;
 
+            /* Live streams cannot seek, but their timeshift buffer may */
+            if( !p_input->p->b_can_pace_control &&
+                !es_out_SeekTimeshift( p_input->p->p_es_out,
+                                       i_time - var_GetTime( p_input, "time" ) ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_SetTime( p_input->p->p_es_out, -1 );
 
@@ -3190,7 +3217,6 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( p_input->p->i_state != INIT_S );
 
-    vlc_mutex_lock( &p_input->p->counters.counters_lock);
     switch( i_type )
     {
 #define I(c) stats_Update( p_input->p->counters.c, i_delta, NULL )
@@ -3219,7 +3245,6 @@ void input_UpdateStatistic( input_thread_t *p_input,
         msg_Err( p_input, "Invalid statistic type %d (internal error)", i_type );
         break;
     }
-    vlc_mutex_unlock( &p_input->p->counters.counters_lock);
 }
 
 /**/
@@ -154,7 +154,13 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
-        vlc_mutex_t counters_lock;
+        counter_t *p_copied_pictures;
+        counter_t *p_skipped_pictures;
+        counter_t *p_decode_time;
+        counter_t *p_display_lateness;
+        counter_t *p_read_jitter;
+        counter_t *p_clock_latency;
+        counter_t *p_clock_jitter;
     } counters;
 
     /* Buffer of pending actions */
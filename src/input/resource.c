@@ -195,6 +195,7 @@ static void DisplayVoutTitle( input_resource_t *p_resource,
 static vout_thread_t *RequestVout( input_resource_t *p_resource,
                                    vout_thread_t *p_vout,
                                    video_format_t *p_fmt, unsigned dpb_size,
+                                   const picture_layout_t *p_layout,
                                    bool b_recycle )
 {
     vlc_assert_locked( &p_resource->lock );
@@ -237,6 +238,7 @@ static vout_thread_t *RequestVout( input_resource_t *p_resource,
 /*            .change_fmt =*/ true,
 /*            .fmt        =*/ p_fmt,
 /*            .dpb_size   =*/ dpb_size,
+/*            .layout     =*/ p_layout,
 		// sunqueen modify end
         };
         p_vout = vout_Request( p_resource->p_parent, &cfg );
@@ -279,6 +281,7 @@ static vout_thread_t *RequestVout( input_resource_t *p_resource,
 /*                .change_fmt =*/ false,
 /*                .fmt        =*/ NULL,
 /*                .dpb_size   =*/ 0,
+/*                .layout     =*/ NULL,
 			// sunqueen modify end
             };
             p_resource->p_vout_free = vout_Request( p_resource->p_parent, &cfg );
@@ -467,10 +470,12 @@ void input_resource_SetInput( input_resource_t *p_resource, input_thread_t *p_in
 vout_thread_t *input_resource_RequestVout( input_resource_t *p_resource,
                                             vout_thread_t *p_vout,
                                             video_format_t *p_fmt, unsigned dpb_size,
+                                            const picture_layout_t *p_layout,
                                             bool b_recycle )
 {
     vlc_mutex_lock( &p_resource->lock );
-    vout_thread_t *p_ret = RequestVout( p_resource, p_vout, p_fmt, dpb_size, b_recycle );
+    vout_thread_t *p_ret = RequestVout( p_resource, p_vout, p_fmt, dpb_size,
+                                        p_layout, b_recycle );
     vlc_mutex_unlock( &p_resource->lock );
 
     return p_ret;
@@ -488,7 +493,7 @@ void input_resource_HoldVouts( input_resource_t *p_resource, vout_thread_t ***pp
 
 void input_resource_TerminateVout( input_resource_t *p_resource )
 {
-    input_resource_RequestVout( p_resource, NULL, NULL, 0, false );
+    input_resource_RequestVout( p_resource, NULL, NULL, 0, NULL, false );
 }
 bool input_resource_HasVout( input_resource_t *p_resource )
 {
@@ -25,6 +25,7 @@
 #define LIBVLC_INPUT_RESOURCE_H 1
 
 #include <vlc_common.h>
+#include <vlc_picture.h>
 
 /**
  * This function set the associated input.
@@ -49,7 +50,7 @@ void input_resource_PutAout( input_resource_t *, audio_output_t * );
 /**
  * This function handles vout request.
  */
-vout_thread_t *input_resource_RequestVout( input_resource_t *, vout_thread_t *, video_format_t *, unsigned dpb_size, bool b_recycle );
+vout_thread_t *input_resource_RequestVout( input_resource_t *, vout_thread_t *, video_format_t *, unsigned dpb_size, const picture_layout_t *, bool b_recycle );
 
 /**
  * This function returns one of the current vout if any.
@@ -27,44 +27,224 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include "input/input_internal.h"
 
+/* Number of samples kept by a STATS_DERIVATIVE counter (a power of two) */
+#define STATS_HISTORY 4
+
+/* Counters are written from several threads (input, decoders, sout) and read
+ * by the input thread. They are only ever updated with atomic operations, and
+ * each one is aligned to its own cache line so that threads updating
+ * different counters do not contend. */
+#define STATS_CACHE_LINE 64
+
+typedef struct
+{
+    atomic_uint           seq; /* odd while the sample is being written */
+    atomic_uint_least64_t value;
+    atomic_uint_least64_t date;
+} counter_ring_sample_t;
+
+struct counter_t
+{
+    int                   i_compute_type;
+    atomic_uint_least64_t value;
+
+    /* STATS_DERIVATIVE: the last samples, at least one second apart */
+    atomic_uint_least64_t last_update;
+    atomic_uint           i_samples; /* number of samples ever written */
+    counter_ring_sample_t samples[STATS_HISTORY];
+
+    /* STATS_HISTOGRAM */
+    atomic_uint_least64_t sum;
+    atomic_uint_least64_t buckets[STATS_HISTOGRAM_BUCKETS];
+};
+
 /**
  * Create a statistics counter
- * \param i_compute_type the aggregation type. One of STATS_LAST (always
- * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
+ * \param i_compute_type the aggregation type. One of STATS_COUNTER (increment
+ * by the passed value), STATS_DERIVATIVE (keep a time derivative of the
+ * value) or STATS_HISTOGRAM (distribution of the passed values)
  */
 counter_t * stats_CounterCreate( int i_compute_type )
 {
-    counter_t *p_counter = (counter_t*) malloc( sizeof( counter_t ) ) ;
+    size_t i_size = (sizeof( counter_t ) + STATS_CACHE_LINE - 1)
+                  & ~(size_t)(STATS_CACHE_LINE - 1);
+    counter_t *p_counter = (counter_t *)vlc_memalign( STATS_CACHE_LINE, i_size );
 
     if( !p_counter ) return NULL;
+    memset( p_counter, 0, i_size );
     p_counter->i_compute_type = i_compute_type;
-    p_counter->i_samples = 0;
-    p_counter->pp_samples = NULL;
-
-    p_counter->last_update = 0;
 
     return p_counter;
 }
 
-static inline int64_t stats_GetTotal(const counter_t *counter)
+void stats_CounterClean( counter_t *p_c )
+{
+    vlc_free( p_c );
+}
+
+static unsigned stats_HistogramBucket( uint64_t val )
 {
-    if (counter == NULL || counter->i_samples == 0)
-        return 0;
-    return counter->pp_samples[0]->value;
+    unsigned i_bucket = 0;
+
+    while( val != 0 && i_bucket < STATS_HISTOGRAM_BUCKETS - 1 )
+    {
+        val >>= 1;
+        i_bucket++;
+    }
+    return i_bucket;
+}
+
+/** Update a counter element with new values
+ * \param p_counter the counter to update
+ * \param val the new value to aggregate. For more information on how data
+ * is aggregated, \see stats_CounterCreate
+ * \param new_val a pointer that will be filled with the new total
+ * (STATS_COUNTER only)
+ */
+void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
+{
+    if( !p_counter )
+        return;
+
+    switch( p_counter->i_compute_type )
+    {
+    case STATS_DERIVATIVE:
+    {
+        mtime_t now = mdate();
+        uint_least64_t last = atomic_load( &p_counter->last_update );
+        if( now - (mtime_t)last < CLOCK_FREQ )
+            return;
+        /* Only one thread gets to record each sample */
+        if( !atomic_compare_exchange_strong( &p_counter->last_update, &last,
+                                             (uint_least64_t)now ) )
+            return;
+
+        unsigned i_sample = atomic_load( &p_counter->i_samples );
+        counter_ring_sample_t *p_sample =
+            &p_counter->samples[i_sample % STATS_HISTORY];
+
+        atomic_fetch_add( &p_sample->seq, 1u );
+        atomic_store( &p_sample->value, (uint_least64_t)val );
+        atomic_store( &p_sample->date, (uint_least64_t)now );
+        atomic_fetch_add( &p_sample->seq, 1u );
+        atomic_store( &p_counter->i_samples, i_sample + 1 );
+        break;
+    }
+    case STATS_COUNTER:
+    {
+        uint64_t total = atomic_fetch_add( &p_counter->value,
+                                           (uint_least64_t)val ) + val;
+        if( new_val )
+            *new_val = total;
+        break;
+    }
+    case STATS_HISTOGRAM:
+        atomic_fetch_add( &p_counter->buckets[stats_HistogramBucket( val )],
+                          (uint_least64_t)1 );
+        atomic_fetch_add( &p_counter->sum, (uint_least64_t)val );
+        break;
+    }
 }
 
-static inline float stats_GetRate(const counter_t *counter)
+/* Reads a consistent derivative sample, false if it was not written yet */
+static bool stats_ReadSample( counter_t *p_counter, unsigned i_sample,
+                              uint64_t *p_value, mtime_t *p_date )
 {
-    if (counter == NULL || counter->i_samples < 2)
-        return 0.;
+    counter_ring_sample_t *p_sample =
+        &p_counter->samples[i_sample % STATS_HISTORY];
+
+    for( ;; )
+    {
+        unsigned seq = atomic_load( &p_sample->seq );
+        if( seq == 0 )
+            return false;
+        if( seq & 1 ) /* being written right now, which is very short */
+            continue;
 
-    return (counter->pp_samples[0]->value - counter->pp_samples[1]->value)
-        / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
+        *p_value = atomic_load( &p_sample->value );
+        *p_date = atomic_load( &p_sample->date );
+        if( atomic_load( &p_sample->seq ) == seq )
+            return true;
+    }
+}
+
+/**
+ * Reads the current state of a counter without blocking its writers.
+ * Each value of the snapshot is consistent on its own; the number of
+ * samples of an histogram is that of its buckets.
+ */
+void stats_Snapshot( counter_t *p_counter, counter_snapshot_t *p_snap )
+{
+    memset( p_snap, 0, sizeof( *p_snap ) );
+    if( !p_counter )
+        return;
+
+    switch( p_counter->i_compute_type )
+    {
+    case STATS_DERIVATIVE:
+    {
+        unsigned i_samples = atomic_load( &p_counter->i_samples );
+        uint64_t value, prev_value;
+        mtime_t date, prev_date;
+
+        if( i_samples < 1
+         || !stats_ReadSample( p_counter, i_samples - 1, &value, &date ) )
+            break;
+        p_snap->value = value;
+        if( i_samples < 2
+         || !stats_ReadSample( p_counter, i_samples - 2, &prev_value, &prev_date )
+         || date <= prev_date )
+            break;
+        p_snap->rate = (value - prev_value) / (float)(date - prev_date);
+        break;
+    }
+    case STATS_COUNTER:
+        p_snap->value = atomic_load( &p_counter->value );
+        break;
+    case STATS_HISTOGRAM:
+        for( unsigned i = 0; i < STATS_HISTOGRAM_BUCKETS; i++ )
+        {
+            p_snap->buckets[i] = atomic_load( &p_counter->buckets[i] );
+            p_snap->value += p_snap->buckets[i];
+        }
+        p_snap->sum = atomic_load( &p_counter->sum );
+        break;
+    }
+}
+
+static inline int64_t stats_GetTotal(counter_t *counter)
+{
+    counter_snapshot_t snap;
+
+    stats_Snapshot(counter, &snap);
+    return snap.value;
+}
+
+static inline float stats_GetRate(counter_t *counter)
+{
+    counter_snapshot_t snap;
+
+    stats_Snapshot(counter, &snap);
+    return snap.rate;
+}
+
+static void stats_GetHistogram(counter_t *counter,
+                               input_stats_histogram_t *hist)
+{
+    counter_snapshot_t snap;
+
+    assert(INPUT_STATS_HISTOGRAM_BUCKETS == STATS_HISTOGRAM_BUCKETS);
+    stats_Snapshot(counter, &snap);
+    hist->i_count = snap.value;
+    hist->i_total = snap.sum;
+    for (unsigned i = 0; i < INPUT_STATS_HISTOGRAM_BUCKETS; i++)
+        hist->pi_buckets[i] = snap.buckets[i];
 }
 
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
@@ -80,12 +260,30 @@ input_stats_t *stats_NewInputStats( input_thread_t *p_input )
     return p_stats;
 }
 
+/**
+ * Publishes the input counters into the input item statistics.
+ * The counters are read without blocking their writers; the statistics lock
+ * only protects the published values, so the slower histogram snapshots are
+ * taken before acquiring it.
+ */
 void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
 {
     if (!libvlc_stats(input))
         return;
 
-    vlc_mutex_lock(&input->p->counters.counters_lock);
+    input_stats_histogram_t decode_time, display_lateness, read_jitter;
+    input_stats_histogram_t clock_latency, clock_jitter;
+
+    stats_GetHistogram(input->p->counters.p_decode_time, &decode_time);
+    stats_GetHistogram(input->p->counters.p_display_lateness, &display_lateness);
+    stats_GetHistogram(input->p->counters.p_read_jitter, &read_jitter);
+    stats_GetHistogram(input->p->counters.p_clock_latency, &clock_latency);
+    stats_GetHistogram(input->p->counters.p_clock_jitter, &clock_jitter);
+
+    /* The demux bitrate is sampled here rather than for each demuxed block */
+    stats_Update(input->p->counters.p_demux_bitrate,
+                 stats_GetTotal(input->p->counters.p_demux_read), NULL);
+
     vlc_mutex_lock(&st->lock);
 
     /* Input */
@@ -116,9 +314,17 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     /* Vouts */
     st->i_displayed_pictures = stats_GetTotal(input->p->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(input->p->counters.p_lost_pictures);
+    st->i_copied_pictures = stats_GetTotal(input->p->counters.p_copied_pictures);
+    st->i_skipped_pictures = stats_GetTotal(input->p->counters.p_skipped_pictures);
+
+    /* Latencies */
+    st->decode_time = decode_time;
+    st->display_lateness = display_lateness;
+    st->read_jitter = read_jitter;
+    st->clock_latency = clock_latency;
+    st->clock_jitter = clock_jitter;
 
     vlc_mutex_unlock(&st->lock);
-    vlc_mutex_unlock(&input->p->counters.counters_lock);
 }
 
 void stats_ReinitInputStats( input_stats_t *p_stats )
@@ -130,81 +336,15 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->f_demux_bitrate = p_stats->f_average_demux_bitrate =
     p_stats->i_demux_corrupted = p_stats->i_demux_discontinuity =
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
+    p_stats->i_copied_pictures = p_stats->i_skipped_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    memset( &p_stats->decode_time, 0, sizeof( p_stats->decode_time ) );
+    memset( &p_stats->display_lateness, 0, sizeof( p_stats->display_lateness ) );
+    memset( &p_stats->read_jitter, 0, sizeof( p_stats->read_jitter ) );
+    memset( &p_stats->clock_latency, 0, sizeof( p_stats->clock_latency ) );
+    memset( &p_stats->clock_jitter, 0, sizeof( p_stats->clock_jitter ) );
     vlc_mutex_unlock( &p_stats->lock );
 }
-
-void stats_CounterClean( counter_t *p_c )
-{
-    if( p_c )
-    {
-        int i = p_c->i_samples - 1 ;
-        while( i >= 0 )
-        {
-            counter_sample_t *p_s = p_c->pp_samples[i];
-            REMOVE_ELEM( (counter_sample_t **), p_c->pp_samples, p_c->i_samples, i );			// sunqueen modify
-            free( p_s );
-            i--;
-        }
-        free( p_c );
-    }
-}
-
-
-/** Update a counter element with new values
- * \param p_counter the counter to update
- * \param val the vlc_value union containing the new value to aggregate. For
- * more information on how data is aggregated, \see stats_Create
- * \param val_new a pointer that will be filled with new data
- */
-void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
-{
-    if( !p_counter )
-        return;
-
-    switch( p_counter->i_compute_type )
-    {
-    case STATS_DERIVATIVE:
-    {
-        counter_sample_t *p_new, *p_old;
-        mtime_t now = mdate();
-        if( now - p_counter->last_update < CLOCK_FREQ )
-            return;
-        p_counter->last_update = now;
-        /* Insert the new one at the beginning */
-        p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
-        p_new->value = val;
-        p_new->date = p_counter->last_update;
-        INSERT_ELEM( (counter_sample_t **), p_counter->pp_samples, p_counter->i_samples,
-                     0, p_new );			// sunqueen modify
-
-        if( p_counter->i_samples == 3 )
-        {
-            p_old = p_counter->pp_samples[2];
-            REMOVE_ELEM( (counter_sample_t **), p_counter->pp_samples, p_counter->i_samples, 2 );			// sunqueen modify
-            free( p_old );
-        }
-        break;
-    }
-    case STATS_COUNTER:
-        if( p_counter->i_samples == 0 )
-        {
-            counter_sample_t *p_new = (counter_sample_t*)malloc(
-                                               sizeof( counter_sample_t ) );
-            p_new->value = 0;
-
-            INSERT_ELEM( (counter_sample_t **), p_counter->pp_samples, p_counter->i_samples,
-                         p_counter->i_samples, p_new );			// sunqueen modify
-        }
-        if( p_counter->i_samples == 1 )
-        {
-            p_counter->pp_samples[0]->value += val;
-            if( new_val )
-                *new_val = p_counter->pp_samples[0]->value;
-        }
-        break;
-    }
-}
@@ -97,6 +97,11 @@
 #define STREAM_READ_ATONCE 1024
 #define STREAM_CACHE_TRACK_SIZE (STREAM_CACHE_SIZE/STREAM_CACHE_TRACK)
 
+/* Minimal size of the peek buffer. It then grows by powers of two, so that
+ * the demuxers probing with increasing sizes do not reallocate it each time.
+ */
+#define STREAM_PEEK_MIN 4096
+
 typedef struct
 {
     int64_t i_date;
@@ -161,6 +166,9 @@ struct stream_sys_t
     /* Peek temporary buffer */
     unsigned int i_peek;
     uint8_t *p_peek;
+    /* Data already copied in p_peek (block method) */
+    uint64_t i_peek_pos;
+    unsigned int i_peek_data;
 
     /* Stat for both method */
     struct
@@ -176,6 +184,10 @@ struct stream_sys_t
         unsigned i_seek_count;
         uint64_t i_seek_time;
 
+        /* Arrival of the access blocks, for the read jitter */
+        mtime_t i_block_date;
+        mtime_t i_block_interval;
+
     } stat;
 
     /* Streams list */
@@ -191,6 +203,7 @@ static int  AStreamPeekBlock( stream_t *s, const uint8_t **p_peek, unsigned int
 static int  AStreamSeekBlock( stream_t *s, uint64_t i_pos );
 static void AStreamPrebufferBlock( stream_t *s );
 static block_t *AReadBlock( stream_t *s, bool *pb_eof );
+static void AReadStatistic( stream_t *s, size_t i_read, bool b_block );
 
 /* Method 2 */
 static int  AStreamReadStream( stream_t *s, void *p_read, unsigned int i_read );
@@ -203,6 +216,7 @@ static int  AReadStream( stream_t *s, void *p_read, unsigned int i_read );
 static int AStreamControl( stream_t *s, int i_query, va_list );
 static void AStreamDestroy( stream_t *s );
 static int  ASeek( stream_t *s, uint64_t i_pos );
+static int  AStreamGrowPeek( stream_t *s, unsigned int i_read );
 
 /****************************************************************************
  * stream_CommonNew: create an empty stream structure
@@ -317,6 +331,8 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
     p_sys->stat.i_read_count = 0;
     p_sys->stat.i_seek_count = 0;
     p_sys->stat.i_seek_time = 0;
+    p_sys->stat.i_block_date = VLC_TS_INVALID;
+    p_sys->stat.i_block_interval = -1;
 
     TAB_INIT( p_sys->i_list, p_sys->list );
     p_sys->i_list_index = 0;
@@ -370,6 +386,8 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
     /* Peek */
     p_sys->i_peek = 0;
     p_sys->p_peek = NULL;
+    p_sys->i_peek_pos = 0;
+    p_sys->i_peek_data = 0;
 
     if( p_sys->method == STREAM_METHOD_BLOCK )
     {
@@ -493,6 +511,7 @@ static void AStreamControlReset( stream_t *s )
     stream_sys_t *p_sys = s->p_sys;
 
     p_sys->i_pos = p_sys->p_access->info.i_pos;
+    p_sys->i_peek_data = 0;
 
     if( p_sys->method == STREAM_METHOD_BLOCK )
     {
@@ -532,6 +551,31 @@ static void AStreamControlReset( stream_t *s )
     }
 }
 
+/****************************************************************************
+ * AStreamGrowPeek: make the peek buffer at least i_read bytes large
+ ****************************************************************************/
+static int AStreamGrowPeek( stream_t *s, unsigned int i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    unsigned int i_size = __MAX( p_sys->i_peek, STREAM_PEEK_MIN );
+
+    if( p_sys->i_peek >= i_read )
+        return VLC_SUCCESS;
+
+    while( i_size < i_read )
+        i_size *= 2;
+
+    p_sys->i_peek_data = 0;
+    p_sys->p_peek = (uint8_t *)realloc_or_free( p_sys->p_peek, i_size );
+    if( !p_sys->p_peek )
+    {
+        p_sys->i_peek = 0;
+        return VLC_ENOMEM;
+    }
+    p_sys->i_peek = i_size;
+    return VLC_SUCCESS;
+}
+
 /****************************************************************************
  * AStreamControlUpdate:
  ****************************************************************************/
@@ -799,18 +843,18 @@ static int AStreamPeekBlock( stream_t *s, const uint8_t **pp_peek, unsigned int
         return i_read;
     }
 
-    /* We need to create a local copy */
-    if( p_sys->i_peek < i_read )
+    /* The previous copy may be enough, as the demuxers probe from the
+     * same position */
+    if( p_sys->i_peek_pos == p_sys->i_pos && i_read <= p_sys->i_peek_data )
     {
-        p_sys->p_peek = (uint8_t *)realloc_or_free( p_sys->p_peek, i_read );			// sunqueen modify
-        if( !p_sys->p_peek )
-        {
-            p_sys->i_peek = 0;
-            return 0;
-        }
-        p_sys->i_peek = i_read;
+        *pp_peek = p_sys->p_peek;
+        return i_read;
     }
 
+    /* We need to create a local copy */
+    if( AStreamGrowPeek( s, i_read ) )
+        return 0;
+
     /* Fill enough data */
     while( p_sys->block.i_size - (p_sys->i_pos - p_sys->block.i_start)
            < i_read )
@@ -845,6 +889,9 @@ static int AStreamPeekBlock( stream_t *s, const uint8_t **pp_peek, unsigned int
         }
     }
 
+    p_sys->i_peek_pos = p_sys->i_pos;
+    p_sys->i_peek_data = i_data;
+
     *pp_peek = p_sys->p_peek;
     return i_data;
 }
@@ -856,6 +903,10 @@ static int AStreamSeekBlock( stream_t *s, uint64_t i_pos )
     int64_t    i_offset = i_pos - p_sys->block.i_start;
     bool b_seek;
 
+    /* The access may not give back the same data */
+    if( i_offset < 0 || (uint64_t)i_offset >= p_sys->block.i_size )
+        p_sys->i_peek_data = 0;
+
     /* We already have thoses data, just update p_current/i_offset */
     if( i_offset >= 0 && (uint64_t)i_offset < p_sys->block.i_size )
     {
@@ -1110,16 +1161,8 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
         return i_read;
     }
 
-    if( p_sys->i_peek < i_read )
-    {
-        p_sys->p_peek = (uint8_t *)realloc_or_free( p_sys->p_peek, i_read );			// sunqueen modify
-        if( !p_sys->p_peek )
-        {
-            p_sys->i_peek = 0;
-            return 0;
-        }
-        p_sys->i_peek = i_read;
-    }
+    if( AStreamGrowPeek( s, i_read ) )
+        return 0;
 
     memcpy( p_sys->p_peek, &tk->p_buffer[i_off],
             STREAM_CACHE_TRACK_SIZE - i_off );
@@ -1674,15 +1717,7 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
         i_read = p_access->pf_read( p_access, (uint8_t *)p_read, i_read );			// sunqueen modify
 
         if( p_input )
-        {
-            uint64_t total;
-
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
-            stats_Update( p_input->p->counters.p_read_bytes, i_read, &total );
-            stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-            stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-        }
+            AReadStatistic( s, i_read, false );
         return i_read;
     }
 
@@ -1713,15 +1748,7 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
 
     /* Update read bytes in input */
     if( p_input )
-    {
-        uint64_t total;
-
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-        stats_Update( p_input->p->counters.p_read_bytes, i_read, &total );
-        stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-        stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-    }
+        AReadStatistic( s, i_read, false );
     return i_read;
 }
 
@@ -1738,17 +1765,7 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
         p_block = p_access->pf_block( p_access );
         if( pb_eof ) *pb_eof = p_access->info.b_eof;
         if( p_input && p_block && libvlc_stats (p_access) )
-        {
-            uint64_t total;
-
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
-            stats_Update( p_input->p->counters.p_read_bytes,
-                          p_block->i_buffer, &total );
-            stats_Update( p_input->p->counters.p_input_bitrate,
-                          total, NULL );
-            stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-        }
+            AReadStatistic( s, p_block->i_buffer, true );
         return p_block;
     }
 
@@ -1779,18 +1796,39 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
     if( p_block )
     {
         if( p_input )
+            AReadStatistic( s, p_block->i_buffer, true );
+    }
+    return p_block;
+}
+
+static void AReadStatistic( stream_t *s, size_t i_read, bool b_block )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    input_thread_t *p_input = s->p_input;
+    uint64_t total;
+
+    stats_Update( p_input->p->counters.p_read_bytes, i_read, &total );
+    stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
+    stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
+
+    if( !b_block )
+        return;
+
+    /* The jitter is the variation of the interval between two blocks */
+    mtime_t i_date = mdate();
+    if( p_sys->stat.i_block_date > VLC_TS_INVALID )
+    {
+        mtime_t i_interval = i_date - p_sys->stat.i_block_date;
+
+        if( p_sys->stat.i_block_interval >= 0 )
         {
-            uint64_t total;
-
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
-            stats_Update( p_input->p->counters.p_read_bytes,
-                          p_block->i_buffer, &total );
-            stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-            stats_Update( p_input->p->counters.p_read_packets, 1 , NULL);
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+            mtime_t i_jitter = i_interval - p_sys->stat.i_block_interval;
+            stats_Update( p_input->p->counters.p_read_jitter,
+                          i_jitter < 0 ? -i_jitter : i_jitter, NULL );
         }
+        p_sys->stat.i_block_interval = i_interval;
     }
-    return p_block;
+    p_sys->stat.i_block_date = i_date;
 }
 
 static int ASeek( stream_t *s, uint64_t i_pos )
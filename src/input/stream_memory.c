@@ -35,7 +35,7 @@ struct stream_sys_t
     uint64_t    i_pos;      /* Current reading offset */
     uint64_t    i_size;
     uint8_t    *p_buffer;
-
+    block_t    *p_block;    /* Owner of p_buffer (stream_BlockNew) */
 };
 
 static int  Read   ( stream_t *, void *p_read, unsigned int i_read );
@@ -72,6 +72,7 @@ stream_t *stream_MemoryNew( vlc_object_t *p_this, uint8_t *p_buffer,
     p_sys->i_pos = 0;
     p_sys->i_size = i_size;
     p_sys->p_buffer = p_buffer;
+    p_sys->p_block = NULL;
     p_sys->i_preserve_memory = i_preserve_memory;
 
     s->pf_read    = Read;
@@ -83,8 +84,30 @@ stream_t *stream_MemoryNew( vlc_object_t *p_this, uint8_t *p_buffer,
     return s;
 }
 
+#undef stream_BlockNew
+/**
+ * Create a stream from a block, without copying its payload. This is
+ * meant for the files loaded with block_File, which are usually mapped.
+ *
+ * \param p_this the calling vlc_object
+ * \param p_block the block, released on stream_Delete (or on error)
+ */
+stream_t *stream_BlockNew( vlc_object_t *p_this, block_t *p_block )
+{
+    stream_t *s = stream_MemoryNew( p_this, p_block->p_buffer,
+                                    p_block->i_buffer, true );
+    if( !s )
+    {
+        block_Release( p_block );
+        return NULL;
+    }
+    s->p_sys->p_block = p_block;
+    return s;
+}
+
 static void Delete( stream_t *s )
 {
+    if( s->p_sys->p_block ) block_Release( s->p_sys->p_block );
     if( !s->p_sys->i_preserve_memory ) free( s->p_sys->p_buffer );
     free( s->p_sys );
     stream_CommonDelete( s );
@@ -95,19 +95,24 @@ static int InputEvent( vlc_object_t *p_this, char const *psz_cmd,
     vlm_t *p_vlm = libvlc_priv( p_input->p_libvlc )->p_vlm;
     assert( p_vlm );
     vlm_media_sys_t *p_media = (vlm_media_sys_t *)p_data;			// sunqueen modify
-    const char *psz_instance_name = NULL;
 
     if( newval.i_int == INPUT_EVENT_STATE )
     {
+        input_state_e i_state = (input_state_e)var_GetInteger( p_input, "state" );
+        bool b_sent = false;
+
+        /* A shared input is the input of every instance attached to it */
         for( int i = 0; i < p_media->i_instance; i++ )
         {
             if( p_media->instance[i]->p_input == p_input )
             {
-                psz_instance_name = p_media->instance[i]->psz_name;
-                break;
+                vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name,
+                                                 p_media->instance[i]->psz_name, i_state );
+                b_sent = true;
             }
         }
-        vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, (input_state_e)var_GetInteger( p_input, "state" ) );			// sunqueen modify
+        if( !b_sent )
+            vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, NULL, i_state );
 
         vlc_mutex_lock( &p_vlm->lock_manage );
         p_vlm->input_state_changed = true;
@@ -795,6 +800,7 @@ static int vlm_ControlMediaAdd( vlm_t *p_vlm, vlm_media_t *p_cfg, int64_t *p_id
 
     p_media->vod.p_media = NULL;
     TAB_INIT( p_media->i_instance, p_media->instance );
+    TAB_INIT( p_media->i_share, p_media->share );
 
     /* */
     TAB_APPEND( (vlm_media_sys_t **), p_vlm->i_media, p_vlm->media, p_media );			// sunqueen modify
@@ -896,6 +902,272 @@ static vlm_media_instance_sys_t *vlm_ControlMediaInstanceGetByName( vlm_media_sy
     }
     return NULL;
 }
+/*****************************************************************************
+ * Shared inputs:
+ *  With "vlm-share-window" set, an instance started less than that many
+ *  seconds after another instance of the same media (and input index) does
+ *  not open its own input. It gets a stream output of its own, fed by the
+ *  "fanout" stream output of the first instance's input instead, so the
+ *  media is read and demuxed only once. An instance that gets paused or
+ *  seeked leaves the share, and continues with an input of its own.
+ *****************************************************************************/
+static void *vlm_ShareEsAdd( sout_fanout_t *p_fanout, const es_format_t *p_fmt )
+{
+    vlm_media_share_t *p_share = (vlm_media_share_t *)p_fanout->p_sys;
+    vlm_share_es_t *p_es = (vlm_share_es_t *)malloc( sizeof( *p_es ) );
+    if( !p_es )
+        return NULL;
+
+    es_format_Copy( &p_es->fmt, p_fmt );
+    TAB_INIT( p_es->i_input, p_es->pp_input );
+
+    vlc_mutex_lock( &p_share->lock );
+    for( int i = 0; i < p_share->i_output; i++ )
+    {
+        sout_packetizer_input_t *p_input = sout_InputNew( p_share->output[i], &p_es->fmt );
+        TAB_APPEND( (sout_packetizer_input_t **), p_es->i_input, p_es->pp_input, p_input );
+    }
+    TAB_APPEND( (vlm_share_es_t **), p_share->i_es, p_share->es, p_es );
+    vlc_mutex_unlock( &p_share->lock );
+
+    return p_es;
+}
+
+static void vlm_ShareEsDel( sout_fanout_t *p_fanout, void *p_id )
+{
+    vlm_media_share_t *p_share = (vlm_media_share_t *)p_fanout->p_sys;
+    vlm_share_es_t *p_es = (vlm_share_es_t *)p_id;
+
+    vlc_mutex_lock( &p_share->lock );
+    TAB_REMOVE( p_share->i_es, p_share->es, p_es );
+    for( int i = 0; i < p_es->i_input; i++ )
+    {
+        if( p_es->pp_input[i] )
+            sout_InputDelete( p_es->pp_input[i] );
+    }
+    vlc_mutex_unlock( &p_share->lock );
+
+    TAB_CLEAN( p_es->i_input, p_es->pp_input );
+    es_format_Clean( &p_es->fmt );
+    free( p_es );
+}
+
+static int vlm_ShareEsSend( sout_fanout_t *p_fanout, void *p_id, block_t *p_buffer )
+{
+    vlm_media_share_t *p_share = (vlm_media_share_t *)p_fanout->p_sys;
+    vlm_share_es_t *p_es = (vlm_share_es_t *)p_id;
+
+    vlc_mutex_lock( &p_share->lock );
+    while( p_buffer )
+    {
+        block_t *p_next = p_buffer->p_next;
+        p_buffer->p_next = NULL;
+
+        /* The last output gets the original block */
+        int i_last = p_es->i_input - 1;
+        while( i_last >= 0 && !p_es->pp_input[i_last] )
+            i_last--;
+        for( int i = 0; i < i_last; i++ )
+        {
+            block_t *p_dup;
+            if( p_es->pp_input[i] && ( p_dup = block_Duplicate( p_buffer ) ) )
+                sout_InputSendBuffer( p_es->pp_input[i], p_dup );
+        }
+        if( i_last >= 0 )
+            sout_InputSendBuffer( p_es->pp_input[i_last], p_buffer );
+        else
+            block_Release( p_buffer );
+
+        p_buffer = p_next;
+    }
+    vlc_mutex_unlock( &p_share->lock );
+
+    return VLC_SUCCESS;
+}
+
+static vlm_media_share_t *vlm_MediaShareNew( vlm_t *p_vlm, vlm_media_sys_t *p_media, int i_index )
+{
+    vlm_media_t *p_cfg = &p_media->cfg;
+    vlm_media_share_t *p_share = (vlm_media_share_t *)calloc( 1, sizeof( *p_share ) );
+    if( !p_share )
+        return NULL;
+
+    p_share->i_index = i_index;
+    p_share->i_start = mdate();
+    p_share->i_ref = 0;
+    vlc_mutex_init( &p_share->lock );
+    TAB_INIT( p_share->i_es, p_share->es );
+    TAB_INIT( p_share->i_output, p_share->output );
+
+    p_share->fanout.p_sys = p_share;
+    p_share->fanout.pf_add = vlm_ShareEsAdd;
+    p_share->fanout.pf_del = vlm_ShareEsDel;
+    p_share->fanout.pf_send = vlm_ShareEsSend;
+
+    p_share->p_parent = (vlc_object_t *)vlc_object_create( p_vlm, sizeof (vlc_object_t) );
+    var_Create( p_share->p_parent, "sout-fanout", VLC_VAR_ADDRESS );
+    var_SetAddress( p_share->p_parent, "sout-fanout", &p_share->fanout );
+    p_share->p_input_resource = input_resource_New( p_share->p_parent );
+
+    p_share->p_item = input_item_New( NULL, NULL );
+    if( strstr( p_cfg->ppsz_input[i_index], "://" ) == NULL )
+    {
+        char *psz_uri = vlc_path2uri( p_cfg->ppsz_input[i_index], NULL );
+        input_item_SetURI( p_share->p_item, psz_uri );
+        free( psz_uri );
+    }
+    else
+        input_item_SetURI( p_share->p_item, p_cfg->ppsz_input[i_index] );
+
+    input_item_AddOption( p_share->p_item, "sout=#fanout", VLC_INPUT_OPTION_TRUSTED );
+    for( int i = 0; i < p_cfg->i_option; i++ )
+    {
+        if( strcmp( p_cfg->ppsz_option[i], "sout-keep" ) &&
+            strcmp( p_cfg->ppsz_option[i], "nosout-keep" ) &&
+            strcmp( p_cfg->ppsz_option[i], "no-sout-keep" ) )
+            input_item_AddOption( p_share->p_item, p_cfg->ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
+    }
+
+    char *psz_log;
+    if( asprintf( &psz_log, _("Media: %s (shared)"), p_cfg->psz_name ) != -1 )
+    {
+        p_share->p_input = input_Create( p_share->p_parent, p_share->p_item,
+                                         psz_log, p_share->p_input_resource );
+        free( psz_log );
+    }
+    if( p_share->p_input )
+    {
+        var_AddCallback( p_share->p_input, "intf-event", InputEvent, p_media );
+        if( input_Start( p_share->p_input ) != VLC_SUCCESS )
+        {
+            var_DelCallback( p_share->p_input, "intf-event", InputEvent, p_media );
+            vlc_object_release( p_share->p_input );
+            p_share->p_input = NULL;
+        }
+    }
+    if( !p_share->p_input )
+    {
+        input_resource_Release( p_share->p_input_resource );
+        vlc_object_release( p_share->p_parent );
+        vlc_gc_decref( p_share->p_item );
+        vlc_mutex_destroy( &p_share->lock );
+        free( p_share );
+        return NULL;
+    }
+
+    TAB_APPEND( (vlm_media_share_t **), p_media->i_share, p_media->share, p_share );
+    return p_share;
+}
+
+static void vlm_MediaShareDelete( vlm_media_sys_t *p_media, vlm_media_share_t *p_share )
+{
+    assert( p_share->i_ref == 0 && p_share->i_output == 0 );
+
+    input_Stop( p_share->p_input, true );
+    input_Join( p_share->p_input );
+    var_DelCallback( p_share->p_input, "intf-event", InputEvent, p_media );
+    input_Release( p_share->p_input );
+
+    /* This deletes the "fanout" stream output, and so every ES */
+    input_resource_Terminate( p_share->p_input_resource );
+    input_resource_Release( p_share->p_input_resource );
+    vlc_object_release( p_share->p_parent );
+    assert( p_share->i_es == 0 );
+
+    TAB_REMOVE( p_media->i_share, p_media->share, p_share );
+    vlc_gc_decref( p_share->p_item );
+    vlc_mutex_destroy( &p_share->lock );
+    free( p_share );
+}
+
+static int vlm_MediaShareAttach( vlm_t *p_vlm, vlm_media_sys_t *p_media, vlm_media_instance_sys_t *p_instance )
+{
+    int i_window = var_InheritInteger( p_vlm, "vlm-share-window" );
+    if( i_window <= 0 || p_instance->b_no_share || !p_instance->psz_sout )
+        return VLC_EGENERIC;
+
+    /* Find a recent enough input, or start one */
+    vlm_media_share_t *p_share = NULL;
+    for( int i = 0; i < p_media->i_share; i++ )
+    {
+        vlm_media_share_t *p = p_media->share[i];
+        if( p->i_index == p_instance->i_index &&
+            !p->p_input->b_eof && !p->p_input->b_error &&
+            mdate() - p->i_start <= (mtime_t)i_window * CLOCK_FREQ )
+        {
+            p_share = p;
+            break;
+        }
+    }
+    if( !p_share )
+    {
+        p_share = vlm_MediaShareNew( p_vlm, p_media, p_instance->i_index );
+        if( !p_share )
+            return VLC_EGENERIC;
+    }
+
+    /* The options of the media apply to the stream output of the instance */
+    for( int i = 0; i < p_media->cfg.i_option; i++ )
+        var_OptionParse( p_instance->p_parent, p_media->cfg.ppsz_option[i], true );
+
+    sout_instance_t *p_sout = sout_NewInstance( p_instance->p_parent, p_instance->psz_sout );
+    if( !p_sout )
+    {
+        if( p_share->i_ref == 0 )
+            vlm_MediaShareDelete( p_media, p_share );
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_lock( &p_share->lock );
+    for( int i = 0; i < p_share->i_es; i++ )
+    {
+        vlm_share_es_t *p_es = p_share->es[i];
+        sout_packetizer_input_t *p_input = sout_InputNew( p_sout, &p_es->fmt );
+        TAB_APPEND( (sout_packetizer_input_t **), p_es->i_input, p_es->pp_input, p_input );
+    }
+    TAB_APPEND( (sout_instance_t **), p_share->i_output, p_share->output, p_sout );
+    vlc_mutex_unlock( &p_share->lock );
+
+    p_share->i_ref++;
+    p_instance->p_share = p_share;
+    p_instance->p_share_sout = p_sout;
+    p_instance->p_input = p_share->p_input;
+    vlc_object_hold( p_instance->p_input );
+
+    msg_Dbg( p_vlm, "instance of media `%s' shares an input (%d instances)",
+             p_media->cfg.psz_name, p_share->i_ref );
+    return VLC_SUCCESS;
+}
+
+static void vlm_MediaShareDetach( vlm_media_sys_t *p_media, vlm_media_instance_sys_t *p_instance )
+{
+    vlm_media_share_t *p_share = p_instance->p_share;
+    sout_instance_t *p_sout = p_instance->p_share_sout;
+
+    vlc_mutex_lock( &p_share->lock );
+    int i_output;
+    TAB_FIND( p_share->i_output, p_share->output, p_sout, i_output );
+    assert( i_output >= 0 );
+    for( int i = 0; i < p_share->i_es; i++ )
+    {
+        vlm_share_es_t *p_es = p_share->es[i];
+        if( p_es->pp_input[i_output] )
+            sout_InputDelete( p_es->pp_input[i_output] );
+        REMOVE_ELEM( (sout_packetizer_input_t **), p_es->pp_input, p_es->i_input, i_output );
+    }
+    REMOVE_ELEM( (sout_instance_t **), p_share->output, p_share->i_output, i_output );
+    vlc_mutex_unlock( &p_share->lock );
+
+    sout_DeleteInstance( p_sout );
+    vlc_object_release( p_instance->p_input );
+    p_instance->p_input = NULL;
+    p_instance->p_share = NULL;
+    p_instance->p_share_sout = NULL;
+
+    if( --p_share->i_ref == 0 )
+        vlm_MediaShareDelete( p_media, p_share );
+}
+
 static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_t *p_vlm, const char *psz_name )
 {
     vlm_media_instance_sys_t *p_instance = (vlm_media_instance_sys_t *)calloc( 1, sizeof(vlm_media_instance_sys_t) );			// sunqueen modify
@@ -919,7 +1191,12 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_t *p_vlm, const char
 static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
 {
     input_thread_t *p_input = p_instance->p_input;
-    if( p_input )
+    if( p_instance->p_share )
+    {
+        vlm_MediaShareDetach( p_media, p_instance );
+        vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
+    }
+    else if( p_input )
     {
         input_Stop( p_input, true );
         input_Join( p_input );
@@ -934,16 +1211,35 @@ static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instanc
 
     TAB_REMOVE( p_media->i_instance, p_media->instance, p_instance );
     vlc_gc_decref( p_instance->p_item );
+    free( p_instance->psz_sout );
     free( p_instance->psz_name );
     free( p_instance );
 }
 
 
+static int vlm_MediaInstanceStartInput( vlm_t *, int64_t, vlm_media_sys_t *, vlm_media_instance_sys_t * );
+
+/* The last "program" option of a media, or 0 */
+static int vlm_MediaProgram( const vlm_media_t *p_cfg )
+{
+    int i_program = 0;
+
+    for( int i = 0; i < p_cfg->i_option; i++ )
+    {
+        const char *psz_option = p_cfg->ppsz_option[i];
+
+        if( *psz_option == ':' )
+            psz_option++;
+        if( !strncmp( psz_option, "program=", 8 ) )
+            i_program = atoi( &psz_option[8] );
+    }
+    return i_program;
+}
+
 static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *psz_id, int i_input_index, const char *psz_vod_output )
 {
     vlm_media_sys_t *p_media = vlm_ControlMediaGetById( p_vlm, id );
     vlm_media_instance_sys_t *p_instance;
-    char *psz_log;
 
     if( !p_media || !p_media->cfg.b_enabled || p_media->cfg.i_input <= 0 )
         return VLC_EGENERIC;
@@ -978,10 +1274,12 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         if( p_cfg->psz_output != NULL || psz_vod_output != NULL )
         {
             char *psz_buffer;
-            if( asprintf( &psz_buffer, "sout=%s%s%s",
+            if( asprintf( &p_instance->psz_sout, "%s%s%s",
                       p_cfg->psz_output ? p_cfg->psz_output : "",
                       (p_cfg->psz_output && psz_vod_output) ? ":" : psz_vod_output ? "#" : "",
-                      psz_vod_output ? psz_vod_output : "" ) != -1 )
+                      psz_vod_output ? psz_vod_output : "" ) == -1 )
+                p_instance->psz_sout = NULL;
+            else if( asprintf( &psz_buffer, "sout=%s", p_instance->psz_sout ) != -1 )
             {
                 input_item_AddOption( p_instance->p_item, psz_buffer, VLC_INPUT_OPTION_TRUSTED );
                 free( psz_buffer );
@@ -1009,24 +1307,53 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         {
             if( var_GetInteger( p_input, "state" ) == PAUSE_S )
                 var_SetInteger( p_input, "state",  PLAYING_S );
+
+            /* A program changed with "setup <media> option program=<n>" is
+             * selected on the running input: re-creating it would lose the
+             * state of the demuxer, like the cached programs of the TS fast
+             * channel change. A shared input is left alone. */
+            const int i_program = vlm_MediaProgram( &p_media->cfg );
+            if( !p_instance->p_share && i_program > 0 &&
+                var_GetInteger( p_input, "program" ) != i_program )
+                var_SetInteger( p_input, "program", i_program );
             return VLC_SUCCESS;
         }
 
 
-        input_Stop( p_input, true );
-        input_Join( p_input );
-        var_DelCallback( p_instance->p_input, "intf-event", InputEvent, p_media );
-        input_Release( p_input );
-
-        if( !p_instance->b_sout_keep )
-            input_resource_TerminateSout( p_instance->p_input_resource );
-        input_resource_TerminateVout( p_instance->p_input_resource );
+        if( p_instance->p_share )
+        {
+            vlm_MediaShareDetach( p_media, p_instance );
+        }
+        else
+        {
+            input_Stop( p_input, true );
+            input_Join( p_input );
+            var_DelCallback( p_instance->p_input, "intf-event", InputEvent, p_media );
+            input_Release( p_input );
+
+            if( !p_instance->b_sout_keep )
+                input_resource_TerminateSout( p_instance->p_input_resource );
+            input_resource_TerminateVout( p_instance->p_input_resource );
+        }
 
         vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
     }
 
     /* Start new one */
     p_instance->i_index = i_input_index;
+    if( vlm_MediaShareAttach( p_vlm, p_media, p_instance ) == VLC_SUCCESS )
+    {
+        vlm_SendEventMediaInstanceStarted( p_vlm, id, p_media->cfg.psz_name );
+        return VLC_SUCCESS;
+    }
+    vlm_MediaInstanceStartInput( p_vlm, id, p_media, p_instance );
+    return VLC_SUCCESS;
+}
+
+static int vlm_MediaInstanceStartInput( vlm_t *p_vlm, int64_t id, vlm_media_sys_t *p_media, vlm_media_instance_sys_t *p_instance )
+{
+    char *psz_log;
+
     if( strstr( p_media->cfg.ppsz_input[p_instance->i_index], "://" ) == NULL )
     {
         char *psz_uri = vlc_path2uri(
@@ -1054,17 +1381,34 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
             }
         }
 
-        if( !p_instance->p_input )
-        {
-            vlm_MediaInstanceDelete( p_vlm, id, p_instance, p_media );
-        }
-        else
-        {
-            vlm_SendEventMediaInstanceStarted( p_vlm, id, p_media->cfg.psz_name );
-        }
         free( psz_log );
     }
 
+    if( !p_instance->p_input )
+    {
+        vlm_MediaInstanceDelete( p_vlm, id, p_instance, p_media );
+        return VLC_EGENERIC;
+    }
+
+    vlm_SendEventMediaInstanceStarted( p_vlm, id, p_media->cfg.psz_name );
+    return VLC_SUCCESS;
+}
+
+/* Give an instance that shares its input an input of its own, at the same
+ * position (on error, the instance is deleted) */
+static int vlm_MediaInstanceUnshare( vlm_t *p_vlm, int64_t id, vlm_media_sys_t *p_media, vlm_media_instance_sys_t *p_instance )
+{
+    int64_t i_time = var_GetTime( p_instance->p_input, "time" );
+
+    msg_Dbg( p_vlm, "instance of media `%s' leaves its shared input",
+             p_media->cfg.psz_name );
+    vlm_MediaShareDetach( p_media, p_instance );
+    p_instance->b_no_share = true;
+
+    if( vlm_MediaInstanceStartInput( p_vlm, id, p_media, p_instance ) )
+        return VLC_EGENERIC;
+    if( i_time > 0 )
+        var_SetTime( p_instance->p_input, "time", i_time );
     return VLC_SUCCESS;
 }
 
@@ -1097,6 +1441,15 @@ static int vlm_ControlMediaInstancePause( vlm_t *p_vlm, int64_t id, const char *
     if( !p_instance || !p_instance->p_input )
         return VLC_EGENERIC;
 
+    /* A shared input is never paused: pause an input of the instance's own */
+    if( p_instance->p_share )
+    {
+        if( vlm_MediaInstanceUnshare( p_vlm, id, p_media, p_instance ) )
+            return VLC_EGENERIC;
+        var_SetInteger( p_instance->p_input, "state", PAUSE_S );
+        return VLC_SUCCESS;
+    }
+
     /* Toggle pause state */
     i_state = var_GetInteger( p_instance->p_input, "state" );
     if( i_state == PAUSE_S && !p_media->cfg.b_vod )
@@ -1135,6 +1488,20 @@ static int vlm_ControlMediaInstanceSetTimePosition( vlm_t *p_vlm, int64_t id, co
     if( !p_instance || !p_instance->p_input )
         return VLC_EGENERIC;
 
+    if( p_instance->p_share )
+    {
+        /* Seeking (back) to about where the shared input is, e.g. to the
+         * start of a VoD session that just joined it, needs no input of
+         * its own */
+        mtime_t i_window = var_InheritInteger( p_vlm, "vlm-share-window" ) * CLOCK_FREQ;
+        int64_t i_shared_time = var_GetTime( p_instance->p_input, "time" );
+        if( i_time >= 0 && i_time <= i_shared_time && i_shared_time - i_time <= i_window )
+            return VLC_SUCCESS;
+
+        if( vlm_MediaInstanceUnshare( p_vlm, id, p_media, p_instance ) )
+            return VLC_EGENERIC;
+    }
+
     if( i_time >= 0 )
         return var_SetTime( p_instance->p_input, "time", i_time );
     else if( d_position >= 0 && d_position <= 100 )
@@ -25,9 +25,46 @@
 #define LIBVLC_VLM_INTERNAL_H 1
 
 #include <vlc_vlm.h>
+#include <vlc_sout.h>
 #include "input_interface.h"
 
 /* Private */
+
+/* An input shared by the instances of a media that were started within
+ * "vlm-share-window" seconds of each other: it is demuxed once, and its
+ * streams are fanned out to the stream output of each instance. */
+typedef struct
+{
+    es_format_t fmt;
+
+    /* one sout input per output of the share (same order) */
+    int i_input;
+    sout_packetizer_input_t **pp_input;
+} vlm_share_es_t;
+
+typedef struct
+{
+    /* "playlist" index */
+    int i_index;
+    mtime_t i_start;
+
+    /* number of instances using the input */
+    int i_ref;
+
+    vlc_object_t *p_parent;
+    input_item_t      *p_item;
+    input_thread_t    *p_input;
+    input_resource_t *p_input_resource;
+
+    /* fan-out (called by the "fanout" stream output of the input) */
+    sout_fanout_t fanout;
+    vlc_mutex_t lock;
+    int i_es;
+    vlm_share_es_t **es;
+    int i_output;
+    sout_instance_t **output;
+} vlm_media_share_t;
+
 typedef struct
 {
     /* instance name */
@@ -43,6 +80,13 @@ typedef struct
     input_thread_t    *p_input;
     input_resource_t *p_input_resource;
 
+    /* stream output chain, and its instance if p_input is shared */
+    char *psz_sout;
+    vlm_media_share_t *p_share;
+    sout_instance_t *p_share_sout;
+    /* the instance was paused or seeked: it needs an input of its own */
+    bool b_no_share;
+
 } vlm_media_instance_sys_t;
 
 
@@ -59,6 +103,10 @@ typedef struct
     /* actual input instances */
     int                      i_instance;
     vlm_media_instance_sys_t **instance;
+
+    /* inputs shared by several instances */
+    int                i_share;
+    vlm_media_share_t  **share;
 } vlm_media_sys_t;
 
 typedef struct
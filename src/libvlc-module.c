@@ -388,6 +388,11 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define FILTER_THREADS_TEXT N_("Video filter threads")
+#define FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads used by the video filters which process " \
+    "pictures in parallel slices (0 = one per CPU)." )
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -532,6 +537,18 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define LOW_LATENCY_TEXT N_("Low latency live playback")
+#define LOW_LATENCY_LONGTEXT N_( \
+    "When playing a live source, slowly reduce the caching down to the " \
+    "measured jitter of the stream clock plus the minimal latency below. " \
+    "The playback gets slightly faster meanwhile, the audio being " \
+    "resampled to follow." )
+
+#define LATENCY_MIN_TEXT N_("Minimal latency (ms)")
+#define LATENCY_MIN_LONGTEXT N_( \
+    "Caching kept in low latency mode in addition to the jitter, in " \
+    "milliseconds. It must cover the decoding and output delays." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -679,6 +696,11 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_WINDOW_TEXT N_("Timeshift window")
+#define INPUT_TIMESHIFT_WINDOW_LONGTEXT N_( \
+    "Amount of already played data (in MiB) kept in the timeshift " \
+    "buffer, so that live streams can be seeked back. 0 disables it." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -902,6 +924,11 @@ static const char *const ppsz_prefres[] = {
     "before trying the other ones. Only advanced users should " \
     "alter this option as it can break playback of all your streams." )
 
+#define DECODER_THREADS_TEXT N_("Shared decoder threads")
+#define DECODER_THREADS_LONGTEXT N_( \
+    "Number of threads shared by the subtitle decoders and the " \
+    "packetizers of the stream output (0 = one thread per decoder)." )
+
 #define ENCODER_TEXT N_("Preferred encoders list")
 #define ENCODER_LONGTEXT N_( \
     "This allows you to select a list of encoders that VLC will use in " \
@@ -1036,6 +1063,13 @@ static const char *const ppsz_prefres[] = {
 #define VLM_CONF_LONGTEXT N_( \
     "Read a VLM configuration file as soon as VLM is started." )
 
+#define VLM_SHARE_WINDOW_TEXT N_("Shared input window (seconds)")
+#define VLM_SHARE_WINDOW_LONGTEXT N_( \
+    "Instances of the same VLM media (e.g. VoD sessions) that start within " \
+    "this many seconds of each other share a single input, which is read " \
+    "and demuxed only once. An instance that is paused or seeked gets an " \
+    "input of its own again. 0 disables sharing." )
+
 #define PLUGINS_CACHE_TEXT N_("Use a plugins cache")
 #define PLUGINS_CACHE_LONGTEXT N_( \
     "Use a plugins cache which will greatly improve the startup time of VLC.")
@@ -1626,6 +1660,8 @@ vlc_module_begin ()
                 VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
     add_module_list( "video-splitter", "video splitter", NULL,
                      VIDEO_SPLITTER_TEXT, VIDEO_SPLITTER_LONGTEXT, false )
+    add_integer( "filter-threads", 0, FILTER_THREADS_TEXT,
+                 FILTER_THREADS_LONGTEXT, true )
     add_obsolete_string( "vout-filter" ) /* since 2.0.0 */
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -1854,6 +1890,13 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_bool( "clock-low-latency", false, LOW_LATENCY_TEXT,
+              LOW_LATENCY_LONGTEXT, true )
+        change_safe()
+    add_integer( "clock-latency-min", 100, LATENCY_MIN_TEXT,
+                 LATENCY_MIN_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -1867,6 +1910,8 @@ vlc_module_begin ()
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-window", 0, INPUT_TIMESHIFT_WINDOW_TEXT,
+                 INPUT_TIMESHIFT_WINDOW_LONGTEXT, true )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -1874,6 +1919,8 @@ vlc_module_begin ()
     add_category_hint( N_("Decoders"), CODEC_CAT_LONGTEXT , true )
     add_string( "codec", NULL, CODEC_TEXT,
                 CODEC_LONGTEXT, true )
+    add_integer( "decoder-threads", 0, DECODER_THREADS_TEXT,
+                 DECODER_THREADS_LONGTEXT, true )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
 
@@ -1917,6 +1964,8 @@ vlc_module_begin ()
     set_section( N_("VLM"), NULL )
     add_loadfile( "vlm-conf", NULL, VLM_CONF_TEXT,
                     VLM_CONF_LONGTEXT, true )
+    add_integer( "vlm-share-window", 0, VLM_SHARE_WINDOW_TEXT,
+                 VLM_SHARE_WINDOW_LONGTEXT, true )
 
 
 
@@ -113,6 +113,9 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->p_playlist = NULL;
     priv->p_dialog_provider = NULL;
     priv->p_vlm = NULL;
+    priv->slices = NULL;
+    priv->demux_hints = NULL;
+    priv->decoder_pool = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -364,6 +367,18 @@ dbus_out:
 
     priv->b_stats = var_InheritBool( p_libvlc, "stats" );
 
+    /* Threads for the slice-parallel video filters (started on first use) */
+    int i_filter_threads = var_InheritInteger( p_libvlc, "filter-threads" );
+    priv->slices = vlc_slices_New( i_filter_threads > 0 ? i_filter_threads
+                                                        : vlc_GetCPUCount() );
+
+    priv->demux_hints = demux_HintsNew( VLC_OBJECT(p_libvlc) );
+
+    /* Threads shared by the decoders (started on first use) */
+    int i_decoder_threads = var_InheritInteger( p_libvlc, "decoder-threads" );
+    if( i_decoder_threads > 0 )
+        priv->decoder_pool = decoder_pool_New( i_decoder_threads );
+
     /*
      * Initialize hotkey handling
      */
@@ -552,6 +567,24 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( p_playlist != NULL )
         playlist_Destroy( p_playlist );
 
+    if( priv->slices != NULL )
+    {
+        vlc_slices_Delete( priv->slices );
+        priv->slices = NULL;
+    }
+
+    if( priv->demux_hints != NULL )
+    {
+        demux_HintsDelete( priv->demux_hints );
+        priv->demux_hints = NULL;
+    }
+
+    if( priv->decoder_pool != NULL )
+    {
+        decoder_pool_Delete( priv->decoder_pool );
+        priv->decoder_pool = NULL;
+    }
+
     msg_Dbg( p_libvlc, "removing stats" );
 
 #if !defined( _WIN32 ) && !defined( __OS2__ )
@@ -173,6 +173,15 @@ typedef struct libvlc_priv_t
 
     /* Exit callback */
     vlc_exit_t       exit;
+
+    /* Threads running the slice-parallel jobs */
+    struct vlc_slices_t *slices;
+
+    /* Demuxers that opened recently */
+    struct demux_hints_t *demux_hints;
+
+    /* Threads shared by the decoders (NULL if disabled) */
+    struct decoder_pool_t *decoder_pool;
 } libvlc_priv_t;
 
 static inline libvlc_priv_t *libvlc_priv (libvlc_int_t *libvlc)
@@ -180,6 +189,27 @@ static inline libvlc_priv_t *libvlc_priv (libvlc_int_t *libvlc)
     return (libvlc_priv_t *)libvlc;
 }
 
+/*
+ * Slice-parallel jobs
+ */
+typedef struct vlc_slices_t vlc_slices_t;
+vlc_slices_t *vlc_slices_New( unsigned i_threads );
+void vlc_slices_Delete( vlc_slices_t * );
+
+/*
+ * Demux probing hints
+ */
+typedef struct demux_hints_t demux_hints_t;
+demux_hints_t *demux_HintsNew( vlc_object_t * );
+void demux_HintsDelete( demux_hints_t * );
+
+/*
+ * Shared decoder threads
+ */
+typedef struct decoder_pool_t decoder_pool_t;
+decoder_pool_t *decoder_pool_New( unsigned i_threads );
+void decoder_pool_Delete( decoder_pool_t * );
+
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 void intf_DestroyAll( libvlc_int_t * );
 
@@ -197,22 +227,21 @@ enum
 {
     STATS_COUNTER,
     STATS_DERIVATIVE,
+    STATS_HISTOGRAM,
 };
 
-typedef struct counter_sample_t
-{
-    uint64_t value;
-    mtime_t  date;
-} counter_sample_t;
+/** Number of power-of-two buckets of a STATS_HISTOGRAM counter */
+#define STATS_HISTOGRAM_BUCKETS 24
 
-typedef struct counter_t
-{
-    int                 i_compute_type;
-    int                 i_samples;
-    counter_sample_t ** pp_samples;
+typedef struct counter_t counter_t;
 
-    mtime_t             last_update;
-} counter_t;
+typedef struct counter_snapshot_t
+{
+    uint64_t value; /**< total, or number of samples for a histogram */
+    float    rate;  /**< per microsecond, for a derivative */
+    uint64_t sum;   /**< sum of the samples, for a histogram */
+    uint64_t buckets[STATS_HISTOGRAM_BUCKETS]; /**< for a histogram */
+} counter_snapshot_t;
 
 enum
 {
@@ -239,6 +268,7 @@ enum
 
 counter_t * stats_CounterCreate (int);
 void stats_Update (counter_t *, uint64_t, uint64_t *);
+void stats_Snapshot (counter_t *, counter_snapshot_t *);
 void stats_CounterClean (counter_t * );
 
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
@@ -41,6 +41,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
 // sunqueen add start
 #include <io.h>
 
@@ -104,6 +105,7 @@ void block_Init( block_t *__restrict b, void *buf, size_t size )			// sunqueen m
 #ifndef NDEBUG
     b->pf_release = BlockNoRelease;
 #endif
+    b->p_payload = NULL;
 }
 
 static void block_generic_Release (block_t *block)
@@ -157,6 +159,108 @@ block_t *block_Alloc (size_t size)
     return b;
 }
 
+/**
+ * Payload shared by several blocks. The block which allocated it (origin)
+ * is kept until the last block is released, even if it was released
+ * first, as the payload may live in the same allocation.
+ */
+typedef struct block_payload_t block_payload_t;
+struct block_payload_t
+{
+    atomic_uint  refs;
+    block_t      *p_origin;
+    block_free_t pf_release; /**< Release callback of the origin */
+};
+
+static bool BlockIsShared( block_t *p_block )
+{
+    return p_block->p_payload != NULL &&
+           atomic_load( &p_block->p_payload->refs ) > 1;
+}
+
+static void block_shared_Release( block_t *p_block )
+{
+    block_payload_t *p_payload = p_block->p_payload;
+    block_t *p_origin = p_payload->p_origin;
+    const bool b_last =
+        atomic_fetch_sub( &p_payload->refs, (atomic_uint)1 ) == 1;
+
+    if( p_block != p_origin )
+        free( p_block );
+    if( !b_last )
+        return;
+
+    p_origin->pf_release = p_payload->pf_release;
+    p_origin->p_payload = NULL;
+    free( p_payload );
+    block_Release( p_origin );
+}
+
+/**
+ * Creates a block referencing the payload of another one, without copying
+ * it. Both blocks then have their own properties (dates, flags, payload
+ * start and length), and the payload must not be written anymore but
+ * through block_Unshare() or block_Realloc().
+ *
+ * @return NULL in case of error, or a new block to release with
+ * block_Release().
+ */
+block_t *block_Share( block_t *p_block )
+{
+    block_Check( p_block );
+
+    block_payload_t *p_payload = p_block->p_payload;
+    if( p_payload == NULL )
+    {
+        p_payload = (block_payload_t *)malloc( sizeof( *p_payload ) );
+        if( unlikely(p_payload == NULL) )
+            return NULL;
+        atomic_init( &p_payload->refs, 1 );
+        p_payload->p_origin = p_block;
+        p_payload->pf_release = p_block->pf_release;
+
+        p_block->pf_release = block_shared_Release;
+        p_block->p_payload = p_payload;
+    }
+
+    block_t *p_share = (block_t *)malloc( sizeof( *p_share ) );
+    if( unlikely(p_share == NULL) )
+        return NULL;
+
+    block_Init( p_share, p_block->p_start, p_block->i_size );
+    p_share->p_buffer = p_block->p_buffer;
+    p_share->i_buffer = p_block->i_buffer;
+    block_CopyProperties( p_share, p_block );
+    p_share->pf_release = block_shared_Release;
+    p_share->p_payload = p_payload;
+    atomic_fetch_add( &p_payload->refs, (atomic_uint)1 );
+    return p_share;
+}
+
+/**
+ * Makes the payload of a block writable: it is copied if it is shared with
+ * other blocks (see block_Share()).
+ *
+ * @return the block, a copy of it (the block is then released), or NULL
+ * in case of error (the block is then released too).
+ */
+block_t *block_Unshare( block_t *p_block )
+{
+    block_Check( p_block );
+
+    if( !BlockIsShared( p_block ) )
+        return p_block;
+
+    block_t *p_copy = block_Alloc( p_block->i_buffer );
+    if( likely(p_copy != NULL) )
+    {
+        BlockMetaCopy( p_copy, p_block );
+        memcpy( p_copy->p_buffer, p_block->p_buffer, p_block->i_buffer );
+    }
+    block_Release( p_block );
+    return p_copy;
+}
+
 block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
 {
     size_t requested = i_prebody + i_body;
@@ -179,7 +283,7 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
          p_block->i_buffer = 0; /* discard current payload */
     if( p_block->i_buffer == 0 )
     {
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !BlockIsShared( p_block ) )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -214,11 +318,14 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
     uint8_t *p_start = p_block->p_start;
     uint8_t *p_end = p_start + p_block->i_size;
 
-    /* Second, reallocate the buffer if we lack space. This is done now to
-     * minimize the payload size for memory copy. */
+    /* Second, reallocate the buffer if we lack space, or if the payload is
+     * shared and grows. This is done now to minimize the payload size for
+     * memory copy. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || ( ( i_prebody > 0 || i_body > p_block->i_buffer )
+          && BlockIsShared( p_block ) ) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea )
@@ -400,6 +507,43 @@ block_t *block_shm_Alloc (void *addr, size_t length)
 #ifdef _WIN32
 # include <io.h>
 
+static void block_view_Release (block_t *block)
+{
+    block_Invalidate (block);
+    UnmapViewOfFile (block->p_start);
+    free (block);
+}
+
+/* Maps a file copy-on-write, like mmap() with MAP_PRIVATE */
+static block_t *block_view_Alloc (int fd, size_t length)
+{
+    HANDLE handle = (HANDLE)(intptr_t)_get_osfhandle (fd);
+    if (handle == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    HANDLE mapping = CreateFileMapping (handle, NULL, PAGE_WRITECOPY,
+                                        0, 0, NULL);
+    if (mapping == NULL)
+        return NULL;
+
+    /* The view keeps a reference to the mapping */
+    void *addr = MapViewOfFile (mapping, FILE_MAP_COPY, 0, 0, length);
+    CloseHandle (mapping);
+    if (addr == NULL)
+        return NULL;
+
+    block_t *block = (block_t *)malloc (sizeof (*block));
+    if (block == NULL)
+    {
+        UnmapViewOfFile (addr);
+        return NULL;
+    }
+
+    block_Init (block, addr, length);
+    block->pf_release = block_view_Release;
+    return block;
+}
+
 static
 ssize_t pread (int fd, void *buf, size_t count, off_t offset)
 {
@@ -418,10 +562,19 @@ ssize_t pread (int fd, void *buf, size_t count, off_t offset)
 }
 #endif
 
+/** Files smaller than this are read rather than mapped: copying them costs
+ * less than setting up the mapping and taking the page faults. */
+#define BLOCK_FILE_MAP_MIN (64 * 1024)
+/** Start of a mapped file that is paged in ahead of time. Large files are
+ * left to the sequential read-ahead instead of being read in full at once. */
+#define BLOCK_FILE_PREFETCH (1024 * 1024)
+
 /**
  * Loads a file into a block of memory through a file descriptor.
- * If possible a private file mapping is created. Otherwise, the file is read
- * normally. This function is a cancellation point.
+ * If possible a private file mapping is created, so that the file is not
+ * copied unless the block is written to. Small files, and files which
+ * cannot be mapped (e.g. on special file systems), are read normally.
+ * This function is a cancellation point.
  *
  * @note On 32-bits platforms,
  * this function will not work for very large files,
@@ -466,13 +619,28 @@ block_t *block_File (int fd)
     length = (size_t)st.st_size;
 
 #ifdef HAVE_MMAP
-    if (length > 0)
+    if (length >= BLOCK_FILE_MAP_MIN)
     {
         void *addr;
 
         addr = mmap (NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
         if (addr != MAP_FAILED)
+        {
+# ifdef POSIX_MADV_SEQUENTIAL
+            /* The whole file is usually read once, from the start */
+            posix_madvise (addr, length, POSIX_MADV_SEQUENTIAL);
+            posix_madvise (addr, __MIN(length, BLOCK_FILE_PREFETCH),
+                           POSIX_MADV_WILLNEED);
+# endif
             return block_mmap_Alloc (addr, length);
+        }
+    }
+#elif defined(_WIN32)
+    if (length >= BLOCK_FILE_MAP_MIN)
+    {
+        block_t *block = block_view_Alloc (fd, length);
+        if (block != NULL)
+            return block;
     }
 #endif
 
@@ -647,6 +815,27 @@ size_t block_FifoPut( block_fifo_t *p_fifo, block_t *p_block )
     return i_size;
 }
 
+/* Unlink the first block of a non-empty FIFO. The lock must be held. */
+static block_t *FifoUnlinkFirst( block_fifo_t *p_fifo )
+{
+    block_t *b = p_fifo->p_first;
+
+    p_fifo->p_first = b->p_next;
+    p_fifo->i_depth--;
+    p_fifo->i_size -= b->i_buffer;
+
+    if( p_fifo->p_first == NULL )
+    {
+        p_fifo->pp_last = &p_fifo->p_first;
+    }
+
+    /* We don't know how many threads can queue new packets now. */
+    vlc_cond_broadcast( &p_fifo->wait_room );
+
+    b->p_next = NULL;
+    return b;
+}
+
 void block_FifoWake( block_fifo_t *p_fifo )
 {
     vlc_mutex_lock( &p_fifo->lock );
@@ -687,20 +876,25 @@ block_t *block_FifoGet( block_fifo_t *p_fifo )
         return NULL;
     }
 
-    p_fifo->p_first = b->p_next;
-    p_fifo->i_depth--;
-    p_fifo->i_size -= b->i_buffer;
+    b = FifoUnlinkFirst( p_fifo );
+    vlc_mutex_unlock( &p_fifo->lock );
+    return b;
+}
 
-    if( p_fifo->p_first == NULL )
-    {
-        p_fifo->pp_last = &p_fifo->p_first;
-    }
+/**
+ * Dequeue the first block from the FIFO without waiting. It is not a
+ * cancellation point.
+ *
+ * @return a valid block, or NULL if the FIFO is empty.
+ */
+block_t *block_FifoTryGet( block_fifo_t *p_fifo )
+{
+    block_t *b = NULL;
 
-    /* We don't know how many threads can queue new packets now. */
-    vlc_cond_broadcast( &p_fifo->wait_room );
+    vlc_mutex_lock( &p_fifo->lock );
+    if( p_fifo->p_first != NULL )
+        b = FifoUnlinkFirst( p_fifo );
     vlc_mutex_unlock( &p_fifo->lock );
-
-    b->p_next = NULL;
     return b;
 }
 
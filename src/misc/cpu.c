@@ -131,6 +131,53 @@ static void Altivec_test (void)
 #endif
 #endif
 
+#if defined (__i386__) || defined (__x86_64__)
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  include <immintrin.h>
+# else
+#  include <cpuid.h>
+# endif
+
+/**
+ * Checks whether the OS saves the AVX registers, then whether the CPU has
+ * the AVX2 instructions (which need the CPUID leaf 7).
+ * _xgetbv() needs Visual C++ 2010 SP1.
+ */
+static uint32_t vlc_CPU_AVX_init (unsigned max_level, unsigned ecx1)
+{
+    unsigned xcr0, ebx7;
+
+    /* OSXSAVE and AVX */
+    if ((ecx1 & 0x18000000) != 0x18000000)
+        return 0;
+# if defined (_MSC_VER) && _MSC_FULL_VER < 160040219
+    return 0;
+# elif defined (_MSC_VER)
+    xcr0 = (unsigned)_xgetbv (0);
+# else
+    __asm__ ("xgetbv" : "=a" (xcr0) : "c" (0) : "edx");
+# endif
+    /* XMM and YMM states */
+    if ((xcr0 & 6) != 6)
+        return 0;
+    if (max_level < 7)
+        return VLC_CPU_AVX;
+
+# ifdef _MSC_VER
+    int regs[4];
+    __cpuidex (regs, 7, 0);
+    ebx7 = regs[1];
+# else
+    unsigned eax7, ecx7, edx7;
+    __cpuid_count (7, 0, eax7, ebx7, ecx7, edx7);
+# endif
+    if (ebx7 & 0x00000020)
+        return VLC_CPU_AVX | VLC_CPU_AVX2;
+    return VLC_CPU_AVX;
+}
+#endif
+
 /**
  * Determines the CPU capabilities and stores them in cpu_flags.
  * The result can be retrieved with vlc_CPU().
@@ -141,6 +188,7 @@ void vlc_CPU_init (void)
 
 #if defined( __i386__ ) || defined( __x86_64__ )
      unsigned int i_eax, i_ebx, i_ecx, i_edx;
+     unsigned int i_max_level;
      bool b_amd;
 
 // sunqueen delete start
@@ -196,6 +244,7 @@ void vlc_CPU_init (void)
     /* the CPU supports the CPUID instruction - get its level */
 //    cpuid( 0x00000000 );
     cover_cpuid(0x00000000, &i_eax, &i_ebx, &i_ecx, &i_edx);			// sunqueen modify
+    i_max_level = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -235,6 +284,7 @@ void vlc_CPU_init (void)
             i_capabilities |= VLC_CPU_SSE4_1;
         if (i_ecx & 0x00100000)
             i_capabilities |= VLC_CPU_SSE4_2;
+        i_capabilities |= vlc_CPU_AVX_init (i_max_level, i_ecx);
     }
 
     /* test for additional capabilities */
@@ -320,7 +370,7 @@ void vlc_CPU_dump (vlc_object_t *obj)
     if (vlc_CPU_SSE4_2()) p += sprintf (p, "SSE4.2 ");
     if (vlc_CPU_SSE4A()) p += sprintf (p, "SSE4A ");
     if (vlc_CPU_AVX()) p += sprintf (p, "AVX ");
-    if (vlc_CPU_AVX2()) p += sprintf (p, "AVX ");
+    if (vlc_CPU_AVX2()) p += sprintf (p, "AVX2 ");
     if (vlc_CPU_3dNOW()) p += sprintf (p, "3DNow! ");
     if (vlc_CPU_XOP()) p += sprintf (p, "XOP ");
     if (vlc_CPU_FMA4()) p += sprintf (p, "FMA4 ");
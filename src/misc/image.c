@@ -46,6 +46,7 @@
 #include <vlc_image.h>
 #include <vlc_stream.h>
 #include <vlc_fs.h>
+#include <vlc_url.h>
 #include <vlc_sout.h>
 #include <libvlc.h>
 #include <vlc_modules.h>
@@ -226,35 +227,47 @@ static picture_t *ImageReadUrl( image_handler_t *p_image, const char *psz_url,
                                 video_format_t *p_fmt_in,
                                 video_format_t *p_fmt_out )
 {
-    block_t *p_block;
+    block_t *p_block = NULL;
     picture_t *p_pic;
     stream_t *p_stream = NULL;
     int i_size;
 
-    p_stream = stream_UrlNew( p_image->p_parent, psz_url );
-
-    if( !p_stream )
+    /* Local files are mapped (see block_File) rather than read */
+    char *psz_path = strstr( psz_url, "://" ) ? make_path( psz_url )
+                                               : strdup( psz_url );
+    if( psz_path )
     {
-        msg_Dbg( p_image->p_parent, "could not open %s for reading",
-                 psz_url );
-        return NULL;
+        p_block = block_FilePath( psz_path );
+        free( psz_path );
     }
 
-    i_size = stream_Size( p_stream );
+    if( !p_block )
+    {
+        p_stream = stream_UrlNew( p_image->p_parent, psz_url );
+
+        if( !p_stream )
+        {
+            msg_Dbg( p_image->p_parent, "could not open %s for reading",
+                     psz_url );
+            return NULL;
+        }
+
+        i_size = stream_Size( p_stream );
 
-    p_block = block_Alloc( i_size );
+        p_block = block_Alloc( i_size );
 
-    stream_Read( p_stream, p_block->p_buffer, i_size );
+        stream_Read( p_stream, p_block->p_buffer, i_size );
 
-    if( !p_fmt_in->i_chroma )
-    {
-        char *psz_mime = NULL;
-        stream_Control( p_stream, STREAM_GET_CONTENT_TYPE, &psz_mime );
-        if( psz_mime )
-            p_fmt_in->i_chroma = image_Mime2Fourcc( psz_mime );
-        free( psz_mime );
+        if( !p_fmt_in->i_chroma )
+        {
+            char *psz_mime = NULL;
+            stream_Control( p_stream, STREAM_GET_CONTENT_TYPE, &psz_mime );
+            if( psz_mime )
+                p_fmt_in->i_chroma = image_Mime2Fourcc( psz_mime );
+            free( psz_mime );
+        }
+        stream_Delete( p_stream );
     }
-    stream_Delete( p_stream );
 
     if( !p_fmt_in->i_chroma )
     {
@@ -50,10 +50,6 @@
 
 #include "variables.h"
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
-
 #ifdef __OS2__
 # include <sys/socket.h>
 # include <netinet/in.h>
@@ -73,7 +69,6 @@
 # include <unistd.h>
 #endif
 
-#include <cover_search.h>			// sunqueen add
 #include <limits.h>
 #include <assert.h>
 
@@ -132,7 +127,11 @@ void *vlc_custom_create (vlc_object_t *parent, size_t length,
     if (unlikely(priv == NULL))
         return NULL;
     priv->psz_name = NULL;
-    priv->var_root = NULL;
+    priv->var_table = NULL;
+    priv->var_count = 0;
+    priv->var_mask = 0;
+    atomic_init (&priv->var_generation, 0);
+    memset (priv->var_inherit, 0, sizeof (priv->var_inherit));
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     priv->pipes[0] = priv->pipes[1] = -1;
@@ -578,13 +577,8 @@ vlc_list_t *vlc_list_children( vlc_object_t *obj )
     return l;
 }
 
-static void DumpVariable (const void *data, const VISIT which, const int depth)
+static void DumpVariable (const variable_t *p_var)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *p_var = *(const variable_t **)data;
     const char *psz_type = "unknown";
 
     switch( p_var->i_type & VLC_VAR_TYPE )
@@ -684,10 +678,13 @@ static int DumpCommand( vlc_object_t *p_this, char const *psz_cmd,
 
         PrintObject( vlc_internals(p_object), "" );
         vlc_mutex_lock( &vlc_internals( p_object )->var_lock );
-        if( vlc_internals( p_object )->var_root == NULL )
+        vlc_object_internals_t *p_priv = vlc_internals( p_object );
+        if( p_priv->var_count == 0 )
             puts( " `-o No variables" );
         else
-            cover_twalk( vlc_internals( p_object )->var_root, DumpVariable );			// sunqueen modify
+            for( unsigned i = 0; i <= p_priv->var_mask; i++ )
+                if( p_priv->var_table[i] != NULL )
+                    DumpVariable( p_priv->var_table[i] );
         vlc_mutex_unlock( &vlc_internals( p_object )->var_lock );
     }
     libvlc_unlock (p_this->p_libvlc);
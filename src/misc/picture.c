@@ -48,7 +48,7 @@
  * used exactly like a video buffer. The video output thread then manages
  * how it gets displayed.
  */
-static int AllocatePicture( picture_t *p_pic )
+static int AllocatePicture( picture_t *p_pic, unsigned i_align )
 {
     /* Calculate how big the new image should be */
     size_t i_bytes = 0;
@@ -65,7 +65,7 @@ static int AllocatePicture( picture_t *p_pic )
         i_bytes += p->i_pitch * p->i_lines;
     }
 
-    uint8_t *p_data = (uint8_t *)vlc_memalign( 16, i_bytes );			// sunqueen modify
+    uint8_t *p_data = (uint8_t *)vlc_memalign( i_align, i_bytes );			// sunqueen modify
     if( !p_data )
     {
         p_pic->i_planes = 0;
@@ -118,8 +118,20 @@ static int LCM( int a, int b )
     return a * b / GCD( a, b );
 }
 
-int picture_Setup( picture_t *p_picture, vlc_fourcc_t i_chroma,
-                   int i_width, int i_height, int i_sar_num, int i_sar_den )
+/* Returns the alignment of the planes for a layout: at least 16 bytes */
+static unsigned LayoutAlign( const picture_layout_t *p_layout )
+{
+    unsigned i_align = 16;
+
+    if( p_layout )
+        while( i_align < p_layout->i_align )
+            i_align <<= 1;
+    return i_align;
+}
+
+static int PictureSetup( picture_t *p_picture, vlc_fourcc_t i_chroma,
+                         int i_width, int i_height, int i_sar_num, int i_sar_den,
+                         const picture_layout_t *p_layout )
 {
     /* Store default values */
     p_picture->i_planes = 0;
@@ -149,21 +161,32 @@ int picture_Setup( picture_t *p_picture, vlc_fourcc_t i_chroma,
         (V * p_dsc->p[i].w.i_num/p_dsc->p[i].w.i_den * p_dsc->i_pixel_size) % 16 == 0
        Which is respected if you have
        V % lcm( p_dsc->p[0..planes].w.i_den * 16) == 0
+       16 is replaced by the alignment of the layout if it is larger.
     */
+    const int i_align = LayoutAlign( p_layout );
     int i_modulo_w = 1;
     int i_modulo_h = 1;
     unsigned int i_ratio_h  = 1;
     for( unsigned i = 0; i < p_dsc->plane_count; i++ )
     {
-        i_modulo_w = LCM( i_modulo_w, 16 * p_dsc->p[i].w.den );
+        i_modulo_w = LCM( i_modulo_w, i_align * p_dsc->p[i].w.den );
         i_modulo_h = LCM( i_modulo_h, 16 * p_dsc->p[i].h.den );
         if( i_ratio_h < p_dsc->p[i].h.den )
             i_ratio_h = p_dsc->p[i].h.den;
     }
     i_modulo_h = LCM( i_modulo_h, 32 );
 
-    const int i_width_aligned  = ( i_width  + i_modulo_w - 1 ) / i_modulo_w * i_modulo_w;
-    const int i_height_aligned = ( i_height + i_modulo_h - 1 ) / i_modulo_h * i_modulo_h;
+    /* The margins required by the layout */
+    int i_width_min  = i_width;
+    int i_height_min = i_height;
+    if( p_layout )
+    {
+        i_width_min  = __MAX( i_width_min, (int)p_layout->i_width );
+        i_height_min = __MAX( i_height_min, (int)p_layout->i_height );
+    }
+
+    const int i_width_aligned  = ( i_width_min  + i_modulo_w - 1 ) / i_modulo_w * i_modulo_w;
+    const int i_height_aligned = ( i_height_min + i_modulo_h - 1 ) / i_modulo_h * i_modulo_h;
     const int i_height_extra   = 2 * i_ratio_h; /* This one is a hack for some ASM functions */
     for( unsigned i = 0; i < p_dsc->plane_count; i++ )
     {
@@ -182,10 +205,19 @@ int picture_Setup( picture_t *p_picture, vlc_fourcc_t i_chroma,
     return VLC_SUCCESS;
 }
 
+int picture_Setup( picture_t *p_picture, vlc_fourcc_t i_chroma,
+                   int i_width, int i_height, int i_sar_num, int i_sar_den )
+{
+    return PictureSetup( p_picture, i_chroma, i_width, i_height,
+                         i_sar_num, i_sar_den, NULL );
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
-picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_resource_t *p_resource )
+static picture_t *PictureNew( const video_format_t *p_fmt,
+                              const picture_resource_t *p_resource,
+                              const picture_layout_t *p_layout )
 {
     video_format_t fmt = *p_fmt;
 
@@ -205,8 +237,8 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
         return NULL;
 
     /* Make sure the real dimensions are a multiple of 16 */
-    if( picture_Setup( p_picture, fmt.i_chroma, fmt.i_width, fmt.i_height,
-                       fmt.i_sar_num, fmt.i_sar_den ) )
+    if( PictureSetup( p_picture, fmt.i_chroma, fmt.i_width, fmt.i_height,
+                      fmt.i_sar_num, fmt.i_sar_den, p_layout ) )
     {
         free( p_picture );
         return NULL;
@@ -226,7 +258,7 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
     }
     else
     {
-        if( AllocatePicture( p_picture ) )
+        if( AllocatePicture( p_picture, LayoutAlign( p_layout ) ) )
         {
             free( p_picture );
             return NULL;
@@ -241,9 +273,46 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
 
     return p_picture;
 }
+picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_resource_t *p_resource )
+{
+    return PictureNew( p_fmt, p_resource, NULL );
+}
 picture_t *picture_NewFromFormat( const video_format_t *p_fmt )
 {
-    return picture_NewFromResource( p_fmt, NULL );
+    return PictureNew( p_fmt, NULL, NULL );
+}
+picture_t *picture_NewFromLayout( const video_format_t *p_fmt, const picture_layout_t *p_layout )
+{
+    return PictureNew( p_fmt, NULL, p_layout );
+}
+
+bool picture_HasLayout( const picture_t *p_picture, const picture_layout_t *p_layout )
+{
+    if( !p_layout )
+        return true;
+
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_picture->format.i_chroma );
+    if( !p_dsc || p_dsc->plane_count != (unsigned)p_picture->i_planes )
+        return false;
+
+    for( int i = 0; i < p_picture->i_planes; i++ )
+    {
+        const plane_t *p = &p_picture->p[i];
+
+        if( p_layout->i_align > 1 &&
+            ( p->i_pitch % p_layout->i_align ||
+              (uintptr_t)p->p_pixels % p_layout->i_align ) )
+            return false;
+
+        /* The margins are in luma samples */
+        if( (int64_t)p->i_pitch * p_dsc->p[i].w.den <
+            (int64_t)p_layout->i_width * p_dsc->p[i].w.num * p->i_pixel_pitch ||
+            (int64_t)p->i_lines * p_dsc->p[i].h.den <
+            (int64_t)p_layout->i_height * p_dsc->p[i].h.num )
+            return false;
+    }
+    return true;
 }
 picture_t *picture_New( vlc_fourcc_t i_chroma, int i_width, int i_height, int i_sar_num, int i_sar_den )
 {
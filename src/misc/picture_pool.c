@@ -134,6 +134,13 @@ picture_pool_t *picture_pool_New(int picture_count, picture_t *picture[])
 }
 
 picture_pool_t *picture_pool_NewFromFormat(const video_format_t *fmt, int picture_count)
+{
+    return picture_pool_NewFromLayout(fmt, NULL, picture_count);
+}
+
+picture_pool_t *picture_pool_NewFromLayout(const video_format_t *fmt,
+                                           const picture_layout_t *layout,
+                                           int picture_count)
 {
 	// sunqueen modify start
 //    picture_t *picture[picture_count];
@@ -142,7 +149,7 @@ picture_pool_t *picture_pool_NewFromFormat(const video_format_t *fmt, int pictur
 	// sunqueen modify end
 
     for (int i = 0; i < picture_count; i++) {
-        picture[i] = picture_NewFromFormat(fmt);
+        picture[i] = picture_NewFromLayout(fmt, layout);
         if (!picture[i])
             goto error;
     }
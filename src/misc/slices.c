@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * slices.c : slice-parallel jobs
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "stdafx.h"
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_slices.h>
+#include "../libvlc.h"
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+typedef struct vlc_slice_job_t vlc_slice_job_t;
+struct vlc_slice_job_t {
+    vlc_slice_job_t      *next;
+
+    vlc_slice_callback_t callback;
+    void                 *opaque;
+    unsigned             count;
+    unsigned             started;   /* slices given to a thread */
+    unsigned             done;      /* slices processed */
+};
+
+struct vlc_slices_t {
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait_job;   /* a job has slices left to start */
+    vlc_cond_t      wait_done;  /* a job has been processed */
+
+    /* Jobs with slices left to start, in FIFO order */
+    vlc_slice_job_t *first;
+    vlc_slice_job_t **last_ptr;
+
+    bool            closing;
+    unsigned        thread_count;   /* wanted worker threads (constant) */
+    unsigned        thread_started;
+    vlc_thread_t    *threads;
+};
+
+/* Take the next slice to run. The lock must be held. */
+static vlc_slice_job_t *SlicesTake(vlc_slices_t *slices, vlc_slice_job_t *job,
+                                   unsigned *slice)
+{
+    if (!job) {
+        job = slices->first;
+        if (!job)
+            return NULL;
+    } else if (job->started >= job->count) {
+        return NULL;
+    }
+
+    *slice = job->started++;
+
+    /* Unqueue the job once all its slices are started */
+    if (job->started >= job->count) {
+        vlc_slice_job_t **pp = &slices->first;
+        while (*pp != job)
+            pp = &(*pp)->next;
+        *pp = job->next;
+        if (slices->last_ptr == &job->next)
+            slices->last_ptr = pp;
+        job->next = NULL;
+    }
+    return job;
+}
+
+/* Run a slice. The lock must be held, it is released while running. */
+static void SlicesProcess(vlc_slices_t *slices, vlc_slice_job_t *job, unsigned slice)
+{
+    vlc_mutex_unlock(&slices->lock);
+    job->callback(job->opaque, slice, job->count);
+    vlc_mutex_lock(&slices->lock);
+
+    if (++job->done >= job->count)
+        vlc_cond_broadcast(&slices->wait_done);
+}
+
+static void *SlicesThread(void *data)
+{
+    vlc_slices_t *slices = (vlc_slices_t *)data;
+
+    vlc_mutex_lock(&slices->lock);
+    for (;;) {
+        unsigned slice;
+        vlc_slice_job_t *job;
+
+        while (!slices->closing && !(job = SlicesTake(slices, NULL, &slice)))
+            vlc_cond_wait(&slices->wait_job, &slices->lock);
+        if (slices->closing)
+            break;
+
+        SlicesProcess(slices, job, slice);
+    }
+    vlc_mutex_unlock(&slices->lock);
+    return NULL;
+}
+
+vlc_slices_t *vlc_slices_New(unsigned thread_count)
+{
+    vlc_slices_t *slices = (vlc_slices_t *)malloc(sizeof(*slices));
+    if (!slices)
+        return NULL;
+
+    vlc_mutex_init(&slices->lock);
+    vlc_cond_init(&slices->wait_job);
+    vlc_cond_init(&slices->wait_done);
+    slices->first    = NULL;
+    slices->last_ptr = &slices->first;
+    slices->closing  = false;
+
+    /* The threads are only created by the first job */
+    slices->thread_count   = thread_count > 1 ? thread_count - 1 : 0;
+    slices->thread_started = 0;
+    slices->threads        = NULL;
+    return slices;
+}
+
+void vlc_slices_Delete(vlc_slices_t *slices)
+{
+    vlc_mutex_lock(&slices->lock);
+    assert(slices->first == NULL);
+    slices->closing = true;
+    vlc_cond_broadcast(&slices->wait_job);
+    vlc_mutex_unlock(&slices->lock);
+
+    for (unsigned i = 0; i < slices->thread_started; i++)
+        vlc_join(slices->threads[i], NULL);
+    free(slices->threads);
+
+    vlc_cond_destroy(&slices->wait_done);
+    vlc_cond_destroy(&slices->wait_job);
+    vlc_mutex_destroy(&slices->lock);
+    free(slices);
+}
+
+/* Start the worker threads. The lock must be held. */
+static void SlicesStart(vlc_slices_t *slices)
+{
+    slices->threads = (vlc_thread_t *)malloc(slices->thread_count * sizeof(*slices->threads));
+    if (!slices->threads)
+        return;
+
+    /* If some threads cannot be created, the callers run more slices */
+    while (slices->thread_started < slices->thread_count) {
+        if (vlc_clone(&slices->threads[slices->thread_started], SlicesThread,
+                      slices, VLC_THREAD_PRIORITY_VIDEO))
+            break;
+        slices->thread_started++;
+    }
+}
+
+#undef vlc_slices_Count
+unsigned vlc_slices_Count(vlc_object_t *obj)
+{
+    vlc_slices_t *slices = libvlc_priv(obj->p_libvlc)->slices;
+
+    if (!slices)
+        return 1;
+    return slices->thread_count + 1;
+}
+
+#undef vlc_slices_Run
+void vlc_slices_Run(vlc_object_t *obj, vlc_slice_callback_t callback,
+                    void *opaque, unsigned count)
+{
+    vlc_slices_t *slices = libvlc_priv(obj->p_libvlc)->slices;
+
+    if (count <= 0)
+        return;
+
+    /* Run small jobs in place */
+    if (!slices || slices->thread_count <= 0 || count == 1) {
+        for (unsigned i = 0; i < count; i++)
+            callback(opaque, i, count);
+        return;
+    }
+
+    vlc_slice_job_t job;
+    job.next     = NULL;
+    job.callback = callback;
+    job.opaque   = opaque;
+    job.count    = count;
+    job.started  = 0;
+    job.done     = 0;
+
+    /* The job lives on our stack: we must not be cancelled before the
+     * workers are done with it */
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock(&slices->lock);
+    if (!slices->threads)
+        SlicesStart(slices);
+
+    *slices->last_ptr = &job;
+    slices->last_ptr = &job.next;
+    vlc_cond_broadcast(&slices->wait_job);
+
+    /* Help with our own job, then wait for the slices run by the workers */
+    unsigned slice;
+    while (SlicesTake(slices, &job, &slice))
+        SlicesProcess(slices, &job, slice);
+    while (job.done < job.count)
+        vlc_cond_wait(&slices->wait_done, &slices->lock);
+    vlc_mutex_unlock(&slices->lock);
+
+    vlc_restorecancel(canc);
+}
@@ -189,6 +189,7 @@ subpicture_region_private_t *subpicture_region_private_New( video_format_t *p_fm
             *p_private->fmt.p_palette = *p_fmt->p_palette;
     }
     p_private->p_picture = NULL;
+    p_private->p_source = NULL;
 
     return p_private;
 }
@@ -197,11 +198,13 @@ void subpicture_region_private_Delete( subpicture_region_private_t *p_private )
 {
     if( p_private->p_picture )
         picture_Release( p_private->p_picture );
+    if( p_private->p_source )
+        picture_Release( p_private->p_source );
     free( p_private->fmt.p_palette );
     free( p_private );
 }
 
-subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
+static subpicture_region_t *RegionNew( const video_format_t *p_fmt )
 {
     subpicture_region_t *p_region = (subpicture_region_t *)calloc( 1, sizeof(*p_region ) );			// sunqueen modify
     if( !p_region )
@@ -222,6 +225,15 @@ subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
     p_region->p_style = NULL;
     p_region->p_picture = NULL;
 
+    return p_region;
+}
+
+subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
+{
+    subpicture_region_t *p_region = RegionNew( p_fmt );
+    if( !p_region )
+        return NULL;
+
     if( p_fmt->i_chroma == VLC_CODEC_TEXT )
         return p_region;
 
@@ -236,6 +248,17 @@ subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
     return p_region;
 }
 
+subpicture_region_t *subpicture_region_NewWithPicture( const video_format_t *p_fmt,
+                                                       picture_t *p_picture )
+{
+    subpicture_region_t *p_region = RegionNew( p_fmt );
+    if( !p_region )
+        return NULL;
+
+    p_region->p_picture = picture_Hold( p_picture );
+    return p_region;
+}
+
 void subpicture_region_Delete( subpicture_region_t *p_region )
 {
     if( !p_region )
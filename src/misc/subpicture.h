@@ -24,8 +24,12 @@
 struct subpicture_region_private_t {
     video_format_t fmt;
     picture_t      *p_picture;
+    picture_t      *p_source;   /* region picture p_picture was computed from */
 };
 
 subpicture_region_private_t *subpicture_region_private_New(video_format_t *);
 void subpicture_region_private_Delete(subpicture_region_private_t *);
 
+/* Create a region holding the given picture instead of allocating one */
+subpicture_region_t *subpicture_region_NewWithPicture(const video_format_t *, picture_t *);
+
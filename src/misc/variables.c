@@ -30,12 +30,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
-
-#include <cover_search.h>			// sunqueen add
-
 #include <assert.h>
 #include <math.h>
 #include <limits.h>
@@ -141,23 +135,201 @@ static void     CheckValue  ( variable_t *, vlc_value_t * );
 static int      TriggerCallback( vlc_object_t *, variable_t *, const char *,
                                  vlc_value_t );
 
-static int varcmp( const void *a, const void *b )
+static int      InheritConfig( vlc_object_t *, const char *, int,
+                               vlc_value_t * );
+
+/*****************************************************************************
+ * Variable names
+ *****************************************************************************
+ * Names are interned in a process wide table and never freed, so that
+ * variables can be compared by handle, and so that an object does not need
+ * its own copy of the name of each of its variables.
+ *****************************************************************************/
+static vlc_mutex_t names_lock = VLC_STATIC_MUTEX;
+static vlc_var_handle_t **names_table = NULL;
+static unsigned names_count = 0;
+static unsigned names_size = 0;
+
+static uint32_t HashName( const char *psz_name )
+{
+    /* FNV-1a */
+    uint32_t h = 2166136261u;
+
+    for( const unsigned char *p = (const unsigned char *)psz_name; *p; p++ )
+    {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void GrowNames( void )
 {
-    const variable_t *va = (const variable_t *)a, *vb = (const variable_t *)b;				// sunqueen modify
+    unsigned size = names_size ? 2 * names_size : 256;
+    vlc_var_handle_t **table =
+        (vlc_var_handle_t **)calloc( size, sizeof( *table ) );
+    if( unlikely(table == NULL) )
+        return; /* keep the longer chains */
+
+    for( unsigned i = 0; i < names_size; i++ )
+        for( vlc_var_handle_t *h = names_table[i], *next; h != NULL; h = next )
+        {
+            next = h->p_next;
+            h->p_next = table[h->i_hash & (size - 1)];
+            table[h->i_hash & (size - 1)] = h;
+        }
+    free( names_table );
+    names_table = table;
+    names_size = size;
+}
+
+/**
+ * Returns the handle of a variable name, see vlc_var_handle_t.
+ *
+ * \return the handle or NULL if out of memory
+ */
+const vlc_var_handle_t *var_Handle( const char *psz_name )
+{
+    const uint32_t hash = HashName( psz_name );
+    vlc_var_handle_t *h;
+
+    vlc_mutex_lock( &names_lock );
+    if( names_count >= names_size )
+        GrowNames();
+    if( unlikely(names_size == 0) )
+    {
+        vlc_mutex_unlock( &names_lock );
+        return NULL;
+    }
+
+    vlc_var_handle_t **pp = &names_table[hash & (names_size - 1)];
+    for( h = *pp; h != NULL; h = h->p_next )
+        if( h->i_hash == hash && !strcmp( h->psz_name, psz_name ) )
+            break;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    if( h == NULL )
+    {   /* Handle and name in a single allocation */
+        const size_t len = strlen( psz_name ) + 1;
+        h = (vlc_var_handle_t *)malloc( sizeof( *h ) + len );
+        if( likely(h != NULL) )
+        {
+            h->psz_name = (const char *)memcpy( (char *)(h + 1), psz_name, len );
+            h->i_hash = hash;
+            h->p_next = *pp;
+            *pp = h;
+            names_count++;
+        }
+    }
+    vlc_mutex_unlock( &names_lock );
+    return h;
 }
 
+/*****************************************************************************
+ * Object variables table
+ *****************************************************************************
+ * Open addressing with linear probing, indexed by the name hash.
+ *****************************************************************************/
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    variable_t **pp_var;
 
     vlc_assert_locked( &priv->var_lock );
-    pp_var = (variable_t **)cover_tfind( &psz_name, &priv->var_root, varcmp );				// sunqueen modify
-    return (pp_var != NULL) ? *pp_var : NULL;
+    if( priv->var_count == 0 )
+        return NULL;
+
+    const uint32_t hash = HashName( psz_name );
+    for( unsigned i = hash & priv->var_mask;; i = (i + 1) & priv->var_mask )
+    {
+        variable_t *p_var = priv->var_table[i];
+        if( p_var == NULL )
+            return NULL;
+        if( p_var->p_handle->i_hash == hash
+         && !strcmp( p_var->psz_name, psz_name ) )
+            return p_var;
+    }
+}
+
+static variable_t *LookupHandle( vlc_object_t *obj,
+                                 const vlc_var_handle_t *h )
+{
+    vlc_object_internals_t *priv = vlc_internals( obj );
+
+    vlc_assert_locked( &priv->var_lock );
+    if( priv->var_count == 0 )
+        return NULL;
+
+    for( unsigned i = h->i_hash & priv->var_mask;; i = (i + 1) & priv->var_mask )
+    {
+        variable_t *p_var = priv->var_table[i];
+        if( p_var == NULL || p_var->p_handle == h )
+            return p_var;
+    }
+}
+
+static void InsertSlot( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    unsigned i = p_var->p_handle->i_hash & priv->var_mask;
+
+    while( priv->var_table[i] != NULL )
+        i = (i + 1) & priv->var_mask;
+    priv->var_table[i] = p_var;
+}
+
+/* The variable must not be in the table yet */
+static int Insert( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    vlc_assert_locked( &priv->var_lock );
+
+    /* Keep the load factor below 3/4 */
+    if( 4 * (priv->var_count + 1) > 3 * (priv->var_mask + 1) )
+    {
+        variable_t **old = priv->var_table;
+        unsigned size = old ? 2 * (priv->var_mask + 1) : 16;
+        variable_t **table = (variable_t **)calloc( size, sizeof( *table ) );
+
+        if( unlikely(table == NULL) )
+            return VLC_ENOMEM;
+
+        unsigned old_size = old ? priv->var_mask + 1 : 0;
+        priv->var_table = table;
+        priv->var_mask = size - 1;
+        for( unsigned i = 0; i < old_size; i++ )
+            if( old[i] != NULL )
+                InsertSlot( priv, old[i] );
+        free( old );
+    }
+
+    InsertSlot( priv, p_var );
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+static void Remove( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    vlc_assert_locked( &priv->var_lock );
+
+    const unsigned mask = priv->var_mask;
+    unsigned i = p_var->p_handle->i_hash & mask;
+
+    while( priv->var_table[i] != p_var )
+        i = (i + 1) & mask;
+
+    /* Shift back the following entries of the cluster, so that no probe
+     * sequence goes through a hole */
+    for( unsigned j = (i + 1) & mask; priv->var_table[j] != NULL;
+         j = (j + 1) & mask )
+    {
+        unsigned home = priv->var_table[j]->p_handle->i_hash & mask;
+
+        /* Move j into i if its home is not in (i, j] (cyclically) */
+        if( ((j - home) & mask) >= ((j - i) & mask) )
+        {
+            priv->var_table[i] = priv->var_table[j];
+            i = j;
+        }
+    }
+    priv->var_table[i] = NULL;
+    priv->var_count--;
 }
 
 static void Destroy( variable_t *p_var )
@@ -192,7 +364,6 @@ static void Destroy( variable_t *p_var )
     }
 #endif
 
-    free( p_var->psz_name );
     free( p_var->psz_text );
     free( p_var->p_entries );
     free( p_var );
@@ -202,9 +373,8 @@ static void Destroy( variable_t *p_var )
 /**
  * Initialize a vlc variable
  *
- * We hash the given string and insert it into the sorted list. The insertion
- * may require slow memory copies, but think about what we gain in the log(n)
- * lookup phase when setting/getting the variable value!
+ * The name is interned (see var_Handle) and the variable is inserted in the
+ * hash table of the object.
  *
  * \param p_this The object in which to create the variable
  * \param psz_name The name of the variable
@@ -215,11 +385,16 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 {
     assert( p_this );
 
+    const vlc_var_handle_t *p_handle = var_Handle( psz_name );
+    if( unlikely(p_handle == NULL) )
+        return VLC_ENOMEM;
+
     variable_t *p_var = (variable_t *)calloc( 1, sizeof( *p_var ) );				// sunqueen modify
     if( p_var == NULL )
         return VLC_ENOMEM;
 
-    p_var->psz_name = strdup( psz_name );
+    p_var->psz_name = p_handle->psz_name;
+    p_var->p_handle = p_handle;
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -294,16 +469,21 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
     }
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = (variable_t **)cover_tsearch( p_var, &p_priv->var_root, varcmp );				// sunqueen modify
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = LookupHandle( p_this, p_handle );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+        {
+            p_var = NULL; /* Variable created */
+            atomic_fetch_add( &p_priv->var_generation, 1u );
+        }
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -322,8 +502,7 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 /**
  * Destroy a vlc variable
  *
- * Look for the variable and destroy it if it is found. As in var_Create we
- * do a call to memmove() but we have performance counterparts elsewhere.
+ * Look for the variable and destroy it if it is found.
  *
  * \param p_this The object that holds the variable
  * \param psz_name The name of the variable
@@ -348,7 +527,10 @@ int var_Destroy( vlc_object_t *p_this, const char *psz_name )
     WaitUnused( p_this, p_var );
 
     if( --p_var->i_usage == 0 )
-        cover_tdelete( p_var, &p_priv->var_root, varcmp );			// sunqueen modify
+    {
+        Remove( p_priv, p_var );
+        atomic_fetch_add( &p_priv->var_generation, 1u );
+    }
     else
         p_var = NULL;
     vlc_mutex_unlock( &p_priv->var_lock );
@@ -358,17 +540,20 @@ int var_Destroy( vlc_object_t *p_this, const char *psz_name )
     return VLC_SUCCESS;
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( (variable_t *)var );				// sunqueen modify
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    if( priv->var_table != NULL )
+    {
+        for( unsigned i = 0; i <= priv->var_mask; i++ )
+            if( priv->var_table[i] != NULL )
+                Destroy( priv->var_table[i] );
+        free( priv->var_table );
+    }
+    priv->var_table = NULL;
+    priv->var_count = 0;
+    priv->var_mask = 0;
 }
 
 #undef var_Change
@@ -704,27 +889,14 @@ int var_Type( vlc_object_t *p_this, const char *psz_name )
     return i_type;
 }
 
-#undef var_SetChecked
-int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
-                    int expected_type, vlc_value_t val )
+/* Sets a variable found with the variable lock held, and releases the lock */
+static int SetLocked( vlc_object_t *p_this, variable_t *p_var,
+                      int expected_type, vlc_value_t val )
 {
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
     int i_ret = VLC_SUCCESS;
-    variable_t *p_var;
     vlc_value_t oldval;
 
-    assert( p_this );
-
-    vlc_object_internals_t *p_priv = vlc_internals( p_this );
-
-    vlc_mutex_lock( &p_priv->var_lock );
-
-    p_var = Lookup( p_this, psz_name );
-    if( p_var == NULL )
-    {
-        vlc_mutex_unlock( &p_priv->var_lock );
-        return VLC_ENOVAR;
-    }
-
     assert( expected_type == 0 ||
             (p_var->i_type & VLC_VAR_CLASS) == expected_type );
     assert ((p_var->i_type & VLC_VAR_CLASS) != VLC_VAR_VOID);
@@ -744,7 +916,7 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
     p_var->val = val;
 
     /* Deal with callbacks */
-    i_ret = TriggerCallback( p_this, p_var, psz_name, oldval );
+    i_ret = TriggerCallback( p_this, p_var, p_var->psz_name, oldval );
 
     /* Free data if needed */
     p_var->ops->pf_free( &oldval );
@@ -754,6 +926,54 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
     return i_ret;
 }
 
+#undef var_SetChecked
+int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
+                    int expected_type, vlc_value_t val )
+{
+    variable_t *p_var;
+
+    assert( p_this );
+
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    vlc_mutex_lock( &p_priv->var_lock );
+
+    p_var = Lookup( p_this, psz_name );
+    if( p_var == NULL )
+    {
+        vlc_mutex_unlock( &p_priv->var_lock );
+        return VLC_ENOVAR;
+    }
+    return SetLocked( p_this, p_var, expected_type, val );
+}
+
+#undef var_SetHandleChecked
+/**
+ * Same as var_SetChecked() but with a variable name handle.
+ */
+int var_SetHandleChecked( vlc_object_t *p_this, const vlc_var_handle_t *h,
+                          int expected_type, vlc_value_t val )
+{
+    variable_t *p_var;
+
+    assert( p_this );
+
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    if( unlikely(h == NULL) )
+        return VLC_ENOVAR;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+
+    p_var = LookupHandle( p_this, h );
+    if( p_var == NULL )
+    {
+        vlc_mutex_unlock( &p_priv->var_lock );
+        return VLC_ENOVAR;
+    }
+    return SetLocked( p_this, p_var, expected_type, val );
+}
+
 #undef var_Set
 /**
  * Set a variable's value
@@ -799,6 +1019,42 @@ int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+#undef var_GetHandleChecked
+/**
+ * Same as var_GetChecked() but with a variable name handle: the lookup
+ * compares pointers instead of strings.
+ */
+int var_GetHandleChecked( vlc_object_t *p_this, const vlc_var_handle_t *h,
+                          int expected_type, vlc_value_t *p_val )
+{
+    assert( p_this );
+
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+    variable_t *p_var;
+    int err = VLC_SUCCESS;
+
+    if( unlikely(h == NULL) )
+        return VLC_ENOVAR;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+
+    p_var = LookupHandle( p_this, h );
+    if( p_var != NULL )
+    {
+        assert( expected_type == 0 ||
+                (p_var->i_type & VLC_VAR_CLASS) == expected_type );
+        assert ((p_var->i_type & VLC_VAR_CLASS) != VLC_VAR_VOID);
+
+        *p_val = p_var->val;
+        p_var->ops->pf_dup( p_val );
+    }
+    else
+        err = VLC_ENOVAR;
+
+    vlc_mutex_unlock( &p_priv->var_lock );
+    return err;
+}
+
 #undef var_Get
 /**
  * Get a variable's value
@@ -1223,6 +1479,83 @@ int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
     }
 
     /* else take value from config */
+    return InheritConfig( p_this, psz_name, i_type, p_val );
+}
+
+#undef var_InheritHandle
+/**
+ * Same as var_Inherit() but with a variable name handle.
+ *
+ * The object where the variable was found (or the configuration) is
+ * remembered in the object, so that the next calls do not look the variable
+ * up in each parent. That is forgotten as soon as a variable is created or
+ * destroyed on the object, on the owner, or on any object in between: the
+ * sum of their generations is remembered too, and checked on each call.
+ */
+int var_InheritHandle( vlc_object_t *p_this, const vlc_var_handle_t *h,
+                       int i_type, vlc_value_t *p_val )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    if( unlikely(h == NULL) )
+        return VLC_ENOMEM;
+
+    i_type &= VLC_VAR_CLASS;
+
+    var_inherit_cache_t *cache = &p_priv->var_inherit[h->i_hash % VAR_INHERIT_CACHE];
+    vlc_object_t *owner;
+    unsigned gen;
+    bool hit;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    hit = cache->p_handle == h;
+    owner = cache->p_owner;
+    gen = cache->i_generation;
+    vlc_mutex_unlock( &p_priv->var_lock );
+
+    if( hit )
+    {   /* The owner is the object or one of its parents, so it is alive */
+        for( vlc_object_t *obj = p_this; obj != NULL; obj = obj->p_parent )
+        {
+            gen -= atomic_load( &vlc_internals( obj )->var_generation );
+            if( obj == owner )
+                break;
+        }
+        hit = gen == 0;
+    }
+
+    if( hit )
+    {
+        if( owner == NULL )
+            return InheritConfig( p_this, h->psz_name, i_type, p_val );
+        if( var_GetHandleChecked( owner, h, i_type, p_val ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
+
+    /* Read each generation before looking the variable up in the object,
+     * so that a concurrent creation or destruction is not missed */
+    gen = 0;
+    for( owner = p_this; owner != NULL; owner = owner->p_parent )
+    {
+        gen += atomic_load( &vlc_internals( owner )->var_generation );
+        if( var_GetHandleChecked( owner, h, i_type, p_val ) == VLC_SUCCESS )
+            break;
+    }
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    cache->p_handle = h;
+    cache->p_owner = owner;
+    cache->i_generation = gen;
+    vlc_mutex_unlock( &p_priv->var_lock );
+
+    if( owner != NULL )
+        return VLC_SUCCESS;
+    return InheritConfig( p_this, h->psz_name, i_type, p_val );
+}
+
+static int InheritConfig( vlc_object_t *p_this, const char *psz_name,
+                          int i_type, vlc_value_t *p_val )
+{
     switch( i_type & VLC_VAR_CLASS )
     {
         case VLC_VAR_STRING:
@@ -30,14 +30,39 @@
  */
 typedef struct vlc_object_internals vlc_object_internals_t;
 
+/**
+ * Interned variable name, see var_Handle().
+ */
+struct vlc_var_handle_t
+{
+    const char       *psz_name;
+    uint32_t          i_hash;
+    vlc_var_handle_t *p_next; /**< Next name in the same interning bucket */
+};
+
+/* Number of inherited variables whose origin is kept by each object */
+#define VAR_INHERIT_CACHE 8
+
+typedef struct
+{
+    const vlc_var_handle_t *p_handle;
+    vlc_object_t           *p_owner; /* NULL if from the configuration */
+    unsigned                i_generation; /* see var_InheritHandle() */
+} var_inherit_cache_t;
+
 struct vlc_object_internals
 {
     char           *psz_name; /* given name */
 
-    /* Object variables */
-    void           *var_root;
+    /* Object variables, in an open addressing hash table */
+    struct variable_t **var_table;
+    unsigned        var_count;
+    unsigned        var_mask; /* size of var_table minus one */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
+    atomic_uint     var_generation; /* bumped when a variable is created or
+                                       destroyed on this object */
+    var_inherit_cache_t var_inherit[VAR_INHERIT_CACHE];
 
     /* Objects thread synchronization */
     int             pipes[2];
@@ -72,7 +97,8 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    const char * psz_name; /**< The variable unique name (interned) */
+    const vlc_var_handle_t *p_handle; /**< Interned name */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -283,6 +283,12 @@ int sout_MuxGetStream (sout_mux_t *p_mux, int i_blocks, mtime_t *pi_dts)
     assert (0);
 }
 
+int sout_MuxPull (sout_mux_t *p_mux, int i_blocks, sout_mux_block_t *p_out,
+                  int i_max)
+{
+    assert (0);
+}
+
 sout_mux_t *sout_MuxNew (sout_instance_t *instance, const char *mux,
                          sout_access_out_t *out)
 {
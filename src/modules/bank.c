@@ -44,17 +44,33 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_modules.h>
+#include <vlc_block.h>
 #include <vlc_fs.h>
 #include "libvlc.h"
 #include "config/configuration.h"
 #include "modules/modules.h"
 
+/** Modules sharing a capability, from the highest score to the lowest */
+typedef struct
+{
+    const char *cap;
+    size_t      count;
+    module_t  **tab;
+} module_cap_t;
+
 static struct
 {
     vlc_mutex_t lock;
     module_t *head;
     unsigned usage;
-} modules = { VLC_STATIC_MUTEX, NULL, 0 };
+
+    /* Capability index, sorted by capability name (see module_list_cap()) */
+    module_cap_t *caps;
+    size_t caps_count;
+    module_t **caps_tab;
+
+    block_t *maps; /* plugins cache files that cached modules point into */
+} modules = { VLC_STATIC_MUTEX, NULL, 0, NULL, 0, NULL, NULL };
 
 /*****************************************************************************
  * Local prototypes
@@ -63,6 +79,8 @@ static struct
 static void AllocateAllPlugins (vlc_object_t *);
 #endif
 static module_t *module_InitStatic (vlc_plugin_cb);
+static void module_BuildCapIndex (void);
+static void module_ClearCapIndex (void);
 
 static void module_StoreBank (module_t *module)
 {
@@ -135,6 +153,7 @@ void module_InitBank (void)
 void module_EndBank (bool b_plugins)
 {
     module_t *head = NULL;
+    block_t *maps = NULL;
 
     /* If plugins were _not_ loaded, then the caller still has the bank lock
      * from module_InitBank(). */
@@ -147,8 +166,11 @@ void module_EndBank (bool b_plugins)
     if (--modules.usage == 0)
     {
         config_UnsortConfig ();
+        module_ClearCapIndex ();
         head = modules.head;
         modules.head = NULL;
+        maps = modules.maps;
+        modules.maps = NULL;
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -166,6 +188,7 @@ void module_EndBank (bool b_plugins)
 #endif
         vlc_module_destroy (module);
     }
+    block_ChainRelease (maps);
 }
 
 #undef module_LoadPlugins
@@ -189,6 +212,7 @@ size_t module_LoadPlugins (vlc_object_t *obj)
 #endif
         config_UnsortConfig ();
         config_SortConfig ();
+        module_BuildCapIndex ();
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -251,6 +275,75 @@ static int modulecmp (const void *a, const void *b)
     return (*mb)->i_score - (*ma)->i_score;
 }
 
+static int modulecapcmp (const void *a, const void *b)
+{
+    const module_t *const *ma = (const module_t *const *)a, *const *mb = (const module_t *const *)b;
+    int ret = strcmp (module_get_capability (*ma),
+                      module_get_capability (*mb));
+    return ret ? ret : modulecmp (a, b);
+}
+
+static int capcmp (const void *key, const void *elem)
+{
+    return strcmp ((const char *)key, ((const module_cap_t *)elem)->cap);
+}
+
+/**
+ * Indexes all modules by capability, once the module bank is complete.
+ * The bank is read-only from then on, so the index stays valid until
+ * module_EndBank().
+ */
+static void module_BuildCapIndex (void)
+{
+    size_t n, count = 0;
+    module_t **tab = module_list_get (&n);
+
+    module_ClearCapIndex ();
+    if (tab == NULL)
+        return;
+
+    qsort (tab, n, sizeof (*tab), modulecapcmp);
+    for (size_t i = 0; i < n; i++)
+        if (i == 0 || strcmp (module_get_capability (tab[i - 1]),
+                              module_get_capability (tab[i])))
+            count++;
+
+    module_cap_t *caps = (module_cap_t *)malloc (count * sizeof (*caps));
+    if (unlikely(caps == NULL))
+    {
+        module_list_free (tab);
+        return;
+    }
+
+    module_cap_t *cap = caps - 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        const char *name = module_get_capability (tab[i]);
+
+        if (i == 0 || strcmp (cap->cap, name))
+        {
+            cap++;
+            cap->cap = name;
+            cap->count = 0;
+            cap->tab = tab + i;
+        }
+        cap->count++;
+    }
+
+    modules.caps = caps;
+    modules.caps_count = count;
+    modules.caps_tab = tab;
+}
+
+static void module_ClearCapIndex (void)
+{
+    free (modules.caps);
+    module_list_free (modules.caps_tab);
+    modules.caps = NULL;
+    modules.caps_count = 0;
+    modules.caps_tab = NULL;
+}
+
 /**
  * Builds a sorted list of all VLC modules with a given capability.
  * The list is sorted from the highest module score to the lowest.
@@ -261,11 +354,28 @@ static int modulecmp (const void *a, const void *b)
  */
 ssize_t module_list_cap (module_t ***__restrict list, const char *cap)			// sunqueen modify
 {
-    /* TODO: This is quite inefficient. List should be sorted by capability. */
     ssize_t n = 0;
 
     assert (list != NULL);
 
+    if (modules.caps_tab != NULL)
+    {   /* Fast path: the bank is complete and indexed */
+        const module_cap_t *entry = (const module_cap_t *)
+            bsearch (cap, modules.caps, modules.caps_count,
+                     sizeof (*modules.caps), capcmp);
+        if (entry != NULL)
+            n = entry->count;
+
+        module_t **tab = (module_t **)malloc (sizeof (*tab) * n);
+        *list = tab;
+        if (unlikely(tab == NULL))
+            return -1;
+        if (n > 0)
+            memcpy (tab, entry->tab, sizeof (*tab) * n);
+        return n;
+    }
+
+    /* Plug-ins are not loaded yet: scan the bank */
     for (module_t *mod = modules.head; mod != NULL; mod = mod->next)
     {
          if (module_provides (mod, cap))
@@ -312,15 +422,12 @@ static void AllocateAllPlugins (vlc_object_t *p_this)
     char *paths;
     cache_mode_t mode;
 
-#if 0			// sunqueen delete start
     if( !var_InheritBool( p_this, "plugins-cache" ) )
         mode = CACHE_IGNORE;
     else if( var_InheritBool( p_this, "reset-plugins-cache" ) )
         mode = CACHE_RESET;
     else
         mode = CACHE_USE;
-#endif			// sunqueen delete end
-    mode = CACHE_IGNORE;			// sunqueen add
 
 #if VLC_WINSTORE_APP
     /* Windows Store Apps can not load external plugins with absolute paths. */
@@ -366,6 +473,7 @@ typedef struct module_bank
 
     int            i_loaded_cache;
     module_cache_t *loaded_cache;
+    bool           b_stale; /* the cache file needs to be written again */
 } module_bank_t;
 
 static void AllocatePluginDir (module_bank_t *, unsigned,
@@ -385,7 +493,7 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
     switch( mode )
     {
         case CACHE_USE:
-            count = CacheLoad( p_this, path, &cache );
+            count = CacheLoad( p_this, path, &cache, &modules.maps );
             break;
         case CACHE_RESET:
             CacheDelete( p_this, path );
@@ -403,6 +511,7 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
     bank.i_cache = 0;
     bank.loaded_cache = cache;
     bank.i_loaded_cache = count;
+    bank.b_stale = mode == CACHE_RESET;
 
     /* Don't go deeper than 5 subdirectories */
     AllocatePluginDir (&bank, 5, path, NULL);
@@ -414,12 +523,23 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
             for( size_t i = 0; i < count; i++ )
             {
                 if (cache[i].p_module != NULL)
+                {
                    vlc_module_destroy (cache[i].p_module);
+                   bank.b_stale = true; /* plug-in was removed */
+                }
                 free (cache[i].path);
             }
             free( cache );
         case CACHE_RESET:
-            CacheSave (p_this, path, bank.cache, bank.i_cache);
+            /* Only rewrite the cache if plug-ins were added or removed */
+            if (bank.b_stale)
+            {
+                CacheSave (p_this, path, bank.cache, bank.i_cache);
+                break;
+            }
+            for (size_t i = 0; i < bank.i_cache; i++)
+                free (bank.cache[i].path);
+            free (bank.cache);
         case CACHE_IGNORE:
             break;
     }
@@ -531,7 +651,10 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
         }
     }
     if (module == NULL)
+    {
         module = module_InitDynamic (bank->obj, abspath, true);
+        bank->b_stale = true;
+    }
     if (module == NULL)
         return -1;
 
@@ -647,23 +770,33 @@ static module_t *module_InitStatic (vlc_plugin_cb entry)
  */
 int module_Map (vlc_object_t *obj, module_t *module)
 {
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+    int ret = 0;
+
     if (module->parent != NULL)
         module = module->parent;
 
-//#warning FIXME: race condition!			// sunqueen delete
-    if (module->b_loaded)
-        return 0;
-    assert (module->psz_filename != NULL);
-
-#ifdef HAVE_DYNAMIC_PLUGINS
-    module_t *uncache = module_InitDynamic (obj, module->psz_filename, false);
-    if (uncache != NULL)
+    /* Plug-ins from the cache are only loaded when first selected, possibly
+     * by several threads at once. */
+    vlc_mutex_lock (&lock);
+    if (!module->b_loaded)
     {
-        CacheMerge (obj, module, uncache);
-        vlc_module_destroy (uncache);
-        return 0;
-    }
+        assert (module->psz_filename != NULL);
+#ifdef HAVE_DYNAMIC_PLUGINS
+        module_t *uncache = module_InitDynamic (obj, module->psz_filename,
+                                                false);
+        if (uncache != NULL)
+        {
+            CacheMerge (obj, module, uncache);
+            vlc_module_destroy (uncache);
+        }
+        else
 #endif
-    msg_Err (obj, "corrupt module: %s", module->psz_filename);
-    return -1;
+        {
+            msg_Err (obj, "corrupt module: %s", module->psz_filename);
+            ret = -1;
+        }
+    }
+    vlc_mutex_unlock (&lock);
+    return ret;
 }
@@ -41,6 +41,8 @@
 #include <assert.h>
 
 #include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_arrays.h>
 #include "libvlc.h"
 
 #include <vlc_plugin.h>
@@ -59,7 +61,7 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 22
+#define CACHE_SUBVERSION_NUM 24
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
@@ -80,8 +82,38 @@ void CacheDelete( vlc_object_t *obj, const char *dir )
     free( path );
 }
 
+/*
+ * The cache file starts with CACHE_STRING (and DISTRO_VERSION if defined),
+ * followed by CACHE_SUBVERSION_NUM, the offset and size of the string table,
+ * the number of plugins and one record per plugin. The string table comes
+ * last. Each string is stored once in the table, and records refer to it by
+ * its offset. The table starts with two nul bytes: offset 0 stands for NULL
+ * and offset 1 for the empty string.
+ *
+ * The whole file is mapped at once when it is loaded, and module descriptors
+ * point directly into the string table instead of copying every string.
+ * Such descriptors have b_mapped set, and the mapping must be kept until they
+ * are destroyed.
+ */
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    const char    *strings; /**< NUL-terminated string table */
+    uint32_t       strings_size;
+} cache_reader_t;
+
+static int CacheLoadBytes (void *buf, size_t len, cache_reader_t *r)
+{
+    if ((size_t)(r->end - r->p) < len)
+        return -1;
+    memcpy (buf, r->p, len);
+    r->p += len;
+    return 0;
+}
+
 #define LOAD_IMMEDIATE(a) \
-    if (fread (&(a), sizeof (char), sizeof (a), file) != sizeof (a)) \
+    if (CacheLoadBytes (&(a), sizeof (a), r)) \
         goto error
 #define LOAD_FLAG(a) \
     do { \
@@ -92,38 +124,33 @@ void CacheDelete( vlc_object_t *obj, const char *dir )
         (a) = b; \
     } while (0)
 
-static int CacheLoadString (char **p, FILE *file)
+static int CacheLoadString (char **p, cache_reader_t *r)
 {
-    char *psz = NULL;
-    uint16_t size;
+    uint32_t offset;
 
-    LOAD_IMMEDIATE (size);
-    if (size > 16384)
+    LOAD_IMMEDIATE (offset);
+    if (offset >= r->strings_size)
     {
 error:
         return -1;
     }
-
-    if (size > 0)
-    {
-        psz = (char *)malloc (size+1);			// sunqueen modify
-        if (unlikely(psz == NULL))
-            goto error;
-        if (fread (psz, 1, size, file) != size)
-        {
-            free (psz);
-            goto error;
-        }
-        psz[size] = '\0';
-    }
-    *p = psz;
+    /* The table ends with a nul byte, so any offset is a valid string. */
+    *p = (offset != 0) ? (char *)(r->strings + offset) : NULL;
     return 0;
 }
 
 #define LOAD_STRING(a) \
-    if (CacheLoadString (&(a), file)) goto error
+    if (CacheLoadString (&(a), r)) goto error
 
-static int CacheLoadConfig (module_config_t *cfg, FILE *file)
+/* Every list entry is at least 4 bytes long in the file */
+#define LOAD_LIST_COUNT(a) \
+    do { \
+        LOAD_IMMEDIATE(a); \
+        if ((a) > (size_t)(r->end - r->p) / 4) \
+            goto error; \
+    } while (0)
+
+static int CacheLoadConfig (module_config_t *cfg, cache_reader_t *r)
 {
     LOAD_IMMEDIATE (cfg->i_type);
     LOAD_IMMEDIATE (cfg->i_short);
@@ -136,26 +163,26 @@ static int CacheLoadConfig (module_config_t *cfg, FILE *file)
     LOAD_STRING (cfg->psz_name);
     LOAD_STRING (cfg->psz_text);
     LOAD_STRING (cfg->psz_longtext);
-    LOAD_IMMEDIATE (cfg->list_count);
+    LOAD_LIST_COUNT (cfg->list_count);
 
     if (IsConfigStringType (cfg->i_type))
     {
         LOAD_STRING (cfg->orig.psz);
+        /* The current value is changed at run-time, so it is not mapped */
         if (cfg->orig.psz != NULL)
             cfg->value.psz = strdup (cfg->orig.psz);
         else
             cfg->value.psz = NULL;
 
         if (cfg->list_count)
-            cfg->list.psz = (char **)xmalloc (cfg->list_count * sizeof (char *));			// sunqueen modify
+            cfg->list.psz = (char **)xmalloc (cfg->list_count * sizeof (char *));
         else /* TODO: fix config_GetPszChoices() instead of this hack: */
             LOAD_IMMEDIATE(cfg->list.psz_cb);
         for (unsigned i = 0; i < cfg->list_count; i++)
         {
             LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = (char *)calloc (1, 1)) == NULL)			// sunqueen modify
-                goto error;
+            if (cfg->list.psz[i] == NULL) /* NULL -> empty string */
+                cfg->list.psz[i] = (char *)r->strings;
         }
     }
     else
@@ -166,27 +193,26 @@ static int CacheLoadConfig (module_config_t *cfg, FILE *file)
         cfg->value = cfg->orig;
 
         if (cfg->list_count)
-            cfg->list.i = (int *)xmalloc (cfg->list_count * sizeof (int));			// sunqueen modify
+            cfg->list.i = (int *)xmalloc (cfg->list_count * sizeof (int));
         else /* TODO: fix config_GetPszChoices() instead of this hack: */
             LOAD_IMMEDIATE(cfg->list.i_cb);
         for (unsigned i = 0; i < cfg->list_count; i++)
              LOAD_IMMEDIATE (cfg->list.i[i]);
     }
-    cfg->list_text = (char **)xmalloc (cfg->list_count * sizeof (char *));			// sunqueen modify
+    cfg->list_text = (char **)xmalloc (cfg->list_count * sizeof (char *));
     for (unsigned i = 0; i < cfg->list_count; i++)
     {
         LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = (char *)calloc (1, 1)) == NULL)			// sunqueen modify
-            goto error;
+        if (cfg->list_text[i] == NULL) /* NULL -> empty string */
+            cfg->list_text[i] = (char *)r->strings;
     }
 
     return 0;
 error:
-    return -1; /* FIXME: leaks */
+    return -1;
 }
 
-static int CacheLoadModuleConfig (module_t *module, FILE *file)
+static int CacheLoadModuleConfig (module_t *module, cache_reader_t *r)
 {
     uint16_t lines;
 
@@ -195,27 +221,70 @@ static int CacheLoadModuleConfig (module_t *module, FILE *file)
     LOAD_IMMEDIATE (module->i_bool_items);
     LOAD_IMMEDIATE (lines);
 
-    /* Allocate memory */
+    /* Allocate memory (zeroed, so that a partly loaded table can be freed) */
     if (lines)
     {
-        module->p_config = (module_config_t *)malloc (lines * sizeof (module_config_t));			// sunqueen modify
+        module->p_config = (module_config_t *)calloc (lines, sizeof (module_config_t));
         if (unlikely(module->p_config == NULL))
-        {
-            module->confsize = 0;
             return -1;
-        }
     }
-    else
-        module->p_config = NULL;
     module->confsize = lines;
 
     /* Do the duplication job */
     for (size_t i = 0; i < lines; i++)
-        if (CacheLoadConfig (module->p_config + i, file))
+        if (CacheLoadConfig (module->p_config + i, r))
             return -1;
     return 0;
 error:
-    return -1; /* FIXME: leaks */
+    return -1;
+}
+
+static int CacheLoadModuleInfo (module_t *module, cache_reader_t *r)
+{
+    LOAD_STRING(module->psz_shortname);
+    LOAD_STRING(module->psz_longname);
+    if (module->parent == NULL)
+        LOAD_STRING(module->psz_help);
+
+    LOAD_IMMEDIATE(module->i_shortcuts);
+    if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
+        goto error;
+    module->pp_shortcuts = (char **)
+                      xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
+    for (unsigned j = 0; j < module->i_shortcuts; j++)
+        LOAD_STRING(module->pp_shortcuts[j]);
+
+    LOAD_STRING(module->psz_capability);
+    LOAD_IMMEDIATE(module->i_score);
+    return 0;
+error:
+    /* Do not let vlc_module_destroy() walk unset shortcuts */
+    module->i_shortcuts = 0;
+    return -1;
+}
+
+/**
+ * Frees the configuration of a module loaded from the plugins cache.
+ * Unlike config_Free(), this leaves alone strings from the cache mapping.
+ */
+void CacheFreeConfig (module_config_t *config, size_t confsize)
+{
+    for (size_t j = 0; j < confsize; j++)
+    {
+        module_config_t *p_item = config + j;
+
+        if (IsConfigStringType (p_item->i_type))
+        {
+            free (p_item->value.psz);
+            if (p_item->list_count)
+                free (p_item->list.psz);
+        }
+        else
+        if (p_item->list_count)
+            free (p_item->list.i);
+        free (p_item->list_text);
+    }
+    free (config);
 }
 
 
@@ -226,26 +295,28 @@ error:
  * will in turn be queried by AllocateAllPlugins() to see if it needs to
  * actually load the dynamically loadable module.
  * This allows us to only fully load plugins when they are actually used.
+ *
+ * The file mapping is appended to *maps on success. It must be released with
+ * block_ChainRelease() only after all the cached modules were destroyed.
  */
-size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
+size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **pp,
+                  block_t **maps )
 {
     char *psz_filename;
-    FILE *file;
-    int i_size, i_read;
-    char p_cachestring[sizeof(CACHE_STRING)];
+    char p_cachestring[sizeof(CACHE_STRING) - 1];
+    uint32_t i_marker, i_strings_offset, i_strings_size;
     size_t i_cache;
-    int32_t i_marker;
 
     assert( dir != NULL );
 
-    *r = NULL;
+    *pp = NULL;
     if( asprintf( &psz_filename, "%s"DIR_SEP CACHE_NAME, dir ) == -1 )
         return 0;
 
     msg_Dbg( p_this, "loading plugins cache file %s", psz_filename );
 
-    file = vlc_fopen( psz_filename, "rb" );
-    if( !file )
+    block_t *map = block_FilePath( psz_filename );
+    if( map == NULL )
     {
         msg_Warn( p_this, "cannot read %s (%m)",
                   psz_filename );
@@ -254,91 +325,90 @@ size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
     }
     free( psz_filename );
 
+    cache_reader_t reader, *r = &reader;
+    reader.p = map->p_buffer;
+    reader.end = map->p_buffer + map->i_buffer;
+    reader.strings = NULL;
+    reader.strings_size = 0;
+
     /* Check the file is a plugins cache */
-    i_size = sizeof(CACHE_STRING) - 1;
-    i_read = fread( p_cachestring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_cachestring, CACHE_STRING, i_size ) )
+    if( CacheLoadBytes( p_cachestring, sizeof(p_cachestring), r ) ||
+        memcmp( p_cachestring, CACHE_STRING, sizeof(p_cachestring) ) )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
+        block_Release( map );
         return 0;
     }
 
 #ifdef DISTRO_VERSION
     /* Check for distribution specific version */
-    char p_distrostring[sizeof( DISTRO_VERSION )];
-    i_size = sizeof( DISTRO_VERSION ) - 1;
-    i_read = fread( p_distrostring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_distrostring, DISTRO_VERSION, i_size ) )
+    char p_distrostring[sizeof( DISTRO_VERSION ) - 1];
+    if( CacheLoadBytes( p_distrostring, sizeof(p_distrostring), r ) ||
+        memcmp( p_distrostring, DISTRO_VERSION, sizeof(p_distrostring) ) )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
+        block_Release( map );
         return 0;
     }
 #endif
 
     /* Check Sub-version number */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) || i_marker != CACHE_SUBVERSION_NUM )
+    if( CacheLoadBytes( &i_marker, sizeof(i_marker), r ) ||
+        i_marker != CACHE_SUBVERSION_NUM )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache "
                   "(corrupted header)" );
-        fclose( file );
+        block_Release( map );
         return 0;
     }
 
-    /* Check header marker */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) ||
-        i_marker != ftell( file ) - (int)sizeof(i_marker) )
+    /* Locate the string table */
+    if( CacheLoadBytes( &i_strings_offset, sizeof(i_strings_offset), r ) ||
+        CacheLoadBytes( &i_strings_size, sizeof(i_strings_size), r ) ||
+        i_strings_offset < (size_t)(r->p - map->p_buffer) ||
+        i_strings_offset > map->i_buffer ||
+        i_strings_size < 2 ||
+        i_strings_size > map->i_buffer - i_strings_offset ||
+        map->p_buffer[i_strings_offset + i_strings_size - 1] != '\0' )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache "
                   "(corrupted header)" );
-        fclose( file );
+        block_Release( map );
         return 0;
     }
+    reader.strings = (const char *)map->p_buffer + i_strings_offset;
+    reader.strings_size = i_strings_size;
+    reader.end = map->p_buffer + i_strings_offset;
 
-    if (fread( &i_cache, 1, sizeof(i_cache), file ) != sizeof(i_cache) )
+    if( CacheLoadBytes( &i_cache, sizeof(i_cache), r ) ||
+        i_cache > (size_t)(r->end - r->p) )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache "
                   "(file too short)" );
-        fclose( file );
+        block_Release( map );
         return 0;
     }
 
     module_cache_t *cache = NULL;
+    size_t count = 0;
+    module_t *module = NULL;
 
-    for (size_t count = 0; count < i_cache;)
+    while (count < i_cache)
     {
-        module_t *module;
         int i_submodules;
 
         module = vlc_module_create (NULL);
+        if (unlikely(module == NULL))
+            goto error;
+        module->b_mapped = true;
 
         /* Load additional infos */
-        LOAD_STRING(module->psz_shortname);
-        LOAD_STRING(module->psz_longname);
-        LOAD_STRING(module->psz_help);
-
-        LOAD_IMMEDIATE(module->i_shortcuts);
-        if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
+        if (CacheLoadModuleInfo (module, r))
             goto error;
-        else
-        {
-            module->pp_shortcuts = (char **)
-                              xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);			// sunqueen modify
-            for (unsigned j = 0; j < module->i_shortcuts; j++)
-                LOAD_STRING(module->pp_shortcuts[j]);
-        }
-
-        LOAD_STRING(module->psz_capability);
-        LOAD_IMMEDIATE(module->i_score);
         LOAD_IMMEDIATE(module->b_unloadable);
 
         /* Config stuff */
-        if (CacheLoadModuleConfig (module, file) != VLC_SUCCESS)
+        if (CacheLoadModuleConfig (module, r) != VLC_SUCCESS)
             goto error;
 
         LOAD_STRING(module->domain);
@@ -347,26 +417,14 @@ size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
 
         LOAD_IMMEDIATE( i_submodules );
 
-        while( i_submodules-- )
+        while( i_submodules-- > 0 )
         {
             module_t *submodule = vlc_module_create (module);
-            free (submodule->pp_shortcuts);
-            LOAD_STRING(submodule->psz_shortname);
-            LOAD_STRING(submodule->psz_longname);
-
-            LOAD_IMMEDIATE(submodule->i_shortcuts);
-            if (submodule->i_shortcuts > MODULE_SHORTCUT_MAX)
+            if (unlikely(submodule == NULL))
+                goto error;
+            submodule->b_mapped = true;
+            if (CacheLoadModuleInfo (submodule, r))
                 goto error;
-            else
-            {
-                submodule->pp_shortcuts = (char **)
-                           xmalloc (sizeof (*submodule->pp_shortcuts) * submodule->i_shortcuts);			// sunqueen modify
-                for (unsigned j = 0; j < submodule->i_shortcuts; j++)
-                    LOAD_STRING(submodule->pp_shortcuts[j]);
-            }
-
-            LOAD_STRING(submodule->psz_capability);
-            LOAD_IMMEDIATE(submodule->i_score);
         }
 
         char *path;
@@ -379,20 +437,76 @@ size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
         LOAD_IMMEDIATE(st.st_mtime);
         LOAD_IMMEDIATE(st.st_size);
 
-        CacheAdd (&cache, &count, path, &st, module);
-        free (path);
-        /* TODO: deal with errors */
+        if (CacheAdd (&cache, &count, path, &st, module))
+            goto error;
+        module = NULL;
     }
-    fclose( file );
 
-    *r = cache;
-    return i_cache;
+    map->p_next = *maps;
+    *maps = map;
+    *pp = cache;
+    return count;
 
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
-    fclose( file );
+    if (module != NULL)
+        vlc_module_destroy (module);
+    for (size_t i = 0; i < count; i++)
+    {
+        vlc_module_destroy (cache[i].p_module);
+        free (cache[i].path);
+    }
+    free (cache);
+    block_Release (map);
+    return 0;
+}
+
+/* String table under construction, see CacheLoad() for the format */
+typedef struct
+{
+    vlc_dictionary_t offsets; /**< offset of each string in the table */
+    char            *buf;
+    size_t           size;
+    size_t           alloc;
+} cache_strtab_t;
+
+static int CacheSaveString (FILE *file, cache_strtab_t *tab, const char *str)
+{
+    uint32_t offset = 0;
+
+    if (str != NULL && *str == '\0')
+        offset = 1;
+    else if (str != NULL)
+    {
+        void *val = vlc_dictionary_value_for_key (&tab->offsets, str);
+        if (val != kVLCDictionaryNotFound)
+            offset = (uintptr_t)val;
+        else
+        {
+            size_t len = strlen (str) + 1;
+
+            if (tab->size + len > UINT32_MAX)
+                return -1;
+            if (tab->size + len > tab->alloc)
+            {
+                size_t alloc = 2 * (tab->size + len);
+                char *buf = (char *)realloc (tab->buf, alloc);
+                if (unlikely(buf == NULL))
+                    return -1;
+                tab->buf = buf;
+                tab->alloc = alloc;
+            }
+            memcpy (tab->buf + tab->size, str, len);
+            offset = tab->size;
+            tab->size += len;
+            vlc_dictionary_insert (&tab->offsets, str,
+                                   (void *)(uintptr_t)offset);
+        }
+    }
+
+    if (fwrite (&offset, sizeof (offset), 1, file) != 1)
+        return -1;
     return 0;
 }
 
@@ -405,24 +519,12 @@ error:
         SAVE_IMMEDIATE(b); \
     } while (0)
 
-static int CacheSaveString (FILE *file, const char *str)
-{
-    uint16_t size = (str != NULL) ? strlen (str) : 0;
-
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite (str, 1, size, file) != size)
-    {
-error:
-        return -1;
-    }
-    return 0;
-}
-
 #define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
+    if (CacheSaveString (file, tab, (a))) \
         goto error
 
-static int CacheSaveConfig (FILE *file, const module_config_t *cfg)
+static int CacheSaveConfig (FILE *file, cache_strtab_t *tab,
+                            const module_config_t *cfg)
 {
     SAVE_IMMEDIATE (cfg->i_type);
     SAVE_IMMEDIATE (cfg->i_short);
@@ -463,7 +565,8 @@ error:
     return -1;
 }
 
-static int CacheSaveModuleConfig (FILE *file, const module_t *module)
+static int CacheSaveModuleConfig (FILE *file, cache_strtab_t *tab,
+                                  const module_t *module)
 {
     uint16_t lines = module->confsize;
 
@@ -472,7 +575,7 @@ static int CacheSaveModuleConfig (FILE *file, const module_t *module)
     SAVE_IMMEDIATE (lines);
 
     for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig (file, module->p_config + i))
+        if (CacheSaveConfig (file, tab, module->p_config + i))
            goto error;
 
     return 0;
@@ -480,6 +583,24 @@ error:
     return -1;
 }
 
+static int CacheSaveModuleInfo (FILE *file, cache_strtab_t *tab,
+                                const module_t *module)
+{
+    SAVE_STRING(module->psz_shortname);
+    SAVE_STRING(module->psz_longname);
+    if (module->parent == NULL)
+        SAVE_STRING(module->psz_help);
+    SAVE_IMMEDIATE(module->i_shortcuts);
+    for (unsigned j = 0; j < module->i_shortcuts; j++)
+        SAVE_STRING(module->pp_shortcuts[j]);
+
+    SAVE_STRING(module->psz_capability);
+    SAVE_IMMEDIATE(module->i_score);
+    return 0;
+error:
+    return -1;
+}
+
 static int CacheSaveBank( FILE *file, const module_cache_t *, size_t );
 
 /**
@@ -531,12 +652,23 @@ out:
     free (entries);
 }
 
-static int CacheSaveSubmodule (FILE *, const module_t *);
+static int CacheSaveSubmodule (FILE *, cache_strtab_t *, const module_t *);
 
 static int CacheSaveBank (FILE *file, const module_cache_t *cache,
                           size_t i_cache)
 {
-    uint32_t i_file_size = 0;
+    cache_strtab_t strtab, *tab = &strtab;
+    uint32_t i_file_size = 0, i_strings_offset, i_strings_size;
+    long i_table_pos, i_strings_pos;
+    int ret = -1;
+
+    vlc_dictionary_init (&strtab.offsets, 4096);
+    strtab.buf = (char *)malloc (65536);
+    strtab.size = 2; /* offset 0 is NULL, offset 1 is the empty string */
+    strtab.alloc = 65536;
+    if (unlikely(strtab.buf == NULL))
+        goto error;
+    strtab.buf[0] = strtab.buf[1] = '\0';
 
     /* Contains version number */
     if (fputs (CACHE_STRING, file) == EOF)
@@ -552,9 +684,12 @@ static int CacheSaveBank (FILE *file, const module_cache_t *cache,
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1 )
         goto error;
 
-    /* Header marker */
-    i_file_size = ftell( file );
-    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
+    /* String table location, filled in at the end */
+    i_table_pos = ftell (file);
+    i_file_size = 0;
+    if (i_table_pos == -1
+     || fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1
+     || fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
     if (fwrite( &i_cache, sizeof (i_cache), 1, file) != 1)
@@ -566,26 +701,19 @@ static int CacheSaveBank (FILE *file, const module_cache_t *cache,
         uint32_t i_submodule;
 
         /* Save additional infos */
-        SAVE_STRING(module->psz_shortname);
-        SAVE_STRING(module->psz_longname);
-        SAVE_STRING(module->psz_help);
-        SAVE_IMMEDIATE(module->i_shortcuts);
-        for (unsigned j = 0; j < module->i_shortcuts; j++)
-            SAVE_STRING(module->pp_shortcuts[j]);
-
-        SAVE_STRING(module->psz_capability);
-        SAVE_IMMEDIATE(module->i_score);
+        if (CacheSaveModuleInfo (file, tab, module))
+            goto error;
         SAVE_IMMEDIATE(module->b_unloadable);
 
         /* Config stuff */
-        if (CacheSaveModuleConfig (file, module))
+        if (CacheSaveModuleConfig (file, tab, module))
             goto error;
 
         SAVE_STRING(module->domain);
 
         i_submodule = module->submodule_count;
         SAVE_IMMEDIATE( i_submodule );
-        if (CacheSaveSubmodule (file, module->submodule))
+        if (CacheSaveSubmodule (file, tab, module->submodule))
             goto error;
 
         /* Save common info */
@@ -594,29 +722,39 @@ static int CacheSaveBank (FILE *file, const module_cache_t *cache,
         SAVE_IMMEDIATE(cache[i].size);
     }
 
+    /* String table */
+    i_strings_pos = ftell (file);
+    i_strings_offset = i_strings_pos;
+    i_strings_size = strtab.size;
+    if (i_strings_pos == -1
+     || fwrite (strtab.buf, 1, strtab.size, file) != strtab.size)
+        goto error;
+
+    if (fseek (file, i_table_pos, SEEK_SET)
+     || fwrite (&i_strings_offset, sizeof (i_strings_offset), 1, file) != 1
+     || fwrite (&i_strings_size, sizeof (i_strings_size), 1, file) != 1)
+        goto error;
+
     if (fflush (file)) /* flush libc buffers */
         goto error;
-    return 0; /* success! */
+    ret = 0; /* success! */
 
 error:
-    return -1;
+    vlc_dictionary_clear (&strtab.offsets, NULL, NULL);
+    free (strtab.buf);
+    return ret;
 }
 
-static int CacheSaveSubmodule( FILE *file, const module_t *p_module )
+static int CacheSaveSubmodule( FILE *file, cache_strtab_t *tab,
+                               const module_t *p_module )
 {
     if( !p_module )
         return 0;
-    if( CacheSaveSubmodule( file, p_module->next ) )
+    if( CacheSaveSubmodule( file, tab, p_module->next ) )
         goto error;
 
-    SAVE_STRING( p_module->psz_shortname );
-    SAVE_STRING( p_module->psz_longname );
-    SAVE_IMMEDIATE( p_module->i_shortcuts );
-    for( unsigned j = 0; j < p_module->i_shortcuts; j++ )
-         SAVE_STRING( p_module->pp_shortcuts[j] );
-
-    SAVE_STRING( p_module->psz_capability );
-    SAVE_IMMEDIATE( p_module->i_score );
+    if( CacheSaveModuleInfo( file, tab, p_module ) )
+        goto error;
     return 0;
 
 error:
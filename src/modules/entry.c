@@ -74,6 +74,7 @@ module_t *vlc_module_create (module_t *parent)
     module->i_score = (parent != NULL) ? parent->i_score : 1;
     module->b_loaded = false;
     module->b_unloadable = parent == NULL;
+    module->b_mapped = false;
     module->pf_activate = NULL;
     module->pf_deactivate = NULL;
     module->p_config = NULL;
@@ -100,10 +101,20 @@ void vlc_module_destroy (module_t *module)
         vlc_module_destroy (m);
     }
 
+    free (module->psz_filename);
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (module->b_mapped)
+    {   /* Strings belong to the plugins cache map, see CacheLoad() */
+        CacheFreeConfig (module->p_config, module->confsize);
+        free (module->pp_shortcuts);
+        free (module);
+        return;
+    }
+#endif
+
     config_Free (module->p_config, module->confsize);
 
     free (module->domain);
-    free (module->psz_filename);
     for (unsigned i = 0; i < module->i_shortcuts; i++)
         free (module->pp_shortcuts[i]);
     free (module->pp_shortcuts);
@@ -78,6 +78,7 @@ struct module_t
 
     bool          b_loaded;        /* Set to true if the dll is loaded */
     bool b_unloadable;                        /**< Can we be dlclosed? */
+    bool b_mapped;   /**< Strings are borrowed from the plugins cache map */
 
     /* Callbacks */
     void *pf_activate;
@@ -123,7 +124,9 @@ void module_Unload (module_handle_t);
 /* Plugins cache */
 void   CacheMerge (vlc_object_t *, module_t *, module_t *);
 void   CacheDelete(vlc_object_t *, const char *);
-size_t CacheLoad  (vlc_object_t *, const char *, module_cache_t **);
+size_t CacheLoad  (vlc_object_t *, const char *, module_cache_t **,
+                   block_t **);
+void   CacheFreeConfig (module_config_t *, size_t);
 
 struct stat;
 
@@ -236,6 +236,11 @@ static playlist_t *playlist_Create( vlc_object_t *p_parent )
     pl_priv(p_playlist)->b_auto_preparse =
         var_InheritBool( p_parent, "auto-preparse" );
 
+    /* Live search index */
+    p->p_search = playlist_SearchIndexNew();
+    if( unlikely(p->p_search == NULL) )
+        msg_Err( p_playlist, "cannot create search index" );
+
     /* Fetcher */
     p->p_fetcher = playlist_fetcher_New( VLC_OBJECT(p_playlist) );
     if( unlikely(p->p_fetcher == NULL) )
@@ -381,6 +386,9 @@ void playlist_Destroy( playlist_t *p_playlist )
     ARRAY_RESET( p_playlist->items );
     ARRAY_RESET( p_playlist->current );
 
+    if( p_sys->p_search )
+        playlist_SearchIndexDelete( p_sys->p_search );
+
     vlc_object_release( p_playlist );
 }
 
@@ -181,7 +181,11 @@ static void input_item_changed( const vlc_event_t * p_event,
                                 void * user_data )
 {
     playlist_item_t *p_item = (playlist_item_t *)user_data;			// sunqueen modify
-    VLC_UNUSED( p_event );
+    playlist_search_t *p_search = pl_priv(p_item->p_playlist)->p_search;
+
+    if( p_search && ( p_event->type == vlc_InputItemMetaChanged ||
+                      p_event->type == vlc_InputItemNameChanged ) )
+        playlist_SearchIndexInvalidate( p_search, p_item->i_id );
     var_SetAddress( p_item->p_playlist, "item-change", p_item->p_input );
 }
 
@@ -247,6 +251,10 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
 
     install_input_item_observer( p_item );
 
+    if( pl_priv(p_playlist)->p_search )
+        playlist_SearchIndexInvalidate( pl_priv(p_playlist)->p_search,
+                                        p_item->i_id );
+
     return p_item;
 }
 
@@ -274,6 +282,9 @@ int playlist_ItemRelease( playlist_item_t *p_item )
      *
      * Who wants to add proper memory management? */
     uninstall_input_item_observer( p_item );
+    if( pl_priv(p_playlist)->p_search )
+        playlist_SearchIndexInvalidate( pl_priv(p_playlist)->p_search,
+                                        p_item->i_id );
     ARRAY_APPEND( (playlist_item_t **), pl_priv(p_playlist)->items_to_delete, p_item);			// sunqueen modify
     return VLC_SUCCESS;
 }
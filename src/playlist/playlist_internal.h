@@ -42,12 +42,14 @@
 #include "preparser.h"
 
 typedef struct vlc_sd_internal_t vlc_sd_internal_t;
+typedef struct playlist_search_t playlist_search_t;
 
 typedef struct playlist_private_t
 {
     playlist_t           public_data;
     playlist_preparser_t *p_preparser;  /**< Preparser data */
     playlist_fetcher_t   *p_fetcher;    /**< Meta and art fetcher data */
+    playlist_search_t    *p_search;     /**< Live search index */
 
     playlist_item_array_t items_to_delete; /**< Array of items and nodes to
             delete... At the very end. This sucks. */
@@ -112,6 +114,11 @@ playlist_item_t * get_current_status_node( playlist_t * p_playlist );
 void set_current_status_item( playlist_t *, playlist_item_t * );
 void set_current_status_node( playlist_t *, playlist_item_t * );
 
+/* Live search index */
+playlist_search_t *playlist_SearchIndexNew( void );
+void playlist_SearchIndexDelete( playlist_search_t * );
+void playlist_SearchIndexInvalidate( playlist_search_t *, int );
+
 /* Load/Save */
 int playlist_MLLoad( playlist_t *p_playlist );
 int playlist_MLDump( playlist_t *p_playlist );
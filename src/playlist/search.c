@@ -30,6 +30,8 @@
 #include <vlc_common.h>
 #include <vlc_playlist.h>
 #include <vlc_charset.h>
+#include <wctype.h>
+#include "../libvlc.h"
 #include "playlist_internal.h"
 
 /***************************************************************************
@@ -83,6 +85,491 @@ playlist_item_t* playlist_ItemGetByInput( playlist_t * p_playlist,
 }
 
 
+/***************************************************************************
+ * Live search index
+ ***************************************************************************/
+
+/*
+ * Every playlist item gets a normalized (lower-cased UTF-8) copy of the
+ * strings the live search looks at, and each three-byte sequence of that
+ * text is recorded in a posting list of item ids. A query of three bytes or
+ * more therefore only needs to check the items of its rarest trigram, and a
+ * query which extends the previous one only needs to re-check the previous
+ * matches. Meta changes only queue the item id; the index is brought up to
+ * date lazily, under the playlist lock, by the next search.
+ */
+
+typedef struct
+{
+    char    *psz_text;  /**< normalized searchable text */
+    unsigned i_match;   /**< generation of the last query it matched */
+} search_entry_t;
+
+typedef struct
+{
+    uint32_t i_key;     /**< packed trigram, 0 for an empty slot */
+    int      i_count;
+    int      i_size;
+    int     *pi_ids;    /**< sorted playlist item ids */
+} search_posting_t;
+
+TYPEDEF_ARRAY(int, search_id_array_t)
+
+struct playlist_search_t
+{
+    vlc_mutex_t lock;           /**< protects the dirty set only */
+    search_id_array_t dirty;    /**< ids of items to (re)index */
+    uint8_t *pb_dirty;          /**< per-id membership of the dirty set */
+    int      i_dirty_max;
+
+    /* The rest is protected by the playlist lock */
+    search_entry_t **pp_entries;    /**< indexed by playlist item id */
+    int              i_entries;
+
+    search_posting_t *p_postings;   /**< open-addressed on the trigram */
+    unsigned          i_postings_size;
+    unsigned          i_postings_count;
+
+    char    *psz_last;          /**< normalized previous query */
+    search_id_array_t results;  /**< ids matching the previous query */
+    unsigned i_match;           /**< current query generation */
+};
+
+playlist_search_t *playlist_SearchIndexNew( void )
+{
+    playlist_search_t *p_search =
+        (playlist_search_t *)calloc( 1, sizeof( *p_search ) );
+    if( !p_search )
+        return NULL;
+
+    vlc_mutex_init( &p_search->lock );
+    ARRAY_INIT( p_search->dirty );
+    ARRAY_INIT( p_search->results );
+    return p_search;
+}
+
+void playlist_SearchIndexDelete( playlist_search_t *p_search )
+{
+    for( int i = 0; i < p_search->i_entries; i++ )
+    {
+        if( p_search->pp_entries[i] )
+        {
+            free( p_search->pp_entries[i]->psz_text );
+            free( p_search->pp_entries[i] );
+        }
+    }
+    free( p_search->pp_entries );
+
+    for( unsigned i = 0; i < p_search->i_postings_size; i++ )
+        free( p_search->p_postings[i].pi_ids );
+    free( p_search->p_postings );
+
+    free( p_search->psz_last );
+    ARRAY_RESET( p_search->results );
+    ARRAY_RESET( p_search->dirty );
+    free( p_search->pb_dirty );
+    vlc_mutex_destroy( &p_search->lock );
+    free( p_search );
+}
+
+/**
+ * Queue an item for (re)indexing.
+ * This can be called from any thread, with or without the playlist lock.
+ * @param p_search: the search index
+ * @param i_id: the playlist item id that was created, changed or removed
+ */
+void playlist_SearchIndexInvalidate( playlist_search_t *p_search, int i_id )
+{
+    vlc_mutex_lock( &p_search->lock );
+    if( i_id >= p_search->i_dirty_max )
+    {
+        int i_max = __MAX( 2 * p_search->i_dirty_max, i_id + 1024 );
+        uint8_t *pb = (uint8_t *)realloc( p_search->pb_dirty, i_max );
+        if( unlikely(pb == NULL) )
+        {
+            vlc_mutex_unlock( &p_search->lock );
+            return;
+        }
+        memset( pb + p_search->i_dirty_max, 0, i_max - p_search->i_dirty_max );
+        p_search->pb_dirty = pb;
+        p_search->i_dirty_max = i_max;
+    }
+    if( !p_search->pb_dirty[i_id] )
+    {
+        p_search->pb_dirty[i_id] = 1;
+        ARRAY_APPEND( (int *), p_search->dirty, i_id );
+    }
+    vlc_mutex_unlock( &p_search->lock );
+}
+
+/**
+ * Lower-case an UTF-8 string code point by code point, so that a plain
+ * strstr() on normalized strings behaves like vlc_strcasestr().
+ */
+static char *SearchNormalize( const char *psz )
+{
+    size_t i_len = strlen( psz );
+    /* towlower() never needs more than 4 bytes per code point */
+    char *psz_norm = (char *)malloc( 4 * i_len + 1 );
+    if( !psz_norm )
+        return NULL;
+
+    char *p = psz_norm;
+    while( *psz )
+    {
+        uint32_t cp;
+        size_t s = vlc_towc( psz, &cp );
+        if( s == (size_t)-1 )
+        {
+            /* Keep invalid bytes as is, they can only match themselves */
+            *p++ = *psz++;
+            continue;
+        }
+        psz += s;
+
+        cp = towlower( cp );
+        if( cp < 0x80 )
+            *p++ = cp;
+        else if( cp < 0x800 )
+        {
+            *p++ = 0xC0 | (cp >> 6);
+            *p++ = 0x80 | (cp & 0x3F);
+        }
+        else if( cp < 0x10000 )
+        {
+            *p++ = 0xE0 | (cp >> 12);
+            *p++ = 0x80 | ((cp >> 6) & 0x3F);
+            *p++ = 0x80 | (cp & 0x3F);
+        }
+        else
+        {
+            *p++ = 0xF0 | (cp >> 18);
+            *p++ = 0x80 | ((cp >> 12) & 0x3F);
+            *p++ = 0x80 | ((cp >> 6) & 0x3F);
+            *p++ = 0x80 | (cp & 0x3F);
+        }
+    }
+    *p = '\0';
+    return psz_norm;
+}
+
+/**
+ * Build the normalized text of an item: its title (or name), album and
+ * artist, one per line.
+ */
+static char *SearchItemText( playlist_item_t *p_item )
+{
+    input_item_t *p_input = p_item->p_input;
+    char *psz_raw;
+    int i_ret;
+
+    vlc_mutex_lock( &p_input->lock );
+    if( p_input->p_meta )
+    {
+        const char *psz_title = vlc_meta_Get( p_input->p_meta, vlc_meta_Title );
+        const char *psz_album = vlc_meta_Get( p_input->p_meta, vlc_meta_Album );
+        const char *psz_artist = vlc_meta_Get( p_input->p_meta, vlc_meta_Artist );
+        if( !psz_title )
+            psz_title = p_input->psz_name;
+        i_ret = asprintf( &psz_raw, "%s\n%s\n%s",
+                          psz_title ? psz_title : "",
+                          psz_album ? psz_album : "",
+                          psz_artist ? psz_artist : "" );
+    }
+    else
+        i_ret = asprintf( &psz_raw, "%s",
+                          p_input->psz_name ? p_input->psz_name : "" );
+    vlc_mutex_unlock( &p_input->lock );
+
+    if( i_ret == -1 )
+        return NULL;
+    char *psz_text = SearchNormalize( psz_raw );
+    free( psz_raw );
+    return psz_text;
+}
+
+static inline uint32_t SearchTrigram( const char *psz )
+{
+    return ((uint8_t)psz[0] << 16) | ((uint8_t)psz[1] << 8) | (uint8_t)psz[2];
+}
+
+static search_posting_t *SearchPostingFind( playlist_search_t *p_search,
+                                            uint32_t i_key )
+{
+    if( p_search->i_postings_size == 0 )
+        return NULL;
+
+    unsigned i_mask = p_search->i_postings_size - 1;
+    for( unsigned i = (i_key * 2654435761u) & i_mask;; i = (i + 1) & i_mask )
+    {
+        search_posting_t *p_posting = &p_search->p_postings[i];
+        if( p_posting->i_key == i_key )
+            return p_posting;
+        if( p_posting->i_key == 0 )
+            return NULL;
+    }
+}
+
+static search_posting_t *SearchPostingGet( playlist_search_t *p_search,
+                                           uint32_t i_key )
+{
+    search_posting_t *p_posting = SearchPostingFind( p_search, i_key );
+    if( p_posting )
+        return p_posting;
+
+    /* Keep the load factor under 1/2 */
+    if( 2 * (p_search->i_postings_count + 1) > p_search->i_postings_size )
+    {
+        unsigned i_size = p_search->i_postings_size ?
+                          2 * p_search->i_postings_size : 4096;
+        search_posting_t *p_old = p_search->p_postings;
+        unsigned i_old = p_search->i_postings_size;
+
+        p_search->p_postings =
+            (search_posting_t *)calloc( i_size, sizeof( search_posting_t ) );
+        if( unlikely(p_search->p_postings == NULL) )
+        {
+            p_search->p_postings = p_old;
+            return NULL;
+        }
+        p_search->i_postings_size = i_size;
+        for( unsigned i = 0; i < i_old; i++ )
+        {
+            if( p_old[i].i_key == 0 )
+                continue;
+            unsigned j = (p_old[i].i_key * 2654435761u) & (i_size - 1);
+            while( p_search->p_postings[j].i_key != 0 )
+                j = (j + 1) & (i_size - 1);
+            p_search->p_postings[j] = p_old[i];
+        }
+        free( p_old );
+    }
+
+    unsigned i_mask = p_search->i_postings_size - 1;
+    unsigned i = (i_key * 2654435761u) & i_mask;
+    while( p_search->p_postings[i].i_key != 0 )
+        i = (i + 1) & i_mask;
+    p_posting = &p_search->p_postings[i];
+    p_posting->i_key = i_key;
+    p_search->i_postings_count++;
+    return p_posting;
+}
+
+/* Binary search for the position of i_id in a sorted id array */
+static int SearchIdPosition( const int *pi_ids, int i_count, int i_id )
+{
+    int i_low = 0, i_high = i_count;
+    while( i_low < i_high )
+    {
+        int i_mid = (i_low + i_high) / 2;
+        if( pi_ids[i_mid] < i_id )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+static void SearchPostingAdd( search_posting_t *p_posting, int i_id )
+{
+    int i_pos = SearchIdPosition( p_posting->pi_ids, p_posting->i_count, i_id );
+    if( i_pos < p_posting->i_count && p_posting->pi_ids[i_pos] == i_id )
+        return; /* trigram seen twice in the same text */
+
+    if( p_posting->i_count == p_posting->i_size )
+    {
+        int i_size = p_posting->i_size ? 2 * p_posting->i_size : 4;
+        int *pi_ids = (int *)realloc( p_posting->pi_ids,
+                                      i_size * sizeof( int ) );
+        if( unlikely(pi_ids == NULL) )
+            return;
+        p_posting->pi_ids = pi_ids;
+        p_posting->i_size = i_size;
+    }
+    /* New items have the highest ids, so this is usually an append */
+    memmove( &p_posting->pi_ids[i_pos + 1], &p_posting->pi_ids[i_pos],
+             (p_posting->i_count - i_pos) * sizeof( int ) );
+    p_posting->pi_ids[i_pos] = i_id;
+    p_posting->i_count++;
+}
+
+static void SearchPostingRemove( search_posting_t *p_posting, int i_id )
+{
+    int i_pos = SearchIdPosition( p_posting->pi_ids, p_posting->i_count, i_id );
+    if( i_pos >= p_posting->i_count || p_posting->pi_ids[i_pos] != i_id )
+        return;
+    memmove( &p_posting->pi_ids[i_pos], &p_posting->pi_ids[i_pos + 1],
+             (p_posting->i_count - i_pos - 1) * sizeof( int ) );
+    p_posting->i_count--;
+}
+
+static void SearchEntryRemove( playlist_search_t *p_search, int i_id )
+{
+    if( i_id >= p_search->i_entries || !p_search->pp_entries[i_id] )
+        return;
+
+    search_entry_t *p_entry = p_search->pp_entries[i_id];
+    if( p_entry->psz_text )
+    {
+        for( const char *p = p_entry->psz_text; p[0] && p[1] && p[2]; p++ )
+        {
+            search_posting_t *p_posting =
+                SearchPostingFind( p_search, SearchTrigram( p ) );
+            if( p_posting )
+                SearchPostingRemove( p_posting, i_id );
+        }
+        free( p_entry->psz_text );
+    }
+    free( p_entry );
+    p_search->pp_entries[i_id] = NULL;
+}
+
+static void SearchEntryAdd( playlist_search_t *p_search,
+                            playlist_item_t *p_item )
+{
+    const int i_id = p_item->i_id;
+
+    if( i_id >= p_search->i_entries )
+    {
+        int i_entries = __MAX( 2 * p_search->i_entries, i_id + 1024 );
+        search_entry_t **pp_entries = (search_entry_t **)realloc(
+                p_search->pp_entries, i_entries * sizeof( search_entry_t * ) );
+        if( unlikely(pp_entries == NULL) )
+            return;
+        memset( pp_entries + p_search->i_entries, 0,
+                (i_entries - p_search->i_entries) * sizeof( search_entry_t * ) );
+        p_search->pp_entries = pp_entries;
+        p_search->i_entries = i_entries;
+    }
+
+    search_entry_t *p_entry = (search_entry_t *)malloc( sizeof( *p_entry ) );
+    if( unlikely(p_entry == NULL) )
+        return;
+    p_entry->psz_text = SearchItemText( p_item );
+    p_entry->i_match = 0;
+    p_search->pp_entries[i_id] = p_entry;
+
+    if( !p_entry->psz_text )
+        return;
+    for( const char *p = p_entry->psz_text; p[0] && p[1] && p[2]; p++ )
+    {
+        search_posting_t *p_posting =
+            SearchPostingGet( p_search, SearchTrigram( p ) );
+        if( p_posting )
+            SearchPostingAdd( p_posting, i_id );
+    }
+}
+
+/**
+ * Bring the index up to date with the queued changes.
+ * @return true if anything changed, in which case the previous results
+ * cannot be narrowed anymore
+ */
+static bool SearchIndexSync( playlist_t *p_playlist, playlist_search_t *p_search )
+{
+    int *pi_dirty;
+    int i_dirty;
+
+    PL_ASSERT_LOCKED;
+
+    vlc_mutex_lock( &p_search->lock );
+    pi_dirty = p_search->dirty.p_elems;
+    i_dirty = p_search->dirty.i_size;
+    ARRAY_INIT( p_search->dirty );
+    for( int i = 0; i < i_dirty; i++ )
+        p_search->pb_dirty[pi_dirty[i]] = 0;
+    vlc_mutex_unlock( &p_search->lock );
+
+    for( int i = 0; i < i_dirty; i++ )
+    {
+        SearchEntryRemove( p_search, pi_dirty[i] );
+
+        playlist_item_t *p_item = playlist_ItemGetById( p_playlist, pi_dirty[i] );
+        if( p_item )
+            SearchEntryAdd( p_search, p_item );
+    }
+    free( pi_dirty );
+    return i_dirty > 0;
+}
+
+static inline bool SearchEntryMatch( playlist_search_t *p_search, int i_id,
+                                     const char *psz_norm )
+{
+    if( i_id >= p_search->i_entries )
+        return false;
+    search_entry_t *p_entry = p_search->pp_entries[i_id];
+    return p_entry && p_entry->psz_text && strstr( p_entry->psz_text, psz_norm );
+}
+
+/**
+ * Compute the set of item ids matching psz_norm, and tag them with a new
+ * match generation.
+ */
+static void SearchIndexQuery( playlist_search_t *p_search, const char *psz_norm,
+                              bool b_narrow )
+{
+    search_id_array_t results;
+    ARRAY_INIT( results );
+
+    if( b_narrow )
+    {
+        /* The query extends the previous one: its matches are a subset */
+        FOREACH_ARRAY( int i_id, p_search->results )
+            if( SearchEntryMatch( p_search, i_id, psz_norm ) )
+                ARRAY_APPEND( (int *), results, i_id );
+        FOREACH_END()
+    }
+    else if( strlen( psz_norm ) >= 3 )
+    {
+        /* Check the items of the rarest trigram of the query */
+        search_posting_t *p_best = NULL;
+        for( const char *p = psz_norm; p[2]; p++ )
+        {
+            search_posting_t *p_posting =
+                SearchPostingFind( p_search, SearchTrigram( p ) );
+            if( !p_posting || p_posting->i_count == 0 )
+            {
+                /* Some trigram of the query appears nowhere */
+                p_best = NULL;
+                break;
+            }
+            if( !p_best || p_posting->i_count < p_best->i_count )
+                p_best = p_posting;
+        }
+        if( p_best )
+            for( int i = 0; i < p_best->i_count; i++ )
+                if( SearchEntryMatch( p_search, p_best->pi_ids[i], psz_norm ) )
+                    ARRAY_APPEND( (int *), results, p_best->pi_ids[i] );
+    }
+    else
+    {
+        for( int i_id = 0; i_id < p_search->i_entries; i_id++ )
+            if( SearchEntryMatch( p_search, i_id, psz_norm ) )
+                ARRAY_APPEND( (int *), results, i_id );
+    }
+
+    ARRAY_RESET( p_search->results );
+    p_search->results = results;
+
+    if( ++p_search->i_match == 0 )
+    {
+        /* Wrapped around: forget the old tags */
+        for( int i = 0; i < p_search->i_entries; i++ )
+            if( p_search->pp_entries[i] )
+                p_search->pp_entries[i]->i_match = 0;
+        p_search->i_match = 1;
+    }
+    FOREACH_ARRAY( int i_id, p_search->results )
+        p_search->pp_entries[i_id]->i_match = p_search->i_match;
+    FOREACH_END()
+}
+
+static inline bool SearchIsMatched( playlist_search_t *p_search, int i_id )
+{
+    return i_id < p_search->i_entries && p_search->pp_entries[i_id] &&
+           p_search->pp_entries[i_id]->i_match == p_search->i_match;
+}
+
 /***************************************************************************
  * Live search handling
  ***************************************************************************/
@@ -156,7 +643,36 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
    return b_match;
 }
 
+/**
+ * Enable/Disable items in the playlist according to the last index query
+ * @param p_search: the search index
+ * @param p_root: the current root item
+ * @return true if an item match
+ */
+static bool playlist_LiveSearchApply( playlist_search_t *p_search,
+                                      playlist_item_t *p_root, bool b_recursive )
+{
+    bool b_match = false;
+    for( int i = 0; i < p_root->i_children; i++ )
+    {
+        playlist_item_t *p_item = p_root->pp_children[i];
+        bool b_enable = false;
 
+        if( b_recursive && p_item->i_children >= 0 &&
+            playlist_LiveSearchApply( p_search, p_item, true ) )
+            b_enable = true;
+        if( !b_enable )
+            b_enable = SearchIsMatched( p_search, p_item->i_id );
+
+        if( b_enable )
+            p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
+        else
+            p_item->i_flags |= PLAYLIST_DBL_FLAG;
+
+        b_match |= b_enable;
+    }
+    return b_match;
+}
 
 /**
  * Launch the recursive search in the playlist
@@ -168,13 +684,34 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
 int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
                                const char *psz_string, bool b_recursive )
 {
+    playlist_search_t *p_search = pl_priv(p_playlist)->p_search;
+
     PL_ASSERT_LOCKED;
     pl_priv(p_playlist)->b_reset_currently_playing = true;
-    if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
-    else
+    if( !*psz_string )
+    {
         playlist_LiveSearchClean( p_root );
+        if( p_search )
+            FREENULL( p_search->psz_last );
+    }
+    else if( p_search )
+    {
+        bool b_changed = SearchIndexSync( p_playlist, p_search );
+        char *psz_norm = SearchNormalize( psz_string );
+        if( unlikely(psz_norm == NULL) )
+            return VLC_ENOMEM;
+
+        const char *psz_last = p_search->psz_last;
+        if( !psz_last || b_changed || strcmp( psz_norm, psz_last ) )
+            SearchIndexQuery( p_search, psz_norm, !b_changed && psz_last &&
+                                                  strstr( psz_norm, psz_last ) );
+        free( p_search->psz_last );
+        p_search->psz_last = psz_norm;
+
+        playlist_LiveSearchApply( p_search, p_root, b_recursive );
+    }
+    else
+        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
     vlc_cond_signal( &pl_priv(p_playlist)->signal );
     return VLC_SUCCESS;
 }
-
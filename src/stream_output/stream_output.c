@@ -370,6 +370,16 @@ sout_mux_t * sout_MuxNew( sout_instance_t *p_sout, const char *psz_mux,
     p_mux->b_add_stream_any_time = false;
     p_mux->b_waiting_stream = true;
     p_mux->i_add_stream_start = -1;
+    p_mux->i_add_stream_caching =
+        var_GetInteger( p_sout, "sout-mux-caching" ) * INT64_C(1000);
+
+    p_mux->interleaver.pp_heap = NULL;
+    p_mux->interleaver.i_heap = 0;
+    p_mux->interleaver.i_inputs = 0;
+    p_mux->interleaver.i_blocks = 0;
+    p_mux->interleaver.i_waiting = 0;
+    p_mux->interleaver.p_last = NULL;
+    p_mux->interleaver.b_dirty = true;
 
     p_mux->p_module =
         module_need( p_mux, "sout mux", p_mux->psz_mux, true );
@@ -433,6 +443,7 @@ void sout_MuxDelete( sout_mux_t *p_mux )
         module_unneed( p_mux, p_mux->p_module );
     }
     free( p_mux->psz_mux );
+    free( p_mux->interleaver.pp_heap );
 
     config_ChainDestroy( p_mux->p_cfg );
 
@@ -462,6 +473,8 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, es_format_t *p_fmt )
     p_input->p_fmt  = p_fmt;
     p_input->p_fifo = block_FifoNew();
     p_input->p_sys  = NULL;
+    p_input->i_heap = -1;
+    p_mux->interleaver.b_dirty = true;
 
     TAB_APPEND( (sout_input_t **), p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );			// sunqueen modify
     if( p_mux->pf_addstream( p_mux, p_input ) < 0 )
@@ -502,6 +515,9 @@ void sout_MuxDeleteStream( sout_mux_t *p_mux, sout_input_t *p_input )
 
         /* remove the entry */
         TAB_REMOVE( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
+        p_mux->interleaver.b_dirty = true;
+        if( p_mux->interleaver.p_last == p_input )
+            p_mux->interleaver.p_last = NULL;
 
         if( p_mux->i_nb_inputs == 0 )
         {
@@ -513,6 +529,147 @@ void sout_MuxDeleteStream( sout_mux_t *p_mux, sout_input_t *p_input )
     }
 }
 
+/*****************************************************************************
+ * Interleaver: inputs with at least i_blocks blocks are kept in a min-heap
+ * on the dts of their first block (then on their index, like the former
+ * linear scan). Only the input a block was added to, and the last input
+ * returned to the muxer (which it dequeued from), can have changed, so
+ * both are updated in O(log n) instead of scanning all the inputs.
+ *****************************************************************************/
+static bool InterleaverLess( const sout_input_t *a, const sout_input_t *b )
+{
+    if( a->i_heap_dts != b->i_heap_dts )
+        return a->i_heap_dts < b->i_heap_dts;
+    return a->i_index < b->i_index;
+}
+
+static void InterleaverSet( sout_mux_t *p_mux, int i, sout_input_t *p_input )
+{
+    p_mux->interleaver.pp_heap[i] = p_input;
+    p_input->i_heap = i;
+}
+
+static void InterleaverSiftUp( sout_mux_t *p_mux, int i )
+{
+    sout_input_t **pp_heap = p_mux->interleaver.pp_heap;
+    sout_input_t *p_input = pp_heap[i];
+
+    while( i > 0 )
+    {
+        const int i_parent = (i - 1) / 2;
+        if( !InterleaverLess( p_input, pp_heap[i_parent] ) )
+            break;
+        InterleaverSet( p_mux, i, pp_heap[i_parent] );
+        i = i_parent;
+    }
+    InterleaverSet( p_mux, i, p_input );
+}
+
+static void InterleaverSiftDown( sout_mux_t *p_mux, int i )
+{
+    sout_input_t **pp_heap = p_mux->interleaver.pp_heap;
+    const int i_heap = p_mux->interleaver.i_heap;
+    sout_input_t *p_input = pp_heap[i];
+
+    for( ;; )
+    {
+        int i_child = 2 * i + 1;
+        if( i_child >= i_heap )
+            break;
+        if( i_child + 1 < i_heap &&
+            InterleaverLess( pp_heap[i_child + 1], pp_heap[i_child] ) )
+            i_child++;
+        if( !InterleaverLess( pp_heap[i_child], p_input ) )
+            break;
+        InterleaverSet( p_mux, i, pp_heap[i_child] );
+        i = i_child;
+    }
+    InterleaverSet( p_mux, i, p_input );
+}
+
+static void InterleaverRemove( sout_mux_t *p_mux, sout_input_t *p_input )
+{
+    const int i = p_input->i_heap;
+    sout_input_t *p_tail =
+        p_mux->interleaver.pp_heap[--p_mux->interleaver.i_heap];
+
+    p_input->i_heap = -1;
+    if( p_tail == p_input )
+        return;
+    InterleaverSet( p_mux, i, p_tail );
+    InterleaverSiftDown( p_mux, i );
+    InterleaverSiftUp( p_mux, p_tail->i_heap );
+}
+
+/* Puts the input in or out of the heap and updates its position */
+static void InterleaverUpdate( sout_mux_t *p_mux, sout_input_t *p_input )
+{
+    if( p_mux->interleaver.b_dirty )
+        return; /* It will be rebuilt */
+
+    const bool b_ready =
+        block_FifoCount( p_input->p_fifo ) >= (size_t)p_mux->interleaver.i_blocks;
+    const bool b_spu = p_input->p_fmt->i_cat == SPU_ES;
+
+    if( !b_ready )
+    {
+        if( p_input->i_heap >= 0 )
+        {
+            InterleaverRemove( p_mux, p_input );
+            if( !b_spu )
+                p_mux->interleaver.i_waiting++;
+        }
+        return;
+    }
+
+    const mtime_t i_dts = block_FifoShow( p_input->p_fifo )->i_dts;
+    if( p_input->i_heap < 0 )
+    {
+        p_input->i_heap_dts = i_dts;
+        InterleaverSet( p_mux, p_mux->interleaver.i_heap++, p_input );
+        InterleaverSiftUp( p_mux, p_input->i_heap );
+        if( !b_spu )
+            p_mux->interleaver.i_waiting--;
+    }
+    else if( i_dts != p_input->i_heap_dts )
+    {
+        const bool b_later = i_dts > p_input->i_heap_dts;
+        p_input->i_heap_dts = i_dts;
+        if( b_later )
+            InterleaverSiftDown( p_mux, p_input->i_heap );
+        else
+            InterleaverSiftUp( p_mux, p_input->i_heap );
+    }
+}
+
+static int InterleaverBuild( sout_mux_t *p_mux, int i_blocks )
+{
+    sout_input_t **pp_heap = (sout_input_t **)realloc( p_mux->interleaver.pp_heap,
+                                 __MAX( p_mux->i_nb_inputs, 1 ) * sizeof( *pp_heap ) );
+    if( !pp_heap )
+        return VLC_ENOMEM;
+
+    p_mux->interleaver.pp_heap = pp_heap;
+    p_mux->interleaver.i_heap = 0;
+    p_mux->interleaver.i_inputs = p_mux->i_nb_inputs;
+    p_mux->interleaver.i_blocks = i_blocks;
+    p_mux->interleaver.i_waiting = 0;
+    p_mux->interleaver.p_last = NULL;
+    p_mux->interleaver.b_dirty = false;
+
+    for( int i = 0; i < p_mux->i_nb_inputs; i++ )
+    {
+        sout_input_t *p_input = p_mux->pp_inputs[i];
+
+        p_input->i_index = i;
+        p_input->i_heap = -1;
+        if( p_input->p_fmt->i_cat != SPU_ES )
+            p_mux->interleaver.i_waiting++;
+        InterleaverUpdate( p_mux, p_input );
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * sout_MuxSendBuffer:
  *****************************************************************************/
@@ -520,6 +677,7 @@ void sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
                          block_t *p_buffer )
 {
     block_FifoPut( p_input->p_fifo, p_buffer );
+    InterleaverUpdate( p_mux, p_input );
 
     if( p_mux->p_sout->i_out_pace_nocontrol )
     {
@@ -531,7 +689,7 @@ void sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
 
     if( p_mux->b_waiting_stream )
     {
-        const int64_t i_caching = var_GetInteger( p_mux->p_sout, "sout-mux-caching" ) * INT64_C(1000);
+        const int64_t i_caching = p_mux->i_add_stream_caching;
 
         if( p_mux->i_add_stream_start < 0 )
             p_mux->i_add_stream_start = p_buffer->i_dts;
@@ -548,38 +706,66 @@ void sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
 
 /*****************************************************************************
  * sout_MuxGetStream: find stream to be muxed
+ *****************************************************************************
+ * It returns the index of the input whose first block has the lowest dts,
+ * or -1 if an audio or video input has less than i_blocks blocks. SPU inputs
+ * with less than i_blocks blocks are ignored.
+ * The muxer may dequeue blocks from the returned input only.
  *****************************************************************************/
 int sout_MuxGetStream( sout_mux_t *p_mux, int i_blocks, mtime_t *pi_dts )
 {
-    mtime_t i_dts = 0;
-    int     i_stream = -1;
-
-    for( int i = 0; i < p_mux->i_nb_inputs; i++ )
+    if( p_mux->interleaver.b_dirty ||
+        p_mux->interleaver.i_inputs != p_mux->i_nb_inputs ||
+        p_mux->interleaver.i_blocks != i_blocks )
     {
-        sout_input_t *p_input = p_mux->pp_inputs[i];
-        block_t *p_data;
-
-        if( block_FifoCount( p_input->p_fifo ) < i_blocks )
+        if( InterleaverBuild( p_mux, i_blocks ) )
         {
-            if( p_input->p_fmt->i_cat != SPU_ES )
-            {
-                return -1;
-            }
-            /* FIXME: SPU muxing */
-            continue;
+            if( pi_dts ) *pi_dts = 0;
+            return -1;
         }
+    }
+    else if( p_mux->interleaver.p_last )
+    {
+        InterleaverUpdate( p_mux, p_mux->interleaver.p_last );
+    }
+    p_mux->interleaver.p_last = NULL;
 
-        p_data = block_FifoShow( p_input->p_fifo );
-        if( i_stream < 0 || p_data->i_dts < i_dts )
-        {
-            i_stream = i;
-            i_dts    = p_data->i_dts;
-        }
+    if( p_mux->interleaver.i_waiting > 0 || p_mux->interleaver.i_heap <= 0 )
+    {
+        if( pi_dts ) *pi_dts = 0;
+        return -1;
     }
 
-    if( pi_dts ) *pi_dts = i_dts;
+    sout_input_t *p_input = p_mux->interleaver.pp_heap[0];
+    p_mux->interleaver.p_last = p_input;
+    if( pi_dts ) *pi_dts = p_input->i_heap_dts;
 
-    return i_stream;
+    return p_input->i_index;
+}
+
+/*****************************************************************************
+ * sout_MuxPull: dequeue blocks to be muxed
+ *****************************************************************************
+ * It dequeues up to i_max blocks in dts order, as long as sout_MuxGetStream
+ * would find a stream, and returns how many it dequeued.
+ *****************************************************************************/
+int sout_MuxPull( sout_mux_t *p_mux, int i_blocks, sout_mux_block_t *p_out,
+                  int i_max )
+{
+    int i_count = 0;
+
+    while( i_count < i_max )
+    {
+        const int i_stream = sout_MuxGetStream( p_mux, i_blocks, NULL );
+        if( i_stream < 0 )
+            break;
+
+        sout_input_t *p_input = p_mux->pp_inputs[i_stream];
+        p_out[i_count].p_input = p_input;
+        p_out[i_count].p_block = block_FifoGet( p_input->p_fifo );
+        i_count++;
+    }
+    return i_count;
 }
 
 
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * block_share_bench.c: Benchmark of the shared block payloads
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Fans out blocks to several outputs like the duplicate stream output,
+ * with block_Duplicate and with block_Share, and prints the time spent per
+ * input block.
+ *
+ * Usage: block_share_bench [blocks] */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#define OUTPUTS 6
+
+static void PrintTime (const char *what, size_t size, mtime_t start,
+                       unsigned blocks)
+{
+    printf ("%-16s %7lu bytes %10.2f ns/block\n", what, (unsigned long)size,
+            (mdate () - start) * 1000. / blocks);
+}
+
+static void Bench (size_t size, unsigned blocks, bool share)
+{
+    block_t *outputs[OUTPUTS];
+    unsigned sum = 0;
+    mtime_t start = mdate ();
+
+    for (unsigned i = 0; i < blocks; i++)
+    {
+        block_t *block = block_Alloc (size);
+        assert (block != NULL);
+        block->p_buffer[0] = i & 0xff;
+
+        for (unsigned j = 0; j < OUTPUTS - 1; j++)
+        {
+            outputs[j] = share ? block_Share (block) : block_Duplicate (block);
+            assert (outputs[j] != NULL);
+        }
+        outputs[OUTPUTS - 1] = block;
+
+        /* The outputs only read the payload, in any order */
+        for (unsigned j = OUTPUTS; j-- > 0;)
+        {
+            sum += outputs[j]->p_buffer[0];
+            block_Release (outputs[j]);
+        }
+    }
+    PrintTime (share ? "block_Share" : "block_Duplicate", size, start, blocks);
+
+    unsigned ref = 0;
+    for (unsigned i = 0; i < blocks; i++)
+        ref += OUTPUTS * (i & 0xff);
+    assert (sum == ref);
+}
+
+int main (int argc, char *argv[])
+{
+    /* 7 TS packets (one UDP datagram), a video frame */
+    static const size_t sizes[] = { 7 * 188, 64 * 1024 };
+    unsigned blocks = (argc > 1) ? strtoul (argv[1], NULL, 0) : 100000;
+
+    if (blocks == 0)
+        blocks = 100000;
+
+    for (unsigned i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+        Bench (sizes[i], blocks, false);
+        Bench (sizes[i], blocks, true);
+    }
+    return 0;
+}
@@ -58,6 +58,38 @@ static void test_block_File (void)
     remove ("testfile.txt");
 }
 
+/* Large enough to be mapped rather than read */
+static void test_block_File_large (void)
+{
+    FILE *stream;
+    const size_t length = 1024 * 1024;
+
+    stream = fopen ("testfile.bin", "wb+");
+    assert (stream != NULL);
+    for (size_t i = 0; i < length; i++)
+        assert (fputc (i & 0xff, stream) != EOF);
+    assert (fflush (stream) != EOF);
+
+    block_t *block = block_File (fileno (stream));
+    fclose (stream);
+
+    assert (block != NULL);
+    assert (block->i_buffer == length);
+    for (size_t i = 0; i < length; i += 4093)
+        assert (block->p_buffer[i] == (i & 0xff));
+
+    /* The file is not modified by writing into the block */
+    block->p_buffer[0] = 0xff;
+    block_Release (block);
+
+    block = block_FilePath ("testfile.bin");
+    assert (block != NULL);
+    assert (block->i_buffer == length && block->p_buffer[0] == 0);
+    block_Release (block);
+
+    remove ("testfile.bin");
+}
+
 static void test_block (void)
 {
     block_t *block = block_Alloc (sizeof (text));
@@ -84,10 +116,58 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = 42;
+
+    block_t *share = block_Share (block);
+    assert (share != NULL);
+    assert (share->p_buffer == block->p_buffer);
+    assert (share->i_buffer == block->i_buffer);
+    assert (share->i_pts == 42);
+
+    /* The properties are not shared */
+    share->p_buffer += 5;
+    share->i_buffer -= 5;
+    share->i_pts = 43;
+    assert (block->i_buffer == sizeof (text) && block->i_pts == 42);
+
+    /* Copy on write */
+    block_t *other = block_Share (share);
+    assert (other != NULL && other->p_buffer == share->p_buffer);
+    other = block_Unshare (other);
+    assert (other != NULL && other->p_buffer != share->p_buffer);
+    other->p_buffer[0] = '!';
+    assert (!memcmp (share->p_buffer, text + 5, share->i_buffer));
+
+    /* Growing copies too */
+    share = block_Realloc (share, 5, share->i_buffer);
+    assert (share != NULL && share->p_buffer != block->p_buffer);
+    memcpy (share->p_buffer, "Test:", 5);
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (share);
+
+    /* The last owner does not copy, even if it is not the first one */
+    share = block_Share (block);
+    assert (share != NULL);
+    block_Release (block);
+    block_t *last = block_Unshare (share);
+    assert (last == share);
+    assert (!memcmp (last->p_buffer, text, sizeof (text)));
+
+    block_Release (last);
+    block_Release (other);
+}
+
 int main (void)
 {
     test_block_File ();
+    test_block_File_large ();
     test_block ();
+    test_block_Share ();
     return 0;
 }
 
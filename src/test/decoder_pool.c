@@ -0,0 +1,224 @@
+/*****************************************************************************
+ * decoder_pool.c: Test for the shared decoder threads
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Plays inputs made of memory ES (the imem module) with shared decoder
+ * threads, through the real input, es_out and decoders:
+ *  - more stream output ES than pool threads, so that every decoder is a
+ *    pooled packetizer (DecoderPlaySout),
+ *  - a subtitle ES displayed on a dummy video output (DecoderPlaySpu).
+ * Both go through the start-up buffering, then are paused and resumed.
+ * A pool thread held by a decoder that cannot run stalls the input thread
+ * in EsOutDecodersStopBuffering, so the test checks that every ES is still
+ * demuxed after each of these steps.
+ *
+ * The plugins are looked up in the usual plugins path. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc/vlc.h>
+#include <vlc_common.h>
+
+#define THREADS 2
+#define STREAMS 6                /* more ES than threads */
+#define PERIOD  (CLOCK_FREQ / 25)
+#define WIDTH   64
+#define HEIGHT  64
+#define TIMEOUT (10 * CLOCK_FREQ)
+
+typedef struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    unsigned    count[STREAMS];
+    bool        b_video;         /* the ES 0 is a video */
+    uint8_t     picture[WIDTH * HEIGHT * 4];
+} source_t;
+
+static const char text[] = "decoder pool";
+
+/* The cookie of each imem ES is its index */
+static int Get (void *data, const char *cookie, int64_t *dts, int64_t *pts,
+                unsigned *flags, size_t *size, void **buffer)
+{
+    source_t *src = (source_t *)data;
+    unsigned i = atoi (cookie);
+
+    assert (i < STREAMS);
+    vlc_mutex_lock (&src->lock);
+    *dts = *pts = src->count[i] * PERIOD;
+    src->count[i]++;
+    vlc_cond_broadcast (&src->wait);
+    vlc_mutex_unlock (&src->lock);
+
+    *flags = 0;
+    if (i == 0 && src->b_video)
+    {
+        *size = sizeof (src->picture);
+        *buffer = src->picture;
+    }
+    else
+    {
+        *size = sizeof (text);
+        *buffer = (void *)text;
+    }
+    return 0;
+}
+
+static void Release (void *data, const char *cookie, size_t size,
+                     void *buffer)
+{
+    VLC_UNUSED(data); VLC_UNUSED(cookie); VLC_UNUSED(size);
+    VLC_UNUSED(buffer);
+}
+
+/* Waits until each of the n first ES is demuxed "blocks" more times */
+static void WaitProgress (source_t *src, unsigned n, unsigned blocks)
+{
+    unsigned target[STREAMS];
+    const mtime_t deadline = mdate () + TIMEOUT;
+
+    vlc_mutex_lock (&src->lock);
+    for (unsigned i = 0; i < n; i++)
+        target[i] = src->count[i] + blocks;
+    for (unsigned i = 0; i < n; i++)
+        while (src->count[i] < target[i])
+            assert (!vlc_cond_timedwait (&src->wait, &src->lock, deadline));
+    vlc_mutex_unlock (&src->lock);
+}
+
+static void AddOption (libvlc_media_t *md, const char *fmt, ...)
+{
+    char option[256];
+    va_list ap;
+
+    va_start (ap, fmt);
+    vsnprintf (option, sizeof (option), fmt, ap);
+    va_end (ap);
+    libvlc_media_add_option (md, option);
+}
+
+static void Play (libvlc_instance_t *vlc, source_t *src, const char *mrl,
+                  const char *slaves, unsigned n)
+{
+    libvlc_media_t *md = libvlc_media_new_location (vlc, mrl);
+    assert (md != NULL);
+
+    /* imem reads the addresses with strtoll() */
+    AddOption (md, ":imem-get=%lld", (long long)(intptr_t)Get);
+    AddOption (md, ":imem-release=%lld", (long long)(intptr_t)Release);
+    AddOption (md, ":imem-data=%lld", (long long)(intptr_t)src);
+    AddOption (md, ":input-slave=%s", slaves);
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    assert (libvlc_media_player_play (mp) == 0);
+
+    /* Past the start-up buffering (network-caching is 300 ms) */
+    WaitProgress (src, n, 50);
+
+    libvlc_media_player_set_pause (mp, 1);
+    msleep (CLOCK_FREQ / 5);
+    libvlc_media_player_set_pause (mp, 0);
+    WaitProgress (src, n, 50);
+
+    /* Twice, the second pause catching the decoders with kept output */
+    libvlc_media_player_set_pause (mp, 1);
+    libvlc_media_player_set_pause (mp, 0);
+    WaitProgress (src, n, 50);
+
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+}
+
+static void test_sout (libvlc_instance_t *vlc, source_t *src)
+{
+    char slaves[1024];
+    size_t len = 0;
+
+    for (unsigned i = 1; i < STREAMS; i++)
+        len += _snprintf (slaves + len, sizeof (slaves) - len,
+                          "%simem://cookie=%u:cat=3:codec=subt:id=%u",
+                          (i > 1) ? "#" : "", i, i);
+    assert (len < sizeof (slaves));
+
+    printf ("%u subtitle ES to the stream output, %u threads\n",
+            STREAMS, THREADS);
+    Play (vlc, src, "imem://cookie=0:cat=3:codec=subt:id=0", slaves,
+          STREAMS);
+}
+
+static void test_spu (libvlc_instance_t *vlc, source_t *src)
+{
+    char video[128];
+
+    _snprintf (video, sizeof (video),
+               "imem://cookie=0:cat=2:codec=RV32:width=%u:height=%u"
+               ":fps=25/1:id=0", WIDTH, HEIGHT);
+
+    printf ("video and subtitle ES to the video output, %u threads\n",
+            THREADS);
+    Play (vlc, src, video, "imem://cookie=1:cat=3:codec=subt:id=1", 2);
+}
+
+int main (void)
+{
+    static const char *const sout_args[] = {
+        "--ignore-config", "--quiet", "--decoder-threads=2",
+        "--sout=#description", "--sout-all",
+    };
+    static const char *const spu_args[] = {
+        "--ignore-config", "--quiet", "--decoder-threads=2",
+        "--vout=vdummy", "--no-audio", "--sub-track=0",
+    };
+    source_t src;
+    libvlc_instance_t *vlc;
+
+    vlc_mutex_init (&src.lock);
+    vlc_cond_init (&src.wait);
+    memset (src.count, 0, sizeof (src.count));
+    src.b_video = false;
+    memset (src.picture, 0x80, sizeof (src.picture));
+
+    vlc = libvlc_new (sizeof (sout_args) / sizeof (sout_args[0]),
+                      sout_args);
+    assert (vlc != NULL);
+    test_sout (vlc, &src);
+    libvlc_release (vlc);
+
+    memset (src.count, 0, sizeof (src.count));
+    src.b_video = true;
+    vlc = libvlc_new (sizeof (spu_args) / sizeof (spu_args[0]), spu_args);
+    assert (vlc != NULL);
+    test_spu (vlc, &src);
+    libvlc_release (vlc);
+
+    vlc_cond_destroy (&src.wait);
+    vlc_mutex_destroy (&src.lock);
+    return 0;
+}
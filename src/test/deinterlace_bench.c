@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * deinterlace_bench.c: Benchmark of the deinterlacing algorithms
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Runs every mode of the deinterlace filter on synthetic interlaced
+ * 1080i and 576i frames, and prints the time spent per input pixel.
+ *
+ * Usage: deinterlace_bench [frames]
+ * The deinterlace plugin is looked up in the usual plugins path. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc/vlc.h>
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include "../../lib/libvlc_internal.h"
+
+#define SOURCE_FRAMES 8
+
+static const char *const modes[] = {
+    "discard", "blend", "mean", "bob", "linear", "x",
+    "yadif", "yadif2x", "phosphor", "ivtc",
+};
+
+static const struct
+{
+    const char *name;
+    int width;
+    int height;
+} sizes[] = {
+    { "1080i", 1920, 1080 },
+    { "576i",   720,  576 },
+};
+
+static picture_t *NewPicture (filter_t *filter)
+{
+    return picture_NewFromFormat (&filter->fmt_out.video);
+}
+
+static void DeletePicture (filter_t *filter, picture_t *pic)
+{
+    VLC_UNUSED(filter);
+    picture_Release (pic);
+}
+
+/* Each field is sampled at its own time, so that moving edges comb */
+static void FillPicture (picture_t *pic, unsigned frame)
+{
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+        {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            int t = 2 * frame + (y & 1);
+
+            for (int x = 0; x < p->i_visible_pitch; x++)
+                line[x] = (((x + 4 * t) & 64) ? 200 : 40)
+                        + ((x * 7 + y * 13) & 15);
+        }
+    }
+}
+
+/* Returns the time per input pixel in nanoseconds, or a negative value */
+static double Bench (vlc_object_t *obj, const char *mode,
+                     picture_t *const *src, int width, int height,
+                     unsigned frames)
+{
+    filter_t *filter = (filter_t *)vlc_object_create (obj, sizeof (*filter));
+    assert (filter != NULL);
+
+    es_format_Init (&filter->fmt_in, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Setup (&filter->fmt_in.video, VLC_CODEC_I420,
+                        width, height, 1, 1);
+    es_format_Copy (&filter->fmt_out, &filter->fmt_in);
+    filter->pf_video_buffer_new = NewPicture;
+    filter->pf_video_buffer_del = DeletePicture;
+
+    char cfg[32];
+    char *name;
+    snprintf (cfg, sizeof (cfg), "deinterlace{mode=%s}", mode);
+    free (config_ChainCreate (&name, &filter->p_cfg, cfg));
+    free (name);
+
+    double ns = -1.;
+    filter->p_module = module_need (filter, "video filter2", "deinterlace",
+                                    true);
+    if (filter->p_module != NULL)
+    {
+        mtime_t start = mdate ();
+
+        for (unsigned i = 0; i < frames; i++)
+        {
+            picture_t *in = src[i % SOURCE_FRAMES];
+
+            picture_Hold (in);
+            in->date = VLC_TS_0 + i * CLOCK_FREQ / 25;
+            for (picture_t *out = filter->pf_video_filter (filter, in), *next;
+                 out != NULL; out = next)
+            {
+                next = out->p_next;
+                picture_Release (out);
+            }
+        }
+
+        ns = (mdate () - start) * 1000. / ((double)frames * width * height);
+        module_unneed (filter, filter->p_module);
+    }
+
+    config_ChainDestroy (filter->p_cfg);
+    es_format_Clean (&filter->fmt_out);
+    es_format_Clean (&filter->fmt_in);
+    vlc_object_release (filter);
+    return ns;
+}
+
+int main (int argc, char *argv[])
+{
+    static const char *const args[] = { "--ignore-config", "--quiet" };
+    unsigned frames = (argc > 1) ? strtoul (argv[1], NULL, 0) : 100;
+
+    if (frames == 0)
+        frames = 100;
+
+    libvlc_instance_t *vlc = libvlc_new (sizeof (args) / sizeof (args[0]),
+                                         args);
+    assert (vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+#if defined (__i386__) || defined (__x86_64__)
+    printf ("CPU: %s%s%s\n", vlc_CPU_MMXEXT () ? "MMXEXT " : "",
+            vlc_CPU_SSE2 () ? "SSE2 " : "", vlc_CPU_AVX2 () ? "AVX2" : "");
+#endif
+
+    for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+        video_format_t fmt;
+        picture_t *src[SOURCE_FRAMES];
+
+        video_format_Setup (&fmt, VLC_CODEC_I420, sizes[s].width,
+                            sizes[s].height, 1, 1);
+        for (unsigned i = 0; i < SOURCE_FRAMES; i++)
+        {
+            src[i] = picture_NewFromFormat (&fmt);
+            assert (src[i] != NULL);
+            FillPicture (src[i], i);
+        }
+
+        for (size_t m = 0; m < sizeof (modes) / sizeof (modes[0]); m++)
+        {
+            double ns = Bench (obj, modes[m], src, sizes[s].width,
+                               sizes[s].height, frames);
+            if (ns < 0.)
+                printf ("%-5s %-9s unavailable\n", sizes[s].name, modes[m]);
+            else
+                printf ("%-5s %-9s %8.3f ns/pixel\n", sizes[s].name,
+                        modes[m], ns);
+        }
+
+        for (unsigned i = 0; i < SOURCE_FRAMES; i++)
+            picture_Release (src[i]);
+    }
+
+    libvlc_release (vlc);
+    return 0;
+}
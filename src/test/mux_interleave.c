@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * mux_interleave.c: Test for the sout mux interleaver
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks sout_MuxGetStream and sout_MuxPull against the former linear scan
+ * of the inputs. The mux is not created from a module: only the fields used
+ * by the interleaver are set. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+
+#define PULL_MAX 8
+#define INPUTS_MAX 64
+
+static int Mux (sout_mux_t *mux)
+{
+    (void) mux;
+    return VLC_SUCCESS;
+}
+
+static int DelStream (sout_mux_t *mux, sout_input_t *input)
+{
+    (void) mux; (void) input;
+    return VLC_SUCCESS;
+}
+
+/* The former sout_MuxGetStream */
+static int RefGetStream (sout_mux_t *mux, int blocks, mtime_t *pdts)
+{
+    mtime_t dts = 0;
+    int stream = -1;
+
+    for (int i = 0; i < mux->i_nb_inputs; i++)
+    {
+        sout_input_t *input = mux->pp_inputs[i];
+
+        if (block_FifoCount (input->p_fifo) < (size_t)blocks)
+        {
+            if (input->p_fmt->i_cat != SPU_ES)
+                return -1;
+            continue;
+        }
+
+        block_t *data = block_FifoShow (input->p_fifo);
+        if (stream < 0 || data->i_dts < dts)
+        {
+            stream = i;
+            dts = data->i_dts;
+        }
+    }
+    *pdts = dts;
+    return stream;
+}
+
+static void Send (sout_mux_t *mux, mtime_t *next_dts)
+{
+    const int i = rand () % mux->i_nb_inputs;
+    block_t *block = block_Alloc (16);
+
+    assert (block != NULL);
+    /* Some equal dates to check the order between inputs */
+    next_dts[i] += (rand () % 4) * 10000;
+    block->i_dts = block->i_pts = next_dts[i];
+    sout_MuxSendBuffer (mux, mux->pp_inputs[i], block);
+}
+
+static void test_interleave (int inputs, int blocks, bool pull)
+{
+    sout_instance_t sout;
+    sout_mux_t mux;
+    es_format_t video, spu;
+    mtime_t next_dts[INPUTS_MAX];
+
+    assert (inputs <= INPUTS_MAX);
+
+    memset (&sout, 0, sizeof (sout));
+    memset (&mux, 0, sizeof (mux));
+    es_format_Init (&video, VIDEO_ES, VLC_CODEC_H264);
+    es_format_Init (&spu, SPU_ES, VLC_CODEC_SPU);
+    mux.p_sout = &sout;
+    mux.pf_mux = Mux;
+    mux.pf_delstream = DelStream;
+    mux.interleaver.b_dirty = true;
+
+    for (int i = 0; i < inputs; i++)
+    {
+        sout_input_t *input = (sout_input_t *)malloc (sizeof (*input));
+        assert (input != NULL);
+        input->p_fmt = (i % 5 == 4) ? &spu : &video;
+        input->p_fifo = block_FifoNew ();
+        input->p_sys = NULL;
+        input->i_heap = -1;
+        TAB_APPEND ((sout_input_t **), mux.i_nb_inputs, mux.pp_inputs, input);
+        next_dts[i] = VLC_TS_0;
+    }
+
+    for (unsigned n = 0; n < 20000; n++)
+    {
+        Send (&mux, next_dts);
+
+        if (n == 10000)
+        {   /* Removing an input renumbers the others */
+            const int i = inputs / 2;
+            sout_MuxDeleteStream (&mux, mux.pp_inputs[i]);
+            memmove (&next_dts[i], &next_dts[i + 1],
+                     (inputs - i - 1) * sizeof (*next_dts));
+        }
+
+        if (rand () % 3)
+            continue;
+
+        if (pull)
+        {
+            sout_mux_block_t out[PULL_MAX];
+            mtime_t last = INT64_MIN;
+            int count = sout_MuxPull (&mux, blocks, out, PULL_MAX);
+
+            for (int i = 0; i < count; i++)
+            {
+                assert (out[i].p_block->i_dts >= last);
+                last = out[i].p_block->i_dts;
+                assert (block_FifoCount (out[i].p_input->p_fifo) + 1
+                        >= (size_t)blocks);
+                block_Release (out[i].p_block);
+            }
+            if (count < PULL_MAX)
+            {
+                mtime_t dts;
+                assert (RefGetStream (&mux, blocks, &dts) < 0);
+            }
+        }
+        else
+        {
+            for (;;)
+            {
+                mtime_t dts, ref_dts;
+                int ref = RefGetStream (&mux, blocks, &ref_dts);
+                int stream = sout_MuxGetStream (&mux, blocks, &dts);
+
+                assert (stream == ref);
+                if (stream < 0)
+                    break;
+                assert (dts == ref_dts);
+                block_Release (block_FifoGet (mux.pp_inputs[stream]->p_fifo));
+            }
+        }
+    }
+
+    while (mux.i_nb_inputs > 0)
+    {
+        sout_input_t *input = mux.pp_inputs[0];
+
+        block_FifoEmpty (input->p_fifo);
+        block_FifoRelease (input->p_fifo);
+        TAB_REMOVE (mux.i_nb_inputs, mux.pp_inputs, input);
+        free (input);
+    }
+    free (mux.interleaver.pp_heap);
+}
+
+int main (void)
+{
+    srand (0);
+    for (int blocks = 1; blocks <= 2; blocks++)
+    {
+        test_interleave (3, blocks, false);
+        test_interleave (3, blocks, true);
+        /* Like a MPTS */
+        test_interleave (INPUTS_MAX, blocks, false);
+        test_interleave (INPUTS_MAX, blocks, true);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * picture_layout.c: Test for the picture memory layouts
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+
+static void test_layout (vlc_fourcc_t chroma, unsigned width, unsigned height)
+{
+    video_format_t fmt;
+    video_format_Setup (&fmt, chroma, width, height, 1, 1);
+
+    /* Like libavcodec for H.264: 2 extra lines and 32 bytes alignment */
+    const picture_layout_t layout = { 32, (width + 31) & ~31, height + 2 };
+
+    picture_t *pic = picture_NewFromLayout (&fmt, &layout);
+    assert (pic != NULL);
+    assert (picture_HasLayout (pic, &layout));
+    assert (picture_HasLayout (pic, NULL));
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        assert (pic->p[i].i_pitch % 32 == 0);
+        assert ((uintptr_t)pic->p[i].p_pixels % 32 == 0);
+        assert (pic->p[i].i_visible_pitch <= pic->p[i].i_pitch);
+    }
+    /* The visible area does not depend on the layout */
+    picture_t *plain = picture_NewFromFormat (&fmt);
+    assert (plain != NULL);
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        assert (pic->p[i].i_visible_pitch == plain->p[i].i_visible_pitch);
+        assert (pic->p[i].i_visible_lines == plain->p[i].i_visible_lines);
+    }
+    picture_Release (plain);
+
+    /* Larger margins are not fulfilled */
+    picture_layout_t larger = layout;
+    larger.i_height = pic->p[0].i_lines + 1;
+    assert (!picture_HasLayout (pic, &larger));
+    larger = layout;
+    larger.i_width = pic->p[0].i_pitch / pic->p[0].i_pixel_pitch + 1;
+    assert (!picture_HasLayout (pic, &larger));
+    picture_Release (pic);
+
+    /* Pools */
+    picture_pool_t *pool = picture_pool_NewFromLayout (&fmt, &layout, 3);
+    assert (pool != NULL);
+    for (int i = 0; i < 3; i++)
+    {
+        pic = picture_pool_Get (pool);
+        assert (pic != NULL);
+        assert (picture_HasLayout (pic, &layout));
+        picture_Release (pic);
+    }
+    picture_pool_Delete (pool);
+}
+
+static void test_merge (void)
+{
+    picture_layout_t a = { 16, 1920, 1082 };
+    const picture_layout_t b = { 64, 1280, 1088 };
+
+    picture_layout_Merge (&a, &b);
+    assert (a.i_align == 64 && a.i_width == 1920 && a.i_height == 1088);
+}
+
+int main (void)
+{
+    test_merge ();
+    test_layout (VLC_CODEC_I420, 1920, 1080);
+    test_layout (VLC_CODEC_I420, 720, 576);
+    test_layout (VLC_CODEC_I422, 1278, 718);
+    test_layout (VLC_CODEC_NV12, 176, 144);
+    test_layout (VLC_CODEC_RGB32, 640, 480);
+    test_layout (VLC_CODEC_YUYV, 352, 288);
+    return 0;
+}
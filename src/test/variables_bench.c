@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * variables_bench.c: Benchmark of the object variables lookups
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Compares the lookups by name (var_GetInteger, var_SetBool,
+ * var_InheritInteger) with the lookups by handle (var_GetIntegerFast,
+ * var_SetBoolFast, var_InheritIntegerFast), on an object three levels below
+ * the libvlc instance, and prints the time spent per call. The inherited
+ * lookups are timed again while another object of the tree creates and
+ * destroys a variable between calls, as the other inputs and outputs do.
+ *
+ * Usage: variables_bench [calls] */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc/vlc.h>
+#include <vlc_common.h>
+#include "../../lib/libvlc_internal.h"
+
+/* Variables created in each intermediate object, like the input does */
+#define FILLER_VARS 64
+
+static void PrintTime (const char *what, mtime_t start, unsigned calls)
+{
+    printf ("%-32s %8.2f ns/call\n", what,
+            (mdate () - start) * 1000. / calls);
+}
+
+int main (int argc, char *argv[])
+{
+    static const char *const args[] = { "--ignore-config", "--quiet" };
+    unsigned calls = (argc > 1) ? strtoul (argv[1], NULL, 0) : 1000000;
+
+    if (calls == 0)
+        calls = 1000000;
+
+    libvlc_instance_t *vlc = libvlc_new (sizeof (args) / sizeof (args[0]),
+                                         args);
+    assert (vlc != NULL);
+
+    vlc_object_t *objs[3];
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        objs[i] = (vlc_object_t *)vlc_object_create (parent, sizeof (*objs[i]));
+        assert (objs[i] != NULL);
+        for (unsigned j = 0; j < FILLER_VARS; j++)
+        {
+            char name[16];
+
+            snprintf (name, sizeof (name), "bench-%u-%u", i, j);
+            var_Create (objs[i], name, VLC_VAR_INTEGER);
+        }
+        parent = objs[i];
+    }
+
+    vlc_object_t *obj = objs[2];
+    var_Create (obj, "bench-local", VLC_VAR_INTEGER);
+    var_SetInteger (obj, "bench-local", 42);
+    var_Create (objs[0], "bench-parent", VLC_VAR_INTEGER);
+    var_SetInteger (objs[0], "bench-parent", 43);
+
+    const vlc_var_handle_t *local = var_Handle ("bench-local");
+    const vlc_var_handle_t *inherited = var_Handle ("bench-parent");
+    const vlc_var_handle_t *config = var_Handle ("file-caching");
+    const int64_t caching = var_InheritInteger (obj, "file-caching");
+    int64_t sum;
+    mtime_t start;
+
+    assert (local != NULL && inherited != NULL && config != NULL);
+    assert (var_GetIntegerFast (obj, local) == 42);
+    assert (var_InheritIntegerFast (obj, inherited) == 43);
+    assert (var_InheritIntegerFast (obj, config) == caching);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_GetInteger (obj, "bench-local");
+    PrintTime ("var_GetInteger", start, calls);
+    assert (sum == 42 * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_GetIntegerFast (obj, local);
+    PrintTime ("var_GetIntegerFast", start, calls);
+    assert (sum == 42 * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_InheritInteger (obj, "bench-parent");
+    PrintTime ("var_InheritInteger (parent)", start, calls);
+    assert (sum == 43 * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_InheritIntegerFast (obj, inherited);
+    PrintTime ("var_InheritIntegerFast", start, calls);
+    assert (sum == 43 * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_InheritInteger (obj, "file-caching");
+    PrintTime ("var_InheritInteger (config)", start, calls);
+    assert (sum == caching * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+        sum += var_InheritIntegerFast (obj, config);
+    PrintTime ("var_InheritIntegerFast", start, calls);
+    assert (sum == caching * (int64_t)calls);
+
+    const vlc_var_handle_t *flag = var_Handle ("bench-flag");
+    assert (flag != NULL);
+    var_Create (obj, "bench-flag", VLC_VAR_BOOL);
+
+    start = mdate ();
+    for (unsigned i = 0; i < calls; i++)
+        var_SetBool (obj, "bench-flag", i & 1);
+    PrintTime ("var_SetBool", start, calls);
+
+    start = mdate ();
+    for (unsigned i = 0; i < calls; i++)
+        var_SetBoolFast (obj, flag, i & 1);
+    PrintTime ("var_SetBoolFast", start, calls);
+
+    /* Variables created and destroyed elsewhere in the tree do not
+     * invalidate what the object remembers */
+    vlc_object_t *other = (vlc_object_t *)vlc_object_create (vlc->p_libvlc_int,
+                                                             sizeof (*other));
+    assert (other != NULL);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+    {
+        var_Create (other, "bench-churn", VLC_VAR_INTEGER);
+        sum += var_InheritInteger (obj, "bench-parent");
+        var_Destroy (other, "bench-churn");
+    }
+    PrintTime ("var_InheritInteger (churn)", start, calls);
+    assert (sum == 43 * (int64_t)calls);
+
+    start = mdate ();
+    sum = 0;
+    for (unsigned i = 0; i < calls; i++)
+    {
+        var_Create (other, "bench-churn", VLC_VAR_INTEGER);
+        sum += var_InheritIntegerFast (obj, inherited);
+        var_Destroy (other, "bench-churn");
+    }
+    PrintTime ("var_InheritIntegerFast (churn)", start, calls);
+    assert (sum == 43 * (int64_t)calls);
+    vlc_object_release (other);
+
+    /* Creating a variable in between must take precedence */
+    var_Create (objs[1], "bench-parent", VLC_VAR_INTEGER);
+    var_SetInteger (objs[1], "bench-parent", 44);
+    assert (var_InheritIntegerFast (obj, inherited) == 44);
+    var_Destroy (objs[1], "bench-parent");
+    assert (var_InheritIntegerFast (obj, inherited) == 43);
+
+    for (unsigned i = 3; i-- > 0;)
+        vlc_object_release (objs[i]);
+    libvlc_release (vlc);
+    return 0;
+}
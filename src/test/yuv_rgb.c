@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * yuv_rgb.c: Test for the YUV to RGB line converters
+ *****************************************************************************
+ * Copyright (C) 2013 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks that the SSE2 line converters give the same pixels as the C ones.
+ * It is linked with modules/video_chroma/yuv_rgb.c. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include "../../modules/video_chroma/yuv_rgb.h"
+
+#define MAX_WIDTH 200
+
+static const unsigned bpps[] = { 4, 4, 3, 3, 2 };
+
+static void test_known_values (void)
+{
+    yuv_rgb_matrix_t m;
+    uint8_t y[2], u[1] = { 128 }, v[1] = { 128 }, rgb[6];
+    yuv_rgb_line_t line = yuv_rgb_GetLine (YUV_RGB_RGB, false, false);
+
+    /* Limited range: 16 is black and 235 is white */
+    yuv_rgb_SetMatrix (&m, false, false);
+    y[0] = 16;
+    y[1] = 235;
+    line (rgb, y, u, v, 2, &m);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        assert (rgb[i] == 0);
+        assert (rgb[3 + i] == 255);
+    }
+
+    /* Full range: no offset */
+    yuv_rgb_SetMatrix (&m, true, true);
+    y[0] = 0;
+    y[1] = 128;
+    line (rgb, y, u, v, 2, &m);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        assert (rgb[i] == 0);
+        assert (rgb[3 + i] == 128);
+    }
+}
+
+static void test_output (yuv_rgb_output_t output, bool nv12,
+                         const yuv_rgb_matrix_t *m)
+{
+    yuv_rgb_line_t ref = yuv_rgb_GetLine (output, nv12, false);
+    yuv_rgb_line_t simd = yuv_rgb_GetLine (output, nv12, true);
+    uint8_t y[MAX_WIDTH], uv[MAX_WIDTH], u[MAX_WIDTH / 2], v[MAX_WIDTH / 2];
+    /* One extra pixel to catch writes past the line */
+    uint8_t a[(MAX_WIDTH + 1) * 4], b[(MAX_WIDTH + 1) * 4];
+
+    assert (ref != NULL && simd != NULL);
+
+    for (unsigned i = 0; i < 50; i++)
+    {
+        const unsigned width = 1 + rand () % MAX_WIDTH;
+
+        for (unsigned x = 0; x < MAX_WIDTH; x++)
+            y[x] = uv[x] = rand ();
+        for (unsigned x = 0; x < MAX_WIDTH / 2; x++)
+            u[x] = rand (), v[x] = rand ();
+        memset (a, 0x55, sizeof (a));
+        memset (b, 0x55, sizeof (b));
+
+        if (nv12)
+        {
+            ref (a, y, uv, uv + 1, width, m);
+            simd (b, y, uv, uv + 1, width, m);
+        }
+        else
+        {
+            ref (a, y, u, v, width, m);
+            simd (b, y, u, v, width, m);
+        }
+
+        if (memcmp (a, b, sizeof (a)))
+        {
+            fprintf (stderr, "output %d, %s, width %u: mismatch\n", output,
+                     nv12 ? "NV12" : "planar", width);
+            abort ();
+        }
+        for (unsigned x = width * bpps[output]; x < sizeof (b); x++)
+            assert (b[x] == 0x55);
+    }
+}
+
+int main (void)
+{
+    test_known_values ();
+
+    if (!vlc_CPU_SSE2 ())
+    {
+        fprintf (stderr, "SSE2 not available, skipping\n");
+        return 77;
+    }
+
+    srand (0);
+    for (unsigned bt709 = 0; bt709 < 2; bt709++)
+        for (unsigned full = 0; full < 2; full++)
+        {
+            yuv_rgb_matrix_t m;
+
+            yuv_rgb_SetMatrix (&m, bt709, full);
+            for (int output = YUV_RGB_BGRX; output <= YUV_RGB_565; output++)
+            {
+                test_output ((yuv_rgb_output_t)output, false, &m);
+                test_output ((yuv_rgb_output_t)output, true, &m);
+            }
+        }
+    return 0;
+}
@@ -31,12 +31,20 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint copied;
+
+    /* Feedback for the decoder, only written by the vout thread */
+    atomic_int_least64_t render; /* high estimate of the render time */
+    atomic_int_least64_t late;   /* smoothed lateness of the pictures */
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->copied, 0);
+    atomic_init(&stat->render, 0);
+    atomic_init(&stat->late, 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -44,10 +52,11 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
     (void) stat;
 }
 
-static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost)
+static inline void vout_statistic_GetReset(vout_statistic_t *stat, int *displayed, int *lost, int *copied)
 {
     *displayed = atomic_exchange(&stat->displayed, (atomic_uint)0);			// sunqueen modify
     *lost      = atomic_exchange(&stat->lost, (atomic_uint)0);			// sunqueen modify
+    *copied    = atomic_exchange(&stat->copied, (atomic_uint)0);
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -61,4 +70,37 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, (atomic_uint)lost);			// sunqueen modify
 }
 
+/* Pictures copied on their way from the decoder pool to the display */
+static inline void vout_statistic_AddCopied(vout_statistic_t *stat, int copied)
+{
+    atomic_fetch_add(&stat->copied, (atomic_uint)copied);
+}
+
+/* The render time is the one of the vout chrono, the lateness is averaged
+ * over the last 8 pictures either displayed or dropped, and it is negative
+ * when the pictures are ready before their date */
+static inline void vout_statistic_SetRender(vout_statistic_t *stat,
+                                            mtime_t render)
+{
+    atomic_store(&stat->render, (int_least64_t)render);
+}
+
+static inline void vout_statistic_AddLate(vout_statistic_t *stat, mtime_t late)
+{
+    const int_least64_t avg = atomic_load(&stat->late);
+    atomic_store(&stat->late, (int_least64_t)((7 * avg + late) / 8));
+}
+
+static inline void vout_statistic_ResetLate(vout_statistic_t *stat)
+{
+    atomic_store(&stat->late, (int_least64_t)0);
+}
+
+static inline void vout_statistic_GetFeedback(vout_statistic_t *stat,
+                                              mtime_t *render, mtime_t *late)
+{
+    *render = atomic_load(&stat->render);
+    *late   = atomic_load(&stat->late);
+}
+
 #endif
@@ -132,6 +132,10 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
     vout->p->original = original;
     vout->p->dpb_size = cfg->dpb_size;
+    if (cfg->layout)
+        vout->p->layout = *cfg->layout;
+    else
+        memset(&vout->p->layout, 0, sizeof(vout->p->layout));
 
     vout_control_Init(&vout->p->control);
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_INIT);
@@ -288,9 +292,16 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     vout_control_WaitEmpty(&vout->p->control);
 }
 
-void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost)
+void vout_GetResetStatistic(vout_thread_t *vout, int *displayed, int *lost,
+                            int *copied)
+{
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, copied );
+}
+
+void vout_GetDisplayFeedback(vout_thread_t *vout, mtime_t *render,
+                             mtime_t *late)
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetFeedback(&vout->p->statistic, render, late);
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -832,10 +843,12 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
         } else {
             decoded = picture_fifo_Pop(vout->p->decoder_fifo);
             if (is_late_dropped && decoded && !decoded->b_force) {
-                const mtime_t predicted = mdate() + 0; /* TODO improve */
+                /* It cannot be displayed before it is rendered */
+                const mtime_t predicted = mdate() + vout_chrono_GetLow(&vout->p->render);
                 const mtime_t late = predicted - decoded->date;
                 if (late > VOUT_DISPLAY_LATE_THRESHOLD) {// ӳٴ20ms貥
                     msg_Warn(vout, "picture is too late to be displayed (missing %d ms)", (int)(late/1000));
+                    vout_statistic_AddLate(&vout->p->statistic, late);
                     picture_Release(decoded);
                     lost_count++;
                     continue;
@@ -977,6 +990,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         if (todisplay) {
             VideoFormatCopyCropAr(&todisplay->format, &filtered->format);
             picture_Copy(todisplay, filtered);
+            vout_statistic_AddCopied(&vout->p->statistic, 1);
             if (vout->p->spu_blend)
                 picture_BlendSubpicture(todisplay, vout->p->spu_blend, subpic);
         }
@@ -988,12 +1002,15 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
             return VLC_EGENERIC;
     }
 
+    /* A filtered display converts the picture into its own buffers: it
+     * does not need a copy in the display pool */
     picture_t *direct;
-    if (!is_direct && todisplay) {
+    if (!is_direct && sys->display.use_dr && todisplay) {
         direct = picture_pool_Get(vout->p->display_pool);
         if (direct) {
             VideoFormatCopyCropAr(&direct->format, &todisplay->format);
             picture_Copy(direct, todisplay);
+            vout_statistic_AddCopied(&vout->p->statistic, 1);
         }
         picture_Release(todisplay);
     } else {
@@ -1031,6 +1048,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     }
 
     vout_chrono_Stop(&vout->p->render);
+    vout_statistic_SetRender(&vout->p->statistic,
+                             vout_chrono_GetHigh(&vout->p->render));
 #if 0
         {
         static int i = 0;
@@ -1046,8 +1065,11 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (delay < 1000)
         msg_Warn(vout, "picture is late (%lld ms)", delay / 1000);
 #endif
-    if (!is_forced)
+    if (!is_forced) {
+        /* Measured before waiting, so that early pictures count negatively */
+        vout_statistic_AddLate(&vout->p->statistic, mdate() - direct->date);
         mwait(direct->date);
+    }
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
@@ -1230,6 +1252,7 @@ static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
     }
 
     picture_fifo_Flush(vout->p->decoder_fifo, date, below);
+    vout_statistic_ResetLate(&vout->p->statistic);
 }
 
 static void ThreadReset(vout_thread_t *vout)
@@ -1429,12 +1452,25 @@ static int ThreadReinit(vout_thread_t *vout,
         ThreadClean(vout);
         return VLC_EGENERIC;
     }
+    picture_layout_t layout;
+    if (cfg->layout)
+        layout = *cfg->layout;
+    else
+        memset(&layout, 0, sizeof(layout));
+
     /* We ignore crop/ar changes at this point, they are dynamically supported */
     VideoFormatCopyCropAr(&vout->p->original, &original);
     if (video_format_IsSimilar(&original, &vout->p->original)) {
-        if (cfg->dpb_size <= vout->p->dpb_size)
+        /* The current pools may already fulfil the new layout */
+        picture_layout_Merge(&layout, &vout->p->layout);
+        const bool same_layout = !memcmp(&layout, &vout->p->layout,
+                                         sizeof(layout));
+        if (cfg->dpb_size <= vout->p->dpb_size && same_layout)
             return VLC_SUCCESS;
-        msg_Warn(vout, "DPB need to be increased");
+        if (!same_layout)
+            msg_Dbg(vout, "picture layout needs to be changed");
+        else
+            msg_Warn(vout, "DPB need to be increased");
     }
 
     vout_display_state_t state;
@@ -1453,6 +1489,7 @@ static int ThreadReinit(vout_thread_t *vout,
 
     vout->p->original = original;
     vout->p->dpb_size = cfg->dpb_size;
+    vout->p->layout = layout;
     if (ThreadStart(vout, &state)) {
         ThreadClean(vout);
         return VLC_EGENERIC;
@@ -39,7 +39,15 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
 /**
  * This function will return and reset internal statistics.
  */
-void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost );
+void vout_GetResetStatistic( vout_thread_t *p_vout, int *pi_displayed, int *pi_lost, int *pi_copied );
+
+/**
+ * This function returns the time needed to render a picture and the
+ * average lateness of the last displayed or dropped pictures (negative
+ * when they are early).
+ * It is thread safe and meant to let the decoder adapt its speed.
+ */
+void vout_GetDisplayFeedback( vout_thread_t *p_vout, mtime_t *pi_render, mtime_t *pi_late );
 
 /**
  * This function will ensure that all ready/displayed pciture have at most
@@ -71,6 +71,8 @@ struct spu_private_t {
 
     int channel;             /**< number of subpicture channels registered */
     filter_t *text;                              /**< text renderer module */
+    const vlc_var_handle_t *elapsed;       /**< "spu-elapsed" of the text */
+    const vlc_var_handle_t *rerender;    /**< "text-rerender" of the text */
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
     bool force_crop;                     /**< force cropping of subpicture */
@@ -286,14 +288,14 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
      * least show up on screen, but the effect won't change
      * the text over time.
      */
-    var_SetTime(text, "spu-elapsed", elapsed_time);
-    var_SetBool(text, "text-rerender", false);
+    var_SetTimeFast(text, spu->p->elapsed, elapsed_time);
+    var_SetBoolFast(text, spu->p->rerender, false);
 
     if (text->pf_render_html && region->psz_html)
         text->pf_render_html(text, region, region, chroma_list);
     else if (text->pf_render_text)
         text->pf_render_text(text, region, region, chroma_list);
-    *rerender_text = var_GetBool(text, "text-rerender");
+    *rerender_text = var_GetBoolFast(text, spu->p->rerender);
 }
 
 /**
@@ -804,6 +806,17 @@ static void SpuRenderRegion(spu_t *spu,
             if (changed_palette)
                 is_changed = true;
 
+            /* Check content changes */
+            if (_private->p_source != region->p_picture)
+                is_changed = true;
+
+            /* Check output format changes */
+            bool is_supported = false;
+            for (int i = 0; chroma_list[i] && !is_supported; i++)
+                is_supported = _private->fmt.i_chroma == chroma_list[i];
+            if (!is_supported)
+                is_changed = true;
+
             if (convert_chroma && _private->fmt.i_chroma != chroma_list[0])			// sunqueen modify
                 is_changed = true;
 
@@ -868,6 +881,7 @@ static void SpuRenderRegion(spu_t *spu,
                 region->p_private = subpicture_region_private_New(&picture->format);
                 if (region->p_private) {
                     region->p_private->p_picture = picture;
+                    region->p_private->p_source  = picture_Hold(region->p_picture);
                     if (!region->p_private->p_picture) {
                         subpicture_region_private_Delete(region->p_private);
                         region->p_private = NULL;
@@ -919,14 +933,13 @@ static void SpuRenderRegion(spu_t *spu,
         }
     }
 
-    subpicture_region_t *dst = *dst_ptr = subpicture_region_New(&region_fmt);
+    /* The output region only references the (cached) picture */
+    subpicture_region_t *dst = *dst_ptr = subpicture_region_NewWithPicture(&region_fmt,
+                                                                          region_picture);
     if (dst) {
         dst->i_x       = x_offset;
         dst->i_y       = y_offset;
         dst->i_align   = 0;
-        if (dst->p_picture)
-            picture_Release(dst->p_picture);
-        dst->p_picture = picture_Hold(region_picture);
         int fade_alpha = 255;
         if (subpic->b_fade) {
             mtime_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
@@ -1225,6 +1238,8 @@ spu_t *spu_Create(vlc_object_t *object)
     SpuHeapInit(&sys->heap);
 
     sys->text = NULL;
+    sys->elapsed = var_Handle("spu-elapsed");
+    sys->rerender = var_Handle("text-rerender");
     sys->scale = NULL;
     sys->scale_yuvp = NULL;
 
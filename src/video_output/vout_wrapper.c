@@ -108,6 +108,28 @@ void vout_CloseWrapper(vout_thread_t *vout, vout_display_state_t *state)
 /* Minimum number of display picture */
 #define DISPLAY_PICTURE_COUNT (1)
 
+/* Checks that all the pictures of a pool fulfil a layout */
+static bool PoolHasLayout(picture_pool_t *pool, const picture_layout_t *layout)
+{
+    picture_t *list = NULL;
+    picture_t *picture;
+    bool has_layout = true;
+
+    /* The pictures are chained so that each one is returned once */
+    while ((picture = picture_pool_Get(pool)) != NULL) {
+        has_layout = has_layout && picture_HasLayout(picture, layout);
+        picture->p_next = list;
+        list = picture;
+    }
+    while (list) {
+        picture = list;
+        list = picture->p_next;
+        picture->p_next = NULL;
+        picture_Release(picture);
+    }
+    return has_layout;
+}
+
 static void NoDrInit(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -142,22 +164,30 @@ int vout_InitWrapper(vout_thread_t *vout)
     picture_pool_t *display_pool =
         vout_display_Pool(vd, allow_dr ? __MAX(VOUT_MAX_PICTURES,
                                                reserved_picture + decoder_picture) : 3);
-    if (allow_dr &&
-        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture) {
+    const bool has_direct = allow_dr &&
+        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture;
+    /* The decoder would copy into display buffers that do not fulfil its
+     * layout: decode into system memory instead, and copy to the display */
+    const bool has_layout = has_direct &&
+        PoolHasLayout(display_pool, &sys->layout);
+
+    if (has_layout) {
         sys->dpb_size     = picture_pool_GetSize(display_pool) - reserved_picture;
         sys->decoder_pool = display_pool;
         sys->display_pool = display_pool;
     } else if (!sys->decoder_pool) {
         sys->decoder_pool =
-            picture_pool_NewFromFormat(&source,
+            picture_pool_NewFromLayout(&source, &sys->layout,
                                        __MAX(VOUT_MAX_PICTURES,
                                              reserved_picture + decoder_picture - DISPLAY_PICTURE_COUNT));
         if (!sys->decoder_pool)
             return VLC_EGENERIC;
-        if (allow_dr) {
+        if (allow_dr && !has_direct) {
             msg_Warn(vout, "Not enough direct buffers, using system memory");
             sys->dpb_size = 0;
         } else {
+            if (has_direct)
+                msg_Dbg(vout, "display buffers do not fulfil the decoder layout, using system memory");
             sys->dpb_size = picture_pool_GetSize(sys->decoder_pool) - reserved_picture;
         }
         NoDrInit(vout);